@@ -0,0 +1,216 @@
+/*
+    Reader for the ring buffer published by the Open Ephys "Shared Memory" sink.
+
+    Header-only C (C99 or C++). POSIX only: on Linux link with -lrt.
+
+        oe_shm_reader r;
+        if (oe_shm_open(&r, "open-ephys-continuous") != 0) ...
+
+        for (;;)
+        {
+            const float* frames; const int64_t* timestamps;
+            uint32_t n = oe_shm_peek(&r, &frames, &timestamps);
+
+            // frames[i * r.header->num_channels + c] is channel c of frame i,
+            // in microvolts; use them in place, without copying
+
+            if (oe_shm_advance(&r, n) == OE_SHM_OVERRUN)
+                ... the writer overwrote some of those frames while they were read
+        }
+
+    The layout is described in Source/Plugins/SharedMemorySink/SharedMemoryRegion.h.
+
+    This file is part of the Open Ephys GUI, Copyright (C) 2017 Open Ephys,
+    and is distributed under the GNU General Public License, version 3 or later.
+*/
+
+#ifndef OPEN_EPHYS_SHM_H
+#define OPEN_EPHYS_SHM_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    char magic[8];              /* "OESHM01" */
+    uint32_t version;           /* 2 */
+    uint32_t header_size;
+    uint32_t num_channels;
+    uint32_t capacity;          /* frames, a power of two */
+    double sample_rate;
+    uint64_t generation;        /* changes every time acquisition starts */
+    uint64_t data_offset;
+    uint64_t timestamp_offset;
+    uint32_t state;             /* OE_SHM_STOPPED, OE_SHM_RUNNING or OE_SHM_CLOSED */
+    uint32_t reserved0;
+    uint64_t write_index;       /* frames written since acquisition started */
+    uint64_t write_end;         /* frames written once the block being written is done */
+    uint8_t reserved1[176];
+    /* followed by num_channels uint32_t input channel indices */
+} oe_shm_header;
+
+enum
+{
+    OE_SHM_STOPPED = 0,
+    OE_SHM_RUNNING = 1,
+    OE_SHM_CLOSED = 2
+};
+
+enum
+{
+    OE_SHM_OK = 0,
+    OE_SHM_ERROR = -1,      /* couldn't open or map the region */
+    OE_SHM_OVERRUN = -2,    /* frames were overwritten before they were read */
+    OE_SHM_REOPEN = -3      /* acquisition restarted or the region was replaced */
+};
+
+typedef struct
+{
+    const oe_shm_header* header;
+    const uint32_t* channels;   /* input channel index of each published channel */
+    const float* data;
+    const int64_t* timestamps;
+    uint64_t generation;
+    uint64_t read_index;        /* next frame to read */
+    uint64_t frames_lost;
+    void* base;
+    size_t size;
+} oe_shm_reader;
+
+static inline uint64_t oe_shm_write_index(const oe_shm_reader* r)
+{
+    return __atomic_load_n(&r->header->write_index, __ATOMIC_ACQUIRE);
+}
+
+/* Frames older than write_end - capacity may be overwritten already. The fence
+   keeps the frames read before it from being read after the load. */
+static inline uint64_t oe_shm_write_end(const oe_shm_reader* r)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&r->header->write_end, __ATOMIC_RELAXED);
+}
+
+static inline void oe_shm_close(oe_shm_reader* r)
+{
+    if (r->base != NULL)
+        munmap(r->base, r->size);
+
+    memset(r, 0, sizeof(*r));
+}
+
+/* Maps the region and starts reading at the newest frame. */
+static inline int oe_shm_open(oe_shm_reader* r, const char* name)
+{
+    char path[256];
+    struct stat st;
+    int fd;
+
+    memset(r, 0, sizeof(*r));
+    snprintf(path, sizeof(path), "/%s", name);
+
+    fd = shm_open(path, O_RDONLY, 0);
+
+    if (fd < 0)
+        return OE_SHM_ERROR;
+
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(oe_shm_header))
+    {
+        close(fd);
+        return OE_SHM_ERROR;
+    }
+
+    r->size = (size_t) st.st_size;
+    r->base = mmap(NULL, r->size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (r->base == MAP_FAILED)
+    {
+        r->base = NULL;
+        return OE_SHM_ERROR;
+    }
+
+    r->header = (const oe_shm_header*) r->base;
+
+    if (memcmp(r->header->magic, "OESHM01", 8) != 0 || r->header->version != 2)
+    {
+        oe_shm_close(r);
+        return OE_SHM_ERROR;
+    }
+
+    r->channels = (const uint32_t*) (r->header + 1);
+    r->data = (const float*) ((const char*) r->base + r->header->data_offset);
+    r->timestamps = (const int64_t*) ((const char*) r->base + r->header->timestamp_offset);
+    r->generation = r->header->generation;
+    r->read_index = oe_shm_write_index(r);
+
+    return OE_SHM_OK;
+}
+
+/* Points frames and timestamps at the unread frames that are contiguous in the
+   ring and returns how many there are; 0 if there are none. If the reader fell
+   behind the block being written, it first skips to the oldest frame that block
+   leaves in place. */
+static inline uint32_t oe_shm_peek(oe_shm_reader* r, const float** frames, const int64_t** timestamps)
+{
+    const uint64_t write_index = oe_shm_write_index(r);
+    const uint64_t write_end = oe_shm_write_end(r);
+    const uint64_t capacity = r->header->capacity;
+    uint64_t slot, available;
+
+    if (write_index < r->read_index) /* acquisition restarted */
+        return 0;
+
+    if (write_end > r->read_index + capacity)
+    {
+        r->frames_lost += write_end - capacity - r->read_index;
+        r->read_index = write_end - capacity;
+    }
+
+    if (r->read_index >= write_index) /* a block longer than the ring */
+        return 0;
+
+    slot = r->read_index & (capacity - 1);
+    available = write_index - r->read_index;
+
+    if (available > capacity - slot)
+        available = capacity - slot;
+
+    *frames = r->data + slot * r->header->num_channels;
+    *timestamps = r->timestamps + slot;
+
+    return (uint32_t) available;
+}
+
+/* Marks num_frames frames as read. Returns OE_SHM_OVERRUN if the writer may have
+   overwritten some of them while they were being used, and OE_SHM_REOPEN if the
+   reader should close and open the region again. */
+static inline int oe_shm_advance(oe_shm_reader* r, uint32_t num_frames)
+{
+    const uint64_t write_end = oe_shm_write_end(r);
+    const uint64_t first = r->read_index;
+
+    if (r->header->state == OE_SHM_CLOSED || r->header->generation != r->generation)
+        return OE_SHM_REOPEN;
+
+    r->read_index += num_frames;
+
+    if (write_end > first + r->header->capacity)
+        return OE_SHM_OVERRUN;
+
+    return OE_SHM_OK;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OPEN_EPHYS_SHM_H */
@@ -0,0 +1,175 @@
+"""
+    Reads continuous data published by the "Shared Memory" sink.
+
+    The sink writes the selected channels into a ring buffer in shared memory.
+    Any number of readers can follow it; each keeps its own read position and
+    the writer never waits for them. Frames are float32 microvolts, one row per
+    sample, with an int64 timestamp per row. See
+    Source/Plugins/SharedMemorySink/SharedMemoryRegion.h for the layout.
+
+    Requires numpy and Python 3.8 or later.
+
+        reader = ContinuousReader('open-ephys-continuous')
+        while True:
+            data, timestamps = reader.read()   # data.shape == (n, num_channels)
+"""
+
+from __future__ import print_function
+
+import struct
+import sys
+import time
+
+import numpy as np
+from multiprocessing import shared_memory
+
+
+HEADER = struct.Struct('<8s4I d 3Q 2I 2Q')
+WRITE_INDEX_OFFSET = 64
+WRITE_END_OFFSET = 72
+
+STOPPED, RUNNING, CLOSED = 0, 1, 2
+
+
+class RegionReplaced(Exception):
+    """Acquisition restarted or the region was recreated; open a new reader."""
+
+
+class ContinuousReader(object):
+
+    def __init__(self, name='open-ephys-continuous'):
+        if sys.version_info >= (3, 13):
+            self._shm = shared_memory.SharedMemory(name=name, track=False)
+        else:
+            self._shm = shared_memory.SharedMemory(name=name)
+            # Python would otherwise unlink the region when this process exits
+            if hasattr(self._shm, '_name') and sys.platform != 'win32':
+                from multiprocessing import resource_tracker
+                resource_tracker.unregister(self._shm._name, 'shared_memory')
+
+        buf = self._shm.buf
+        (magic, version, header_size, self.num_channels, self.capacity,
+         self.sample_rate, self.generation, data_offset, timestamp_offset,
+         self._state, _, _, _) = HEADER.unpack_from(buf, 0)
+
+        if magic != b'OESHM01\0' or version != 2:
+            self._shm.close()
+            raise ValueError('%s is not an Open Ephys shared memory region' % name)
+
+        self.channels = np.frombuffer(buf, np.uint32, self.num_channels, 256)
+        self.frames = np.frombuffer(buf, np.float32, self.capacity * self.num_channels,
+                                    data_offset).reshape(self.capacity, self.num_channels)
+        self.timestamps = np.frombuffer(buf, np.int64, self.capacity, timestamp_offset)
+        self._write_index = np.frombuffer(buf, np.uint64, 1, WRITE_INDEX_OFFSET)
+        self._write_end = np.frombuffer(buf, np.uint64, 1, WRITE_END_OFFSET)
+        self._header_words = np.frombuffer(buf, np.uint32, 2, 56)  # state, reserved
+        self._generation = np.frombuffer(buf, np.uint64, 1, 32)
+
+        self.read_index = self.write_index()
+        self.frames_lost = 0
+
+    def write_index(self):
+        return int(self._write_index[0])
+
+    def write_end(self):
+        """Frames older than write_end() - capacity may be overwritten already."""
+        return int(self._write_end[0])
+
+    def state(self):
+        return int(self._header_words[0])
+
+    def _check_generation(self):
+        if self.state() == CLOSED or int(self._generation[0]) != self.generation:
+            raise RegionReplaced()
+
+    def peek(self):
+        """Returns views of the unread frames that are contiguous in the ring,
+        without copying. Call advance() once they have been used."""
+        self._check_generation()
+
+        write_index = self.write_index()
+        write_end = self.write_end()
+
+        # skip to the oldest frame the block being written leaves in place
+        if write_end > self.read_index + self.capacity:
+            self.frames_lost += write_end - self.capacity - self.read_index
+            self.read_index = write_end - self.capacity
+
+        slot = self.read_index % self.capacity
+        n = max(0, min(write_index - self.read_index, self.capacity - slot))
+
+        return self.frames[slot:slot + n], self.timestamps[slot:slot + n]
+
+    def advance(self, n):
+        """Marks n frames as read. Returns False if the writer may have overwritten
+        some of them while they were in use."""
+        first = self.read_index
+        self.read_index += n
+        return self.write_end() <= first + self.capacity
+
+    def read(self, max_frames=None):
+        """Returns copies of all unread frames, up to max_frames, and their timestamps."""
+        chunks, stamps = [], []
+
+        while max_frames is None or max_frames > 0:
+            frames, timestamps = self.peek()
+
+            if max_frames is not None:
+                frames, timestamps = frames[:max_frames], timestamps[:max_frames]
+                max_frames -= len(frames)
+
+            if len(frames) == 0:
+                break
+
+            chunks.append(frames.copy())
+            stamps.append(timestamps.copy())
+
+            if not self.advance(len(frames)):
+                # the copies may be torn; drop them rather than return bad data
+                self.frames_lost += len(frames)
+                chunks.pop()
+                stamps.pop()
+
+        if not chunks:
+            return (np.empty((0, self.num_channels), np.float32),
+                    np.empty(0, np.int64))
+
+        return np.concatenate(chunks), np.concatenate(stamps)
+
+    def close(self):
+        self.channels = self.frames = self.timestamps = None
+        self._write_index = self._write_end = self._header_words = self._generation = None
+        self._shm.close()
+
+
+def run(name='open-ephys-continuous'):
+    while True:
+        try:
+            reader = ContinuousReader(name)
+        except (FileNotFoundError, ValueError):
+            time.sleep(0.5)
+            continue
+
+        print('%d channels at %g Hz' % (reader.num_channels, reader.sample_rate))
+
+        try:
+            while True:
+                data, timestamps = reader.read()
+
+                if len(data):
+                    print('%d: %d frames, channel 1 mean %.1f uV, %d lost' %
+                          (timestamps[0], len(data), data[:, 0].mean(), reader.frames_lost))
+
+                time.sleep(0.1)
+
+        except RegionReplaced:
+            reader.close()
+
+        except KeyboardInterrupt:
+            print()  # Add final newline
+            reader.close()
+            break
+
+
+if __name__ == '__main__':
+    run(*sys.argv[1:])
@@ -0,0 +1,361 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "HeadlessChain.h"
+#include "KwdRecording.h"
+#include "../Plugins/PhaseDetector/PhaseEstimator.h"
+#include "../Plugins/SyntheticSource/SyntheticSignalGenerator.h"
+#include "../Plugins/EcubeSource/EcubeBufferAssembler.h"
+#include "../Plugins/CompressedRecording/NeuralCodec.h"
+
+/*
+    open-ephys-benchmark: runs a saved signal chain without the GUI and reports
+    its throughput, so performance changes can be checked from the command line
+    or in CI. Exits with 1 on errors and with 2 if the chain ran slower than
+    --min-realtime.
+
+    The other modes time single components on their own instead of the chain.
+*/
+
+static void printUsage()
+{
+    std::cout << "Usage: open-ephys-benchmark [options]" << std::endl
+              << "  --settings FILE      signal chain to run (a .settings.xml file)" << std::endl
+              << "  --seconds N          wall-clock duration of the run (default 10)" << std::endl
+              << "  --channels N         number of channels, overrides the settings file" << std::endl
+              << "  --rate HZ            sample rate, overrides the settings file" << std::endl
+              << "  --block N            samples per block (default: buffer size in the settings file)" << std::endl
+              << "  --input FILE         loop a raw interleaved int16 file instead of synthetic data" << std::endl
+              << "  --no-record          don't write the data to disk" << std::endl
+              << "  --min-realtime X     exit with 2 if the chain is less than X times faster than real time" << std::endl
+              << std::endl
+              << "Other modes:" << std::endl
+              << "  --phase FILE         PhaseDetector's phase estimate against sign-change detection, on a" << std::endl
+              << "                       .kwd recording and on --seconds of synthetic theta" << std::endl
+              << "  --channel N          channel of the recording used by --phase (default 0)" << std::endl
+              << "  --generator          Synthetic Source's signal generator, for --seconds of data at the" << std::endl
+              << "                       --channels and --rate of the chain; --min-realtime applies" << std::endl
+              << "  --ecube              eCube buffer assembly for each data format, from synthetic device" << std::endl
+              << "                       buffers, with --channels separate analog streams" << std::endl
+              << "  --codec FILE         compressed recording codec on a .kwd recording: compression ratio," << std::endl
+              << "                       encode and decode MB/s; can be given more than once" << std::endl;
+}
+
+static void runEcubeBenchmark(int numChannels)
+{
+    // runSyntheticBenchmark() times its buffers for a 25 kHz acquisition
+    const double sampleRate = 25000.0;
+    const int numBufferSets = 10000;
+
+    const EcubeBufferAssembler::DataFormat formats[3] = {
+        EcubeBufferAssembler::dfSeparateChannelsAnalog,
+        EcubeBufferAssembler::dfInterleavedChannelsAnalog,
+        EcubeBufferAssembler::dfDigital
+    };
+
+    const String names[3] = {
+        "Separate analog channels (" + String(numChannels) + " streams)",
+        "Interleaved analog channels (32 per stream)",
+        "Digital panel ports"
+    };
+
+    for (int i = 0; i < 3; i++)
+    {
+        const double framesPerSecond = EcubeBufferAssembler::runSyntheticBenchmark(formats[i], numChannels, numBufferSets);
+
+        std::cout << "eCube " << names[i] << ": " << String(framesPerSecond / 1.0e6, 2) << " M frames/s, "
+                  << String(framesPerSecond / sampleRate, 1) << "x real time" << std::endl;
+    }
+}
+
+static int runCodecBenchmark(const Array<File>& files)
+{
+    using namespace CompressedRecordingEngine;
+
+    // the CompressedRecording engine's default chunk length
+    const int blockSamples = 16384;
+
+    // the files are short, so they are encoded and decoded until this much time has passed
+    const double minSeconds = 0.5;
+
+    for (int f = 0; f < files.size(); f++)
+    {
+        KwdRecording recording;
+
+        if (! recording.load(files[f]))
+            return 1;
+
+        const int numChannels = recording.getNumChannels();
+        const int numSamples = recording.getNumSamples();
+        const int numBlocks = (numSamples + blockSamples - 1) / blockSamples;
+        const size_t maxEncodedSize = NeuralCodec::getMaxEncodedSize(blockSamples);
+        const double rawBytes = double(numChannels) * numSamples * sizeof(int16);
+
+        // one channel after another, as the record engine stages them
+        HeapBlock<int16> samples((size_t) numChannels * numSamples);
+        HeapBlock<int16> decoded((size_t) numChannels * numSamples);
+        HeapBlock<uint8> encoded((size_t) numChannels * numBlocks * maxEncodedSize);
+        HeapBlock<size_t> encodedSizes((size_t) numChannels * numBlocks);
+
+        const int16* data = recording.getData();
+
+        for (int chan = 0; chan < numChannels; chan++)
+            for (int i = 0; i < numSamples; i++)
+                samples[chan * numSamples + i] = data[i * numChannels + chan];
+
+        size_t encodedBytes = 0;
+        int encodePasses = 0;
+        const int64 encodeStart = Time::getHighResolutionTicks();
+        double encodeSeconds;
+
+        do
+        {
+            encodedBytes = 0;
+
+            for (int chan = 0; chan < numChannels; chan++)
+            {
+                for (int block = 0; block < numBlocks; block++)
+                {
+                    const int index = chan * numBlocks + block;
+                    const int first = block * blockSamples;
+
+                    encodedSizes[index] = NeuralCodec::encode(samples + (size_t) chan * numSamples + first,
+                                                              jmin(blockSamples, numSamples - first),
+                                                              encoded + index * maxEncodedSize);
+                    encodedBytes += encodedSizes[index];
+                }
+            }
+
+            encodePasses++;
+            encodeSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - encodeStart);
+        }
+        while (encodeSeconds < minSeconds);
+
+        bool lossless = true;
+        int decodePasses = 0;
+        const int64 decodeStart = Time::getHighResolutionTicks();
+        double decodeSeconds;
+
+        do
+        {
+            for (int chan = 0; chan < numChannels; chan++)
+            {
+                for (int block = 0; block < numBlocks; block++)
+                {
+                    const int index = chan * numBlocks + block;
+                    const int first = block * blockSamples;
+
+                    lossless &= NeuralCodec::decode(encoded + index * maxEncodedSize, encodedSizes[index],
+                                                    decoded + (size_t) chan * numSamples + first,
+                                                    jmin(blockSamples, numSamples - first));
+                }
+            }
+
+            decodePasses++;
+            decodeSeconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - decodeStart);
+        }
+        while (decodeSeconds < minSeconds);
+
+        lossless &= memcmp(samples, decoded, (size_t) numChannels * numSamples * sizeof(int16)) == 0;
+
+        std::cout << files[f].getFileName() << ": " << numChannels << " channels, "
+                  << String(numSamples / recording.getSampleRate(), 2) << " s, "
+                  << String(rawBytes / (1024.0 * 1024.0), 2) << " MB" << std::endl;
+        std::cout << "  ratio " << String(rawBytes / jmax<size_t>(1, encodedBytes), 2)
+                  << ", encode " << String(rawBytes * encodePasses / encodeSeconds / (1024.0 * 1024.0), 1) << " MB/s"
+                  << ", decode " << String(rawBytes * decodePasses / decodeSeconds / (1024.0 * 1024.0), 1) << " MB/s"
+                  << (lossless ? "" : ", DECODED DATA DIFFERS") << std::endl;
+
+        if (! lossless)
+            return 1;
+    }
+
+    return 0;
+}
+
+static int runPhaseBenchmark(const File& file, int channel, double seconds)
+{
+    KwdRecording recording;
+
+    if (! recording.load(file))
+        return 1;
+
+    if (! isPositiveAndBelow(channel, recording.getNumChannels()))
+    {
+        std::cout << file.getFileName() << " has no channel " << channel << std::endl;
+        return 1;
+    }
+
+    HeapBlock<float> samples(recording.getNumSamples());
+    recording.getChannel(channel, samples);
+
+    std::cout << file.getFileName() << ", channel " << channel << std::endl;
+
+    const double targets[4] = { 0.0, double_Pi / 2.0, double_Pi, 3.0 * double_Pi / 2.0 };
+
+    for (int t = 0; t < 4; t++)
+        PhaseEstimator::runBenchmark(samples, recording.getNumSamples(), recording.getSampleRate(), targets[t], 5.0);
+
+    std::cout << std::endl << "Synthetic theta" << std::endl;
+    PhaseEstimator::runSyntheticBenchmark(recording.getSampleRate(), seconds);
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    StringArray args;
+
+    for (int i = 1; i < argc; i++)
+        args.add(CharPointer_UTF8(argv[i]));
+
+    // the processors and the record node use timers and components, which need
+    // a message manager even though no window is opened
+    ScopedJuceInitialiser_GUI juceInitialiser;
+
+    HeadlessChain chain;
+
+    double seconds = 10.0;
+    double minRealTime = 0.0;
+    int blockSize = 0;
+
+    File phaseFile;
+    int channel = 0;
+    bool runGenerator = false;
+    bool runEcube = false;
+    Array<File> codecFiles;
+
+    const int settingsIndex = args.indexOf("--settings");
+
+    // the settings go first, so the other options can override them
+    if (settingsIndex >= 0)
+    {
+        const File settingsFile = File::getCurrentWorkingDirectory().getChildFile(args[settingsIndex + 1]);
+
+        if (! chain.loadSettings(settingsFile))
+            return 1;
+    }
+
+    for (int i = 0; i < args.size(); i++)
+    {
+        const String& arg = args[i];
+
+        if (arg == "--no-record")
+        {
+            chain.setRecordingEnabled(false);
+            continue;
+        }
+
+        if (arg == "--generator")
+        {
+            runGenerator = true;
+            continue;
+        }
+
+        if (arg == "--ecube")
+        {
+            runEcube = true;
+            continue;
+        }
+
+        if (arg == "--help" || arg == "-h")
+        {
+            printUsage();
+            return 0;
+        }
+
+        if (i + 1 >= args.size() || ! arg.startsWith("--"))
+        {
+            std::cout << "Unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+
+        const String value = args[++i];
+
+        if (arg == "--settings")
+            continue;
+        else if (arg == "--seconds")
+            seconds = value.getDoubleValue();
+        else if (arg == "--channels")
+            chain.setNumChannels(value.getIntValue());
+        else if (arg == "--rate")
+            chain.setSampleRate(value.getFloatValue());
+        else if (arg == "--block")
+            blockSize = value.getIntValue();
+        else if (arg == "--input")
+            chain.setInputFile(File::getCurrentWorkingDirectory().getChildFile(value));
+        else if (arg == "--min-realtime")
+            minRealTime = value.getDoubleValue();
+        else if (arg == "--phase")
+            phaseFile = File::getCurrentWorkingDirectory().getChildFile(value);
+        else if (arg == "--channel")
+            channel = value.getIntValue();
+        else if (arg == "--codec")
+            codecFiles.add(File::getCurrentWorkingDirectory().getChildFile(value));
+        else
+        {
+            std::cout << "Unknown option " << arg << std::endl;
+            printUsage();
+            return 1;
+        }
+    }
+
+    if (phaseFile != File::nonexistent)
+        return runPhaseBenchmark(phaseFile, channel, seconds);
+
+    if (codecFiles.size() > 0)
+        return runCodecBenchmark(codecFiles);
+
+    if (runEcube)
+    {
+        runEcubeBenchmark(chain.getNumChannels());
+        return 0;
+    }
+
+    double realTimeFactor;
+
+    if (runGenerator)
+    {
+        realTimeFactor = SyntheticSignalGenerator::runBenchmark(chain.getNumChannels(), chain.getSampleRate(), seconds);
+    }
+    else
+    {
+        if (blockSize <= 0)
+            blockSize = chain.getDefaultBlockSize();
+
+        if (! chain.run(seconds, blockSize))
+            return 1;
+
+        chain.printReport();
+        realTimeFactor = chain.getRealTimeFactor();
+    }
+
+    if (realTimeFactor < minRealTime)
+    {
+        std::cout << "Below the required " << minRealTime << "x real time." << std::endl;
+        return 2;
+    }
+
+    return 0;
+}
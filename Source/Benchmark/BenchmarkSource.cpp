@@ -0,0 +1,208 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "BenchmarkSource.h"
+#include "../Plugins/SyntheticSource/SyntheticSignalGenerator.h"
+
+// same scaling as an Intan headstage and BinaryRecording
+static const float bitVolts = 0.195f;
+
+// the synthetic TTL word uses the low three lines, see SyntheticSignalGenerator
+static const int numTTLLines = 8;
+
+BenchmarkSource::BenchmarkSource()
+    : GenericProcessor("Benchmark Source"),
+      numChannels(64),
+      sampleRate(30000.0f),
+      maxBlockSize(1024),
+      numGenerated(0),
+      ttlChannel(nullptr),
+      ttlState(0),
+      timestamp(0)
+{
+    setProcessorType(PROCESSOR_TYPE_SOURCE);
+}
+
+BenchmarkSource::~BenchmarkSource()
+{
+}
+
+void BenchmarkSource::setNumChannels(int numChannels_)
+{
+    numChannels = jmax(1, numChannels_);
+}
+
+void BenchmarkSource::setSampleRate(float sampleRate_)
+{
+    sampleRate = jmax(1.0f, sampleRate_);
+}
+
+void BenchmarkSource::setInputFile(const File& file)
+{
+    inputFile = file;
+}
+
+void BenchmarkSource::setMaxBlockSize(int maxBlockSize_)
+{
+    maxBlockSize = jmax(1, maxBlockSize_);
+}
+
+int BenchmarkSource::getDefaultNumDataOutputs(DataChannel::DataChannelTypes type, int) const
+{
+    return type == DataChannel::HEADSTAGE_CHANNEL ? numChannels : 0;
+}
+
+float BenchmarkSource::getDefaultSampleRate() const
+{
+    return sampleRate;
+}
+
+float BenchmarkSource::getSampleRate(int) const
+{
+    return sampleRate;
+}
+
+float BenchmarkSource::getDefaultBitVolts() const
+{
+    return bitVolts;
+}
+
+void BenchmarkSource::createEventChannels()
+{
+    ttlChannel = new EventChannel(EventChannel::TTL, numTTLLines, 0, sampleRate, this, 0);
+    ttlChannel->setName(getName() + " source TTL events input");
+    ttlChannel->setDescription("TTL Events coming from the hardware source processor \"" + getName() + "\"");
+    ttlChannel->setIdentifier("sourceevent");
+    eventChannelArray.add(ttlChannel);
+}
+
+bool BenchmarkSource::enable()
+{
+    if (inputFile != File::nonexistent)
+    {
+        if (inputFile.getSize() < int64(maxBlockSize) * numChannels * (int64) sizeof(int16))
+        {
+            std::cout << inputFile.getFullPathName() << " is shorter than one block of "
+                      << numChannels << " channels." << std::endl;
+            return false;
+        }
+
+        inputStream = inputFile.createInputStream();
+        inputData.malloc((size_t) maxBlockSize * numChannels);
+    }
+    else
+    {
+        SyntheticSignalSettings settings;
+        settings.numChannels = numChannels;
+        settings.sampleRate = sampleRate;
+
+        generator = new SyntheticSignalGenerator(settings, 1);
+    }
+
+    interleaved.malloc((size_t) maxBlockSize * numChannels);
+    ttl.calloc(maxBlockSize);
+
+    numGenerated = 0;
+    ttlState = 0;
+    timestamp = 0;
+
+    return true;
+}
+
+bool BenchmarkSource::disable()
+{
+    generator = nullptr;
+    inputStream = nullptr;
+
+    return true;
+}
+
+void BenchmarkSource::generateBlock(int numSamples)
+{
+    numGenerated = jmin(numSamples, maxBlockSize);
+
+    if (inputStream != nullptr)
+    {
+        const int numValues = numGenerated * numChannels;
+        const int numBytes = numValues * (int) sizeof(int16);
+        int bytesRead = 0;
+
+        while (bytesRead < numBytes)
+        {
+            const int n = inputStream->read(reinterpret_cast<char*>(inputData.getData()) + bytesRead, numBytes - bytesRead);
+
+            if (n <= 0)
+                inputStream->setPosition(0); // loop the file
+            else
+                bytesRead += n;
+        }
+
+        for (int i = 0; i < numValues; i++)
+            interleaved[i] = inputData[i] * bitVolts;
+    }
+    else if (generator != nullptr)
+    {
+        generator->fillBlock(interleaved, ttl, numGenerated);
+    }
+}
+
+void BenchmarkSource::process(AudioSampleBuffer& buffer)
+{
+    const int nSamples = jmin(numGenerated, buffer.getNumSamples());
+
+    for (int chan = 0; chan < numChannels; chan++)
+    {
+        float* out = buffer.getWritePointer(chan);
+        const float* in = interleaved + chan;
+
+        for (int i = 0; i < nSamples; i++)
+            out[i] = in[i * numChannels];
+    }
+
+    setTimestampAndSamples(timestamp, nSamples, 0);
+
+    uint64 last = ttlState;
+
+    for (int i = 0; i < nSamples; ++i)
+    {
+        uint64 current = ttl[i];
+
+        if (last != current)
+        {
+            for (int c = 0; c < numTTLLines; ++c)
+            {
+                if (((current >> c) & 0x01) != ((last >> c) & 0x01))
+                {
+                    TTLEventPtr event = TTLEvent::createTTLEvent(ttlChannel, timestamp + i, &current, sizeof(uint64), c);
+                    addEvent(ttlChannel, event, i);
+                }
+            }
+
+            last = current;
+        }
+    }
+
+    ttlState = last;
+    timestamp += nSamples;
+    numGenerated = 0;
+}
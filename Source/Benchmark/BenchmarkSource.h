@@ -0,0 +1,98 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef BENCHMARKSOURCE_H_INCLUDED
+#define BENCHMARKSOURCE_H_INCLUDED
+
+#include "../Processors/GenericProcessor/GenericProcessor.h"
+#include "../Processors/Events/Events.h"
+
+class SyntheticSignalGenerator;
+
+/**
+    The source of the headless benchmark's signal chain.
+
+    It stands in for a SourceNode and its DataThread. generateBlock() plays the
+    part of the thread filling the DataBuffer, from SyntheticSignalGenerator or
+    from a raw interleaved int16 file that is looped, and process() does what
+    SourceNode::process() does with the result: it copies the samples into the
+    buffer, sets the timestamps and sends an event for each TTL line that changed.
+
+    @see HeadlessChain
+*/
+class BenchmarkSource : public GenericProcessor
+{
+public:
+    BenchmarkSource();
+    ~BenchmarkSource();
+
+    void setNumChannels (int numChannels);
+    void setSampleRate (float sampleRate);
+
+    /** Plays a raw interleaved int16 file instead of synthetic data. */
+    void setInputFile (const File& file);
+
+    /** Sets the largest block generateBlock() will be asked for. */
+    void setMaxBlockSize (int maxBlockSize);
+
+    /** Produces the next numSamples frames, to be copied out by the next process(). */
+    void generateBlock (int numSamples);
+
+    void process (AudioSampleBuffer& buffer) override;
+
+    bool enable() override;
+    bool disable() override;
+
+    bool isGeneratesTimestamps() const override { return true; }
+
+    int getDefaultNumDataOutputs (DataChannel::DataChannelTypes type, int subProcessorIdx = 0) const override;
+
+    float getDefaultSampleRate() const override;
+    float getSampleRate (int subProcessorIdx = 0) const override;
+    float getDefaultBitVolts() const override;
+
+    void createEventChannels() override;
+
+private:
+    int numChannels;
+    float sampleRate;
+    int maxBlockSize;
+    File inputFile;
+
+    ScopedPointer<FileInputStream> inputStream;
+    HeapBlock<int16> inputData;
+    ScopedPointer<SyntheticSignalGenerator> generator;
+
+    HeapBlock<float> interleaved;
+    HeapBlock<uint64> ttl;
+    int numGenerated;
+
+    EventChannel* ttlChannel;
+    uint64 ttlState;
+    int64 timestamp;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BenchmarkSource);
+};
+
+
+#endif  // BENCHMARKSOURCE_H_INCLUDED
@@ -0,0 +1,548 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "HeadlessChain.h"
+#include "HeadlessStubs.h"
+#include "BenchmarkSource.h"
+
+#include "../Audio/AudioComponent.h"
+#include "../UI/ControlPanel.h"
+#include "../UI/EditorViewport.h"
+#include "../Processors/ProcessorGraph/ProcessorGraph.h"
+#include "../Processors/RecordNode/RecordNode.h"
+#include "../Processors/RecordNode/RecordEngine.h"
+#include "../Processors/Editors/GenericEditor.h"
+
+#if JUCE_LINUX || JUCE_MAC
+ #include <sys/resource.h>
+#endif
+
+// block latencies are counted in buckets 1/16 of an octave wide (about 4%),
+// from 1 us to 2^24 us; anything longer goes in the last one
+static const int latencyBucketsPerOctave = 16;
+static const int numLatencyBuckets = 24 * latencyBucketsPerOctave;
+
+HeadlessChain::HeadlessChain()
+    : numChannels(64),
+      sampleRate(30000.0f),
+      defaultBlockSize(1024),
+      recordingEnabled(true),
+      source(nullptr),
+      recordNode(nullptr),
+      numRecordChannels(0),
+      numBlocks(0),
+      maxBlockMicros(0),
+      sourceSeconds(0),
+      elapsedSeconds(0),
+      samplesProcessed(0),
+      bytesRecorded(0),
+      runBlockSize(0)
+{
+}
+
+HeadlessChain::~HeadlessChain()
+{
+    // the processors go first, they may still reach the rest through AccessClass
+    graph = nullptr;
+}
+
+bool HeadlessChain::loadSettings(const File& file)
+{
+    ScopedPointer<XmlElement> xml = XmlDocument::parse(file);
+
+    if (xml == nullptr || ! xml->hasTagName("SETTINGS"))
+    {
+        std::cout << file.getFullPathName() << " is not a settings file." << std::endl;
+        return false;
+    }
+
+    if (XmlElement* audio = xml->getChildByName("AUDIO"))
+        defaultBlockSize = audio->getIntAttribute("bufferSize", defaultBlockSize);
+
+    XmlElement* signalChain = xml->getChildByName("SIGNALCHAIN");
+
+    if (signalChain == nullptr)
+    {
+        std::cout << file.getFullPathName() << " has no signal chain." << std::endl;
+        return false;
+    }
+
+    if (signalChain->getNextElementWithTagName("SIGNALCHAIN") != nullptr)
+        std::cout << "Only the first signal chain is run." << std::endl;
+
+    forEachXmlChildElementWithTagName(*signalChain, processorXml, "PROCESSOR")
+    {
+        if (! processorXml->getBoolAttribute("isSource"))
+            continue;
+
+        // the source's data is replaced, only its shape is kept
+        if (XmlElement* states = processorXml->getChildByName("CHANNELSTATES"))
+            numChannels = states->getIntAttribute("count", numChannels);
+        else
+        {
+            int count = 0;
+
+            forEachXmlChildElementWithTagName(*processorXml, channelXml, "CHANNEL")
+                count++;
+
+            if (count > 0)
+                numChannels = count;
+        }
+
+        if (XmlElement* editorXml = processorXml->getChildByName("EDITOR"))
+            sampleRate = (float) editorXml->getDoubleAttribute("SampleRate", sampleRate);
+
+        break;
+    }
+
+    settingsXml = xml.release();
+    settingsFile = file;
+
+    return true;
+}
+
+void HeadlessChain::setNumChannels(int numChannels_)
+{
+    numChannels = jmax(1, numChannels_);
+}
+
+void HeadlessChain::setSampleRate(float sampleRate_)
+{
+    sampleRate = jmax(1.0f, sampleRate_);
+}
+
+void HeadlessChain::setInputFile(const File& file)
+{
+    inputFile = file;
+}
+
+void HeadlessChain::setRecordingEnabled(bool shouldRecord)
+{
+    recordingEnabled = shouldRecord;
+}
+
+int HeadlessChain::getNumChannels() const
+{
+    return numChannels;
+}
+
+float HeadlessChain::getSampleRate() const
+{
+    return sampleRate;
+}
+
+int HeadlessChain::getDefaultBlockSize() const
+{
+    return defaultBlockSize;
+}
+
+void HeadlessChain::addBlockLatency(float micros)
+{
+    const int bucket = jlimit(0, numLatencyBuckets - 1,
+                              int(std::log2(jmax(1.0f, micros)) * latencyBucketsPerOctave));
+
+    latencyCounts.getReference(bucket)++;
+    maxBlockMicros = jmax(maxBlockMicros, micros);
+    numBlocks++;
+}
+
+float HeadlessChain::getBlockLatencyPercentile(double fraction) const
+{
+    const int64 rank = jmin(numBlocks - 1, int64(numBlocks * fraction));
+    int64 count = 0;
+
+    for (int bucket = 0; bucket < latencyCounts.size(); bucket++)
+    {
+        count += latencyCounts[bucket];
+
+        if (count > rank)
+            return jmin(maxBlockMicros, std::exp2(float(bucket + 1) / latencyBucketsPerOctave));
+    }
+
+    return maxBlockMicros;
+}
+
+bool HeadlessChain::createProcessors()
+{
+    audioComponent = new AudioComponent();
+    graph = new ProcessorGraph();
+    controlPanel = new ControlPanel(graph, audioComponent);
+    editorViewport = new EditorViewport();
+
+    HeadlessStubs::setComponents(graph, controlPanel, editorViewport, audioComponent);
+
+    graph->createDefaultNodes();
+    recordNode = graph->getRecordNode();
+
+    // what ControlPanel::comboBoxChanged() does for the first built-in format;
+    // the formats loaded from plugins are not available here
+    recordEngineManager = RecordEngineManager::createBuiltInEngineManager(0);
+    RecordEngine* engine = recordEngineManager->instantiateEngine();
+    engine->registerManager(recordEngineManager);
+    recordNode->clearRecordEngines();
+    recordNode->registerRecordEngine(engine);
+
+    audioComponent->setBufferSize(runBlockSize);
+    controlPanel->setBaseName("benchmark");
+    editorViewport->currentFile = settingsFile;
+
+    processors.clearQuick();
+    skippedProcessors.clear();
+    source = nullptr;
+
+    XmlElement* signalChain = settingsXml != nullptr ? settingsXml->getChildByName("SIGNALCHAIN") : nullptr;
+    Array<XmlElement*> processorXmls;
+
+    if (signalChain != nullptr)
+    {
+        forEachXmlChildElementWithTagName(*signalChain, processorXml, "PROCESSOR")
+            processorXmls.add(processorXml);
+    }
+
+    // a chain without a source, or no chain at all, gets one at the start
+    if (processorXmls.isEmpty() || ! processorXmls[0]->getBoolAttribute("isSource"))
+        processorXmls.insert(0, nullptr);
+
+    for (int i = 0; i < processorXmls.size(); i++)
+    {
+        XmlElement* processorXml = processorXmls[i];
+
+        const String pluginName = processorXml != nullptr
+                                  ? processorXml->getStringAttribute("pluginName", processorXml->getStringAttribute("name"))
+                                  : String("Benchmark Source");
+
+        if (pluginName == "Splitter" || pluginName == "Merger")
+            continue;
+
+        const bool isSource = processorXml != nullptr ? processorXml->getBoolAttribute("isSource") : true;
+
+        if (isSource && source != nullptr)
+        {
+            skippedProcessors.add(pluginName);
+            continue;
+        }
+
+        // see ProcessorGraph::createProcessorFromDescription for the description
+        Array<var> description;
+        description.add(false);
+        description.add(pluginName);
+
+        if (processorXml != nullptr)
+        {
+            description.add(processorXml->getIntAttribute("pluginType"));
+            description.add(processorXml->getIntAttribute("pluginIndex"));
+            description.add(processorXml->getStringAttribute("libraryName"));
+            description.add(processorXml->getIntAttribute("libraryVersion"));
+        }
+        else
+        {
+            description.add(0);
+            description.add(0);
+            description.add(String());
+            description.add(0);
+        }
+
+        description.add(isSource);
+        description.add(processorXml != nullptr && processorXml->getBoolAttribute("isSink"));
+
+        const int nodeId = processorXml != nullptr ? processorXml->getIntAttribute("NodeId", 100 + i) : 100 + i;
+
+        GenericEditor* editor = (GenericEditor*) graph->createNewProcessor(description, nodeId);
+
+        if (editor == nullptr)
+        {
+            skippedProcessors.add(pluginName);
+            continue;
+        }
+
+        GenericProcessor* p = editor->getProcessor();
+        p->parametersAsXml = processorXml;
+
+        if (isSource)
+        {
+            source = (BenchmarkSource*) p;
+            source->setNumChannels(numChannels);
+            source->setSampleRate(sampleRate);
+            source->setInputFile(inputFile);
+            source->setMaxBlockSize(runBlockSize);
+        }
+        else
+            p->setSourceNode(processors.getLast());
+
+        processors.add(p);
+        updateProcessors();
+    }
+
+    if (settingsXml != nullptr)
+    {
+        if (XmlElement* timestampXml = settingsXml->getChildByName("GLOBAL_TIMESTAMP"))
+            graph->setSyncLine(timestampXml->getIntAttribute("sync_line", -1));
+    }
+
+    graph->restoreParameters();
+
+    // once more, so each processor sees the channels its source made from its parameters
+    updateProcessors();
+
+    return source != nullptr;
+}
+
+void HeadlessChain::updateProcessors()
+{
+    for (int i = 0; i < processors.size(); i++)
+        processors[i]->update();
+}
+
+void HeadlessChain::connectRecordNode()
+{
+    recordNode->resetConnections();
+
+    recordChannelOffsets.clearQuick();
+    numRecordChannels = 0;
+
+    for (int i = 0; i < processors.size(); i++)
+    {
+        GenericProcessor* p = processors[i];
+
+        if (p->isSink() || p->isSplitter() || p->isMerger() || p->isUtility())
+        {
+            recordChannelOffsets.add(-1);
+            continue;
+        }
+
+        recordNode->registerProcessor(p);
+        recordChannelOffsets.add(numRecordChannels);
+
+        for (int chan = 0; chan < p->getNumOutputs(); chan++)
+        {
+            recordNode->addInputChannel(p, chan);
+            recordNode->getNextChannel(true);
+            numRecordChannels++;
+        }
+
+        recordNode->addInputChannel(p, AudioProcessorGraph::midiChannelIndex);
+    }
+
+    Array<EventChannel*> extraChannels;
+    recordNode->addSpecialProcessorChannels(extraChannels);
+}
+
+bool HeadlessChain::run(double durationSecs, int blockSize)
+{
+    runBlockSize = jmax(1, blockSize);
+
+    if (! createProcessors())
+    {
+        std::cout << "The signal chain could not be created." << std::endl;
+        return false;
+    }
+
+    connectRecordNode();
+
+    int numBufferChannels = 1;
+
+    for (int i = 0; i < processors.size(); i++)
+        numBufferChannels = jmax(numBufferChannels, processors[i]->getNumInputs(), processors[i]->getNumOutputs());
+
+    buffer.setSize(numBufferChannels, runBlockSize);
+    recordBuffer.setSize(jmax(1, numRecordChannels), runBlockSize);
+    eventBuffer.ensureSize(1 << 16);
+
+    if (! graph->enableProcessors())
+        return false;
+
+    const File dataDirectory = File::getSpecialLocation(File::tempDirectory)
+                               .getNonexistentChildFile("open-ephys-benchmark", String());
+    dataDirectory.createDirectory();
+    recordNode->setDataDirectory(dataDirectory);
+
+    if (recordingEnabled)
+        graph->setRecordState(true);
+
+    stageSeconds.clearQuick();
+    stageSeconds.insertMultiple(0, 0.0, processors.size() + 1);
+
+    latencyCounts.clearQuick();
+    latencyCounts.insertMultiple(0, 0, numLatencyBuckets);
+    numBlocks = 0;
+    maxBlockMicros = 0;
+
+    const double ticksPerSecond = (double) Time::getHighResolutionTicksPerSecond();
+    const int64 startTicks = Time::getHighResolutionTicks();
+    const int64 endTicks = startTicks + int64(durationSecs * ticksPerSecond);
+    const int recordStage = processors.size();
+
+    int64 sourceTicks = 0;
+    int64 nowTicks = startTicks;
+    samplesProcessed = 0;
+
+    while (nowTicks < endTicks)
+    {
+        source->generateBlock(runBlockSize);
+        eventBuffer.clear();
+
+        int64 stageStart = Time::getHighResolutionTicks();
+        sourceTicks += stageStart - nowTicks;
+
+        const int64 blockStart = stageStart;
+
+        for (int i = 0; i < processors.size(); i++)
+        {
+            // called the way the graph calls it, GenericProcessor hides it
+            AudioProcessor* p = processors[i];
+            p->processBlock(buffer, eventBuffer);
+
+            int64 stageEnd = Time::getHighResolutionTicks();
+            stageSeconds.getReference(i) += (stageEnd - stageStart) / ticksPerSecond;
+            stageStart = stageEnd;
+
+            // the graph hands the record node a copy of every processor's outputs
+            const int offset = recordChannelOffsets[i];
+
+            if (offset >= 0)
+            {
+                for (int chan = 0; chan < processors[i]->getNumOutputs(); chan++)
+                    recordBuffer.copyFrom(offset + chan, 0, buffer, chan, 0, runBlockSize);
+
+                stageEnd = Time::getHighResolutionTicks();
+                stageSeconds.getReference(recordStage) += (stageEnd - stageStart) / ticksPerSecond;
+                stageStart = stageEnd;
+            }
+        }
+
+        static_cast<AudioProcessor*>(recordNode)->processBlock(recordBuffer, eventBuffer);
+
+        const int64 blockEnd = Time::getHighResolutionTicks();
+        stageSeconds.getReference(recordStage) += (blockEnd - stageStart) / ticksPerSecond;
+
+        addBlockLatency(float((blockEnd - blockStart) * 1.0e6 / ticksPerSecond));
+        samplesProcessed += runBlockSize;
+        nowTicks = blockEnd;
+
+        if (recordingEnabled)
+        {
+            // the record thread writes at the rate it would during an acquisition
+            const int64 dueTicks = startTicks + int64(samplesProcessed / sampleRate * ticksPerSecond);
+            const int aheadMs = int((dueTicks - nowTicks) * 1000.0 / ticksPerSecond);
+
+            if (aheadMs > 0)
+            {
+                Thread::sleep(aheadMs);
+                nowTicks = Time::getHighResolutionTicks();
+            }
+        }
+    }
+
+    sourceSeconds = sourceTicks / ticksPerSecond;
+    elapsedSeconds = (nowTicks - startTicks) / ticksPerSecond;
+
+    if (recordingEnabled)
+        graph->setRecordState(false);
+
+    graph->disableProcessors();
+
+    Array<File> recordedFiles;
+    dataDirectory.findChildFiles(recordedFiles, File::findFiles, true);
+
+    bytesRecorded = 0;
+
+    for (int i = 0; i < recordedFiles.size(); i++)
+        bytesRecorded += recordedFiles[i].getSize();
+
+    dataDirectory.deleteRecursively();
+
+    return true;
+}
+
+double HeadlessChain::getRealTimeFactor() const
+{
+    double processingSeconds = 0;
+
+    for (int i = 0; i < stageSeconds.size(); i++)
+        processingSeconds += stageSeconds[i];
+
+    return (samplesProcessed / sampleRate) / jmax(1e-9, processingSeconds);
+}
+
+void HeadlessChain::printReport() const
+{
+    const double dataSeconds = samplesProcessed / sampleRate;
+    const double channelSamples = double(samplesProcessed) * numChannels;
+
+    std::cout << std::endl;
+    std::cout << numChannels << " channels at " << sampleRate << " Hz, blocks of " << runBlockSize << " samples, "
+              << (inputFile != File::nonexistent ? inputFile.getFileName() : String("synthetic data")) << std::endl;
+    std::cout << dataSeconds << " s of data in " << elapsedSeconds << " s ("
+              << sourceSeconds << " s producing the source data)" << std::endl;
+    std::cout << std::endl;
+
+    for (int i = 0; i < stageSeconds.size(); i++)
+    {
+        const double seconds = stageSeconds[i];
+        const GenericProcessor* p = i < processors.size() ? processors[i] : (const GenericProcessor*) recordNode;
+
+        std::cout << "  " << p->getName().paddedRight(' ', 18)
+                  << String(channelSamples / jmax(1e-9, seconds) / 1.0e6, 1).paddedLeft(' ', 10) << " M ch-samples/s"
+                  << String(dataSeconds / jmax(1e-9, seconds), 1).paddedLeft(' ', 10) << "x real time" << std::endl;
+    }
+
+    for (int i = 0; i < skippedProcessors.size(); i++)
+        std::cout << "  " << skippedProcessors[i].paddedRight(' ', 18) << "   skipped, not available headless" << std::endl;
+
+    const double realTimeFactor = getRealTimeFactor();
+
+    std::cout << std::endl;
+    std::cout << "Chain: " << String(channelSamples * realTimeFactor / jmax(1e-9, dataSeconds) / 1.0e6, 1)
+              << " M ch-samples/s, " << String(realTimeFactor, 2) << "x real time" << std::endl;
+
+    if (numBlocks > 0)
+    {
+        const double budget = runBlockSize * 1.0e6 / sampleRate;
+
+        // the percentiles are bucket edges, so they are within about 4%
+        std::cout << "Block latency (us): p50 " << getBlockLatencyPercentile(0.5)
+                  << ", p90 " << getBlockLatencyPercentile(0.9)
+                  << ", p99 " << getBlockLatencyPercentile(0.99)
+                  << ", max " << maxBlockMicros
+                  << " (block duration " << budget << ")" << std::endl;
+    }
+
+    if (recordingEnabled)
+        std::cout << "Recorded " << String(bytesRecorded / (1024.0 * 1024.0), 1) << " MB in the "
+                  << recordEngineManager->getName() << " format" << std::endl;
+
+#if JUCE_LINUX || JUCE_MAC
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+       #if JUCE_MAC
+        const double peakMB = usage.ru_maxrss / (1024.0 * 1024.0); // bytes
+       #else
+        const double peakMB = usage.ru_maxrss / 1024.0;            // kilobytes
+       #endif
+
+        std::cout << "Peak memory: " << String(peakMB, 1) << " MB" << std::endl;
+    }
+#endif
+}
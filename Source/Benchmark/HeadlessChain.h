@@ -0,0 +1,152 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef HEADLESSCHAIN_H_INCLUDED
+#define HEADLESSCHAIN_H_INCLUDED
+
+#include <BasicJuceHeader.h>
+
+class ProcessorGraph;
+class ControlPanel;
+class EditorViewport;
+class AudioComponent;
+class GenericProcessor;
+class RecordNode;
+class BenchmarkSource;
+class RecordEngineManager;
+
+/**
+    Runs the processors of a saved signal chain without the GUI and reports how
+    long each of them took.
+
+    The chain is read from a .settings.xml file and built from the same classes
+    the GUI uses, with the editors and the rest of the GUI replaced by the
+    stand-ins in HeadlessStubs.cpp. The source is replaced by a BenchmarkSource,
+    which plays synthetic data or a raw interleaved int16 file. Every processor
+    is connected to the record node, as the ProcessorGraph does, and when
+    recording is on the data is written by the record thread to a temporary
+    directory. Processors the benchmark can't create are listed and skipped.
+
+    @see BenchmarkSource, HeadlessStubs
+*/
+class HeadlessChain
+{
+public:
+    HeadlessChain();
+    ~HeadlessChain();
+
+    /** Reads the first signal chain of a settings file. Returns false, after
+        printing why, if the file can't be used. */
+    bool loadSettings (const File& settingsFile);
+
+    /** Overrides the channel count and sample rate found in the settings file. */
+    void setNumChannels (int numChannels);
+    void setSampleRate (float sampleRate);
+
+    int getNumChannels() const;
+    float getSampleRate() const;
+
+    /** Plays a raw interleaved int16 file, e.g. a continuous.dat from a binary
+        recording, instead of synthetic data. */
+    void setInputFile (const File& file);
+
+    void setRecordingEnabled (bool shouldRecord);
+
+    /** Processes blocks of blockSize samples for durationSecs of wall-clock time.
+        While recording, blocks are paced to real time so the record thread sees
+        the data rate of an acquisition; otherwise they run as fast as possible.
+        Returns false if the chain could not be prepared. */
+    bool run (double durationSecs, int blockSize);
+
+    void printReport() const;
+
+    /** How many times faster than real time the whole chain ran. */
+    double getRealTimeFactor() const;
+
+    int getDefaultBlockSize() const;
+
+private:
+    /** Creates the processors of the signal chain and links them in order, as
+        EditorViewport::loadState() does, then restores their parameters. */
+    bool createProcessors();
+
+    /** Updates every processor in order, as the signal chain manager does after
+        each change to the chain. */
+    void updateProcessors();
+
+    /** Registers every output of the chain with the record node, as
+        ProcessorGraph::connectProcessorToAudioAndRecordNodes() does. */
+    void connectRecordNode();
+
+    /** Adds a block's processing time to latencyCounts, which is allocated
+        before the run, so nothing is allocated in the timed loop. */
+    void addBlockLatency (float micros);
+
+    /** The upper edge of the latencyCounts bucket the given fraction of the
+        blocks fall into. */
+    float getBlockLatencyPercentile (double fraction) const;
+
+    ScopedPointer<XmlElement> settingsXml; // the processors' parametersAsXml point into it
+    File settingsFile;
+    StringArray skippedProcessors;
+
+    int numChannels;
+    float sampleRate;
+    int defaultBlockSize;
+    bool recordingEnabled;
+    File inputFile;
+
+    ScopedPointer<AudioComponent> audioComponent;
+    ScopedPointer<ProcessorGraph> graph;
+    ScopedPointer<ControlPanel> controlPanel;
+    ScopedPointer<EditorViewport> editorViewport;
+    ScopedPointer<RecordEngineManager> recordEngineManager;
+
+    // owned by the graph
+    BenchmarkSource* source;
+    RecordNode* recordNode;
+    Array<GenericProcessor*> processors; // in chain order, starting with the source
+
+    Array<int> recordChannelOffsets; // the record node's channel for each processor's first output, or -1
+    int numRecordChannels;
+
+    AudioSampleBuffer buffer;
+    AudioSampleBuffer recordBuffer;
+    MidiBuffer eventBuffer;
+
+    // results of the last run
+    Array<double> stageSeconds; // one per processor, then the record node
+    Array<int64> latencyCounts; // log-spaced buckets, see addBlockLatency()
+    int64 numBlocks;
+    float maxBlockMicros;
+    double sourceSeconds;
+    double elapsedSeconds;
+    int64 samplesProcessed;
+    int64 bytesRecorded;
+    int runBlockSize;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (HeadlessChain);
+};
+
+
+#endif  // HEADLESSCHAIN_H_INCLUDED
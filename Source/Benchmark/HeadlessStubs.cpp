@@ -0,0 +1,634 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "HeadlessStubs.h"
+#include "BenchmarkSource.h"
+
+#include "../AccessClass.h"
+#include "../CoreServices.h"
+#include "../Audio/AudioComponent.h"
+#include "../UI/ControlPanel.h"
+#include "../UI/EditorViewport.h"
+#include "../UI/SignalChainManager.h"
+#include "../Processors/ProcessorGraph/ProcessorGraph.h"
+#include "../Processors/RecordNode/RecordNode.h"
+#include "../Processors/PluginManager/PluginClass.h"
+
+#include "../Plugins/FilterNode/FilterNode.h"
+#include "../Plugins/FilterNode/FilterEditor.h"
+#include "../Plugins/BasicSpikeDisplay/SpikeDetector/SpikeDetector.h"
+#include "../Plugins/BasicSpikeDisplay/SpikeDetector/SpikeDetectorEditor.h"
+#include "../Plugins/PhaseDetector/PhaseDetector.h"
+#include "../Plugins/PhaseDetector/PhaseDetectorEditor.h"
+
+namespace
+{
+ProcessorGraph* pg = nullptr;
+ControlPanel* cp = nullptr;
+EditorViewport* ev = nullptr;
+AudioComponent* ac = nullptr;
+
+// the AudioComponent has no device to keep it in
+int bufferSize = 1024;
+}
+
+void HeadlessStubs::setComponents(ProcessorGraph* graph,
+                                  ControlPanel* controlPanel,
+                                  EditorViewport* editorViewport,
+                                  AudioComponent* audioComponent)
+{
+    pg = graph;
+    cp = controlPanel;
+    ev = editorViewport;
+    ac = audioComponent;
+}
+
+//==============================================================================
+// AccessClass and CoreServices
+
+ProcessorGraph* AccessClass::getProcessorGraph()    { return pg; }
+ControlPanel* AccessClass::getControlPanel()        { return cp; }
+EditorViewport* AccessClass::getEditorViewport()    { return ev; }
+AudioComponent* AccessClass::getAudioComponent()    { return ac; }
+
+void CoreServices::setRecordingStatus(bool enable)
+{
+    pg->setRecordState(enable);
+}
+
+void CoreServices::sendStatusMessage(const String& text)
+{
+    std::cout << text << std::endl;
+}
+
+void CoreServices::sendStatusMessage(const char* text)
+{
+    std::cout << text << std::endl;
+}
+
+float CoreServices::getGlobalSampleRate()
+{
+    return pg->getGlobalSampleRate(false);
+}
+
+//==============================================================================
+// PluginClass: the benchmark creates its processors directly, not from libraries
+
+PluginClass::PluginClass()
+    : pluginType(Plugin::NOT_A_PLUGIN_TYPE),
+      libVersion(-1),
+      pluginIndex(-1)
+{
+}
+
+PluginClass::~PluginClass()
+{
+}
+
+//==============================================================================
+// ProcessorGraph: holds the processors and the record node, but the benchmark
+// moves the data itself, so there are no connections, audio node or message center
+
+ProcessorGraph::ProcessorGraph() : currentNodeId(100)
+{
+}
+
+ProcessorGraph::~ProcessorGraph()
+{
+}
+
+void ProcessorGraph::createDefaultNodes()
+{
+    RecordNode* recn = new RecordNode();
+    recn->setNodeId(RECORD_NODE_ID);
+
+    addNode(recn, RECORD_NODE_ID);
+}
+
+void* ProcessorGraph::createNewProcessor(Array<var>& description, int id)
+{
+    GenericProcessor* processor = createProcessorFromDescription(description);
+
+    if (processor == nullptr)
+        return nullptr;
+
+    processor->setNodeId(id);
+    addNode(processor, id);
+
+    if (processor->isSource())
+    {
+        processor->setAllChannelsToRecord();
+
+        if (processor->isGeneratesTimestamps())
+        {
+            m_validTimestampSources.add(processor);
+
+            if (m_timestampSource == nullptr)
+            {
+                m_timestampSource = processor;
+                m_timestampSourceSubIdx = 0;
+            }
+        }
+    }
+
+    return processor->createEditor();
+}
+
+GenericProcessor* ProcessorGraph::createProcessorFromDescription(Array<var>& description)
+{
+    const String processorName = description[1];
+    const bool isSource = description[6];
+
+    // whatever the source was, the benchmark plays its own data in its place
+    if (isSource)
+        return new BenchmarkSource();
+
+    if (processorName == "Bandpass Filter")
+        return new FilterNode();
+
+    if (processorName == "Spike Detector")
+        return new SpikeDetector();
+
+    if (processorName == "Phase Detector")
+        return new PhaseDetector();
+
+    return nullptr;
+}
+
+void ProcessorGraph::changeListenerCallback(ChangeBroadcaster*)
+{
+}
+
+void ProcessorGraph::restoreParameters()
+{
+    for (int i = 0; i < getNumNodes(); i++)
+    {
+        Node* node = getNode(i);
+
+        if (node->nodeId != RECORD_NODE_ID)
+        {
+            GenericProcessor* p = (GenericProcessor*) node->getProcessor();
+            p->loadFromXml();
+        }
+    }
+}
+
+bool ProcessorGraph::enableProcessors()
+{
+    for (int i = 0; i < getNumNodes(); i++)
+    {
+        GenericProcessor* p = (GenericProcessor*) getNode(i)->getProcessor();
+
+        if (! p->isReady())
+        {
+            std::cout << p->getName() << " said it's not OK." << std::endl;
+            return false;
+        }
+    }
+
+    for (int i = 0; i < getNumNodes(); i++)
+    {
+        GenericProcessor* p = (GenericProcessor*) getNode(i)->getProcessor();
+
+        p->enableEditor();
+
+        if (! p->enableProcessor())
+        {
+            std::cout << p->getName() << " could not be enabled." << std::endl;
+            return false;
+        }
+    }
+
+    getRecordNode()->updateRecordChannelIndexes();
+
+    m_startSoftTimestamp = Time::getHighResolutionTicks();
+    return true;
+}
+
+bool ProcessorGraph::disableProcessors()
+{
+    bool allClear = true;
+
+    for (int i = 0; i < getNumNodes(); i++)
+    {
+        GenericProcessor* p = (GenericProcessor*) getNode(i)->getProcessor();
+
+        p->disableEditor();
+        allClear = p->disableProcessor() && allClear;
+    }
+
+    return allClear;
+}
+
+void ProcessorGraph::setRecordState(bool isRecording)
+{
+    getRecordNode()->setParameter(isRecording ? 1 : 0, 10.0f);
+
+    for (int i = 0; i < getNumNodes(); i++)
+        ((GenericProcessor*) getNode(i)->getProcessor())->setRecording(isRecording);
+}
+
+SourceNode* ProcessorGraph::getSourceNode()
+{
+    // the benchmark's source is not a SourceNode; only BinaryRecording asks for it
+    return nullptr;
+}
+
+RecordNode* ProcessorGraph::getRecordNode()
+{
+    Node* node = getNodeForId(RECORD_NODE_ID);
+    return (RecordNode*) node->getProcessor();
+}
+
+void ProcessorGraph::getTimestampSources(Array<const GenericProcessor*>& validSources, int& selectedSource, int& selectedSubId) const
+{
+    validSources = m_validTimestampSources;
+    getTimestampSources(selectedSource, selectedSubId);
+}
+
+void ProcessorGraph::getTimestampSources(int& selectedSource, int& selectedSubId) const
+{
+    if (m_timestampSource)
+        selectedSource = m_validTimestampSources.indexOf(m_timestampSource);
+    else
+        selectedSource = -1;
+    selectedSubId = m_timestampSourceSubIdx;
+}
+
+float ProcessorGraph::getGlobalSampleRate(bool softwareOnly) const
+{
+    if (softwareOnly || !m_timestampSource)
+        return Time::getHighResolutionTicksPerSecond();
+    else
+        return m_timestampSource->getSampleRate(m_timestampSourceSubIdx);
+}
+
+void ProcessorGraph::setSyncLine(int line)
+{
+    m_syncLine = line;
+}
+
+int ProcessorGraph::getSyncLine() const
+{
+    return m_syncLine;
+}
+
+//==============================================================================
+// ControlPanel: only the base name of the recording directory is kept
+
+ControlPanel::ControlPanel(ProcessorGraph* graph_, AudioComponent* audio_)
+    : graph(graph_),
+      audio(audio_),
+      audioEditor(nullptr),
+      initialize(false),
+      open(false),
+      lastEngineIndex(-1)
+{
+    baseNameText = new Label("Base name", "");
+}
+
+ControlPanel::~ControlPanel()
+{
+}
+
+String ControlPanel::getBaseName()
+{
+    return baseNameText->getText();
+}
+
+void ControlPanel::setBaseName(String t)
+{
+    baseNameText->setText(t, dontSendNotification);
+}
+
+void ControlPanel::paint(Graphics&) {}
+void ControlPanel::resized() {}
+void ControlPanel::buttonClicked(Button*) {}
+void ControlPanel::comboBoxChanged(ComboBox*) {}
+void ControlPanel::labelTextChanged(Label*) {}
+void ControlPanel::timerCallback() {}
+bool ControlPanel::keyPressed(const KeyPress&) { return false; }
+
+//==============================================================================
+// EditorViewport: the settings written with each recording are those of currentFile
+
+EditorViewport::EditorViewport()
+    : leftmostEditor(0),
+      somethingIsBeingDraggedOver(false),
+      shiftDown(false),
+      canEdit(true),
+      lastEditor(nullptr),
+      lastEditorClicked(nullptr),
+      editorToUpdate(nullptr),
+      selectionIndex(0),
+      borderSize(6),
+      tabSize(30),
+      tabButtonSize(15),
+      insertionPoint(0),
+      componentWantsToMove(false),
+      indexOfMovingComponent(-1),
+      currentTab(-1),
+      leftButton(nullptr),
+      rightButton(nullptr),
+      upButton(nullptr),
+      downButton(nullptr),
+      currentId(100),
+      maxId(100)
+{
+}
+
+EditorViewport::~EditorViewport()
+{
+}
+
+SignalChainManager::~SignalChainManager()
+{
+}
+
+XmlElement* EditorViewport::createSettingsXml()
+{
+    if (XmlElement* xml = XmlDocument::parse(currentFile))
+        return xml;
+
+    return new XmlElement("SETTINGS");
+}
+
+void EditorViewport::paint(Graphics&) {}
+void EditorViewport::resized() {}
+bool EditorViewport::isInterestedInDragSource(const SourceDetails&) { return false; }
+void EditorViewport::itemDragEnter(const SourceDetails&) {}
+void EditorViewport::itemDragMove(const SourceDetails&) {}
+void EditorViewport::itemDragExit(const SourceDetails&) {}
+void EditorViewport::itemDropped(const SourceDetails&) {}
+void EditorViewport::mouseDown(const MouseEvent&) {}
+void EditorViewport::mouseDrag(const MouseEvent&) {}
+void EditorViewport::mouseUp(const MouseEvent&) {}
+void EditorViewport::mouseExit(const MouseEvent&) {}
+bool EditorViewport::keyPressed(const KeyPress&) { return false; }
+void EditorViewport::buttonClicked(Button*) {}
+void EditorViewport::labelTextChanged(Label*) {}
+
+//==============================================================================
+// AudioComponent: no device is opened
+
+AudioComponent::AudioComponent() : isPlaying(false)
+{
+}
+
+AudioComponent::~AudioComponent()
+{
+}
+
+void AudioComponent::setBufferSize(int s)
+{
+    bufferSize = s;
+}
+
+int AudioComponent::getBufferSize()
+{
+    return bufferSize;
+}
+
+//==============================================================================
+// GenericEditor: no components. The record state of a channel lives in its
+// DataChannel, which is where the ChannelSelector's buttons put it.
+
+GenericEditor::GenericEditor(GenericProcessor* owner, bool)
+    : AudioProcessorEditor(owner),
+      desiredWidth(150),
+      nodeId(owner->getNodeId()),
+      isFading(false),
+      accumulator(0.0f),
+      acquisitionIsActive(false),
+      drawerButton(nullptr),
+      drawerWidth(170),
+      drawerOpen(false),
+      channelSelector(nullptr),
+      isSelected(false),
+      isEnabled(true),
+      isCollapsed(false),
+      isSplitOrMerge(false),
+      tNum(-1),
+      originalWidth(150),
+      name(owner->getName()),
+      displayName(owner->getName())
+{
+}
+
+GenericEditor::~GenericEditor()
+{
+}
+
+GenericProcessor* GenericEditor::getProcessor() const
+{
+    return (GenericProcessor*) getAudioProcessor();
+}
+
+void GenericEditor::update()
+{
+    updateSettings();
+}
+
+void GenericEditor::updateName()
+{
+    nodeId = getProcessor()->getNodeId();
+}
+
+void GenericEditor::editorStartAcquisition()
+{
+    startAcquisition();
+    acquisitionIsActive = true;
+}
+
+void GenericEditor::editorStopAcquisition()
+{
+    stopAcquisition();
+    acquisitionIsActive = false;
+}
+
+void GenericEditor::startRecording() {}
+void GenericEditor::stopRecording() {}
+void GenericEditor::updateParameterButtons(int) {}
+
+void GenericEditor::getChannelSelectionState(int chan, bool* p, bool* r, bool* a)
+{
+    const DataChannel* ch = getProcessor()->getDataChannel(chan);
+
+    *p = true;
+    *r = ch != nullptr && ch->getRecordState();
+    *a = false;
+}
+
+void GenericEditor::setChannelSelectionState(int chan, bool, bool r, bool)
+{
+    // one past the channel, as in the real editor
+    if (const DataChannel* ch = getProcessor()->getDataChannel(chan + 1))
+        const_cast<DataChannel*>(ch)->setRecordState(r);
+}
+
+void GenericEditor::saveEditorParameters(XmlElement* xml)
+{
+    xml->setAttribute("isCollapsed", isCollapsed);
+    xml->setAttribute("displayName", displayName);
+
+    saveCustomParameters(xml);
+}
+
+void GenericEditor::loadEditorParameters(XmlElement* xml)
+{
+    displayName = xml->getStringAttribute("displayName", name);
+
+    loadCustomParameters(xml);
+}
+
+void GenericEditor::paint(Graphics&) {}
+bool GenericEditor::keyPressed(const KeyPress&) { return false; }
+void GenericEditor::buttonClicked(Button*) {}
+void GenericEditor::resized() {}
+void GenericEditor::sliderValueChanged(Slider*) {}
+void GenericEditor::startAcquisition() {}
+void GenericEditor::stopAcquisition() {}
+int GenericEditor::getChannelDisplayNumber(int chan) const { return chan; }
+void GenericEditor::tabNumber(int t) { tNum = t; }
+void GenericEditor::switchSource(int) {}
+void GenericEditor::switchSource() {}
+void GenericEditor::switchDest() {}
+void GenericEditor::switchIO(int) {}
+int GenericEditor::getPathForEditor(GenericEditor*) { return -1; }
+void GenericEditor::buttonEvent(Button*) {}
+void GenericEditor::sliderEvent(Slider*) {}
+void GenericEditor::editorWasClicked() {}
+void GenericEditor::updateSettings() {}
+void GenericEditor::updateVisualizer() {}
+void GenericEditor::channelChanged(int, bool) {}
+void GenericEditor::saveCustomParameters(XmlElement*) {}
+void GenericEditor::loadCustomParameters(XmlElement*) {}
+void GenericEditor::collapsedStateChanged() {}
+Array<GenericEditor*> GenericEditor::getConnectedEditors() { return Array<GenericEditor*>(); }
+void GenericEditor::timerCallback() {}
+
+//==============================================================================
+// FilterEditor: the cut-offs are the processor's parameters, only ApplyToADC
+// is set through the editor
+
+FilterEditor::FilterEditor(GenericProcessor* parentNode, bool useDefaultParameterEditors)
+    : GenericEditor(parentNode, useDefaultParameterEditors)
+{
+}
+
+FilterEditor::~FilterEditor()
+{
+}
+
+void FilterEditor::loadCustomParameters(XmlElement* xml)
+{
+    forEachXmlChildElementWithTagName(*xml, xmlNode, "VALUES")
+        ((FilterNode*) getProcessor())->setApplyOnADC(xmlNode->getBoolAttribute("ApplyToADC", false));
+}
+
+void FilterEditor::setDefaults(double, double) {}
+void FilterEditor::buttonEvent(Button*) {}
+void FilterEditor::labelTextChanged(Label*) {}
+void FilterEditor::saveCustomParameters(XmlElement*) {}
+void FilterEditor::channelChanged(int, bool) {}
+
+//==============================================================================
+// SpikeDetectorEditor: electrodes go straight to the processor
+
+SpikeDetectorEditor::SpikeDetectorEditor(GenericProcessor* parentNode, bool useDefaultParameterEditors)
+    : GenericEditor(parentNode, useDefaultParameterEditors),
+      electrodeTypes(nullptr),
+      electrodeList(nullptr),
+      numElectrodes(nullptr),
+      thresholdLabel(nullptr),
+      upButton(nullptr),
+      downButton(nullptr),
+      plusButton(nullptr),
+      thresholdSlider(nullptr),
+      lastId(0),
+      isPlural(true)
+{
+}
+
+SpikeDetectorEditor::~SpikeDetectorEditor()
+{
+}
+
+bool SpikeDetectorEditor::addElectrode(int nChans, int electrodeID)
+{
+    return ((SpikeDetector*) getProcessor())->addElectrode(nChans, electrodeID);
+}
+
+void SpikeDetectorEditor::checkSettings() {}
+void SpikeDetectorEditor::refreshElectrodeList() {}
+void SpikeDetectorEditor::buttonEvent(Button*) {}
+void SpikeDetectorEditor::labelTextChanged(Label*) {}
+void SpikeDetectorEditor::comboBoxChanged(ComboBox*) {}
+void SpikeDetectorEditor::sliderEvent(Slider*) {}
+void SpikeDetectorEditor::channelChanged(int, bool) {}
+
+//==============================================================================
+// PhaseDetectorEditor: makes the same calls on the processor as its
+// DetectorInterfaces do
+
+PhaseDetectorEditor::PhaseDetectorEditor(GenericProcessor* parentNode, bool useDefaultParameterEditors)
+    : GenericEditor(parentNode, useDefaultParameterEditors),
+      previousChannelCount(-1)
+{
+    // the editor starts with one detector
+    ((PhaseDetector*) parentNode)->addModule();
+}
+
+PhaseDetectorEditor::~PhaseDetectorEditor()
+{
+}
+
+void PhaseDetectorEditor::loadCustomParameters(XmlElement* xml)
+{
+    PhaseDetector* pd = (PhaseDetector*) getProcessor();
+    int i = 0;
+
+    forEachXmlChildElementWithTagName(*xml, xmlNode, "DETECTOR")
+    {
+        if (i > 0)
+            pd->addModule();
+
+        pd->setActiveModule(i);
+        pd->setParameter(1, (float) xmlNode->getIntAttribute("PHASE") + 1);
+        pd->setParameter(2, (float) xmlNode->getIntAttribute("INPUT"));
+        pd->setParameter(4, (float) xmlNode->getIntAttribute("GATE"));
+        pd->setParameter(3, (float) xmlNode->getIntAttribute("OUTPUT"));
+
+        pd->setActiveModule(i);
+        pd->setParameter(5, (float) xmlNode->getDoubleAttribute("LEAD", 0.0));
+
+        i++;
+    }
+}
+
+void PhaseDetectorEditor::buttonEvent(Button*) {}
+void PhaseDetectorEditor::comboBoxChanged(ComboBox*) {}
+void PhaseDetectorEditor::updateSettings() {}
+void PhaseDetectorEditor::saveCustomParameters(XmlElement*) {}
+void PhaseDetectorEditor::startAcquisition() {}
+void PhaseDetectorEditor::stopAcquisition() {}
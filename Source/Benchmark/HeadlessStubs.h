@@ -0,0 +1,54 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef HEADLESSSTUBS_H_INCLUDED
+#define HEADLESSSTUBS_H_INCLUDED
+
+class ProcessorGraph;
+class ControlPanel;
+class EditorViewport;
+class AudioComponent;
+
+/**
+    The benchmark links the real processors and record node, which reach the rest
+    of the application through AccessClass, CoreServices and their editors.
+
+    HeadlessStubs.cpp defines those for a process without windows: AccessClass
+    returns the objects set here, the ProcessorGraph only creates the processors
+    the benchmark knows and never connects them (HeadlessChain moves the data),
+    and the editors keep none of their components, only what they pass on to
+    their processors when a settings file is loaded.
+
+    @see HeadlessChain
+*/
+namespace HeadlessStubs
+{
+    /** Sets what AccessClass returns. The objects are not owned. */
+    void setComponents (ProcessorGraph* graph,
+                        ControlPanel* controlPanel,
+                        EditorViewport* editorViewport,
+                        AudioComponent* audioComponent);
+}
+
+
+#endif  // HEADLESSSTUBS_H_INCLUDED
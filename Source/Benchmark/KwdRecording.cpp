@@ -0,0 +1,144 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <H5Cpp.h>
+#include "KwdRecording.h"
+
+using namespace H5;
+
+// what the files say when channel_bit_volts can't be read, see BenchmarkSource
+static const float defaultBitVolts = 0.195f;
+
+KwdRecording::KwdRecording()
+    : numChannels(0),
+      numSamples(0),
+      sampleRate(0.0f)
+{
+    Exception::dontPrint();
+}
+
+KwdRecording::~KwdRecording()
+{
+}
+
+bool KwdRecording::load(const File& file)
+{
+    numChannels = 0;
+    numSamples = 0;
+    bitVolts.clear();
+
+    if (! file.existsAsFile())
+    {
+        std::cout << "Can't find " << file.getFullPathName() << std::endl;
+        return false;
+    }
+
+    try
+    {
+        H5File h5(file.getFullPathName().toUTF8(), H5F_ACC_RDONLY);
+
+        Group recording = h5.openGroup("/recordings/0");
+        recording.openAttribute("sample_rate").read(PredType::NATIVE_FLOAT, &sampleRate);
+
+        DataSet dataSet = h5.openDataSet("/recordings/0/data");
+        DataSpace space = dataSet.getSpace();
+
+        hsize_t dims[2] = { 0, 0 };
+
+        if (space.getSimpleExtentNdims() != 2)
+        {
+            std::cout << file.getFileName() << " has no two-dimensional data set." << std::endl;
+            return false;
+        }
+
+        space.getSimpleExtentDims(dims);
+        numSamples = (int) dims[0];
+        numChannels = (int) dims[1];
+
+        data.malloc((size_t) numSamples * numChannels);
+        dataSet.read(data.getData(), PredType::NATIVE_INT16);
+
+        try
+        {
+            // stored as one variable-length array of floats
+            Attribute attribute = h5.openGroup("/recordings/0/application_data").openAttribute("channel_bit_volts");
+            VarLenType type(&PredType::NATIVE_FLOAT);
+            hvl_t values;
+            attribute.read(type, &values);
+
+            const float* v = static_cast<const float*>(values.p);
+
+            for (size_t i = 0; i < values.len; i++)
+                bitVolts.add(v[i]);
+
+            H5free_memory(values.p);
+        }
+        catch (const Exception&)
+        {
+            bitVolts.clear();
+        }
+    }
+    catch (const Exception& error)
+    {
+        std::cout << "Can't read " << file.getFileName() << ": " << error.getDetailMsg() << std::endl;
+        numChannels = 0;
+        numSamples = 0;
+        return false;
+    }
+
+    return true;
+}
+
+int KwdRecording::getNumChannels() const
+{
+    return numChannels;
+}
+
+int KwdRecording::getNumSamples() const
+{
+    return numSamples;
+}
+
+float KwdRecording::getSampleRate() const
+{
+    return sampleRate;
+}
+
+float KwdRecording::getBitVolts(int channel) const
+{
+    return isPositiveAndBelow(channel, bitVolts.size()) ? bitVolts[channel] : defaultBitVolts;
+}
+
+const int16* KwdRecording::getData() const
+{
+    return data;
+}
+
+void KwdRecording::getChannel(int channel, float* dest) const
+{
+    const float scale = getBitVolts(channel);
+    const int16* src = data + channel;
+
+    for (int i = 0; i < numSamples; i++)
+        dest[i] = src[i * numChannels] * scale;
+}
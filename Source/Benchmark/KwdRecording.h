@@ -0,0 +1,68 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef KWDRECORDING_H_INCLUDED
+#define KWDRECORDING_H_INCLUDED
+
+#include <BasicJuceHeader.h>
+
+/**
+    The continuous data of a .kwd file, such as the ones in Resources/DataFiles,
+    read into memory so the benchmarks can run on recorded signals.
+
+    Only the first recording in the file is read.
+*/
+class KwdRecording
+{
+public:
+    KwdRecording();
+    ~KwdRecording();
+
+    /** Reads the file. Prints what went wrong and returns false if it can't. */
+    bool load (const File& file);
+
+    int getNumChannels() const;
+    int getNumSamples() const;
+    float getSampleRate() const;
+
+    /** Microvolts per bit of the given channel. */
+    float getBitVolts (int channel) const;
+
+    /** The samples as stored in the file, numSamples rows of numChannels. */
+    const int16* getData() const;
+
+    /** Copies one channel out, in microvolts. */
+    void getChannel (int channel, float* dest) const;
+
+private:
+    int numChannels;
+    int numSamples;
+    float sampleRate;
+    Array<float> bitVolts;
+    HeapBlock<int16> data;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (KwdRecording);
+};
+
+
+#endif  // KWDRECORDING_H_INCLUDED
@@ -154,6 +154,21 @@ int getRecordingNumber()
 	return getProcessorGraph()->getRecordNode()->getRecordingNumber();
 }
 
+void setRecordingStatusAt(bool enable, int64 timestamp, uint16 sourceNodeId, uint16 subProcessorIdx)
+{
+    getProcessorGraph()->getRecordNode()->setRecordingStatusAt(enable, timestamp, sourceNodeId, subProcessorIdx);
+}
+
+bool isRecordingRequested()
+{
+    return getProcessorGraph()->getRecordNode()->isRecordingRequested();
+}
+
+void setPreTriggerSeconds(float seconds)
+{
+    getProcessorGraph()->getRecordNode()->setPreTriggerSeconds(seconds);
+}
+
 void writeSpike(const SpikeEvent* spike, const SpikeChannel* chan)
 {
     getProcessorGraph()->getRecordNode()->writeSpike(spike, chan);
@@ -107,6 +107,18 @@ PLUGIN_API File getRecordingPath();
 PLUGIN_API String getBaseName();
 PLUGIN_API int getRecordingNumber();
 
+/** Starts or stops recording at a given sample of a source subprocessor. Unlike
+setRecordingStatus, this can be called from the audio thread: data is kept from
+(or up to) that sample, and the files are opened or closed shortly after. */
+PLUGIN_API void setRecordingStatusAt(bool enable, int64 timestamp, uint16 sourceNodeId, uint16 subProcessorIdx);
+
+/** Returns whether recording will be on once pending starts and stops take effect */
+PLUGIN_API bool isRecordingRequested();
+
+/** Sets how many seconds before each recording start are kept in it (0 for none).
+Applies until the signal chain is next rebuilt, so set it from enable(). */
+PLUGIN_API void setPreTriggerSeconds(float seconds);
+
 /* Spike related methods. See record engine documentation */
 
 PLUGIN_API void writeSpike(const SpikeEvent* spike, const SpikeChannel* chan);
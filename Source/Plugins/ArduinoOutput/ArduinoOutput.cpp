@@ -32,6 +32,9 @@ ArduinoOutput::ArduinoOutput()
     , outputChannel         (13)
     , inputChannel          (-1)
     , gateChannel           (-1)
+    , outputThread          ("Arduino Output", this)
+    , blockStartTime        (0)
+    , blockSize             (0)
     , state                 (true)
     , acquisitionIsActive   (false)
     , deviceSelected        (false)
@@ -42,6 +45,8 @@ ArduinoOutput::ArduinoOutput()
 
 ArduinoOutput::~ArduinoOutput()
 {
+    outputThread.stopOutput();
+
     if (arduino.isInitialized())
         arduino.disconnect();
 }
@@ -58,6 +63,17 @@ void ArduinoOutput::setDevice (String devName)
 {
     if (! acquisitionIsActive)
     {
+        if (devName == "Loopback test")
+        {
+            deviceSelected = outputThread.setLoopbackMode (true);
+            CoreServices::sendStatusMessage (deviceSelected ? "Arduino output looped back through a pty"
+                                                            : "Loopback test is not available");
+            return;
+        }
+
+        outputThread.setLoopbackMode (false);
+        deviceSelected = false;
+
         Time timer;
 
         arduino.connect (devName.toStdString());
@@ -124,20 +140,23 @@ void ArduinoOutput::handleEvent (const EventChannel* eventInfo, const MidiMessag
         {
             if (inputChannel == -1 || eventChannel == inputChannel)
             {
-                if (eventId == 0)
-                {
-                    arduino.sendDigital (outputChannel, ARD_LOW);
-                }
-                else
-                {
-                    arduino.sendDigital (outputChannel, ARD_HIGH);
-                }
+                outputThread.post (outputChannel,
+                                   eventId == 0 ? ARD_LOW : ARD_HIGH,
+                                   ttl->getTimestamp(),
+                                   SerialOutputThread::getDetectionTime (blockStartTime, sampleNum, blockSize,
+                                                                         eventInfo->getSampleRate()));
             }
         }
     }
 }
 
 
+void ArduinoOutput::fireSerialOutput (const SerialOutputThread::Command& command)
+{
+    arduino.sendDigital (command.channel, command.value);
+}
+
+
 void ArduinoOutput::setParameter (int parameterIndex, float newValue)
 {
     // make sure current output channel is off:
@@ -185,13 +204,25 @@ bool ArduinoOutput::enable()
 {
     acquisitionIsActive = true;
 
+    if (deviceSelected)
+    {
+        outputThread.resetLatencyStats();
+        outputThread.startOutput();
+    }
+
     return deviceSelected;
 }
 
 
 bool ArduinoOutput::disable()
 {
-    arduino.sendDigital (outputChannel, ARD_LOW);
+    outputThread.stopOutput();
+
+    if (outputThread.isLoopbackMode())
+        CoreServices::sendStatusMessage ("Arduino output latency: " + outputThread.getLatencySummary());
+    else
+        arduino.sendDigital (outputChannel, ARD_LOW);
+
     acquisitionIsActive = false;
 
     return true;
@@ -200,5 +231,8 @@ bool ArduinoOutput::disable()
 
 void ArduinoOutput::process (AudioSampleBuffer& buffer)
 {
-    checkForEvents ();
+    blockStartTime = Time::getMillisecondCounterHiRes();
+    blockSize = buffer.getNumSamples();
+
+    checkForEventLanes (TTL_EVENT_LANE);
 }
@@ -37,9 +37,15 @@
 
     Based on Open Frameworks ofArduino class.
 
-    @see GenericProcessor
+    Pin writes are posted to a SerialOutputThread rather than done on the audio
+    thread. Selecting the "Loopback test" device routes them through a
+    pseudo-terminal instead and reports detection-to-output latencies when
+    acquisition stops.
+
+    @see GenericProcessor, SerialOutputThread
  */
 class ArduinoOutput : public GenericProcessor
+                    , public SerialOutputThread::Target
 {
 public:
     ArduinoOutput();
@@ -70,6 +76,9 @@ public:
 
     void setDevice (String deviceString);
 
+    /** Writes the pin on the output thread. */
+    void fireSerialOutput (const SerialOutputThread::Command& command) override;
+
     int outputChannel;
     int inputChannel;
     int gateChannel;
@@ -79,6 +88,11 @@ private:
     /** An open-frameworks Arduino object. */
     ofArduino arduino;
 
+    SerialOutputThread outputThread;
+
+    double blockStartTime;
+    int blockSize;
+
     bool state;
     bool acquisitionIsActive;
     bool deviceSelected;
@@ -58,6 +58,8 @@ ArduinoOutputEditor::ArduinoOutputEditor(GenericProcessor* parentNode, bool useD
         deviceSelector->addItem(devices[i].getDevicePath(),i+2);
     }
 
+    deviceSelector->addItem("Loopback test",devices.size()+2);
+
     deviceSelector->setSelectedId(1, dontSendNotification);
     addAndMakeVisible(deviceSelector);
 
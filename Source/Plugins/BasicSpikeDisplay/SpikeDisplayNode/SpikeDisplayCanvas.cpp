@@ -66,7 +66,6 @@ SpikeDisplayCanvas::SpikeDisplayCanvas(SpikeDisplayNode* n) :
 
 SpikeDisplayCanvas::~SpikeDisplayCanvas()
 {
-    processor->removeSpikePlots();
 }
 
 void SpikeDisplayCanvas::beginAnimation()
@@ -90,7 +89,6 @@ void SpikeDisplayCanvas::update()
     int ninputs = processor->getNumInputs();
     //std::cout << "SpikeDisplayCanvas nplots " << nplots << std::endl;
     //std::cout << "SpikeDisplayCanvas ninputs " << ninputs << std::endl;
-    processor->removeSpikePlots();
     // this fails to update plot titles when chans are rearranged in chanmap:
     // if (nplots != spikeDisplay->getNumPlots())
     if (true)
@@ -110,19 +108,11 @@ void SpikeDisplayCanvas::update()
             String dataChanName = processor->getDataChannel(ploti)->getName();
             // label each spike plot according to datachan name - this obeys preceding chanmaps
             // and is simpler and more meaningful than processor->getNameForElectrode(i)):
-            SpikePlot* sp = spikeDisplay->addSpikePlot(nchans, ploti, dataChanName);
-            processor->addSpikePlotForElectrode(sp, ploti);
-        }
-    }
-    else
-    // mspacek: is this more efficient? if so, not sure how to easily check for change
-    // in chanmap that doesn't involve change in num chans
-    {
-        for (int ploti = 0; ploti < nplots; ploti++)
-        {
-            processor->addSpikePlotForElectrode(spikeDisplay->getSpikePlot(ploti), ploti);
+            spikeDisplay->addSpikePlot(nchans, ploti, dataChanName);
         }
     }
+    // mspacek: is reusing the existing plots more efficient? if so, not sure how to easily
+    // check for change in chanmap that doesn't involve change in num chans
     spikeDisplay->resized();
     spikeDisplay->repaint();
 }
@@ -156,17 +146,39 @@ void SpikeDisplayCanvas::paint(Graphics& g)
 
 void SpikeDisplayCanvas::refresh()
 {
+    // the axes repaint only the areas their rasterisers updated
     processSpikeEvents();
-
-    repaint();
 }
 
 
 void SpikeDisplayCanvas::processSpikeEvents()
 {
+    int nplots = jmin(processor->getNumElectrodes(), spikeDisplay->getNumPlots());
+
+    for (int i = 0; i < nplots; i++)
+    {
+        SpikePlot* plot = spikeDisplay->getSpikePlot(i);
+
+        // pass the plot thresholds on to the processor, which checks them in handleSpike()
+        for (int j = 0; j < plot->nChannels; j++)
+            processor->setDisplayThresholdForChannel(i, j, plot->getDisplayThresholdForChannel(j));
+
+        // drain the spikes queued on the audio thread since the last refresh
+        for (;;)
+        {
+            SpikeEventPtr spike = processor->popSpikeForElectrode(i);
+
+            if (spike == nullptr)
+                break;
+
+            plot->processSpikeObject(spike);
 
-    processor->setParameter(2, 0.0f); // request redraw
+            for (int j = 0; j < plot->nChannels; j++)
+                plot->setDetectorThresholdForChannel(j, spike->getThreshold(j));
+        }
 
+        plot->updateFrame();
+    }
 }
 
 bool SpikeDisplayCanvas::keyPressed(const KeyPress& key)
@@ -544,6 +556,15 @@ void SpikePlot::processSpikeObject(const SpikeEvent* s)
 
 }
 
+void SpikePlot::updateFrame()
+{
+    for (int i = 0; i < nWaveAx; i++)
+        wAxes[i]->updateFrame();
+
+    for (int i = 0; i < nProjAx; i++)
+        pAxes[i]->updateFrame();
+}
+
 void SpikePlot::select()
 {
     isSelected = true;
@@ -779,9 +800,6 @@ WaveAxes::WaveAxes(int channel) : GenericAxes(channel),
     drawGrid(true),
     displayThresholdLevel(0.0f),
     detectorThresholdLevel(0.0f),
-    spikesReceivedSinceLastRedraw(0),
-    spikeIndex(0),
-    bufferSize(5),
     range(250.0f),
     isOverThresholdSlider(false),
     isDraggingThresholdSlider(false),
@@ -796,10 +814,8 @@ WaveAxes::WaveAxes(int channel) : GenericAxes(channel),
 
     font = Font("Small Text",10,Font::plain);
 
-    for (int n = 0; n < bufferSize; n++)
-    {
-        spikeBuffer.add(nullptr);
-    }
+    raster.setDecay(0.9f);
+    raster.setFullScaleHits(6.0f);
 }
 
 void WaveAxes::setRange(float r)
@@ -809,6 +825,8 @@ void WaveAxes::setRange(float r)
 
     range = r;
 
+    raster.clear();
+
     repaint();
 }
 
@@ -824,92 +842,26 @@ void WaveAxes::paint(Graphics& g)
     if (drawGrid)
         drawWaveformGrid(g);
 
+    // the spikes are already rasterised, so this costs the same however many have arrived
+    if (gotFirstSpike)
+        g.drawImageAt(raster.getImage(), 0, 0);
+
     // draw the threshold line and labels
     drawThresholdSlider(g);
     //drawBoundingBox(g);
-
-    // if no spikes have been received then don't plot anything
-    if (!gotFirstSpike)
-    {
-        return;
-    }
-
-
-    for (int spikeNum = 0; spikeNum < bufferSize; spikeNum++)
-    {
-
-        if (spikeNum != spikeIndex)
-        {
-            g.setColour(Colours::grey);
-            plotSpike(spikeBuffer[spikeNum], g);
-        }
-
-    }
-
-    
-    plotSpike(spikeBuffer[spikeIndex], g);
-
-
-    spikesReceivedSinceLastRedraw = 0;
-
 }
 
-void WaveAxes::plotSpike(const SpikeEvent* s, Graphics& g)
+void WaveAxes::resized()
 {
-	if (!s) return;
-
-    float h = getHeight();
-
-    //compute the spatial width for each waveform sample
-	int nSamples = s->getChannelInfo()->getTotalSamples();
-	float dx = getWidth() / float(nSamples);
-
-    //TODO: check for special metadata for this
-	//if (s.sortedId > 0)
-    //   g.setColour(Colour(s.color[0],s.color[1],s.color[2]));
-    //else
-       g.setColour(Colours::white);
-
-    // type corresponds to channel so we need to calculate the starting
-    // sample based upon which channel is getting plotted
-    int sampIdx = nSamples*type; //spikeBuffer[0].nSamples * type; //
-
-    int dSamples = 1;
-
-    float x = 0.0f;
-	const float* data = s->getDataPointer();
-
-	for (int i = 0; i < nSamples - 1; i++)
-	{
-		//std::cout << s.data[sampIdx] << std::endl;
-
-
-
-		float s1, s2;
-
-		if (spikesInverted)
-		{
-			s1 = h / 2 + data[sampIdx] / range * h;
-			s2 = h / 2 + data[sampIdx + 1] / range * h;
-		}
-		else
-		{
-			s1 = h / 2 - data[sampIdx] / range * h;
-			s2 = h / 2 - data[sampIdx + 1] / range * h;
-
-		}
-		g.drawLine(x,
-			s1,
-			x + dx,
-			s2);
-
-
-
+    raster.setSize(getWidth(), getHeight());
+}
 
-		sampIdx += dSamples;
-		x += dx;
-	}
+void WaveAxes::updateFrame()
+{
+    Rectangle<int> area = raster.renderFrame();
 
+    if (!area.isEmpty())
+        repaint(area);
 }
 
 void WaveAxes::drawThresholdSlider(Graphics& g)
@@ -963,19 +915,14 @@ bool WaveAxes::updateSpikeData(const SpikeEvent* s)
         gotFirstSpike = true;
     }
 
-    if (spikesReceivedSinceLastRedraw < bufferSize)
-    {
-
-        SpikeEvent* newSpike = new SpikeEvent(*s);
-
-        spikeIndex++;
-        spikeIndex %= bufferSize;
-
-        spikeBuffer.set(spikeIndex, newSpike);
+    float h = getHeight();
 
-        spikesReceivedSinceLastRedraw++;
+    // type corresponds to channel so we need to calculate the starting
+    // sample based upon which channel is getting plotted
+    int nSamples = s->getChannelInfo()->getTotalSamples();
+    const float* data = s->getDataPointer() + nSamples*type;
 
-    }
+    raster.addWaveform(data, nSamples, h / 2, (spikesInverted ? h : -h) / range);
 
     return true;
 
@@ -1005,13 +952,7 @@ bool WaveAxes::checkThreshold(const SpikeEvent* s)
 void WaveAxes::clear()
 {
 
-    spikeBuffer.clear();
-    spikeIndex = 0;
-
-    for (int n = 0; n < bufferSize; n++)
-    {
-        spikeBuffer.add(nullptr);
-    }
+    raster.clear();
 
     repaint();
 }
@@ -1129,7 +1070,11 @@ float WaveAxes::getDisplayThreshold()
 
 void WaveAxes::setDetectorThreshold(float t)
 {
-    detectorThresholdLevel = t;
+    if (t != detectorThresholdLevel)
+    {
+        detectorThresholdLevel = t;
+        repaint();
+    }
 }
 
 void WaveAxes::registerThresholdCoordinator(SpikeThresholdCoordinator* stc)
@@ -1147,9 +1092,11 @@ void WaveAxes::setDisplayThreshold(float threshold)
 // --------------------------------------------------
 
 ProjectionAxes::ProjectionAxes(int projectionNum) : GenericAxes(projectionNum), imageDim(500),
-    rangeX(250), rangeY(250), spikesReceivedSinceLastRedraw(0)
+    rangeX(250), rangeY(250)
 {
-    projectionImage = Image(Image::RGB, imageDim, imageDim, true);
+    // projections accumulate until cleared, coloured by how many spikes land on each pixel
+    raster.setSize(imageDim, imageDim);
+    raster.setFullScaleHits(20.0f);
 
     clear();
     //Graphics g(projectionImage);
@@ -1176,11 +1123,36 @@ void ProjectionAxes::paint(Graphics& g)
     //g.setColour(Colours::orange);
     //g.fillRect(5,5,getWidth()-5, getHeight()-5);
 
-    g.drawImage(projectionImage,
+    g.fillAll(Colours::black);
+
+    g.drawImage(raster.getImage(),
                 0, 0, getWidth(), getHeight(),
                 0, imageDim-rangeY, rangeX, rangeY);
 }
 
+void ProjectionAxes::updateFrame()
+{
+    Rectangle<int> area = raster.renderFrame();
+
+    if (area.isEmpty() || rangeX <= 0 || rangeY <= 0)
+        return;
+
+    // map the updated image area onto the visible part of the image
+    float sx = getWidth() / float(rangeX);
+    float sy = getHeight() / float(rangeY);
+
+    Rectangle<float> visible(area.getX() * sx,
+                             (area.getY() - (imageDim - rangeY)) * sy,
+                             area.getWidth() * sx,
+                             area.getHeight() * sy);
+
+    Rectangle<int> dirty = visible.getSmallestIntegerContainer().expanded(1)
+                           .getIntersection(getLocalBounds());
+
+    if (!dirty.isEmpty())
+        repaint(dirty);
+}
+
 bool ProjectionAxes::updateSpikeData(const SpikeEvent* s)
 {
     if (!gotFirstSpike)
@@ -1191,25 +1163,16 @@ bool ProjectionAxes::updateSpikeData(const SpikeEvent* s)
     int idx1, idx2;
     calcWaveformPeakIdx(s, ampDim1, ampDim2, &idx1, &idx2);
 
-    // add peaks to image
-    Colour col;
-
-	//Again, fix this adding proper metadata check
-    //if (s.sortedId > 0)
-    //    col = Colour(s.color[0], s.color[1], s.color[2]);
-    //else
-        col = Colours::white;
-
+    // add peaks to image; colour now comes from the point density
+	//TODO: colour by sorted ID once it's available as proper metadata
 	const float* data = s->getDataPointer();
-    updateProjectionImage(data[idx1], data[idx2], 1, col);
+    updateProjectionImage(data[idx1], data[idx2], 1);
 
     return true;
 }
 
-void ProjectionAxes::updateProjectionImage(float x, float y, float gain, Colour col)
+void ProjectionAxes::updateProjectionImage(float x, float y, float gain)
 {
-    Graphics g(projectionImage);
-
     // h/2 + float(s.data[sampIdx]-32768)/float(*s.gain)*1000.0f / range * h;
 
     if (gain != 0)
@@ -1217,8 +1180,7 @@ void ProjectionAxes::updateProjectionImage(float x, float y, float gain, Colour
 		float xf = x;
         float yf = float(imageDim) - y; // in microvolts
 
-        g.setColour(col);
-        g.fillEllipse(xf,yf,2.0f,2.0f);
+        raster.addPoint(xf, yf, 2);
     }
 
 }
@@ -1250,8 +1212,7 @@ void ProjectionAxes::calcWaveformPeakIdx(const SpikeEvent* s, int d1, int d2, in
 
 void ProjectionAxes::clear()
 {
-    projectionImage.clear(Rectangle<int>(0, 0, projectionImage.getWidth(), projectionImage.getHeight()),
-                          Colours::black);
+    raster.clear();
 
     repaint();
 }
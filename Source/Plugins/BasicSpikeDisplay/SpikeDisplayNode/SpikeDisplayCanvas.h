@@ -27,6 +27,7 @@
 #include <VisualizerWindowHeaders.h>
 
 #include "SpikeDisplayNode.h"
+#include "SpikeRasteriser.h"
 
 #include <vector>
 
@@ -206,6 +207,9 @@ public:
 
     void processSpikeObject(const SpikeEvent* s);
 
+    /** Called once per canvas refresh to update the rasterised axes. */
+    void updateFrame();
+
     SpikeDisplayCanvas* canvas;
 
     bool isSelected;
@@ -282,6 +286,9 @@ public:
 
     virtual bool updateSpikeData(const SpikeEvent* s);
 
+    /** Renders the spikes received since the last frame and repaints the area that changed. */
+    virtual void updateFrame() {}
+
     void setXLims(double xmin, double xmax);
     void getXLims(double* xmin, double* xmax);
     void setYLims(double ymin, double ymax);
@@ -327,9 +334,10 @@ public:
     bool updateSpikeData(const SpikeEvent* s);
     bool checkThreshold(const SpikeEvent* spike);
 
-    void paint(Graphics& g);
+    void updateFrame();
 
-    void plotSpike(const SpikeEvent* s, Graphics& g);
+    void paint(Graphics& g);
+    void resized();
 
     void clear();
 
@@ -356,6 +364,7 @@ public:
     void invertSpikes(bool shouldInvert)
     {
         spikesInverted = shouldInvert;
+        raster.clear();
         repaint();
     }
 
@@ -374,14 +383,9 @@ private:
 
     void drawThresholdSlider(Graphics& g);
 
-    int spikesReceivedSinceLastRedraw;
-
     Font font;
 
-   OwnedArray<SpikeEvent> spikeBuffer;
-
-    int spikeIndex;
-    int bufferSize;
+    SpikeRasteriser raster;
 
     float range;
 
@@ -413,6 +417,8 @@ public:
 
     bool updateSpikeData(const SpikeEvent* s);
 
+    void updateFrame();
+
     void paint(Graphics& g);
 
     void clear();
@@ -423,13 +429,13 @@ public:
 
 private:
 
-    void updateProjectionImage(float, float, float, Colour);
+    void updateProjectionImage(float, float, float);
 
     void calcWaveformPeakIdx(const SpikeEvent*, int, int, int*, int*);
 
     int ampDim1, ampDim2;
 
-    Image projectionImage;
+    SpikeRasteriser raster;
 
     Colour pointColour;
     Colour gridColour;
@@ -439,8 +445,6 @@ private:
     int rangeX;
     int rangeY;
 
-    int spikesReceivedSinceLastRedraw;
-
 };
 
 class SpikeThresholdCoordinator
@@ -29,14 +29,29 @@
 
 SpikeDisplayNode::SpikeDisplayNode()
     : GenericProcessor  ("Spike Viewer")
-    , displayBufferSize (5)
-    ,  redrawRequested  (false)
     , isRecording       (false)
 {
     setProcessorType (PROCESSOR_TYPE_SINK);
 }
 
 
+SpikeDisplayNode::Electrode::Electrode (int nChans, size_t messageSize, size_t waveformSize_)
+    : numChannels       (nChans)
+    , recordIndex       (-1)
+    , displayThresholds (nChans)
+    , spikeFifo         (SPIKE_RING_SIZE)
+    , slotSize          (messageSize)
+    , waveformSize      (waveformSize_)
+    , bitVolts          (1.0f)
+{
+    for (int i = 0; i < nChans; ++i)
+        displayThresholds[i] = 0.0f;
+
+    spikeSlots.malloc (SPIKE_RING_SIZE * slotSize);
+    waveform.malloc (waveformSize);
+}
+
+
 SpikeDisplayNode::~SpikeDisplayNode()
 {
 }
@@ -57,18 +72,13 @@ void SpikeDisplayNode::updateSettings()
 	for (int i = 0; i < spikeChannelArray.size(); ++i)
 	{
 
-		Electrode* elec = new Electrode();
-		elec->numChannels = spikeChannelArray[i]->getNumChannels();
-		elec->bitVolts = spikeChannelArray[i]->getChannelBitVolts(0); //lets assume all channels have the same bitvolts
-		elec->name = spikeChannelArray[i]->getName();
-		elec->currentSpikeIndex = 0;
-		elec->mostRecentSpikes.ensureStorageAllocated(displayBufferSize);
+		const SpikeChannel* chan = spikeChannelArray[i];
+		int nChans = chan->getNumChannels();
+		size_t messageSize = SPIKE_BASE_SIZE + nChans * sizeof(float) + chan->getDataSize() + chan->getTotalEventMetaDataSize();
 
-		for (int j = 0; j < elec->numChannels; ++j)
-		{
-			elec->displayThresholds.add(0);
-			elec->detectorThresholds.add(0);
-		}
+		Electrode* elec = new Electrode(nChans, messageSize, chan->getDataSize() / sizeof(float));
+		elec->bitVolts = chan->getChannelBitVolts(0); //lets assume all channels have the same bitvolts
+		elec->name = chan->getName();
 
 		electrodes.add(elec);
 
@@ -86,6 +96,7 @@ bool SpikeDisplayNode::enable()
 	{
 		Electrode* elec = electrodes[i];
 		elec->recordIndex = CoreServices::RecordNode::addSpikeElectrode(spikeChannelArray[i]);
+		elec->spikeFifo.reset();
 	}
 
     editor->enable();
@@ -130,20 +141,36 @@ String SpikeDisplayNode::getNameForElectrode (int i) const
 }
 
 
-void SpikeDisplayNode::addSpikePlotForElectrode (SpikePlot* sp, int i)
+SpikeEventPtr SpikeDisplayNode::popSpikeForElectrode (int i)
 {
+    if (i < 0 || i >= electrodes.size())
+        return nullptr;
+
     Electrode* e = electrodes[i];
-    e->spikePlot = sp;
+
+    int start1, size1, start2, size2;
+    e->spikeFifo.prepareToRead (1, start1, size1, start2, size2);
+
+    if (size1 == 0)
+        return nullptr;
+
+    // the message is rebuilt here, on the message thread, so all allocation stays off the audio thread
+    MidiMessage message (e->spikeSlots + start1 * e->slotSize, (int) e->slotSize);
+    e->spikeFifo.finishedRead (1);
+
+    return SpikeEvent::deserializeFromMessage (message, spikeChannelArray[i]);
 }
 
 
-void SpikeDisplayNode::removeSpikePlots()
+void SpikeDisplayNode::setDisplayThresholdForChannel (int electrode, int chan, float threshold)
 {
-    for (int i = 0; i < getNumElectrodes(); ++i)
-    {
-        Electrode* e = electrodes[i];
-        e->spikePlot = nullptr;
-    }
+    if (electrode < 0 || electrode >= electrodes.size())
+        return;
+
+    Electrode* e = electrodes[electrode];
+
+    if (chan >= 0 && chan < e->numChannels)
+        e->displayThresholds[chan] = threshold;
 }
 
 
@@ -177,65 +204,40 @@ void SpikeDisplayNode::setParameter (int param, float val)
     {
         isRecording = true;
     }
-    else if (param == 2)   // redraw
-    {
-        redrawRequested = true;
-    }
 }
 
 
 void SpikeDisplayNode::process (AudioSampleBuffer& buffer)
 {
-    checkForEvents (true); // automatically calls 'handleEvent
-
-    if (redrawRequested)
-    {
-        // update incoming thresholds
-        for (int i = 0; i < getNumElectrodes(); ++i)
-        {
-            Electrode* e = electrodes[i];
-
-            // update thresholds
-            for (int j = 0; j < e->numChannels; ++j)
-            {
-                e->displayThresholds.set (j,
-                                         e->spikePlot->getDisplayThresholdForChannel (j));
-
-                e->spikePlot->setDetectorThresholdForChannel (j, e->detectorThresholds[j]);
-            }
-
-            // transfer buffered spikes to spike plot
-            for (int j = 0; j < e->currentSpikeIndex; ++j)
-            {
-                //std::cout << "Transferring spikes." << std::endl;
-                e->spikePlot->processSpikeObject (e->mostRecentSpikes[j]);
-                e->currentSpikeIndex = 0;
-            }
-        }
-
-        redrawRequested = false;
-    }
+    checkForEventLanes (SPIKE_EVENT_LANE); // automatically calls 'handleSpike
 }
 
 
 void SpikeDisplayNode::handleSpike(const SpikeChannel* spikeInfo, const MidiMessage& event, int samplePosition)
 {
-	SpikeEventPtr newSpike = SpikeEvent::deserializeFromMessage(event, spikeInfo);
-	if (!newSpike) return;
-
-	int electrodeNum = getSpikeChannelIndex(newSpike);
+	int electrodeNum = getSpikeChannelIndex(EventBase::getSourceIndex(event), EventBase::getSourceID(event), EventBase::getSubProcessorIdx(event));
+	if (electrodeNum < 0 || electrodeNum >= electrodes.size()) return;
 
 	Electrode* e = electrodes[electrodeNum];
-	// std::cout << electrodeNum << std::endl;
+
+	if (size_t(event.getRawDataSize()) != e->slotSize)
+	{
+		jassertfalse;
+		return;
+	}
+
+	// check the waveform without deserializing the spike; it is copied out because the
+	// message doesn't keep it aligned for floats
+	const uint8* raw = event.getRawData();
+	memcpy(e->waveform, raw + SPIKE_BASE_SIZE + e->numChannels * sizeof(float), e->waveformSize * sizeof(float));
+	const float* data = e->waveform;
+	int nSamples = spikeChannelArray[electrodeNum]->getTotalSamples();
 
 	bool aboveThreshold = false;
 
-	// update threshold / check threshold
 	for (int i = 0; i < e->numChannels; ++i)
 	{
-		e->detectorThresholds.set(i, float(newSpike->getThreshold(i))); // / float(newSpike.gain[i]));
-
-		aboveThreshold = aboveThreshold | checkThreshold(i, e->displayThresholds[i], newSpike);
+		aboveThreshold = aboveThreshold | checkThreshold(data + i * nSamples, nSamples, e->displayThresholds[i]);
 	}
 
 	if (aboveThreshold)
@@ -243,28 +245,29 @@ void SpikeDisplayNode::handleSpike(const SpikeChannel* spikeInfo, const MidiMess
 		// save spike
 		if (isRecording)
 		{
-			CoreServices::RecordNode::writeSpike(newSpike, spikeInfo);
+			SpikeEventPtr newSpike = SpikeEvent::deserializeFromMessage(event, spikeInfo);
+			if (newSpike)
+				CoreServices::RecordNode::writeSpike(newSpike, spikeInfo);
 		}
-		// add to buffer
-		if (e->currentSpikeIndex < displayBufferSize)
+
+		// add to the display ring; if the canvas isn't draining it the spike is dropped
+		int start1, size1, start2, size2;
+		e->spikeFifo.prepareToWrite(1, start1, size1, start2, size2);
+
+		if (size1 > 0)
 		{
-			//This releases the spike from the smart pointer to avoid copies, so it's done latest.
-			e->mostRecentSpikes.set(e->currentSpikeIndex, newSpike.release());
-			e->currentSpikeIndex++;
+			memcpy(e->spikeSlots + start1 * e->slotSize, raw, e->slotSize);
+			e->spikeFifo.finishedWrite(1);
 		}
-
-		
 	}
 }
 
 
-bool SpikeDisplayNode::checkThreshold (int chan, float thresh, SpikeEvent* s)
+bool SpikeDisplayNode::checkThreshold (const float* data, int nSamples, float thresh) const
 {
-	int nSamples = getSpikeChannel(getSpikeChannelIndex(s))->getTotalSamples();
-
     for (int i = 0; i < nSamples-1; ++i)
     {
-        if  (s->getDataPointer(chan)[i]  > thresh)
+        if  (data[i]  > thresh)
         {
             return true;
         }
@@ -27,13 +27,18 @@
 #include <ProcessorHeaders.h>
 #include "SpikeDisplayEditor.h"
 
+#include <atomic>
+#include <vector>
+
 class DataViewport;
-class SpikePlot;
+
+#define SPIKE_RING_SIZE 64
 
 
 /**
   Takes in MidiEvents and extracts SpikeObjects from the MidiEvent buffers.
-  Those Events are then held in a queue until they are pulled by the SpikeDisplayCanvas.
+  Those Events are then held in a per-electrode lock-free ring until they are pulled
+  by the SpikeDisplayCanvas on the message thread.
 
   @see GenericProcessor, SpikeDisplayEditor, SpikeDisplayCanvas
 */
@@ -63,36 +68,43 @@ public:
     int getNumberOfChannelsForElectrode (int i) const;
     int getNumElectrodes() const;
 
-    void addSpikePlotForElectrode (SpikePlot* sp, int i);
-    void removeSpikePlots();
+    /** Called by the canvas from the message thread. Returns the oldest spike queued
+        for electrode i, or nullptr if there are none. */
+    SpikeEventPtr popSpikeForElectrode (int i);
 
-    bool checkThreshold (int, float, SpikeEvent*);
+    /** Called by the canvas from the message thread to pass on the threshold set in the plot. */
+    void setDisplayThresholdForChannel (int electrode, int chan, float threshold);
+
+    bool checkThreshold (const float* data, int nSamples, float thresh) const;
 
 
 private:
     struct Electrode
     {
+        Electrode (int nChans, size_t messageSize, size_t waveformSize);
+
         String name;
 
         int numChannels;
         int recordIndex;
-        int currentSpikeIndex;
 
-        Array<float> displayThresholds;
-        Array<float> detectorThresholds;
+        // written by the message thread, read in handleSpike()
+        std::vector<std::atomic<float>> displayThresholds;
 
-        OwnedArray<SpikeEvent> mostRecentSpikes;
+        // fixed-size slots holding the serialized spike messages, so handleSpike() only copies bytes
+        AbstractFifo spikeFifo;
+        HeapBlock<uint8> spikeSlots;
+        size_t slotSize;
 
-		float bitVolts;
+        // the waveform of the spike being checked; in the message it is not aligned for floats
+        HeapBlock<float> waveform;
+        size_t waveformSize;
 
-        SpikePlot* spikePlot;
+		float bitVolts;
     };
 
     OwnedArray<Electrode> electrodes;
 
-    int displayBufferSize;
-    bool redrawRequested;
-
     // members for recording
     bool isRecording;
     //   bool signalFilesShouldClose;
@@ -0,0 +1,225 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SpikeRasteriser.h"
+
+SpikeRasteriser::SpikeRasteriser() :
+    width(0), height(0), decay(1.0f), fullScale(1.0f), paletteScale(255.0f)
+{
+    buildPalette();
+}
+
+SpikeRasteriser::~SpikeRasteriser()
+{
+}
+
+void SpikeRasteriser::setSize(int w, int h)
+{
+    w = jmax(w, 1);
+    h = jmax(h, 1);
+
+    if (w == width && h == height)
+        return;
+
+    width = w;
+    height = h;
+
+    density.calloc(width * height);
+    image = Image(Image::ARGB, width, height, true);
+
+    dirtyBounds = Rectangle<int>();
+    activeBounds = Rectangle<int>();
+}
+
+void SpikeRasteriser::setDecay(float decayPerFrame)
+{
+    decay = jlimit(0.0f, 1.0f, decayPerFrame);
+}
+
+void SpikeRasteriser::setFullScaleHits(float hits)
+{
+    fullScale = jmax(hits, 1.0f);
+    paletteScale = 255.0f / fullScale;
+}
+
+void SpikeRasteriser::buildPalette()
+{
+    // transparent -> blue -> cyan -> yellow -> white as the density increases
+    const Colour stops[] = { Colour(0, 60, 160), Colour(0, 200, 220), Colour(255, 230, 0), Colours::white };
+    const int numStops = 4;
+
+    palette[0] = Colours::transparentBlack.getPixelARGB();
+
+    for (int i = 1; i < 256; i++)
+    {
+        float pos = float(i - 1) / 254.0f * (numStops - 1);
+        int stop = jmin(int(pos), numStops - 2);
+
+        Colour c = stops[stop].interpolatedWith(stops[stop + 1], pos - stop);
+
+        // fade in the lowest densities so sparse traces don't cover the grid
+        float alpha = jmin(1.0f, 0.3f + float(i) / 32.0f);
+
+        palette[i] = c.withAlpha(alpha).getPixelARGB();
+    }
+}
+
+void SpikeRasteriser::clear()
+{
+    if (width == 0)
+        return;
+
+    density.clear(width * height);
+    image.clear(image.getBounds());
+
+    dirtyBounds = Rectangle<int>();
+    activeBounds = Rectangle<int>();
+}
+
+void SpikeRasteriser::addWaveform(const float* data, int numSamples, float yOffset, float yScale)
+{
+    if (width == 0 || numSamples < 2)
+        return;
+
+    float dx = width / float(numSamples);
+
+    int x1 = 0;
+    int y1 = roundFloatToInt(yOffset + yScale * data[0]);
+
+    for (int i = 1; i < numSamples; i++)
+    {
+        int x2 = roundFloatToInt(i * dx);
+        int y2 = roundFloatToInt(yOffset + yScale * data[i]);
+
+        addLine(x1, y1, x2, y2);
+
+        x1 = x2;
+        y1 = y2;
+    }
+}
+
+void SpikeRasteriser::addLine(int x1, int y1, int x2, int y2)
+{
+    int steps = jmax(std::abs(x2 - x1), std::abs(y2 - y1));
+
+    // the end pixel is left to the next segment, so shared vertices aren't counted twice
+    if (steps == 0)
+        steps = 1;
+
+    float xStep = float(x2 - x1) / steps;
+    float yStep = float(y2 - y1) / steps;
+
+    float x = float(x1);
+    float y = float(y1);
+
+    for (int i = 0; i < steps; i++)
+    {
+        int px = roundFloatToInt(x);
+        int py = roundFloatToInt(y);
+
+        if (px >= 0 && px < width && py >= 0 && py < height)
+            density[py * width + px] += 1.0f;
+
+        x += xStep;
+        y += yStep;
+    }
+
+    Rectangle<int> bounds = Rectangle<int>::leftTopRightBottom(jmin(x1, x2), jmin(y1, y2),
+                                                               jmax(x1, x2) + 1, jmax(y1, y2) + 1);
+
+    dirtyBounds = dirtyBounds.getUnion(bounds.getIntersection(image.getBounds()));
+}
+
+void SpikeRasteriser::addPoint(float x, float y, int size)
+{
+    if (width == 0)
+        return;
+
+    Rectangle<int> bounds = Rectangle<int>(roundFloatToInt(x), roundFloatToInt(y), size, size)
+                            .getIntersection(image.getBounds());
+
+    for (int py = bounds.getY(); py < bounds.getBottom(); py++)
+    {
+        float* row = density + py * width;
+
+        for (int px = bounds.getX(); px < bounds.getRight(); px++)
+            row[px] += 1.0f;
+    }
+
+    dirtyBounds = dirtyBounds.getUnion(bounds);
+}
+
+Rectangle<int> SpikeRasteriser::renderFrame()
+{
+    const bool decaying = decay < 1.0f && !activeBounds.isEmpty();
+
+    Rectangle<int> region = dirtyBounds;
+
+    if (decaying)
+        region = region.getUnion(activeBounds);
+
+    if (region.isEmpty())
+        return region;
+
+    // densities that would map to the first colour are dropped, so decayed areas end up empty
+    const float minimumDensity = 1.0f / paletteScale;
+    float peak = 0.0f;
+
+    Image::BitmapData bitmap(image, region.getX(), region.getY(), region.getWidth(), region.getHeight(),
+                             Image::BitmapData::writeOnly);
+
+    for (int y = 0; y < region.getHeight(); y++)
+    {
+        float* row = density + (region.getY() + y) * width + region.getX();
+        uint8* pixel = bitmap.getLinePointer(y);
+
+        for (int x = 0; x < region.getWidth(); x++)
+        {
+            float d = row[x];
+
+            if (decaying)
+            {
+                d *= decay;
+
+                if (d < minimumDensity)
+                    d = 0.0f;
+
+                row[x] = d;
+            }
+
+            peak = jmax(peak, d);
+
+            int index = d >= fullScale ? 255 : int(d * paletteScale);
+
+            *reinterpret_cast<PixelARGB*>(pixel) = palette[index];
+            pixel += bitmap.pixelStride;
+        }
+    }
+
+    if (decay < 1.0f)
+        activeBounds = peak > 0.0f ? region : Rectangle<int>();
+
+    dirtyBounds = Rectangle<int>();
+
+    return region;
+}
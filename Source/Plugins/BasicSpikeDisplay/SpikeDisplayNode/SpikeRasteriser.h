@@ -0,0 +1,101 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SPIKERASTERISER_H_
+#define SPIKERASTERISER_H_
+
+#include <BasicJuceHeader.h>
+
+/**
+
+  Software rasteriser for the spike waveform and projection plots.
+
+  Spikes are accumulated into a per-pixel density buffer as they arrive, instead
+  of being kept and redrawn with Graphics calls on every repaint. Once per frame
+  renderFrame() applies the persistence decay and converts the densities that
+  changed into colours in an ARGB image, returning the rectangle that needs to
+  be repainted. The cost of a frame therefore depends on the plot area, not on
+  the number of spikes received.
+
+  @see WaveAxes, ProjectionAxes
+
+*/
+
+class SpikeRasteriser
+{
+public:
+    SpikeRasteriser();
+    ~SpikeRasteriser();
+
+    /** Resizes the density buffer and image, clearing them. */
+    void setSize(int width, int height);
+
+    /** Fraction of the density kept from one frame to the next (1.0 keeps everything). */
+    void setDecay(float decayPerFrame);
+
+    /** Number of overlapping hits that map to the top of the colour scale. */
+    void setFullScaleHits(float hits);
+
+    void clear();
+
+    /** Adds a waveform as a polyline spread over the full width, with
+        y = yOffset + yScale * data[i]. */
+    void addWaveform(const float* data, int numSamples, float yOffset, float yScale);
+
+    /** Adds a square point of the given size, in pixels. */
+    void addPoint(float x, float y, int size);
+
+    /** Applies the decay and updates the image where it changed.
+        Returns the area to repaint, in image coordinates. */
+    Rectangle<int> renderFrame();
+
+    const Image& getImage() const
+    {
+        return image;
+    }
+
+private:
+    void addLine(int x1, int y1, int x2, int y2);
+    void buildPalette();
+
+    int width;
+    int height;
+
+    HeapBlock<float> density;
+    Image image;
+
+    PixelARGB palette[256];
+
+    float decay;
+    float fullScale;
+    float paletteScale;
+
+    // strokes added since the last frame, and the area still holding decaying density
+    Rectangle<int> dirtyBounds;
+    Rectangle<int> activeBounds;
+
+    JUCE_DECLARE_NON_COPYABLE(SpikeRasteriser);
+
+};
+
+#endif  // SPIKERASTERISER_H_
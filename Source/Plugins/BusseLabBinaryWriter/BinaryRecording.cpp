@@ -31,11 +31,12 @@ BinaryRecording::BinaryRecording()
 {
     m_scaledBuffer.malloc(MAX_BUFFER_SIZE);
     m_intBuffer.malloc(MAX_BUFFER_SIZE);
+    m_bufferSize = MAX_BUFFER_SIZE;
 }
 
 BinaryRecording::~BinaryRecording()
 {
-
+    m_lfpFile = nullptr; // the writer uses the thread pool
 }
 
 String BinaryRecording::getEngineID() const
@@ -216,15 +217,10 @@ void BinaryRecording::openFiles(File rootFolder, String baseName, int recordingN
     // write .dat metadata to .dat.json file:
     String jsonFileName = basepath;
     jsonFileName += getRecordingNumberString(recordingNumber) + ".dat.json";
-    File jsonf = File(jsonFileName);
-    Result res = jsonf.create();
-    if (res.failed())
-        std::cerr << "Error creating JSON file:" << res.getErrorMessage() << std::endl;
-    ScopedPointer<FileOutputStream> jsonFile = jsonf.createOutputStream();
-    std::cout << "WRITING FILE: " << jsonFileName << std::endl;
-    // this writeText() is from JUCE 5.3.2, see commit 06be1c2:
-    jsonFile->writeText(jsonstr, false, false, nullptr);
-    jsonFile->flush();
+    writeJsonFile(jsonFileName, var(json));
+
+    if (m_saveLfp)
+        openLfpFile(basepath + getRecordingNumberString(recordingNumber), json, sample_rate);
 
     // open .msg.txt and .din.npy event files:
     int nEventChans = getNumRecordedEventChannels();
@@ -245,10 +241,14 @@ void BinaryRecording::openFiles(File rootFolder, String baseName, int recordingN
                     std::cerr << "Error creating message text file:" << res.getErrorMessage()
                               << std::endl;
                 else
-                    m_msgFile = msgf.createOutputStream(); // store file handle
+                {
+                    m_msgFile = msgf.createOutputStream(msgBufferSize); // store file handle
                     // this writeText() is from JUCE 5.3.2, see commit 06be1c2:
                     m_msgFile->writeText(getMessageHeader(datetime), false, false, nullptr);
                     m_msgFile->flush();
+                    m_msgFilePending = false;
+                    m_lastMsgFlushTime = Time::getMillisecondCounter();
+                }
                 break;
             }
         case EventChannel::TTL:
@@ -278,10 +278,103 @@ void BinaryRecording::openFiles(File rootFolder, String baseName, int recordingN
     rec->dataFile = new NpyFile(spikeFileName, spikedtype);
     m_spikeFile = rec.release(); // store pointer to rec object
 
+    // open .spikes.waveforms.npy file, one fixed-size int16 snippet per .spikes.npy row,
+    // in the same AD units as the .dat file. Snippets of electrodes with fewer chans or
+    // samples than the largest one are zero-padded, so the file can be memory-mapped
+    // as a plain (nspikes, nchans, nsamples) array:
+    m_spikeWaveChans = 0;
+    m_spikeWaveSamples = 0;
+    int nSpikeChans = getNumRecordedSpikeChannels();
+    for (int i = 0; i < nSpikeChans; i++)
+    {
+        const SpikeChannel* spikeChan = getSpikeChannel(i);
+        m_spikeWaveChans = jmax(m_spikeWaveChans, (int)spikeChan->getNumChannels());
+        m_spikeWaveSamples = jmax(m_spikeWaveSamples, (int)spikeChan->getTotalSamples());
+    }
+    if (m_spikeWaveChans > 0 && m_spikeWaveSamples > 0
+        && m_spikeWaveChans * m_spikeWaveSamples <= m_bufferSize)
+    {
+        String waveFileName = basepath;
+        waveFileName += getRecordingNumberString(recordingNumber) + ".spikes.waveforms.npy";
+        std::cout << "OPENING FILE: " << waveFileName << std::endl;
+        rec = new EventRecording();
+        NpyType wavedtype = NpyType(BaseType::INT16, m_spikeWaveSamples);
+        rec->dataFile = new NpyFile(waveFileName, wavedtype, m_spikeWaveChans);
+        m_spikeWaveFile = rec.release();
+    }
+
     //m_recordingNum = recordingNumber; // don't really need to store this?
 }
 
 
+void BinaryRecording::writeJsonFile(String fileName, const var& json)
+{
+    File jsonf = File(fileName);
+    Result res = jsonf.create();
+    if (res.failed())
+        std::cerr << "Error creating JSON file:" << res.getErrorMessage() << std::endl;
+    ScopedPointer<FileOutputStream> jsonFile = jsonf.createOutputStream();
+    std::cout << "WRITING FILE: " << fileName << std::endl;
+    // this writeText() is from JUCE 5.3.2, see commit 06be1c2:
+    jsonFile->writeText(JSON::toString(json, false), false, false, nullptr);
+    jsonFile->flush();
+}
+
+void BinaryRecording::openLfpFile(String basepath, DynamicObject::Ptr datJson, int sample_rate)
+{
+    int factor = roundToInt(double(sample_rate) / m_lfpSampleRate);
+    if (factor < 2)
+    {
+        std::cerr << "Not writing LFP: " << m_lfpSampleRate << " Hz is not below the "
+                  << sample_rate << " Hz sample rate" << std::endl;
+        return;
+    }
+
+    int nRecChans = getNumRecordedChannels();
+    Array<double> bitVolts;
+    for (int chani = 0; chani < nRecChans; chani++)
+        bitVolts.add(getDataChannel(getRealChannel(getProcessorInfo(0).recordedChannels[chani]))->getBitVolts());
+
+    // decimation runs on its own threads; keep a couple of cores for acquisition
+    int nThreads = jmax(1, SystemStats::getNumCpus() - 2);
+    if (!m_threadPool)
+        m_threadPool = new ThreadPool(nThreads);
+
+    String lfpFileName = basepath + ".lfp.dat";
+    std::cout << "OPENING FILE: " << lfpFileName << std::endl;
+    m_lfpFile = new LfpFileWriter(nRecChans, factor, bitVolts, *m_threadPool, nThreads);
+    if (!m_lfpFile->openFile(lfpFileName))
+    {
+        m_lfpFile = nullptr;
+        return;
+    }
+
+    // same fields as the .dat.json, LFP sample i being .dat sample i * decimation_factor:
+    var filterStages;
+    Array<int> stageFactors = m_lfpFile->getStageFactors();
+    Array<int> stageTaps = m_lfpFile->getStageTaps();
+    for (int i = 0; i < stageFactors.size(); i++)
+    {
+        DynamicObject::Ptr stage = new DynamicObject();
+        stage->setProperty("decimation_factor", stageFactors[i]);
+        stage->setProperty("ntaps", stageTaps[i]);
+        filterStages.append(var(stage));
+    }
+    DynamicObject::Ptr filter = new DynamicObject();
+    filter->setProperty("type", "linear phase FIR, Kaiser window, zero delay");
+    filter->setProperty("passband_Hz", LfpFileWriter::passbandFraction * sample_rate / factor);
+    filter->setProperty("stopband_attenuation_dB", LfpDecimator::stopbandAttenuation);
+    filter->setProperty("stages", filterStages);
+
+    DynamicObject::Ptr json = datJson->clone();
+    json->setProperty("sample_rate", double(sample_rate) / factor);
+    json->setProperty("dat_sample_rate", sample_rate);
+    json->setProperty("decimation_factor", factor);
+    json->setProperty("filter", var(filter));
+
+    writeJsonFile(lfpFileName + ".json", var(json));
+}
+
 template <typename TO, typename FROM>
 void dataToVar(var& dataTo, const void* dataFrom, int length)
 {
@@ -295,6 +388,9 @@ void dataToVar(var& dataTo, const void* dataFrom, int length)
 
 void BinaryRecording::closeFiles()
 {
+    if (m_lfpFile)
+        m_lfpFile->closeFile();
+    flushEventFiles(true);
     resetChannels();
 }
 
@@ -302,11 +398,14 @@ void BinaryRecording::resetChannels()
 {
     // clear all stored objects, including open file handles?
     m_DataFiles.clear();
+    m_lfpFile = nullptr;
     m_channelIndexes.clear();
     m_fileIndexes.clear();
     m_dinFile = nullptr;
     m_spikeFile = nullptr;
+    m_spikeWaveFile = nullptr;
     m_msgFile = nullptr;
+    m_msgFilePending = false;
 
     m_scaledBuffer.malloc(MAX_BUFFER_SIZE);
     m_intBuffer.malloc(MAX_BUFFER_SIZE);
@@ -334,46 +433,74 @@ void BinaryRecording::writeData(int writeChannel, int realChannel, const float*
     m_DataFiles[fileIndex]->writeChannel(getTimestamp(writeChannel) - m_startTS[writeChannel],
                                          m_channelIndexes[writeChannel],
                                          m_intBuffer.getData(), size);
+    if (m_lfpFile)
+        m_lfpFile->writeChannel(m_channelIndexes[writeChannel], buffer, size);
 }
 
+void BinaryRecording::endChannelBlock(bool lastBlock)
+{
+    // called once per record thread cycle, even when no events arrive, so that buffered
+    // events reach the disk within the flush intervals during quiet periods too:
+    flushEventFiles(lastBlock);
+}
+
+void BinaryRecording::flushEventFiles(bool force)
+{
+    if (m_dinFile)
+        m_dinFile->dataFile->flush(force);
+    if (m_spikeFile)
+        m_spikeFile->dataFile->flush(force);
+    if (m_spikeWaveFile)
+        m_spikeWaveFile->dataFile->flush(force);
+    if (m_msgFile && m_msgFilePending)
+    {
+        uint32 now = Time::getMillisecondCounter();
+        if (force || now - m_lastMsgFlushTime >= msgFlushInterval)
+        {
+            m_msgFile->flush();
+            m_msgFilePending = false;
+            m_lastMsgFlushTime = now;
+        }
+    }
+}
 
 void BinaryRecording::addSpikeElectrode(int index, const SpikeChannel* elec)
 {
+    // nothing to do here, waveform snippet dimensions are taken from all recorded spike
+    // channels in openFiles()
 }
 
 void BinaryRecording::writeEvent(int eventIndex, const MidiMessage& event)
 {
     EventPtr ev = Event::deserializeFromMessage(event, getEventChannel(eventIndex));
-    EventRecording* rec = m_dinFile;
-    if (!rec)
-        return;
-    const EventChannel* info = getEventChannel(eventIndex);
     int64 ts = ev->getTimestamp();
     if (ev->getEventType() == EventChannel::TEXT)
     {
-        const String tsstr = String(ts);
-        //String msg = String((char*)ev->getRawDataPointer(), info->getDataSize());
-        const String msg = String((char*)ev->getRawDataPointer());
-        // this writeText() is from JUCE 5.3.2, see commit 06be1c2:
-        m_msgFile->writeText(tsstr + "\t" + msg + '\n', false, false, nullptr);
-        m_msgFile->flush();
+        if (!m_msgFile)
+            return;
+        // append straight into the stream buffer, flushed later by flushEventFiles():
+        *m_msgFile << ts << '\t' << (const char*)ev->getRawDataPointer() << '\n';
+        m_msgFilePending = true;
     }
     else if (ev->getEventType() == EventChannel::TTL)
     {
+        EventRecording* rec = m_dinFile;
+        if (!rec)
+            return;
         TTLEvent* ttl = static_cast<TTLEvent*>(ev.get());
         // cast void pointer to uint8 pointer, dereference, cast to int64:
         int64 word = (int64)*(uint8*)(ttl->getTTLWordPointer());
-        rec->dataFile->writeData(&ts, sizeof(int64)); // timestamp
-        rec->dataFile->writeData(&word, sizeof(int64)); // digital input word
+        int64 row[2] = { ts, word }; // timestamp, digital input word
+        rec->dataFile->writeData(row, sizeof(row));
         increaseEventCounts(rec);
-        // if old and new words differ at the experiment bit, flush to disk so that online
-        // analysis can be performed on the dinFile:
+        // if old and new words differ at the experiment bit, flush to disk right away so
+        // that online analysis can be performed on the dinFile:
         int64 expBitChanged = (word ^ m_lastTTLWord) & m_experimentBit;
         //std::cout << "expBitChanged: " << expBitChanged << std::endl;
         if (expBitChanged)
         {
             std::cout << "Experiment bit change detected, flushing .din to disk" << std::endl;
-            rec->dataFile->updateHeader();
+            rec->dataFile->flush(true);
         }
         m_lastTTLWord = word; // update
     }
@@ -403,7 +530,7 @@ void BinaryRecording::writeTimestampSyncText(uint16 sourceID, uint16 sourceIdx,
         return;
     // this writeText() is from JUCE 5.3.2, see commit 06be1c2:
     m_msgFile->writeText("## " + text + "\n", false, false, nullptr);
-    m_msgFile->flush();
+    m_msgFilePending = true;
 }
 
 void BinaryRecording::writeSpike(int electrodeIndex, const SpikeEvent* spike)
@@ -432,15 +559,41 @@ void BinaryRecording::writeSpike(int electrodeIndex, const SpikeEvent* spike)
     int64 chanID = chanIDstr.getLargeIntValue();
     int64 sortedID = (int64)(uint16)spike->getSortedID();
     EventRecording* rec = m_spikeFile;
-    rec->dataFile->writeData(&ts, sizeof(int64)); // timestamp
-    rec->dataFile->writeData(&chanID, sizeof(int64)); // spike channel
-    rec->dataFile->writeData(&sortedID, sizeof(int64)); // cluster ID
+    int64 row[3] = { ts, chanID, sortedID }; // timestamp, spike channel, cluster ID
+    rec->dataFile->writeData(row, sizeof(row));
     increaseEventCounts(rec);
+    if (m_spikeWaveFile)
+        writeSpikeWaveform(spike);
     //std::cout << "ts " << ts << std::endl;
     //std::cout << "chanID " << chanID << std::endl;
     //std::cout << "sortedID " << sortedID << std::endl;
 }
 
+void BinaryRecording::writeSpikeWaveform(const SpikeEvent* spike)
+{
+    // convert into the preallocated write buffers, same scaling as writeData(), and append
+    // the whole snippet in one go:
+    const SpikeChannel* spikeChan = spike->getChannelInfo();
+    int nChans = jmin((int)spikeChan->getNumChannels(), m_spikeWaveChans);
+    int nSamples = jmin((int)spikeChan->getTotalSamples(), m_spikeWaveSamples);
+    int snippetSize = m_spikeWaveChans * m_spikeWaveSamples;
+    int16* snippet = m_intBuffer.getData();
+    if (nChans < m_spikeWaveChans || nSamples < m_spikeWaveSamples)
+        zeromem(snippet, snippetSize * sizeof(int16));
+    for (int chan = 0; chan < nChans; chan++)
+    {
+        double multFactor = 1 / (float(0x7fff) * spikeChan->getChannelBitVolts(chan));
+        FloatVectorOperations::copyWithMultiply(m_scaledBuffer.getData(),
+                                                spike->getDataPointer(chan), multFactor,
+                                                nSamples);
+        AudioDataConverters::convertFloatToInt16LE(m_scaledBuffer.getData(),
+                                                   snippet + chan * m_spikeWaveSamples,
+                                                   nSamples);
+    }
+    m_spikeWaveFile->dataFile->writeData(snippet, snippetSize * sizeof(int16));
+    increaseEventCounts(m_spikeWaveFile);
+}
+
 void BinaryRecording::increaseEventCounts(EventRecording* rec)
 {
     rec->dataFile->increaseRecordCount();
@@ -456,10 +609,16 @@ RecordEngineManager* BinaryRecording::getEngineManager()
     EngineParameter* param;
     param = new EngineParameter(EngineParameter::BOOL, 0, "Record TTL full words", true);
     man->addParameter(param);
+    param = new EngineParameter(EngineParameter::BOOL, 1, "Write decimated LFP (.lfp.dat)", false);
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::INT, 2, "LFP sample rate (Hz)", 1000, 500, 5000);
+    man->addParameter(param);
     return man;
 }
 
 void BinaryRecording::setParameter(EngineParameter& parameter)
 {
     boolParameter(0, m_saveTTLWords);
+    boolParameter(1, m_saveLfp);
+    intParameter(2, m_lfpSampleRate);
 }
@@ -26,6 +26,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <RecordingLib.h>
 #include "SequentialBlockFile.h"
 #include "NpyFile.h"
+#include "LfpFileWriter.h"
 
 namespace BinaryRecordingEngine
 {
@@ -40,6 +41,7 @@ namespace BinaryRecordingEngine
         void openFiles(File rootFolder, String baseName, int recordingNumber) override;
         void closeFiles() override;
         void writeData(int writeChannel, int realChannel, const float* buffer, int size) override;
+        void endChannelBlock(bool lastBlock) override;
         void writeEvent(int eventIndex, const MidiMessage& event) override;
         void resetChannels() override;
         void addSpikeElectrode(int index, const SpikeChannel* elec) override;
@@ -61,11 +63,17 @@ namespace BinaryRecordingEngine
             //ScopedPointer<NpyFile> extraFile;
         };
 
+        void writeSpikeWaveform(const SpikeEvent* spike);
         void increaseEventCounts(EventRecording* rec);
+        void flushEventFiles(bool force);
         static String getProcessorString(const InfoObjectCommon* channelInfo);
         String getRecordingNumberString(int recordingNumber);
+        static void writeJsonFile(String fileName, const var& json);
+        void openLfpFile(String basepath, DynamicObject::Ptr datJson, int sample_rate);
 
         bool m_saveTTLWords{ true };
+        bool m_saveLfp{ false };
+        int m_lfpSampleRate{ 1000 };
         int64 m_lastTTLWord{ 0 };
         int64 m_experimentBit{ 1 << 0 }; // first bit (1 bit shifted left 0 positions)
 
@@ -74,17 +82,28 @@ namespace BinaryRecordingEngine
         int m_bufferSize;
 
         OwnedArray<SequentialBlockFile> m_DataFiles;
+        ScopedPointer<ThreadPool> m_threadPool;
+        ScopedPointer<LfpFileWriter> m_lfpFile;
         Array<unsigned int> m_channelIndexes;
         Array<unsigned int> m_fileIndexes;
         ScopedPointer<EventRecording> m_dinFile;
         ScopedPointer<EventRecording> m_spikeFile;
+        ScopedPointer<EventRecording> m_spikeWaveFile;
+        int m_spikeWaveChans{ 0 }; // waveform snippet dimensions in .spikes.waveforms.npy
+        int m_spikeWaveSamples{ 0 };
         ScopedPointer<FileOutputStream> m_msgFile;
+        bool m_msgFilePending{ false }; // messages written since last flush
+        uint32 m_lastMsgFlushTime{ 0 }; // ms, from Time::getMillisecondCounter()
 
         //int m_recordingNum;
         Array<int64> m_startTS;
 
         //Compile-time constants
         const int samplesPerBlock{ 4096 };
+        // messages are coalesced in the .msg.txt stream buffer and flushed at most this
+        // often (ms):
+        const int msgBufferSize{ 1 << 16 };
+        const uint32 msgFlushInterval{ 500 };
         const String BusseLabBinaryWriterPluginVersion = "0.5";
 
     };
@@ -0,0 +1,226 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LfpDecimator.h"
+
+using namespace BinaryRecordingEngine;
+
+const double LfpDecimator::stopbandAttenuation = 80.0;
+
+namespace
+{
+    double besselI0(double x)
+    {
+        double sum = 1.0;
+        double term = 1.0;
+        for (int k = 1; k < 50 && term > 1e-12 * sum; k++)
+        {
+            term *= (x / (2 * k)) * (x / (2 * k));
+            sum += term;
+        }
+        return sum;
+    }
+}
+
+LfpDecimator::LfpDecimator(int factor, double passbandFraction, int maxInputSamples) :
+m_factor(jmax(1, factor)),
+m_maxInputSamples(maxInputSamples)
+{
+    Array<int> factors;
+    int remaining = m_factor;
+    for (int p = 2; p <= remaining; p++)
+    {
+        while (remaining % p == 0)
+        {
+            factors.insert(0, p); // largest first
+            remaining /= p;
+        }
+    }
+
+    // frequencies relative to the input rate
+    const double outputRate = 1.0 / m_factor;
+    const double passband = passbandFraction * outputRate;
+    const double finalStopband = 0.5 * outputRate;
+
+    double stageRate = 1.0;
+    int stageInputs = maxInputSamples;
+    int largestOutput = 0;
+    for (int i = 0; i < factors.size(); i++)
+    {
+        const int stageFactor = factors[i];
+        const double stageOutputRate = stageRate / stageFactor;
+        // an earlier stage only has to keep out what would alias below the final stopband
+        const double stopband = (i == factors.size() - 1) ? finalStopband
+                                                          : stageOutputRate - finalStopband;
+
+        m_stages.add(new Stage(stageFactor, passband / stageRate, stopband / stageRate, stageInputs));
+
+        stageInputs = stageInputs / stageFactor + 2;
+        largestOutput = jmax(largestOutput, stageInputs);
+        stageRate = stageOutputRate;
+    }
+
+    m_work[0].malloc(largestOutput);
+    m_work[1].malloc(largestOutput);
+}
+
+LfpDecimator::~LfpDecimator()
+{
+}
+
+int LfpDecimator::process(const float* input, int nSamples, float* dest)
+{
+    m_numInputs += nSamples;
+
+    if (m_stages.size() == 0)
+    {
+        memcpy(dest, input, nSamples * sizeof(float));
+        m_numOutputs += nSamples;
+        return nSamples;
+    }
+
+    const float* in = input;
+    int n = nSamples;
+    for (int i = 0; i < m_stages.size(); i++)
+    {
+        float* out = (i == m_stages.size() - 1) ? dest : m_work[i % 2].getData();
+        n = m_stages[i]->process(in, n, out);
+        in = out;
+    }
+    m_numOutputs += n;
+    return n;
+}
+
+int LfpDecimator::finish(float* dest)
+{
+    const int64 owed = (m_numInputs + m_factor - 1) / m_factor - m_numOutputs;
+    if (owed <= 0)
+        return 0;
+
+    HeapBlock<float> zeros(m_maxInputSamples, true);
+    HeapBlock<float> out(m_maxInputSamples / m_factor + 2);
+    int written = 0;
+    while (written < owed)
+    {
+        const int n = process(zeros, m_maxInputSamples, out);
+        const int used = (int)jmin<int64>(n, owed - written);
+        memcpy(dest + written, out, used * sizeof(float));
+        written += used;
+    }
+    return written;
+}
+
+void LfpDecimator::reset()
+{
+    for (int i = 0; i < m_stages.size(); i++)
+        m_stages[i]->reset();
+    m_numInputs = 0;
+    m_numOutputs = 0;
+}
+
+int LfpDecimator::getFactor() const
+{
+    return m_factor;
+}
+
+Array<int> LfpDecimator::getStageFactors() const
+{
+    Array<int> factors;
+    for (int i = 0; i < m_stages.size(); i++)
+        factors.add(m_stages[i]->m_factor);
+    return factors;
+}
+
+Array<int> LfpDecimator::getStageTaps() const
+{
+    Array<int> taps;
+    for (int i = 0; i < m_stages.size(); i++)
+        taps.add(m_stages[i]->m_numTaps);
+    return taps;
+}
+
+LfpDecimator::Stage::Stage(int factor, double passband, double stopband, int maxInputSamples) :
+m_factor(factor),
+m_maxInputSamples(maxInputSamples)
+{
+    // Kaiser window estimate of the length, rounded up so the delay, (taps - 1) / 2,
+    // is a whole number of output samples
+    const double transition = jmax(1e-4, stopband - passband);
+    const int minTaps = (int)std::ceil((stopbandAttenuation - 7.95) / (14.36 * transition)) + 1;
+    const int delay = factor * jmax(1, (minTaps - 1 + 2 * factor - 1) / (2 * factor));
+    m_numTaps = 2 * delay + 1;
+
+    const double cutoff = 0.5 * (passband + stopband);
+    const double beta = 0.1102 * (stopbandAttenuation - 8.7);
+    const double i0Beta = besselI0(beta);
+
+    m_taps.malloc(m_numTaps);
+    double sum = 0;
+    for (int k = 0; k < m_numTaps; k++)
+    {
+        const double t = k - delay;
+        const double sinc = (t == 0) ? 2 * cutoff
+                                     : std::sin(2 * double_Pi * cutoff * t) / (double_Pi * t);
+        const double r = t / delay;
+        const double window = besselI0(beta * std::sqrt(jmax(0.0, 1 - r * r))) / i0Beta;
+        m_taps[k] = (float)(sinc * window);
+        sum += m_taps[k];
+    }
+    // unity gain at DC
+    for (int k = 0; k < m_numTaps; k++)
+        m_taps[k] = (float)(m_taps[k] / sum);
+
+    m_buffer.malloc(m_numTaps - 1 + maxInputSamples);
+    reset();
+}
+
+void LfpDecimator::Stage::reset()
+{
+    zeromem(m_buffer, (m_numTaps - 1) * sizeof(float));
+    m_nextOutput = (m_numTaps - 1) / 2;
+    m_numInputs = 0;
+}
+
+int LfpDecimator::Stage::process(const float* input, int nSamples, float* dest)
+{
+    const int history = m_numTaps - 1;
+    memcpy(m_buffer + history, input, nSamples * sizeof(float));
+
+    // the taps are symmetric, so each output is a plain dot product over the buffer,
+    // starting at the oldest input it uses
+    const int64 end = m_numInputs + nSamples;
+    int nOut = 0;
+    while (m_nextOutput < end)
+    {
+        const float* x = m_buffer + (m_nextOutput - m_numInputs);
+        float acc = 0;
+        for (int k = 0; k < m_numTaps; k++)
+            acc += m_taps[k] * x[k];
+        dest[nOut++] = acc;
+        m_nextOutput += m_factor;
+    }
+    m_numInputs = end;
+
+    memmove(m_buffer, m_buffer + nSamples, history * sizeof(float));
+    return nOut;
+}
@@ -0,0 +1,104 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef LFPDECIMATOR_H
+#define LFPDECIMATOR_H
+
+#include <BasicJuceHeader.h>
+
+namespace BinaryRecordingEngine
+{
+
+    /**
+    Low-pass filters and decimates one channel by an integer factor, in a cascade of
+    FIR stages, one per prime factor of the total, largest first. Each stage only
+    computes the samples it keeps, so its cost is set by its output rate, and the early
+    stages get away with few taps because everything that would alias into the band
+    below half the final rate is removed by a later, sharper stage.
+
+    Every stage has a linear phase with a delay of a whole number of its output
+    samples, which is taken out, so output sample i lines up with input sample
+    i * factor. Samples before the first one are treated as zero.
+    */
+    class LfpDecimator
+    {
+    public:
+        /** Designs the stages. passbandFraction is the passband edge as a fraction of
+            the output rate; it must be below 0.5. */
+        LfpDecimator(int factor, double passbandFraction, int maxInputSamples);
+        ~LfpDecimator();
+
+        /** Filters nSamples of input and writes the output samples they complete to dest,
+            returning how many. At most ceil(nSamples / factor) + 1 are written. */
+        int process(const float* input, int nSamples, float* dest);
+
+        /** Feeds enough zeros to complete every output sample owed for the input so far,
+            and writes them to dest. Returns how many. */
+        int finish(float* dest);
+
+        void reset();
+
+        /** Stopband attenuation of every stage, in dB */
+        static const double stopbandAttenuation;
+
+        int getFactor() const;
+        /** The decimation factor of each stage */
+        Array<int> getStageFactors() const;
+        /** The number of taps of each stage */
+        Array<int> getStageTaps() const;
+
+    private:
+        class Stage
+        {
+        public:
+            Stage(int factor, double passband, double stopband, int maxInputSamples);
+
+            int process(const float* input, int nSamples, float* dest);
+            void reset();
+
+            const int m_factor;
+            int m_numTaps;
+
+        private:
+            HeapBlock<float> m_taps;
+            // the last m_numTaps - 1 inputs, followed by the new ones
+            HeapBlock<float> m_buffer;
+            int m_maxInputSamples;
+            // index of the input the next output is centred on, counted from the first input
+            int64 m_nextOutput;
+            int64 m_numInputs;
+        };
+
+        const int m_factor;
+        OwnedArray<Stage> m_stages;
+        HeapBlock<float> m_work[2];
+        int m_maxInputSamples;
+        int64 m_numInputs{ 0 };
+        int64 m_numOutputs{ 0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LfpDecimator);
+    };
+
+}
+
+#endif
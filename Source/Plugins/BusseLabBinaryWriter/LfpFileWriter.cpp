@@ -0,0 +1,221 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "LfpFileWriter.h"
+
+using namespace BinaryRecordingEngine;
+
+const double LfpFileWriter::passbandFraction = 0.4;
+
+LfpFileWriter::LfpFileWriter(int nChannels, int factor, const Array<double>& bitVolts,
+                             ThreadPool& pool, int nThreads) :
+m_file(nullptr),
+m_pool(pool),
+m_nChannels(nChannels),
+m_factor(factor),
+m_chunkSamples(factor * 256),
+m_maxOutputSamples(256 + 2),
+m_bitVolts(bitVolts)
+{
+    for (int chan = 0; chan < nChannels; chan++)
+        m_decimators.add(new LfpDecimator(factor, passbandFraction, m_chunkSamples));
+
+    m_staging.setSize(nChannels, 2 * m_chunkSamples);
+    m_stagingFill.calloc(nChannels);
+    m_chunkData.setSize(nChannels, m_chunkSamples);
+    m_output.malloc(nChannels * m_maxOutputSamples);
+    m_outputSizes.calloc(nChannels);
+
+    m_scaledBuffer.malloc(m_maxOutputSamples);
+    m_intBuffer.malloc(m_maxOutputSamples);
+    m_frames.malloc(nChannels * m_maxOutputSamples);
+
+    // one job per worker thread, each decimating a contiguous range of channels:
+    int nJobs = jmax(1, jmin(nChannels, nThreads));
+    for (int i = 0; i < nJobs; i++)
+        m_jobs.add(new DecimateJob(*this, i * nChannels / nJobs, (i + 1) * nChannels / nJobs));
+}
+
+LfpFileWriter::~LfpFileWriter()
+{
+    closeFile();
+}
+
+bool LfpFileWriter::openFile(String filename)
+{
+    File file(filename);
+    Result res = file.create();
+    if (res.failed())
+    {
+        std::cerr << "Error creating file " << filename << ":" << res.getErrorMessage() << std::endl;
+        return false;
+    }
+    file.deleteFile(); // never append to an existing file
+    m_file = file.createOutputStream();
+    return m_file != nullptr;
+}
+
+void LfpFileWriter::writeChannel(int channel, const float* data, int nSamples)
+{
+    if (!m_file)
+        return;
+
+    int fill = m_stagingFill[channel];
+    if (fill + nSamples > m_staging.getNumSamples())
+    {
+        // only when a large block arrives at once, as when the queue is drained at the end
+        m_staging.setSize(m_nChannels, fill + nSamples + m_chunkSamples, true);
+    }
+    m_staging.copyFrom(channel, fill, data, nSamples);
+    m_stagingFill[channel] = fill + nSamples;
+
+    if (fill < m_chunkSamples && fill + nSamples >= m_chunkSamples)
+        m_fullChannels++;
+    while (m_fullChannels == m_nChannels)
+        submitChunk(m_chunkSamples);
+}
+
+void LfpFileWriter::submitChunk(int nSamples)
+{
+    // the previous chunk has had a whole chunk's worth of time to decimate:
+    writePendingChunk();
+
+    m_fullChannels = 0;
+    for (int chan = 0; chan < m_nChannels; chan++)
+    {
+        float* staged = m_staging.getWritePointer(chan);
+        int remaining = m_stagingFill[chan] - nSamples;
+        m_chunkData.copyFrom(chan, 0, staged, nSamples);
+        memmove(staged, staged + nSamples, remaining * sizeof(float));
+        m_stagingFill[chan] = remaining;
+        if (remaining >= m_chunkSamples)
+            m_fullChannels++;
+    }
+    m_chunkNumSamples = nSamples;
+    m_chunkPending = true;
+
+    for (int i = 0; i < m_jobs.size(); i++)
+        m_pool.addJob(m_jobs[i], false);
+}
+
+void LfpFileWriter::writePendingChunk()
+{
+    if (!m_chunkPending)
+        return;
+
+    for (int i = 0; i < m_jobs.size(); i++)
+        m_pool.waitForJobToFinish(m_jobs[i], -1);
+    m_chunkPending = false;
+
+    // every channel got the same number of inputs, so they all have the same output
+    writeFrames(m_outputSizes[0]);
+}
+
+void LfpFileWriter::writeFrames(int nFrames)
+{
+    if (nFrames <= 0)
+        return;
+
+    for (int chan = 0; chan < m_nChannels; chan++)
+    {
+        // same scaling as BinaryRecording::writeData():
+        double multFactor = 1 / (float(0x7fff) * m_bitVolts[chan]);
+        FloatVectorOperations::copyWithMultiply(m_scaledBuffer.getData(),
+                                                m_output + chan * m_maxOutputSamples,
+                                                multFactor, nFrames);
+        AudioDataConverters::convertFloatToInt16LE(m_scaledBuffer.getData(),
+                                                   m_intBuffer.getData(), nFrames);
+        for (int i = 0; i < nFrames; i++)
+            m_frames[i * m_nChannels + chan] = m_intBuffer[i];
+    }
+    m_file->write(m_frames, nFrames * m_nChannels * sizeof(int16));
+}
+
+void LfpFileWriter::closeFile()
+{
+    if (!m_file)
+        return;
+
+    // channels that ran ahead of the others lose their extra samples, so that all
+    // channels in the file have the same length:
+    int nSamples = m_staging.getNumSamples();
+    for (int chan = 0; chan < m_nChannels; chan++)
+        nSamples = jmin(nSamples, m_stagingFill[chan]);
+    while (nSamples > 0)
+    {
+        int n = jmin(nSamples, m_chunkSamples);
+        submitChunk(n);
+        nSamples -= n;
+    }
+    writePendingChunk();
+
+    // the filters are centred on each output sample, so the last few are still owed
+    HeapBlock<float> tail(m_nChannels * m_maxOutputSamples);
+    HeapBlock<float> out(m_chunkSamples);
+    int nTail = 0;
+    for (int chan = 0; chan < m_nChannels; chan++)
+    {
+        nTail = jmin(m_decimators[chan]->finish(out), m_maxOutputSamples);
+        memcpy(tail + chan * m_maxOutputSamples, out, nTail * sizeof(float));
+    }
+    m_output.swapWith(tail);
+    writeFrames(nTail);
+
+    m_file->flush();
+    m_file = nullptr;
+}
+
+int LfpFileWriter::getFactor() const
+{
+    return m_factor;
+}
+
+Array<int> LfpFileWriter::getStageFactors() const
+{
+    return m_decimators[0]->getStageFactors();
+}
+
+Array<int> LfpFileWriter::getStageTaps() const
+{
+    return m_decimators[0]->getStageTaps();
+}
+
+LfpFileWriter::DecimateJob::DecimateJob(LfpFileWriter& writer, int firstChannel, int lastChannel) :
+ThreadPoolJob("LFP writer decimate job"),
+m_writer(writer),
+m_firstChannel(firstChannel),
+m_lastChannel(lastChannel)
+{
+}
+
+ThreadPoolJob::JobStatus LfpFileWriter::DecimateJob::runJob()
+{
+    for (int chan = m_firstChannel; chan < m_lastChannel; chan++)
+    {
+        m_writer.m_outputSizes[chan] = m_writer.m_decimators[chan]->process(
+            m_writer.m_chunkData.getReadPointer(chan),
+            m_writer.m_chunkNumSamples,
+            m_writer.m_output + chan * m_writer.m_maxOutputSamples);
+    }
+    return jobHasFinished;
+}
@@ -0,0 +1,109 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef LFPFILEWRITER_H
+#define LFPFILEWRITER_H
+
+#include <BasicJuceHeader.h>
+#include "LfpDecimator.h"
+
+namespace BinaryRecordingEngine
+{
+
+    /**
+    Writes a decimated copy of the recorded channels to a .lfp.dat file, int16 and
+    interleaved like the .dat file, in the same AD units.
+
+    Samples of each channel are staged until every channel holds a full chunk. The chunk
+    is then decimated on the shared thread pool while the next one is filled, and written
+    out once that one is complete, so the record thread only ever copies samples.
+
+    @see LfpDecimator
+    */
+    class LfpFileWriter
+    {
+    public:
+        LfpFileWriter(int nChannels, int factor, const Array<double>& bitVolts, ThreadPool& pool,
+                      int nThreads);
+        ~LfpFileWriter();
+
+        bool openFile(String filename);
+        void writeChannel(int channel, const float* data, int nSamples);
+        /** Decimates and writes all staged samples, and the end of the filters' output */
+        void closeFile();
+
+        int getFactor() const;
+        Array<int> getStageFactors() const;
+        Array<int> getStageTaps() const;
+
+        /** Passband edge as a fraction of the output rate */
+        static const double passbandFraction;
+
+    private:
+        class DecimateJob : public ThreadPoolJob
+        {
+        public:
+            DecimateJob(LfpFileWriter& writer, int firstChannel, int lastChannel);
+            JobStatus runJob() override;
+        private:
+            LfpFileWriter& m_writer;
+            const int m_firstChannel;
+            const int m_lastChannel;
+        };
+
+        void submitChunk(int nSamples);
+        void writePendingChunk();
+        void writeFrames(int nFrames);
+
+        ScopedPointer<FileOutputStream> m_file;
+        ThreadPool& m_pool;
+        const int m_nChannels;
+        const int m_factor;
+        const int m_chunkSamples;
+        const int m_maxOutputSamples;
+        Array<double> m_bitVolts;
+        OwnedArray<LfpDecimator> m_decimators;
+
+        // staged samples; grows if a channel gets far ahead of the others
+        AudioSampleBuffer m_staging;
+        HeapBlock<int> m_stagingFill;
+        int m_fullChannels{ 0 };
+
+        // the chunk being decimated, and its output, m_maxOutputSamples per channel
+        AudioSampleBuffer m_chunkData;
+        HeapBlock<float> m_output;
+        HeapBlock<int> m_outputSizes;
+        int m_chunkNumSamples{ 0 };
+        bool m_chunkPending{ false };
+        OwnedArray<DecimateJob> m_jobs;
+
+        HeapBlock<float> m_scaledBuffer;
+        HeapBlock<int16> m_intBuffer;
+        HeapBlock<int16> m_frames;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LfpFileWriter);
+    };
+
+}
+
+#endif
@@ -76,13 +76,13 @@ bool NpyFile::openFile(String path)
         return false;
     }
     file.deleteFile(); // overwrite, never append a new .npy file to end of an existing one
-    // output stream buffer size defaults to 32768 bytes, but is irrelevant because
-    // each updateHeader() call triggers a m_file->flush() to disk:
-    m_file = file.createOutputStream();
+    // data only hits the disk when the stream buffer fills up or on flush():
+    m_file = file.createOutputStream(streamBufferSize);
     if (!m_file)
         return false;
 
     m_okOpen = true;
+    m_lastFlushTime = Time::getMillisecondCounter();
     return true;
 }
 
@@ -156,9 +156,9 @@ void NpyFile::writeHeader(const Array<NpyType>& typeList)
 
 void NpyFile::updateHeader()
 {
-    // overwrite the shape part of the header - even without explicitly calling
-    // m_file->flush(), overwriting seems to trigger a flush to disk,
-    // while appending to end of file does not
+    // overwrite the shape part of the header - seeking flushes the stream buffer first,
+    // so all records counted in the new shape are already on disk when it's written,
+    // and online readers never see a shape that runs past the end of the file
     int64 currentPos = m_file->getPosition(); // returns int64, necessary for big files
     if (m_file->setPosition(m_shapePos))
     {
@@ -180,7 +180,25 @@ void NpyFile::updateHeader()
 
 NpyFile::~NpyFile()
 {
-    updateHeader();
+    if (m_okOpen)
+        updateHeader();
+}
+
+void NpyFile::flush(bool force)
+{
+    if (!m_okOpen)
+        return;
+    int64 pending = m_recordCount - m_flushedRecordCount;
+    if (pending == 0)
+        return;
+    uint32 now = Time::getMillisecondCounter();
+    uint32 elapsed = now - m_lastFlushTime;
+    if (!force && elapsed < maxFlushInterval
+        && (pending < recordBufferSize || elapsed < minFlushInterval))
+        return;
+    updateHeader(); // flushes the stream buffer before rewriting the shape
+    m_flushedRecordCount = m_recordCount;
+    m_lastFlushTime = now;
 }
 
 void NpyFile::writeData(const void* data, size_t size)
@@ -190,10 +208,8 @@ void NpyFile::writeData(const void* data, size_t size)
 
 void NpyFile::increaseRecordCount(int count)
 {
-    int64 old_recordCount = m_recordCount;
     m_recordCount += count;
-    if ((old_recordCount / recordBufferSize) != (m_recordCount / recordBufferSize))
-        updateHeader(); // crossed recordBufferSize threshold, update header
+    flush();
 }
 
 NpyType::NpyType(String n, BaseType t, size_t l)
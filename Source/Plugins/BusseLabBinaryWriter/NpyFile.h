@@ -54,6 +54,9 @@ namespace BinaryRecordingEngine
         void writeData(const void* data, size_t size);
         void increaseRecordCount(int count = 1);
         void updateHeader();
+        // write out buffered records and rewrite the header, subject to the flush policy
+        // below, unless force is true:
+        void flush(bool force = false);
     private:
         bool openFile(String path);
         String getShapeString();
@@ -62,14 +65,23 @@ namespace BinaryRecordingEngine
         int64 m_headerLen; // total header length
         bool m_okOpen{ false };
         int64 m_recordCount{ 0 };
+        int64 m_flushedRecordCount{ 0 }; // record count in header as of last flush
+        uint32 m_lastFlushTime{ 0 }; // ms, from Time::getMillisecondCounter()
         size_t m_shapePos;
         unsigned int m_dim1;
         unsigned int m_dim2;
 
         // Compile-time constants
 
-        // flush file buffer to disk and update the .npy header every this many records:
+        // records are coalesced in the output stream buffer, so that bursts of events turn
+        // into a few large appends instead of many small writes:
+        const int streamBufferSize{ 1 << 18 };
+        // flush file buffer to disk and update the .npy header once this many records are
+        // pending, but never more often than every minFlushInterval ms:
         const int recordBufferSize{ 1024 };
+        const uint32 minFlushInterval{ 100 };
+        // flush pending records at least this often, so that online readers don't lag:
+        const uint32 maxFlushInterval{ 1000 };
 
     };
 
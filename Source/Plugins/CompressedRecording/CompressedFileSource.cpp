@@ -0,0 +1,279 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedFileSource.h"
+
+using namespace CompressedRecordingEngine;
+
+CompressedFileSource::CompressedFileSource()
+{
+}
+
+CompressedFileSource::~CompressedFileSource()
+{
+}
+
+bool CompressedFileSource::Open(File file)
+{
+    ScopedPointer<FileInputStream> stream = file.createInputStream();
+    if (!stream)
+        return false;
+
+    char magic[CompressedFormat::magicLength];
+    if (stream->read(magic, CompressedFormat::magicLength) != CompressedFormat::magicLength
+        || memcmp(magic, CompressedFormat::fileMagic, CompressedFormat::magicLength) != 0)
+    {
+        std::cerr << "Not a compressed recording file: " << file.getFullPathName() << std::endl;
+        return false;
+    }
+    if (stream->readInt() != CompressedFormat::version)
+    {
+        std::cerr << "Unsupported compressed recording version" << std::endl;
+        return false;
+    }
+    int metadataLength = stream->readInt();
+    MemoryBlock metadata;
+    if (metadataLength <= 0 || stream->readIntoMemoryBlock(metadata, metadataLength) != (size_t) metadataLength)
+        return false;
+    m_metadata = JSON::parse(metadata.toString());
+
+    m_numChannels = m_metadata["nchans"];
+    m_sampleRate = m_metadata["sample_rate"];
+    m_bitVolts.clear();
+    const Array<var>* channels = m_metadata["channels"].getArray();
+    if (m_numChannels <= 0 || !channels || channels->size() != m_numChannels)
+        return false;
+    for (int i = 0; i < m_numChannels; i++)
+        m_bitVolts.add((*channels)[i]["bit_volts"]);
+
+    m_dataStart = stream->getPosition();
+    m_file = stream.release();
+    if (!readIndex() && !rebuildIndex())
+        return false;
+
+    m_currentChunk = -1;
+    m_samplePos = 0;
+    return true;
+}
+
+bool CompressedFileSource::readIndex()
+{
+    m_indexSamples.clear();
+    m_indexOffsets.clear();
+
+    int64 trailerPos = m_file->getTotalLength() - CompressedFormat::magicLength - sizeof(int64);
+    if (trailerPos <= 0 || !m_file->setPosition(trailerPos))
+        return false;
+    int64 indexOffset = m_file->readInt64();
+    char magic[CompressedFormat::magicLength];
+    if (m_file->read(magic, CompressedFormat::magicLength) != CompressedFormat::magicLength
+        || memcmp(magic, CompressedFormat::trailerMagic, CompressedFormat::magicLength) != 0)
+        return false;
+
+    if (!m_file->setPosition(indexOffset) || m_file->readInt() != CompressedFormat::indexMagic)
+        return false;
+    int nChunks = m_file->readInt();
+    for (int i = 0; i < nChunks; i++)
+    {
+        m_indexSamples.add(m_file->readInt64());
+        m_indexOffsets.add(m_file->readInt64());
+    }
+    if (nChunks == 0)
+    {
+        m_numSamples = 0;
+        return true;
+    }
+
+    // total length is the start of the last chunk plus its length
+    if (!m_file->setPosition(m_indexOffsets.getLast() + sizeof(int32) + sizeof(int64)))
+        return false;
+    m_numSamples = m_indexSamples.getLast() + m_file->readInt();
+    return true;
+}
+
+bool CompressedFileSource::rebuildIndex()
+{
+    // file was not closed cleanly, walk the chunk headers instead
+    std::cout << "No chunk index in " << m_file->getFile().getFileName()
+              << ", rebuilding it" << std::endl;
+    m_indexSamples.clear();
+    m_indexOffsets.clear();
+    m_numSamples = 0;
+
+    int64 pos = m_dataStart;
+    int64 fileLength = m_file->getTotalLength();
+    while (m_file->setPosition(pos) && !m_file->isExhausted())
+    {
+        if (m_file->readInt() != CompressedFormat::chunkMagic)
+            break;
+        int64 firstSample = m_file->readInt64();
+        int nSamples = m_file->readInt();
+        int nChannels = m_file->readInt();
+        if (nChannels != m_numChannels)
+            break;
+        int64 payload = 0;
+        for (int i = 0; i < nChannels; i++)
+            payload += m_file->readInt();
+        int64 next = m_file->getPosition() + payload;
+        if (next > fileLength)
+            break; // truncated chunk
+        m_indexSamples.add(firstSample);
+        m_indexOffsets.add(pos);
+        m_numSamples = firstSample + nSamples;
+        pos = next;
+    }
+    return m_indexSamples.size() > 0;
+}
+
+void CompressedFileSource::fillRecordInfo()
+{
+    infoArray.clear();
+
+    RecordInfo info;
+    info.name = m_metadata["processor_name"].toString();
+    info.sampleRate = m_sampleRate;
+    info.numSamples = m_numSamples;
+
+    const Array<var>* channels = m_metadata["channels"].getArray();
+    for (int i = 0; i < m_numChannels; i++)
+    {
+        RecordedChannelInfo c;
+        c.name = (*channels)[i]["name"].toString();
+        c.bitVolts = m_bitVolts[i];
+        info.channels.add(c);
+    }
+    infoArray.add(info);
+    numRecords = 1;
+}
+
+void CompressedFileSource::updateActiveRecord()
+{
+    // a file holds a single record
+    seekTo(0);
+}
+
+bool CompressedFileSource::loadChunk(int chunk)
+{
+    if (chunk == m_currentChunk)
+        return true;
+    if (chunk < 0 || chunk >= m_indexOffsets.size() || !m_file->setPosition(m_indexOffsets[chunk]))
+        return false;
+
+    if (m_file->readInt() != CompressedFormat::chunkMagic)
+        return false;
+    m_file->readInt64(); // first sample, already in the index
+    int nSamples = m_file->readInt();
+    if (m_file->readInt() != m_numChannels || nSamples <= 0)
+        return false;
+
+    size_t totalEncoded = 0;
+    m_encodedSizes.clearQuick();
+    for (int i = 0; i < m_numChannels; i++)
+    {
+        m_encodedSizes.add(m_file->readInt());
+        totalEncoded += m_encodedSizes.getLast();
+    }
+    if (totalEncoded > m_encodedCapacity)
+    {
+        m_encodedData.malloc(totalEncoded);
+        m_encodedCapacity = totalEncoded;
+    }
+    if (nSamples > m_chunkCapacity)
+    {
+        m_chunkData.malloc(m_numChannels * nSamples);
+        m_chunkCapacity = nSamples;
+    }
+    if (m_file->read(m_encodedData, (int)totalEncoded) != (int)totalEncoded)
+        return false;
+
+    const uint8* encoded = m_encodedData;
+    for (int i = 0; i < m_numChannels; i++)
+    {
+        if (!NeuralCodec::decode(encoded, m_encodedSizes[i], m_chunkData + i * m_chunkCapacity,
+                                 nSamples))
+        {
+            std::cerr << "Corrupt block in chunk " << chunk << " channel " << i << std::endl;
+            m_currentChunk = -1;
+            return false;
+        }
+        encoded += m_encodedSizes[i];
+    }
+    m_chunkNumSamples = nSamples;
+    m_currentChunk = chunk;
+    return true;
+}
+
+void CompressedFileSource::seekTo(int64 sample)
+{
+    m_samplePos = jlimit<int64>(0, m_numSamples, sample);
+}
+
+int CompressedFileSource::readData(int16* buffer, int nSamples)
+{
+    int samplesRead = 0;
+    while (samplesRead < nSamples && m_samplePos < m_numSamples)
+    {
+        // last chunk starting at or before the current position:
+        int chunk = m_currentChunk;
+        if (chunk < 0 || m_indexSamples[chunk] > m_samplePos
+            || m_indexSamples[chunk] + m_chunkNumSamples <= m_samplePos)
+        {
+            int lo = 0, hi = m_indexSamples.size() - 1;
+            while (lo < hi)
+            {
+                int mid = (lo + hi + 1) / 2;
+                if (m_indexSamples[mid] <= m_samplePos)
+                    lo = mid;
+                else
+                    hi = mid - 1;
+            }
+            chunk = lo;
+        }
+        if (!loadChunk(chunk))
+            break;
+
+        int offset = (int)(m_samplePos - m_indexSamples[chunk]);
+        int n = jmin(nSamples - samplesRead, m_chunkNumSamples - offset);
+        if (n <= 0)
+            break;
+
+        // interleave into the output buffer, as the File Reader expects
+        int16* out = buffer + samplesRead * m_numChannels;
+        for (int i = 0; i < m_numChannels; i++)
+        {
+            const int16* in = m_chunkData + i * m_chunkCapacity + offset;
+            for (int j = 0; j < n; j++)
+                out[j * m_numChannels + i] = in[j];
+        }
+        samplesRead += n;
+        m_samplePos += n;
+    }
+    return samplesRead;
+}
+
+void CompressedFileSource::processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 numSamples)
+{
+    float bitVolts = m_bitVolts[channel];
+    for (int i = 0; i < numSamples; i++)
+        outBuffer[i] = inBuffer[i * m_numChannels + channel] * bitVolts;
+}
@@ -0,0 +1,83 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSEDFILESOURCE_H
+#define COMPRESSEDFILESOURCE_H
+
+#include <FileSourceHeaders.h>
+#include "CompressedFileWriter.h"
+
+namespace CompressedRecordingEngine
+{
+
+    /**
+    Reads .oec files written by CompressedRecording into the File Reader. Chunks are
+    decoded on demand, and seeking uses the chunk index.
+    */
+    class CompressedFileSource : public FileSource
+    {
+    public:
+        CompressedFileSource();
+        ~CompressedFileSource();
+
+        int readData(int16* buffer, int nSamples) override;
+        void seekTo(int64 sample) override;
+        void processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 numSamples) override;
+
+    private:
+        bool Open(File file) override;
+        void fillRecordInfo() override;
+        void updateActiveRecord() override;
+
+        bool readIndex();
+        bool rebuildIndex();
+        bool loadChunk(int chunk);
+
+        ScopedPointer<FileInputStream> m_file;
+        var m_metadata;
+        int m_numChannels{ 0 };
+        float m_sampleRate{ 0 };
+        Array<float> m_bitVolts;
+        int64 m_numSamples{ 0 };
+        int64 m_dataStart{ 0 }; // file offset of the first chunk
+
+        Array<int64> m_indexSamples;
+        Array<int64> m_indexOffsets;
+
+        // decoded samples of the current chunk, m_chunkCapacity per channel
+        int m_currentChunk{ -1 };
+        int m_chunkNumSamples{ 0 };
+        int m_chunkCapacity{ 0 };
+        HeapBlock<int16> m_chunkData;
+        HeapBlock<uint8> m_encodedData;
+        size_t m_encodedCapacity{ 0 };
+        Array<int32> m_encodedSizes;
+
+        int64 m_samplePos{ 0 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CompressedFileSource);
+    };
+
+}
+
+#endif
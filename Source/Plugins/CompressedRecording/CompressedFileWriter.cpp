@@ -0,0 +1,220 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedFileWriter.h"
+
+using namespace CompressedRecordingEngine;
+
+CompressedFileWriter::CompressedFileWriter(int nChannels, int chunkSamples, ThreadPool& pool,
+                                           int nThreads) :
+m_file(nullptr),
+m_pool(pool),
+m_nChannels(nChannels),
+m_chunkSamples(chunkSamples),
+m_stagingSamples(2 * chunkSamples),
+m_maxEncodedSize(NeuralCodec::getMaxEncodedSize(chunkSamples))
+{
+    m_staging.malloc(nChannels * m_stagingSamples);
+    m_stagingFill.calloc(nChannels);
+    m_chunkData.malloc(nChannels * chunkSamples);
+    m_encodedData.malloc(nChannels * m_maxEncodedSize);
+    m_encodedSizes.calloc(nChannels);
+
+    // one job per worker thread, each encoding a contiguous range of channels:
+    int nJobs = jmax(1, jmin(nChannels, nThreads));
+    for (int i = 0; i < nJobs; i++)
+        m_jobs.add(new EncodeJob(*this, i * nChannels / nJobs, (i + 1) * nChannels / nJobs));
+}
+
+CompressedFileWriter::~CompressedFileWriter()
+{
+    closeFile();
+}
+
+bool CompressedFileWriter::openFile(String filename, const String& metadata)
+{
+    File file(filename);
+    Result res = file.create();
+    if (res.failed())
+    {
+        std::cerr << "Error creating file " << filename << ":" << res.getErrorMessage() << std::endl;
+        return false;
+    }
+    file.deleteFile(); // never append to an existing file
+    m_file = file.createOutputStream();
+    if (!m_file)
+        return false;
+
+    m_file->write(CompressedFormat::fileMagic, CompressedFormat::magicLength);
+    m_file->writeInt(CompressedFormat::version);
+    m_file->writeInt((int)metadata.getNumBytesAsUTF8());
+    m_file->write(metadata.toRawUTF8(), metadata.getNumBytesAsUTF8());
+    return true;
+}
+
+void CompressedFileWriter::writeChannel(int channel, const int16* data, int nSamples)
+{
+    if (!m_file)
+        return;
+
+    int fill = m_stagingFill[channel];
+    if (fill + nSamples > m_stagingSamples)
+    {
+        // only when a block larger than the chunk size arrives, as when the pre-trigger
+        // buffer or the queue is drained at once
+        growStaging(fill + nSamples + m_chunkSamples);
+    }
+    memcpy(m_staging + channel * m_stagingSamples + fill, data, nSamples * sizeof(int16));
+    m_stagingFill[channel] = fill + nSamples;
+
+    if (fill < m_chunkSamples && fill + nSamples >= m_chunkSamples)
+        m_fullChannels++;
+    while (m_fullChannels == m_nChannels)
+        submitChunk(m_chunkSamples);
+}
+
+void CompressedFileWriter::growStaging(int nSamples)
+{
+    HeapBlock<int16> staging(m_nChannels * nSamples);
+    for (int chan = 0; chan < m_nChannels; chan++)
+        memcpy(staging + chan * nSamples, m_staging + chan * m_stagingSamples,
+               m_stagingFill[chan] * sizeof(int16));
+    m_staging.swapWith(staging);
+    m_stagingSamples = nSamples;
+}
+
+void CompressedFileWriter::submitChunk(int nSamples)
+{
+    // the previous chunk has had a whole chunk's worth of time to encode:
+    writePendingChunk();
+
+    m_fullChannels = 0;
+    for (int chan = 0; chan < m_nChannels; chan++)
+    {
+        int16* staged = m_staging + chan * m_stagingSamples;
+        int remaining = m_stagingFill[chan] - nSamples;
+        memcpy(m_chunkData + chan * m_chunkSamples, staged, nSamples * sizeof(int16));
+        memmove(staged, staged + nSamples, remaining * sizeof(int16));
+        m_stagingFill[chan] = remaining;
+        if (remaining >= m_chunkSamples)
+            m_fullChannels++;
+    }
+    m_chunkNumSamples = nSamples;
+    m_chunkFirstSample = m_samplesSubmitted;
+    m_samplesSubmitted += nSamples;
+    m_chunkPending = true;
+
+    for (int i = 0; i < m_jobs.size(); i++)
+        m_pool.addJob(m_jobs[i], false);
+}
+
+void CompressedFileWriter::writePendingChunk()
+{
+    if (!m_chunkPending)
+        return;
+
+    for (int i = 0; i < m_jobs.size(); i++)
+        m_pool.waitForJobToFinish(m_jobs[i], -1);
+    m_chunkPending = false;
+
+    m_indexSamples.add(m_chunkFirstSample);
+    m_indexOffsets.add(m_file->getPosition());
+
+    m_file->writeInt(CompressedFormat::chunkMagic);
+    m_file->writeInt64(m_chunkFirstSample);
+    m_file->writeInt(m_chunkNumSamples);
+    m_file->writeInt(m_nChannels);
+    for (int chan = 0; chan < m_nChannels; chan++)
+        m_file->writeInt(m_encodedSizes[chan]);
+    for (int chan = 0; chan < m_nChannels; chan++)
+    {
+        m_file->write(m_encodedData + chan * m_maxEncodedSize, m_encodedSizes[chan]);
+        m_encodedBytes += m_encodedSizes[chan];
+    }
+    m_rawBytes += (int64)m_nChannels * m_chunkNumSamples * sizeof(int16);
+}
+
+void CompressedFileWriter::closeFile()
+{
+    if (!m_file)
+        return;
+
+    // channels that ran ahead of the others lose their extra samples, so that all
+    // channels in the file have the same length:
+    int nSamples = m_stagingSamples;
+    for (int chan = 0; chan < m_nChannels; chan++)
+        nSamples = jmin(nSamples, m_stagingFill[chan]);
+    if (nSamples > 0)
+        submitChunk(nSamples);
+    writePendingChunk();
+
+    int64 indexOffset = m_file->getPosition();
+    m_file->writeInt(CompressedFormat::indexMagic);
+    m_file->writeInt(m_indexSamples.size());
+    for (int i = 0; i < m_indexSamples.size(); i++)
+    {
+        m_file->writeInt64(m_indexSamples[i]);
+        m_file->writeInt64(m_indexOffsets[i]);
+    }
+    m_file->writeInt64(indexOffset);
+    m_file->write(CompressedFormat::trailerMagic, CompressedFormat::magicLength);
+    m_file->flush();
+    m_file = nullptr;
+}
+
+int64 CompressedFileWriter::getRawBytes() const
+{
+    return m_rawBytes;
+}
+
+int64 CompressedFileWriter::getEncodedBytes() const
+{
+    return m_encodedBytes;
+}
+
+double CompressedFileWriter::getEncodeSeconds() const
+{
+    return Time::highResolutionTicksToSeconds(m_encodeTicks.get());
+}
+
+CompressedFileWriter::EncodeJob::EncodeJob(CompressedFileWriter& writer, int firstChannel, int lastChannel) :
+ThreadPoolJob("Compressed writer encode job"),
+m_writer(writer),
+m_firstChannel(firstChannel),
+m_lastChannel(lastChannel)
+{
+}
+
+ThreadPoolJob::JobStatus CompressedFileWriter::EncodeJob::runJob()
+{
+    int64 start = Time::getHighResolutionTicks();
+    for (int chan = m_firstChannel; chan < m_lastChannel; chan++)
+    {
+        m_writer.m_encodedSizes[chan] = (int32)NeuralCodec::encode(
+            m_writer.m_chunkData + chan * m_writer.m_chunkSamples,
+            m_writer.m_chunkNumSamples,
+            m_writer.m_encodedData + chan * m_writer.m_maxEncodedSize);
+    }
+    m_writer.m_encodeTicks += Time::getHighResolutionTicks() - start;
+    return jobHasFinished;
+}
@@ -0,0 +1,139 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSEDFILEWRITER_H
+#define COMPRESSEDFILEWRITER_H
+
+#include <BasicJuceHeader.h>
+#include "NeuralCodec.h"
+
+namespace CompressedRecordingEngine
+{
+
+    /**
+    Layout of a compressed continuous (.oec) file, all values little endian:
+
+        char[8] fileMagic
+        int32   format version
+        int32   metadata length, followed by that many bytes of UTF-8 JSON metadata
+        chunks, each:
+            int32   chunkMagic
+            int64   index of the first sample in the chunk
+            int32   number of samples per channel
+            int32   number of channels
+            int32   encoded size of each channel block
+            encoded channel blocks, see NeuralCodec
+        chunk index, written when the file is closed:
+            int32   indexMagic
+            int32   number of chunks
+            per chunk: int64 first sample, int64 file offset of the chunk header
+        int64   file offset of the chunk index
+        char[8] trailerMagic
+
+    A reader can seek to any chunk through the index. If the file was not closed cleanly,
+    the index can be rebuilt by walking the chunk headers.
+    */
+    namespace CompressedFormat
+    {
+        const char fileMagic[] = "OECZDATA";
+        const char trailerMagic[] = "OECZINDX";
+        const int magicLength = 8;
+        const int32 version = 1;
+        const int32 chunkMagic = 0x4b4e4843; // "CHNK"
+        const int32 indexMagic = 0x58444943; // "CIDX"
+    }
+
+    /**
+    Writes the continuous data of one recorded processor to a chunked compressed file.
+
+    Samples of each channel are staged until every channel holds a full chunk. Its channel
+    blocks are then encoded on the shared thread pool while the next chunk is filled, and
+    written out once that one is complete, so the record thread only ever copies samples.
+    */
+    class CompressedFileWriter
+    {
+    public:
+        CompressedFileWriter(int nChannels, int chunkSamples, ThreadPool& pool, int nThreads);
+        ~CompressedFileWriter();
+
+        bool openFile(String filename, const String& metadata);
+        void writeChannel(int channel, const int16* data, int nSamples);
+        /** Encodes and writes all staged samples and the chunk index */
+        void closeFile();
+
+        int64 getRawBytes() const;
+        int64 getEncodedBytes() const;
+        /** Total time spent encoding, summed over all worker threads */
+        double getEncodeSeconds() const;
+
+    private:
+        class EncodeJob : public ThreadPoolJob
+        {
+        public:
+            EncodeJob(CompressedFileWriter& writer, int firstChannel, int lastChannel);
+            JobStatus runJob() override;
+        private:
+            CompressedFileWriter& m_writer;
+            const int m_firstChannel;
+            const int m_lastChannel;
+        };
+
+        void submitChunk(int nSamples);
+        void writePendingChunk();
+        void growStaging(int nSamples);
+
+        ScopedPointer<FileOutputStream> m_file;
+        ThreadPool& m_pool;
+        const int m_nChannels;
+        const int m_chunkSamples;
+        int m_stagingSamples;
+        const size_t m_maxEncodedSize;
+
+        // staged samples, m_stagingSamples per channel
+        HeapBlock<int16> m_staging;
+        HeapBlock<int> m_stagingFill;
+        int m_fullChannels{ 0 };
+
+        // the chunk being encoded, m_chunkSamples and m_maxEncodedSize per channel
+        HeapBlock<int16> m_chunkData;
+        HeapBlock<uint8> m_encodedData;
+        HeapBlock<int32> m_encodedSizes;
+        int m_chunkNumSamples{ 0 };
+        int64 m_chunkFirstSample{ 0 };
+        bool m_chunkPending{ false };
+        OwnedArray<EncodeJob> m_jobs;
+
+        int64 m_samplesSubmitted{ 0 };
+        Array<int64> m_indexSamples;
+        Array<int64> m_indexOffsets;
+
+        int64 m_rawBytes{ 0 };
+        int64 m_encodedBytes{ 0 };
+        Atomic<int64> m_encodeTicks;
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CompressedFileWriter);
+    };
+
+}
+
+#endif
@@ -0,0 +1,279 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "CompressedRecording.h"
+
+#define MAX_BUFFER_SIZE 40960
+
+using namespace CompressedRecordingEngine;
+
+CompressedRecording::CompressedRecording()
+{
+    m_scaledBuffer.malloc(MAX_BUFFER_SIZE);
+    m_intBuffer.malloc(MAX_BUFFER_SIZE);
+    m_bufferSize = MAX_BUFFER_SIZE;
+    m_numThreads = SystemStats::getNumCpus();
+}
+
+CompressedRecording::~CompressedRecording()
+{
+    m_dataFiles.clear(); // writers use the thread pool
+}
+
+String CompressedRecording::getEngineID() const
+{
+    return "COMPRESSED";
+}
+
+String CompressedRecording::getRecordingNumberString(int recordingNumber)
+{
+    String s = "";
+    if (recordingNumber > 0)
+        s = "_r" + String(recordingNumber).paddedLeft('0', 2); // pad with at most 1 leading 0
+    return s;
+}
+
+String CompressedRecording::getMetadata(int processor)
+{
+    const RecordProcessorInfo& pInfo = getProcessorInfo(processor);
+    const DataChannel* chan0 = getDataChannel(getRealChannel(pInfo.recordedChannels[0]));
+
+    var channels;
+    for (int i = 0; i < pInfo.recordedChannels.size(); i++)
+    {
+        int recordedChan = pInfo.recordedChannels[i];
+        const DataChannel* datachan = getDataChannel(getRealChannel(recordedChan));
+        DynamicObject::Ptr chan = new DynamicObject();
+        chan->setProperty("name", datachan->getName());
+        chan->setProperty("bit_volts", datachan->getBitVolts());
+        channels.append(var(chan));
+    }
+
+    Time now = Time::getCurrentTime();
+    DynamicObject::Ptr json = new DynamicObject();
+    json->setProperty("processor_name", chan0->getCurrentNodeName());
+    json->setProperty("processor_id", chan0->getCurrentNodeID());
+    json->setProperty("subprocessor_index", (int)chan0->getSubProcessorIdx());
+    json->setProperty("nchans", pInfo.recordedChannels.size());
+    json->setProperty("sample_rate", chan0->getSampleRate());
+    json->setProperty("dtype", "int16");
+    json->setProperty("chunk_samples", m_chunkSamples);
+    json->setProperty("codec", "lpc2-bitpack32");
+    json->setProperty("nsamples_offset", getTimestamp(pInfo.recordedChannels[0]));
+    json->setProperty("datetime", now.toISO8601(true));
+    json->setProperty("version", CoreServices::getGUIVersion());
+    json->setProperty("channels", channels);
+    return JSON::toString(var(json), true);
+}
+
+void CompressedRecording::openFiles(File rootFolder, String baseName, int recordingNumber)
+{
+    String basepath = rootFolder.getFullPathName() + rootFolder.separatorString + baseName
+                      + getRecordingNumberString(recordingNumber);
+
+    if (!m_threadPool)
+        m_threadPool = new ThreadPool(m_numThreads);
+
+    int nRecChans = getNumRecordedChannels();
+    m_fileIndexes.insertMultiple(0, 0, nRecChans);
+    m_channelIndexes.insertMultiple(0, 0, nRecChans);
+
+    int nRecProcessors = getNumRecordedProcessors();
+    for (int proc = 0; proc < nRecProcessors; proc++)
+    {
+        const RecordProcessorInfo& pInfo = getProcessorInfo(proc);
+        int nChans = pInfo.recordedChannels.size();
+        for (int i = 0; i < nChans; i++)
+        {
+            m_fileIndexes.set(pInfo.recordedChannels[i], proc);
+            m_channelIndexes.set(pInfo.recordedChannels[i], i);
+        }
+
+        const DataChannel* chan0 = getDataChannel(getRealChannel(pInfo.recordedChannels[0]));
+        String fileName = basepath + "."
+                          + chan0->getCurrentNodeName().replaceCharacter(' ', '_') + "-"
+                          + String(chan0->getCurrentNodeID()) + "."
+                          + String(chan0->getSubProcessorIdx()) + ".oec";
+        std::cout << "OPENING FILE: " << fileName << std::endl;
+        ScopedPointer<CompressedFileWriter> writer =
+            new CompressedFileWriter(nChans, m_chunkSamples, *m_threadPool, m_numThreads);
+        if (writer->openFile(fileName, getMetadata(proc)))
+            m_dataFiles.add(writer.release());
+        else
+            m_dataFiles.add(nullptr);
+    }
+
+    if (getNumRecordedEventChannels() > 0)
+    {
+        String eventFileName = basepath + ".events.txt";
+        std::cout << "OPENING FILE: " << eventFileName << std::endl;
+        File eventf = File(eventFileName);
+        Result res = eventf.create();
+        if (res.failed())
+        {
+            std::cerr << "Error creating event file:" << res.getErrorMessage() << std::endl;
+        }
+        else
+        {
+            m_eventFile = eventf.createOutputStream(eventBufferSize);
+            *m_eventFile << "samplei\tchannel\tevent\n";
+            m_eventFilePending = true;
+            m_lastEventFlushTime = Time::getMillisecondCounter();
+        }
+    }
+}
+
+void CompressedRecording::closeFiles()
+{
+    int64 rawBytes = 0, encodedBytes = 0;
+    double encodeSeconds = 0;
+    for (int i = 0; i < m_dataFiles.size(); i++)
+    {
+        if (CompressedFileWriter* writer = m_dataFiles[i])
+        {
+            writer->closeFile();
+            rawBytes += writer->getRawBytes();
+            encodedBytes += writer->getEncodedBytes();
+            encodeSeconds += writer->getEncodeSeconds();
+        }
+    }
+    if (encodedBytes > 0 && encodeSeconds > 0)
+    {
+        std::cout << "Compressed recording: " << rawBytes << " bytes -> " << encodedBytes
+                  << " bytes, ratio " << (double)rawBytes / encodedBytes << ", "
+                  << rawBytes / encodeSeconds / 1e6 << " MB/s per core" << std::endl;
+    }
+    if (m_eventFile)
+        m_eventFile->flush();
+    resetChannels();
+}
+
+void CompressedRecording::resetChannels()
+{
+    m_dataFiles.clear();
+    m_fileIndexes.clear();
+    m_channelIndexes.clear();
+    m_eventFile = nullptr;
+    m_eventFilePending = false;
+
+    m_scaledBuffer.malloc(MAX_BUFFER_SIZE);
+    m_intBuffer.malloc(MAX_BUFFER_SIZE);
+    m_bufferSize = MAX_BUFFER_SIZE;
+}
+
+void CompressedRecording::writeData(int writeChannel, int realChannel, const float* buffer,
+                                    int size)
+{
+    if (size > m_bufferSize)
+    // shouldn't happen, and if it does it'll be slow, but better this than crashing
+    {
+        std::cerr << "Write buffer overrun, resizing to" << size << std::endl;
+        m_bufferSize = size;
+        m_scaledBuffer.malloc(size);
+        m_intBuffer.malloc(size);
+    }
+    CompressedFileWriter* writer = m_dataFiles[m_fileIndexes[writeChannel]];
+    if (!writer)
+        return;
+    double multFactor = 1 / (float(0x7fff) * getDataChannel(realChannel)->getBitVolts());
+    FloatVectorOperations::copyWithMultiply(m_scaledBuffer.getData(), buffer, multFactor,
+                                            size);
+    AudioDataConverters::convertFloatToInt16LE(m_scaledBuffer.getData(), m_intBuffer.getData(),
+                                               size);
+    writer->writeChannel(m_channelIndexes[writeChannel], m_intBuffer.getData(), size);
+}
+
+void CompressedRecording::endChannelBlock(bool lastBlock)
+{
+    if (!m_eventFile || !m_eventFilePending)
+        return;
+    uint32 now = Time::getMillisecondCounter();
+    if (lastBlock || now - m_lastEventFlushTime >= eventFlushInterval)
+    {
+        m_eventFile->flush();
+        m_eventFilePending = false;
+        m_lastEventFlushTime = now;
+    }
+}
+
+void CompressedRecording::writeEvent(int eventIndex, const MidiMessage& event)
+{
+    if (!m_eventFile)
+        return;
+    EventPtr ev = Event::deserializeFromMessage(event, getEventChannel(eventIndex));
+    if (ev->getEventType() == EventChannel::TEXT)
+    {
+        *m_eventFile << ev->getTimestamp() << "\ttext\t" << (const char*)ev->getRawDataPointer()
+                     << '\n';
+    }
+    else if (ev->getEventType() == EventChannel::TTL)
+    {
+        TTLEvent* ttl = static_cast<TTLEvent*>(ev.get());
+        *m_eventFile << ev->getTimestamp() << '\t' << (int)ttl->getChannel() << '\t'
+                     << (ttl->getState() ? 1 : 0) << '\n';
+    }
+    m_eventFilePending = true;
+}
+
+void CompressedRecording::writeTimestampSyncText(uint16 sourceID, uint16 sourceIdx,
+                                                 int64 timestamp, float, String text)
+{
+    if (!m_eventFile)
+        return;
+    *m_eventFile << timestamp << "\tsync\t" << text.toRawUTF8() << '\n';
+    m_eventFilePending = true;
+}
+
+void CompressedRecording::addSpikeElectrode(int index, const SpikeChannel* elec)
+{
+}
+
+void CompressedRecording::writeSpike(int electrodeIndex, const SpikeEvent* spike)
+{
+}
+
+RecordEngineManager* CompressedRecording::getEngineManager()
+{
+    RecordEngineManager* man = new RecordEngineManager("COMPRESSED", "Compressed",
+                                                       &(engineFactory<CompressedRecording>));
+    EngineParameter* param;
+    param = new EngineParameter(EngineParameter::INT, 0, "Samples per chunk", 16384, 1024,
+                                262144);
+    man->addParameter(param);
+    param = new EngineParameter(EngineParameter::INT, 1, "Encoder threads (0 = all cores)", 0,
+                                0, 64);
+    man->addParameter(param);
+    return man;
+}
+
+void CompressedRecording::setParameter(EngineParameter& parameter)
+{
+    intParameter(0, m_chunkSamples);
+    int numThreads = -1;
+    intParameter(1, numThreads);
+    if (numThreads >= 0)
+    {
+        m_numThreads = (numThreads == 0) ? SystemStats::getNumCpus() : numThreads;
+        m_threadPool = nullptr; // recreated with the new size when files are opened
+    }
+}
@@ -0,0 +1,86 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef COMPRESSEDRECORDING_H
+#define COMPRESSEDRECORDING_H
+
+#include <RecordingLib.h>
+#include "CompressedFileWriter.h"
+
+namespace CompressedRecordingEngine
+{
+
+    /**
+    Record engine that writes continuous data losslessly compressed, one chunked and
+    seekable .oec file per recorded processor. TTL and text events go to a tab separated
+    .events.txt file. Spikes are not stored by this engine.
+    */
+    class CompressedRecording : public RecordEngine
+    {
+    public:
+        CompressedRecording();
+        ~CompressedRecording();
+
+        String getEngineID() const override;
+        void openFiles(File rootFolder, String baseName, int recordingNumber) override;
+        void closeFiles() override;
+        void writeData(int writeChannel, int realChannel, const float* buffer, int size) override;
+        void endChannelBlock(bool lastBlock) override;
+        void writeEvent(int eventIndex, const MidiMessage& event) override;
+        void resetChannels() override;
+        void addSpikeElectrode(int index, const SpikeChannel* elec) override;
+        void writeSpike(int electrodeIndex, const SpikeEvent* spike) override;
+        void writeTimestampSyncText(uint16 sourceID, uint16 sourceIdx, int64 timestamp, float, String text) override;
+        void setParameter(EngineParameter& parameter) override;
+
+        static RecordEngineManager* getEngineManager();
+
+    private:
+        String getRecordingNumberString(int recordingNumber);
+        String getMetadata(int processor);
+
+        HeapBlock<float> m_scaledBuffer;
+        HeapBlock<int16> m_intBuffer;
+        int m_bufferSize;
+
+        ScopedPointer<ThreadPool> m_threadPool;
+        int m_numThreads;
+        int m_chunkSamples{ 16384 };
+
+        OwnedArray<CompressedFileWriter> m_dataFiles;
+        Array<int> m_fileIndexes;
+        Array<int> m_channelIndexes;
+        ScopedPointer<FileOutputStream> m_eventFile;
+        bool m_eventFilePending{ false };
+        uint32 m_lastEventFlushTime{ 0 };
+
+        //Compile-time constants
+        const int eventBufferSize{ 1 << 16 };
+        const uint32 eventFlushInterval{ 500 };
+
+        JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CompressedRecording);
+    };
+
+}
+
+#endif
@@ -0,0 +1,202 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "NeuralCodec.h"
+
+using namespace CompressedRecordingEngine;
+
+namespace
+{
+    // second order residuals of int16 data need up to 18 bits after zigzag coding
+    const int maxBitWidth = 18;
+
+    inline uint32 zigzag(int32 v)
+    {
+        return ((uint32)v << 1) ^ (uint32)(v >> 31);
+    }
+
+    inline int32 unzigzag(uint32 v)
+    {
+        return (int32)(v >> 1) ^ -(int32)(v & 1);
+    }
+
+    inline int bitWidth(uint32 v)
+    {
+        int width = 0;
+        while (v != 0)
+        {
+            v >>= 1;
+            width++;
+        }
+        return width;
+    }
+
+    int choosePredictor(const int16* in, int nSamples)
+    {
+        // sum of absolute residuals for each order, in a single pass:
+        int64 sum0 = 0, sum1 = 0, sum2 = 0;
+        for (int i = 2; i < nSamples; i++)
+        {
+            int32 x0 = in[i];
+            int32 d1 = x0 - in[i - 1];
+            int32 d2 = d1 - (in[i - 1] - in[i - 2]);
+            sum0 += std::abs(x0);
+            sum1 += std::abs(d1);
+            sum2 += std::abs(d2);
+        }
+        if (sum2 < sum1 && sum2 < sum0)
+            return 2;
+        return (sum1 < sum0) ? 1 : 0;
+    }
+}
+
+size_t NeuralCodec::getMaxEncodedSize(int nSamples)
+{
+    int nSubBlocks = (nSamples + subBlockSize - 1) / subBlockSize;
+    return 1 + maxOrder * sizeof(int16) + nSubBlocks * (1 + (subBlockSize * maxBitWidth + 7) / 8);
+}
+
+size_t NeuralCodec::encode(const int16* in, int nSamples, uint8* out)
+{
+    uint8* const start = out;
+    int order = (nSamples > maxOrder) ? choosePredictor(in, nSamples) : 0;
+    *out++ = (uint8)order;
+    for (int i = 0; i < order; i++)
+    {
+        *out++ = (uint8)(in[i] & 0xff);
+        *out++ = (uint8)((in[i] >> 8) & 0xff);
+    }
+
+    uint32 residuals[subBlockSize];
+    for (int pos = order; pos < nSamples; pos += subBlockSize)
+    {
+        int n = jmin(subBlockSize, nSamples - pos);
+        const int16* x = in + pos;
+        uint32 bits = 0;
+        switch (order)
+        {
+        case 0:
+            for (int i = 0; i < n; i++)
+                residuals[i] = zigzag(x[i]);
+            break;
+        case 1:
+            for (int i = 0; i < n; i++)
+                residuals[i] = zigzag((int32)x[i] - x[i - 1]);
+            break;
+        default:
+            for (int i = 0; i < n; i++)
+                residuals[i] = zigzag((int32)x[i] - 2 * (int32)x[i - 1] + x[i - 2]);
+            break;
+        }
+        for (int i = 0; i < n; i++)
+            bits |= residuals[i];
+
+        int width = bitWidth(bits);
+        *out++ = (uint8)width;
+        if (width == 0)
+            continue;
+
+        uint64 acc = 0;
+        int accBits = 0;
+        for (int i = 0; i < n; i++)
+        {
+            acc |= (uint64)residuals[i] << accBits;
+            accBits += width;
+            while (accBits >= 8)
+            {
+                *out++ = (uint8)acc;
+                acc >>= 8;
+                accBits -= 8;
+            }
+        }
+        if (accBits > 0)
+            *out++ = (uint8)acc; // sub-blocks are byte aligned
+    }
+    return out - start;
+}
+
+bool NeuralCodec::decode(const uint8* in, size_t size, int16* out, int nSamples)
+{
+    const uint8* const end = in + size;
+    if (size < 1)
+        return false;
+    int order = *in++;
+    if (order > maxOrder || order > nSamples || in + order * sizeof(int16) > end)
+        return false;
+    for (int i = 0; i < order; i++)
+    {
+        out[i] = (int16)(in[0] | (in[1] << 8));
+        in += 2;
+    }
+
+    uint32 residuals[subBlockSize];
+    for (int pos = order; pos < nSamples; pos += subBlockSize)
+    {
+        int n = jmin(subBlockSize, nSamples - pos);
+        if (in >= end)
+            return false;
+        int width = *in++;
+        if (width > maxBitWidth || in + (n * width + 7) / 8 > end)
+            return false;
+
+        if (width == 0)
+        {
+            zeromem(residuals, n * sizeof(uint32));
+        }
+        else
+        {
+            const uint32 mask = (1u << width) - 1;
+            uint64 acc = 0;
+            int accBits = 0;
+            for (int i = 0; i < n; i++)
+            {
+                while (accBits < width)
+                {
+                    acc |= (uint64)(*in++) << accBits;
+                    accBits += 8;
+                }
+                residuals[i] = (uint32)acc & mask;
+                acc >>= width;
+                accBits -= width;
+            }
+        }
+
+        int16* x = out + pos;
+        switch (order)
+        {
+        case 0:
+            for (int i = 0; i < n; i++)
+                x[i] = (int16)unzigzag(residuals[i]);
+            break;
+        case 1:
+            for (int i = 0; i < n; i++)
+                x[i] = (int16)(unzigzag(residuals[i]) + x[i - 1]);
+            break;
+        default:
+            for (int i = 0; i < n; i++)
+                x[i] = (int16)(unzigzag(residuals[i]) + 2 * (int32)x[i - 1] - x[i - 2]);
+            break;
+        }
+    }
+    return true;
+}
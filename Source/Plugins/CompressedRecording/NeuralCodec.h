@@ -0,0 +1,64 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef NEURALCODEC_H
+#define NEURALCODEC_H
+
+#include <BasicJuceHeader.h>
+
+namespace CompressedRecordingEngine
+{
+
+    /**
+    Fast lossless codec for blocks of int16 neural data from a single channel.
+
+    Each block is encoded as a fixed linear predictor (order 0, 1 or 2, whichever gives
+    the smallest residuals for the block), followed by the zigzag-coded residuals bit-packed
+    in sub-blocks of subBlockSize samples, each with its own bit width:
+
+        uint8  predictor order
+        int16  order warm-up samples, little endian
+        per sub-block: uint8 bit width, then ceil(n * width / 8) bytes, LSB first
+
+    Blocks are independent, so channels and chunks can be encoded and decoded in parallel.
+    */
+    namespace NeuralCodec
+    {
+        const int subBlockSize = 32;
+        const int maxOrder = 2;
+
+        /** Upper bound of the encoded size in bytes of a block of nSamples */
+        size_t getMaxEncodedSize(int nSamples);
+
+        /** Encodes nSamples from in into out, which must hold getMaxEncodedSize(nSamples)
+        bytes. Returns the number of bytes written. */
+        size_t encode(const int16* in, int nSamples, uint8* out);
+
+        /** Decodes a block of nSamples that was encoded into size bytes. Returns false
+        if the block is malformed. */
+        bool decode(const uint8* in, size_t size, int16* out, int nSamples);
+    }
+
+}
+
+#endif
@@ -0,0 +1,357 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "EcubeBufferAssembler.h"
+
+static const char bits_port0[16] = { 23, 22, -1, 14, 11, -1, -1, 28, 12, 10, 27, 26, -1, -1, -1, -1 };
+static const char bits_port1[16] = { 20, 21, 19, 18, 13, 6, 4, 5, 3, 2, -1, -1, 29, -1, 24, 25 };
+static const char bits_port2[16] = { 16, 17, 15, 8, 9, 7, 0, 1, 31, 30, -1, -1, -1, -1, -1, -1 };
+
+// Builds bit conversion table for 8 bits of raw data
+static void build_bit_conversion_table(uint32_t* table, const char* bits)
+{
+    for (uint16_t i = 0; i < 256; i++)
+    {
+        uint8_t is = i;
+        uint32_t outval = 0;
+        for (uint16_t j = 0; j < 8; j++)
+        {
+            if ((is & 1) && bits[j]>=0)
+            {
+                outval |= (uint32_t)1<<bits[j];
+            }
+            is >>= 1;
+        }
+        table[i] = outval;
+    }
+}
+
+static void build_bit_conversion_tables(uint32_t* tables)
+{
+    // Bit conversion tables have 256 uint64s for each 8 bits of ecube ports
+    // Each sparse 16-bit port has two such tables
+    // The structure in memory is {tbl_port0l, tbl_port0h, tbl_port1l, tbl_port1h, tbl_port2l, tbl_port2h)
+    build_bit_conversion_table(tables        , bits_port0);
+    build_bit_conversion_table(tables + 0x100, bits_port0 + 8);
+    build_bit_conversion_table(tables + 0x200, bits_port1);
+    build_bit_conversion_table(tables + 0x300, bits_port1 + 8);
+    build_bit_conversion_table(tables + 0x400, bits_port2);
+    build_bit_conversion_table(tables + 0x500, bits_port2 + 8);
+}
+
+
+EcubeBufferAssembler::EcubeBufferAssembler (DataFormat format_, const std::vector<unsigned long>& streamIds,
+                                            unsigned long sampleTime80MHz_, DataBuffer* output_)
+    : format            (format_)
+    , numChannelObjects ((int) streamIds.size())
+    , sampleTime80MHz   (sampleTime80MHz_)
+    , output            (output_)
+    , timestampLocked   (false)
+    , bufTimestamp      (0)
+    , bufTimestamp64    (0)
+    , intBufSize        (0)
+    , bufferFrames      (0)
+{
+    unsigned long maxId = 0;
+    for (unsigned long id : streamIds)
+        maxId = jmax (maxId, id);
+
+    streamTable.assign (maxId + 1, -1);
+    for (size_t i = 0; i < streamIds.size(); i++)
+        streamTable[streamIds[i]] = (int) i;
+
+    if (format == dfSeparateChannelsAnalog)
+        frameChannels = numChannelObjects;
+    else if (format == dfInterleavedChannelsAnalog)
+        frameChannels = 32;
+    else
+        frameChannels = 64;
+
+    ensureCapacity (1500);
+
+    if (format == dfDigital)
+    {
+        bitConversionTables.malloc (0x600);
+        build_bit_conversion_tables (bitConversionTables);
+    }
+}
+
+
+EcubeBufferAssembler::~EcubeBufferAssembler()
+{
+}
+
+
+void EcubeBufferAssembler::reset()
+{
+    timestampLocked = false;
+}
+
+
+int EcubeBufferAssembler::getChannelIndex (unsigned long streamId) const
+{
+    return streamId < streamTable.size() ? streamTable[streamId] : -1;
+}
+
+
+void EcubeBufferAssembler::ensureCapacity (unsigned long numFrames)
+{
+    if (numFrames <= bufferFrames)
+        return;
+
+    interleavingBuffer.calloc (numFrames * frameChannels);
+    eventBuffer.calloc (numFrames);
+    timestampBuffer.calloc (numFrames);
+    bufferFrames = numFrames;
+}
+
+
+void EcubeBufferAssembler::advanceTimestamp (uint32_t timestamp)
+{
+    // The eCube timestamp is a wrapping 32-bit 80 MHz counter; unsigned
+    // subtraction gives the forward distance across a wrap
+    if (timestampLocked)
+        bufTimestamp64 += (uint32_t) (timestamp - bufTimestamp);
+    else
+        bufTimestamp64 = timestamp;
+
+    bufTimestamp = timestamp;
+}
+
+
+void EcubeBufferAssembler::flush()
+{
+    // Convert eCube 80MHz timestamp into a sample number
+    const int64 cts = bufTimestamp64 / sampleTime80MHz;
+
+    for (unsigned long j = 0; j < intBufSize; j++)
+        timestampBuffer[j] = cts + j;
+
+    output->addToBuffer (interleavingBuffer, timestampBuffer, eventBuffer, intBufSize, 1);
+}
+
+
+void EcubeBufferAssembler::addBuffer (unsigned long streamId, uint32_t bts, const void* data, unsigned long dataSizeBytes)
+{
+    const int chid = getChannelIndex (streamId);
+    if (chid < 0)
+        return;
+
+    // Data size is returned in bytes, not in samples
+    const unsigned long datasize = dataSizeBytes / 2;
+
+    if (format == dfSeparateChannelsAnalog)
+    {
+        const uint32_t tsdif = bts - bufTimestamp;
+        if (! timestampLocked || (tsdif >= sampleTime80MHz && (0u - tsdif) >= sampleTime80MHz)
+            || datasize != intBufSize)
+        {
+            // The new buffer does not match interleaving buffer length, or has a different timestamp,
+            // or interleaving buffer is empty
+            if (timestampLocked)
+                flush(); // Send the previous set of frames out to the application
+
+            advanceTimestamp (bts);
+            intBufSize = datasize;
+            timestampLocked = true;
+            ensureCapacity (datasize);
+            // Clear the interleaving buffer within the new packet's size
+            memset (interleavingBuffer, 0, sizeof (float) * datasize * frameChannels);
+        }
+
+        const int16_t* pData = (const int16_t*) data;
+        float* dest = interleavingBuffer + chid;
+        for (unsigned long j = 0; j < datasize; j++)
+            dest[frameChannels * j] = pData[j] * headstageScale; // Convert into microvolts
+    }
+    else if (format == dfInterleavedChannelsAnalog)
+    {
+        advanceTimestamp (bts);
+        timestampLocked = true;
+        ensureCapacity ((datasize + 31) / 32);
+
+        const int16_t* pData = (const int16_t*) data;
+        for (unsigned long j = 0; j < datasize; j++)
+            interleavingBuffer[j] = pData[j] * panelAnalogScale; // Convert into volts
+
+        // Samples on the Panel Analog input come as whole 32-channel frames
+        intBufSize = datasize / 32;
+        flush();
+    }
+    else // Digital data
+    {
+        const uint32_t tsdif = bts - bufTimestamp;
+        if (! timestampLocked || (bts != bufTimestamp && tsdif != 5 && tsdif != 10 && tsdif != 0xFFFFFFFB && tsdif != 0xFFFFFFFA)
+            || datasize != intBufSize)
+        {
+            // The new buffer does not match interleaving buffer length, or has a different timestamp,
+            // or interleaving buffer is empty
+            if (timestampLocked)
+                flush();
+
+            advanceTimestamp (bts);
+            intBufSize = datasize;
+            timestampLocked = true;
+            ensureCapacity (datasize);
+            // Clear the interleaving buffer and the event buffer within the new packet's size
+            memset (interleavingBuffer, 0, sizeof (float) * datasize * frameChannels);
+            memset (eventBuffer, 0, sizeof (uint64) * datasize);
+        }
+
+        addDigitalWords (chid, (const uint16_t*) data, datasize);
+    }
+}
+
+
+void EcubeBufferAssembler::addDigitalWords (int chid, const uint16_t* pData, unsigned long datasize)
+{
+    const char* pbits;
+    const uint32_t* pconvtbl;
+    switch (chid)
+    {
+        case 0:
+        case 3:
+            pbits = bits_port0;
+            pconvtbl = bitConversionTables;
+            break;
+        case 1:
+        case 4:
+            pbits = bits_port1;
+            pconvtbl = bitConversionTables + 0x200;
+            break;
+        case 2:
+        case 5:
+        default:
+            pbits = bits_port2;
+            pconvtbl = bitConversionTables + 0x400;
+            break;
+    }
+    const int bitchn_offset = chid >= 3 ? 32 : 0;
+    const int dword_shift = chid >= 3 ? 32 : 0;
+
+    // Output channels driven by this port, so the per-word loop skips unused bits
+    int numBits = 0;
+    int bitIndex[16];
+    int bitChannel[16];
+    for (int k = 0; k < 16; k++)
+    {
+        if (pbits[k] >= 0)
+        {
+            bitIndex[numBits] = k;
+            bitChannel[numBits] = pbits[k] + bitchn_offset;
+            numBits++;
+        }
+    }
+
+    for (unsigned long j = 0; j < datasize; j++)
+    {
+        const uint16_t wrd = pData[j];
+
+        // Convert the word into packed 32-bit representation for this port
+        const uint32_t packedwrd = pconvtbl[wrd & 0xFF] | pconvtbl[0x100 + (wrd >> 8)];
+        eventBuffer[j] |= (uint64) packedwrd << dword_shift;
+
+        float* frame = interleavingBuffer + frameChannels * j;
+        for (int b = 0; b < numBits; b++)
+            frame[bitChannel[b]] = (wrd >> bitIndex[b]) & 1 ? 5.0f : 0.0f; // Convert to 5V/0V values
+    }
+}
+
+
+double EcubeBufferAssembler::runSyntheticBenchmark (DataFormat format, int numChannelObjects, int numBufferSets)
+{
+    const unsigned long sampleTime = 3200; // 25 kHz in 80 MHz ticks
+    unsigned long samplesPerBuffer;
+    if (format == dfInterleavedChannelsAnalog)
+    {
+        numChannelObjects = 1;
+        samplesPerBuffer = 32 * 40;
+    }
+    else
+    {
+        samplesPerBuffer = 1000;
+        if (format == dfDigital)
+            numChannelObjects = jmin (numChannelObjects, 6);
+    }
+
+    std::vector<unsigned long> streamIds;
+    OwnedArray<SyntheticEcubeDataBuffer> buffers;
+    for (int i = 0; i < numChannelObjects; i++)
+    {
+        streamIds.push_back (100 + 3 * i);
+        buffers.add (new SyntheticEcubeDataBuffer (streamIds.back(), samplesPerBuffer));
+    }
+
+    const int framesPerSet = format == dfInterleavedChannelsAnalog ? samplesPerBuffer / 32 : samplesPerBuffer;
+
+    DataBuffer output (format == dfSeparateChannelsAnalog ? numChannelObjects : format == dfDigital ? 64 : 32,
+                       framesPerSet * 4);
+    EcubeBufferAssembler assembler (format, streamIds, sampleTime, &output);
+
+    AudioSampleBuffer drain (assembler.getNumOutputChannels(), framesPerSet * 4);
+    HeapBlock<uint64> drainTimestamps (framesPerSet * 4);
+    HeapBlock<uint64> drainEvents (framesPerSet * 4);
+
+    // starting close to the 32-bit limit exercises the wrap-around
+    uint32_t timestamp = 0xFFFFFFFF - 10 * sampleTime * samplesPerBuffer;
+    int64 frames = 0;
+
+    const int64 start = Time::getHighResolutionTicks();
+    for (int set = 0; set < numBufferSets; set++)
+    {
+        for (int i = 0; i < buffers.size(); i++)
+        {
+            buffers[i]->generate (timestamp);
+            assembler.addBuffer (buffers[i]->GetStreamID(), buffers[i]->GetTimestamp(),
+                                 buffers[i]->GetDataPointer(), buffers[i]->GetDataSize());
+        }
+        timestamp += sampleTime * framesPerSet;
+        frames += output.readAllFromBuffer (drain, drainTimestamps, drainEvents, framesPerSet * 4);
+    }
+    const double seconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+
+    return seconds > 0 ? frames / seconds : 0;
+}
+
+
+SyntheticEcubeDataBuffer::SyntheticEcubeDataBuffer (unsigned long streamId_, unsigned long numSamples_)
+    : streamId      (streamId_)
+    , numSamples    (numSamples_)
+    , timestamp     (0)
+    , phase         (streamId_ * 7919)
+{
+    data.malloc (numSamples);
+}
+
+
+void SyntheticEcubeDataBuffer::generate (uint32_t timestamp_)
+{
+    timestamp = timestamp_;
+
+    // cheap pseudo-random samples, so the conversion cannot be folded away
+    for (unsigned long i = 0; i < numSamples; i++)
+    {
+        phase = phase * 1664525u + 1013904223u;
+        data[i] = (int16_t) (phase >> 16);
+    }
+}
@@ -0,0 +1,139 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef ECUBEBUFFERASSEMBLER_H_INCLUDED
+#define ECUBEBUFFERASSEMBLER_H_INCLUDED
+
+#include <DataThreadHeaders.h>
+#include <stdint.h>
+#include <vector>
+
+/**
+    Device-independent half of the eCube acquisition path.
+
+    EcubeThread fetches buffers from the eCube API and hands each one to
+    addBuffer(). This class deinterleaves or converts the samples into
+    frames, unwraps the 32-bit 80 MHz buffer timestamps into 64-bit sample
+    numbers, and pushes each completed set of frames to the DataBuffer with
+    a single addToBuffer() call. Stream IDs are looked up in a flat table.
+
+    It has no COM dependencies, so runSyntheticBenchmark() can exercise the
+    whole path with SyntheticEcubeDataBuffer on any platform; open-ephys-benchmark
+    --ecube runs it.
+
+    @see EcubeThread
+*/
+class EcubeBufferAssembler
+{
+public:
+    enum DataFormat
+    {
+        dfSeparateChannelsAnalog,
+        dfInterleavedChannelsAnalog,
+        dfDigital
+    };
+
+    /** streamIds[i] is the eCube stream ID of channel object i. */
+    EcubeBufferAssembler (DataFormat format, const std::vector<unsigned long>& streamIds,
+                          unsigned long sampleTime80MHz, DataBuffer* output);
+    ~EcubeBufferAssembler();
+
+    /** Forgets any partially assembled frames, called when acquisition starts. */
+    void reset();
+
+    /** Processes one buffer fetched from the device. */
+    void addBuffer (unsigned long streamId, uint32_t timestamp, const void* data, unsigned long dataSizeBytes);
+
+    /** Returns the channel object index of a stream, or -1 if it is not ours. */
+    int getChannelIndex (unsigned long streamId) const;
+
+    DataFormat getFormat() const { return format; }
+
+    /** Number of channels in each output frame. */
+    int getNumOutputChannels() const { return frameChannels; }
+
+    /** Feeds numBufferSets sets of synthetic buffers through the assembler and
+        returns the throughput in frames per second. */
+    static double runSyntheticBenchmark (DataFormat format, int numChannelObjects, int numBufferSets);
+
+private:
+    void flush();
+    void advanceTimestamp (uint32_t timestamp);
+    /** Makes room for numFrames frames. Only called with no frames pending, so nothing is kept. */
+    void ensureCapacity (unsigned long numFrames);
+    void addDigitalWords (int port, const uint16_t* words, unsigned long numWords);
+
+    DataFormat format;
+    int numChannelObjects;
+    int frameChannels;
+    unsigned long sampleTime80MHz;
+    DataBuffer* output;
+
+    std::vector<int> streamTable; // stream ID -> channel object index, -1 if unused
+
+    HeapBlock<float, true> interleavingBuffer;
+    HeapBlock<uint64, true> eventBuffer;
+    HeapBlock<int64, true> timestampBuffer;
+    HeapBlock<uint32_t, true> bitConversionTables;
+
+    bool timestampLocked;
+    uint32_t bufTimestamp;
+    int64 bufTimestamp64;
+    unsigned long intBufSize;
+    unsigned long bufferFrames; // capacity, grows to the largest buffer the device delivers
+
+    //Compile-time constants
+    const float headstageScale{ 6.25e3f / 32768 }; // microvolts per bit
+    const float panelAnalogScale{ 10.0f / 32768 }; // volts per bit
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EcubeBufferAssembler);
+};
+
+
+/**
+    Stand-in for the eCube API's IEcubeDataBuffer, with the same accessors,
+    so the acquisition path can be benchmarked without a device.
+*/
+class SyntheticEcubeDataBuffer
+{
+public:
+    SyntheticEcubeDataBuffer (unsigned long streamId, unsigned long numSamples);
+
+    /** Advances the timestamp and fills the buffer with a new block of samples. */
+    void generate (uint32_t timestamp);
+
+    unsigned long GetStreamID() const { return streamId; }
+    uint32_t GetTimestamp() const { return timestamp; }
+    unsigned long GetDataSize() const { return numSamples * sizeof (int16_t); }
+    unsigned char* GetDataPointer() const { return (unsigned char*) data.getData(); }
+
+private:
+    unsigned long streamId;
+    unsigned long numSamples;
+    uint32_t timestamp;
+    uint32_t phase;
+    HeapBlock<int16_t> data;
+};
+
+
+#endif  // ECUBEBUFFERASSEMBLER_H_INCLUDED
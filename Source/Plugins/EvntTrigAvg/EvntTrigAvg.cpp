@@ -22,6 +22,7 @@
 */
 
 #include <stdio.h>
+#include <algorithm>
 #include "EvntTrigAvg.h"
 #include "EvntTrigAvgCanvas.h"
 //#include "HistogramLib/HistogramLib.h"
@@ -66,12 +67,14 @@ void EvntTrigAvg::setParameter(int parameterIndex, float newValue)
     else if (parameterIndex == 4)
         changed = true;
     
-    // If anything was changed, delete all data and start over
+    // If anything was changed, delete all data and start over. During
+    // acquisition the histograms are being filled on the audio thread, so
+    // the reset is done there at the start of the next block.
     if (changed){
-        spikeData.clear();
-        ttlTimestampBuffer.clear();
-        lastTTLCalculated=0;
-        updateSettings();
+        if (CoreServices::getAcquisitionStatus())
+            resetRequested = true;
+        else
+            resetHistograms();
     }
 }
 
@@ -85,28 +88,27 @@ void EvntTrigAvg::updateSettings()
  //   electrodeMap = createElectrodeMap();
     electrodeLabels.clear();
     electrodeLabels = createElectrodeLabels();
-    if(spikeData.size()!=getTotalSpikeChannels())
-        spikeData.resize(getTotalSpikeChannels());
     electrodeSortedId.clear();
-    if(electrodeSortedId.size()!=getTotalSpikeChannels())
-        electrodeSortedId.resize(getTotalSpikeChannels());
-    for(int electrodeIt = 0 ; electrodeIt < spikeData.size() ; electrodeIt++){
+    electrodeSortedId.resize(getTotalSpikeChannels());
+    unitHistograms.clear();
+    unitHistograms.resize(getTotalSpikeChannels());
+    for(int electrodeIt = 0 ; electrodeIt < getTotalSpikeChannels() ; electrodeIt++){
         electrodeSortedId[electrodeIt].push_back(0);
-        if(spikeData[electrodeIt].size()<1)
-            spikeData[electrodeIt].resize(1);
+        UnitHistogram unit = {histogramData[electrodeIt], minMaxMean[electrodeIt], 0, 0, getNumBins()};
+        unitHistograms[electrodeIt].push_back(unit);
     }
+    // the spikes and triggers kept so far belong to the old channel layout
+    resetWindows();
 }
 void EvntTrigAvg::initializeHistogramArray()
 {
     const ScopedLock lock(mut);
     for (int i = 0 ; i < getTotalSpikeChannels() ; i++){
-        histogramData.add(new uint64[1003]{0});
-        histogramData[i][0]=i;//electrode
-        histogramData[i][1]=0;//sortedID
-        histogramData[i][2]=0;//num bins used
-        for (int data = 3 ; data < 1003 ; data++){
-            histogramData[i][data] = 0;
-        }
+        uint64* row = new uint64[maxBins+3](); // zeroed
+        row[0]=i;//electrode
+        row[1]=0;//sortedID
+        row[2]=getNumBins();//num bins used
+        histogramData.add(row);
     }
 }
 
@@ -140,6 +142,7 @@ void EvntTrigAvg::clearMinMaxMean()
 
 bool EvntTrigAvg::enable()
 {
+    resetWindows();
     return true;
 }
 
@@ -152,28 +155,16 @@ bool EvntTrigAvg::disable()
 void EvntTrigAvg::process(AudioSampleBuffer& buffer)
 {
     
-    checkForEvents(true);// see if got any spikes
-    
+    if(resetRequested.exchange(false))
+        resetHistograms();
+
     if(buffer.getNumChannels() != numChannels)
         numChannels = buffer.getNumChannels();
-    if(ttlTimestampBuffer.size() > lastTTLCalculated && buffer.getNumSamples() + getTimestamp(0) >= ttlTimestampBuffer[lastTTLCalculated+1] + windowSize/2){ // if need to recalc
-        recalc = true;
-    }
-    if(recalc){ // triggered after window time has expirered
-        //process the data
-        processSpikeData(spikeData, ttlTimestampBuffer);
-        
-        //clear the data
-        for(int channelIterator = 0 ; channelIterator < spikeData.size() ; channelIterator++){
-            for(int sortedIdIterator = 0 ; sortedIdIterator < spikeData[channelIterator].size() ; sortedIdIterator++){
-                spikeData[channelIterator][sortedIdIterator].clear();
-            }
-        }
-        //advance the TTL that needs to be calculated
-        lastTTLCalculated+=1;
-        //just recalculated, don't need to again until next ttl window has expired
-        recalc=false;
-    }
+    
+    checkForEventLanes(TTL_EVENT_LANE | SPIKE_EVENT_LANE);// see if got any spikes or triggers
+
+    if(numChannels > 0)
+        trimWindows(getTimestamp(0) + buffer.getNumSamples());
 }
 
 void EvntTrigAvg::handleEvent(const EventChannel* eventInfo, const MidiMessage& event, int sampleNum)
@@ -183,7 +174,7 @@ void EvntTrigAvg::handleEvent(const EventChannel* eventInfo, const MidiMessage&
     {// if TTL from right channel
         TTLEventPtr ttl = TTLEvent::deserializeFromMessage(event, eventInfo);
         if (ttl->getChannel() == triggerChannel)
-            ttlTimestampBuffer.push_back(Event::getTimestamp(event)); // add timestamp of TTL to buffer
+            addTrigger(Event::getTimestamp(event));
     }
 }
 
@@ -194,91 +185,49 @@ void EvntTrigAvg::handleSpike(const SpikeChannel* spikeInfo, const MidiMessage&
         return;
     else {
         // extract information from spike
-        
-        const SpikeChannel* chan = newSpike->getChannelInfo();
-        Array<SourceChannelInfo> chanInfo = chan->getSourceChannelInfo();
-        //int chanIDX = chanInfo[0].channelIDX;
         int electrode = getSpikeChannelIndex(newSpike);
-        //std::cout<<"chanIDX: " << chanIDX << "\n";
         int sortedID = newSpike->getSortedID();
         //int electrode = electrodeMap[chanInfo];
-        if(sortedID!=0 && sortedID>idIndex.size()){ // respond to new sortedID
-            idIndex.push_back(spikeData[electrode].size());// update map of what sorted ID is on what electrode
+        if (electrode < 0 || electrode >= int(unitHistograms.size()))
+            return;
+
+        // unit 0 collects every spike on the electrode, sorted units get their own row
+        int unit = 0;
+        if (sortedID != 0){
+            std::vector<int>& ids = electrodeSortedId[electrode];
+            unit = int(std::find(ids.begin(), ids.end(), sortedID) - ids.begin());
+            if (unit == int(ids.size()))
+                addNewSortedId(electrode, sortedID);
         }
-            
-        bool newID = true;
-        //for(int i = 0 ; i < electrodeSortedId[chanIDX].size() ; i++){
-        for(int i = 0 ; i < electrodeSortedId[electrode].size() ; i++){
-            //if(sortedID == electrodeSortedId[chanIDX][i])
-           if(sortedID == electrodeSortedId[electrode][i])
-               newID=false;
-        }
-        if(newID){
-            //electrodeSortedId[chanIDX].push_back(sortedID);
-            electrodeSortedId[electrode].push_back(sortedID);
-            addNewSortedIdMinMaxMean(electrode,sortedID);
-            addNewSortedIdHistoData(electrode,sortedID); //insert new sortedId into histogramArray
-            spikeData[electrode].resize(spikeData[electrode].size()+1);
-            }
-        
-        int relativeSortedID = 0;
-        if (sortedID>0)
-            relativeSortedID = idIndex[sortedID-1];
-        spikeData[electrode][0].push_back(newSpike->getTimestamp());
-        if (sortedID>0)
-            spikeData[electrode][relativeSortedID].push_back(newSpike->getTimestamp());
+        addSpike(electrode, unit, newSpike->getTimestamp());
     }
 }
 
-void EvntTrigAvg::addNewSortedIdHistoData(int electrode,int sortedId)
+void EvntTrigAvg::addNewSortedId(int electrode,int sortedId)
 {
     const ScopedLock myScopedLock(mut);
-    if(electrode == getTotalSpikeChannels()-1){
-        histogramData.add(new uint64[1003]{0});
-        histogramData.getLast()[0]=electrode;//electrode
-        histogramData.getLast()[1]=sortedId;//sortedID
-        histogramData.getLast()[2]=windowSize/binSize;//num bins used
-
-        return;
-    }
-    else{
-        for(int i = 1 ; i < histogramData.size() ; i++){
-            if(histogramData[i][0]>electrode){
-                histogramData.insert(i,new uint64[1003]{0});
-                histogramData[i][0]=electrode;//electrode
-                histogramData[i][1]=sortedId;//sortedID
-                histogramData[i][2]=windowSize/binSize;//num bins used
-                return;
-            }
-        }
-    }
-}
-
-void EvntTrigAvg::addNewSortedIdMinMaxMean(int electrode,int sortedId)
-{
-    const ScopedLock myScopedLock(mut);
-    if(electrode == getTotalSpikeChannels()-1){
-        minMaxMean.add(new float[5]);
-        minMaxMean.getLast()[0]=electrode;//electrode
-        minMaxMean.getLast()[1]=sortedId;//sortedID
-        minMaxMean.getLast()[2]=0;//minimum
-        minMaxMean.getLast()[3]=0;//maximum
-        minMaxMean.getLast()[4]=0;//mean
-        return;
-    }
-    else{
-        for(int i = 1 ; i < histogramData.size() ; i++){
-            if(minMaxMean[i][0]>electrode){
-                minMaxMean.insert(i,new float[5]);
-                minMaxMean[i][0]=electrode;//electrode
-                minMaxMean[i][1]=sortedId;//sortedID
-                minMaxMean[i][2]=0;//minimum
-                minMaxMean[i][3]=0;//maximum
-                minMaxMean[i][4]=0;//mean
-                return;
-            }
-        }
-    }
+    // rows are kept grouped by electrode, insert after the last row of this one
+    int i = 0;
+    while (i < histogramData.size() && histogramData[i][0] <= uint64(electrode))
+        i++;
+
+    uint64* row = new uint64[maxBins+3]{0};
+    row[0]=electrode;//electrode
+    row[1]=sortedId;//sortedID
+    row[2]=getNumBins();//num bins used
+    histogramData.insert(i,row);
+
+    float* stats = new float[5];
+    stats[0]=electrode;//electrode
+    stats[1]=sortedId;//sortedID
+    stats[2]=0;//minimum
+    stats[3]=0;//maximum
+    stats[4]=0;//mean
+    minMaxMean.insert(i,stats);
+
+    electrodeSortedId[electrode].push_back(sortedId);
+    UnitHistogram unit = {row, stats, 0, 0, getNumBins()};
+    unitHistograms[electrode].push_back(unit);
 }
 
 //AudioProcessorEditor* EvntTrigAvg::createEditor()
@@ -336,84 +285,123 @@ std::vector<String> EvntTrigAvg::createElectrodeLabels()
     return map;
 }
 
-/** passes data into createHistogramData() by electrode and sorted ID */
-void EvntTrigAvg::processSpikeData(std::vector<std::vector<std::vector<uint64>>> spikeData,std::vector<uint64> ttlData)
+/** bins a new spike against every trigger window already open around it */
+void EvntTrigAvg::addSpike(int electrode, int unit, uint64 timestamp)
 {
-    
-    for (int channelIterator = 0 ; channelIterator < getTotalSpikeChannels() ; channelIterator++){
-        const ScopedLock myScopedLock(mut);
-        for (int sortedIdIterator = 0 ; sortedIdIterator < spikeData[channelIterator].size() ; sortedIdIterator++){
-            uint64* data = createHistogramData(spikeData[channelIterator][sortedIdIterator],ttlData);
-            histogramData[channelIterator+sortedIdIterator][2]=windowSize/binSize;
-            for(int dataIterator = 3 ; dataIterator<windowSize/binSize+3 ; dataIterator++){
-                histogramData[channelIterator+sortedIdIterator][dataIterator] += (data[dataIterator-3]);
-            }
-        minMaxMean[channelIterator+sortedIdIterator][2]= findMin(&histogramData[channelIterator+sortedIdIterator][3]);
-            
-        minMaxMean[channelIterator+sortedIdIterator][3]= findMax(&histogramData[channelIterator+sortedIdIterator][3]);
-            
-        minMaxMean[channelIterator+sortedIdIterator][4] = findMean(&histogramData[channelIterator+sortedIdIterator][3]);
-        }
+    const uint64 halfWindow = windowSize/2;
+    const uint64 first = timestamp > halfWindow ? timestamp - halfWindow : 0;
+    for (auto it = std::lower_bound(openTriggers.begin(), openTriggers.end(), first);
+         it != openTriggers.end() && *it <= timestamp + halfWindow; ++it){
+        const int64 offset = int64(timestamp) - int64(*it) + int64(halfWindow);
+        addToHistogram(electrode, 0, offset);
+        if (unit > 0)
+            addToHistogram(electrode, unit, offset);
     }
+
+    // keep the spike for triggers that have not arrived yet, in timestamp order
+    RecentSpike spike = {timestamp, electrode, unit};
+    auto pos = recentSpikes.end();
+    while (pos != recentSpikes.begin() && (pos-1)->timestamp > timestamp)
+        --pos;
+    recentSpikes.insert(pos, spike);
+}
+
+/** bins the recent spikes that fall inside a new trigger's window */
+void EvntTrigAvg::addTrigger(uint64 timestamp)
+{
+    const uint64 halfWindow = windowSize/2;
+    const uint64 first = timestamp > halfWindow ? timestamp - halfWindow : 0;
+    auto it = std::lower_bound(recentSpikes.begin(), recentSpikes.end(), first,
+                               [](const RecentSpike& a, uint64 t) { return a.timestamp < t; });
+    for (; it != recentSpikes.end() && it->timestamp <= timestamp + halfWindow; ++it){
+        const int64 offset = int64(it->timestamp) - int64(timestamp) + int64(halfWindow);
+        addToHistogram(it->electrode, 0, offset);
+        if (it->unit > 0)
+            addToHistogram(it->electrode, it->unit, offset);
+    }
+
+    auto pos = openTriggers.end();
+    while (pos != openTriggers.begin() && *(pos-1) > timestamp)
+        --pos;
+    openTriggers.insert(pos, timestamp);
+    pendingTrials.push_back(timestamp);
 }
 
-/** returns bin counts */
-uint64* EvntTrigAvg::createHistogramData(std::vector<uint64> spikeData, std::vector<uint64> ttlData)
+/** counts one spike in a unit's histogram and updates its statistics in place */
+void EvntTrigAvg::addToHistogram(int electrode, int unit, int64 offset)
 {
-    uint64 numberOfBins = windowSize/binSize;
-    std::vector<uint64> histoData;
-    for(int ttlIterator = 0 ; ttlIterator < ttlData.size() ; ttlIterator++){
-        for(int spikeIterator = 0 ; spikeIterator < spikeData.size() ; spikeIterator++){
-            int relativeSpikeValue = int(spikeData[spikeIterator])-int(ttlData[ttlIterator]);
-            if (relativeSpikeValue >= -int(windowSize)/2 && relativeSpikeValue <= int(windowSize)/2){
-                uint64 bin = binDataPoint(0, numberOfBins, binSize, relativeSpikeValue+windowSize/2);
-                histoData.push_back(bin);
-            }
-        }
+    UnitHistogram& h = unitHistograms[electrode][unit];
+    const uint64 numBins = h.row[2];
+    if (numBins == 0 || binSize == 0)
+        return;
+
+    uint64* counts = &h.row[3];
+    const uint64 bin = jmin(uint64(offset)/binSize, numBins-1);
+    const uint64 count = ++counts[bin];
+    h.total++;
+
+    // counts only ever grow by one, so the minimum moves up a level once
+    // every bin that was at the old minimum has been incremented
+    if (count-1 == h.minCount && --h.numAtMin == 0){
+        h.minCount++;
+        for (uint64 i = 0 ; i < numBins ; i++)
+            if (counts[i] == h.minCount)
+                h.numAtMin++;
     }
-    return binCount(histoData,numberOfBins);
-}
 
+    h.stats[2] = float(h.minCount);
+    h.stats[3] = jmax(h.stats[3], float(count));
+    h.stats[4] = float(h.total)/float(numBins);
+}
 
-/** Returns the bin a data point belongs to given the very first bin, the very last bin, bin size and the data point to bin, currently only works for positive numbers (can get around by adding minimum value to all values*/
-uint64 EvntTrigAvg::binDataPoint(uint64 startBin, uint64 endBin, uint64 binSize, uint64 dataPoint)
+/** drops triggers and spikes that can no longer pair with anything, and counts closed trials */
+void EvntTrigAvg::trimWindows(uint64 currentTimestamp)
 {
-    uint64 binsInRange = (endBin-startBin);
-    uint64 binsToSearch = binsInRange/2;
-    if (binsToSearch <= 1){
-        
-        if (dataPoint < (startBin+binsToSearch)*binSize){
-            return startBin;
-        }
-        else if (dataPoint < (startBin+1+binsToSearch) * binSize){
-            return startBin+1;
-        }
-        else{
-            return startBin+2;
-        }
+    const uint64 halfWindow = windowSize/2;
+    while (!pendingTrials.empty() && pendingTrials.front() + halfWindow < currentTimestamp){
+        pendingTrials.pop_front();
+        lastTTLCalculated++;
     }
 
-    else if (dataPoint < (startBin+binsToSearch)*binSize){ // if in first half of search range
-        return binDataPoint(startBin,startBin+(binsToSearch),binSize,dataPoint);
-    }
-    else if (dataPoint >= (startBin+binsToSearch) * binSize){ // if in second half of search range
-        return binDataPoint(startBin+(binsToSearch),endBin,binSize,dataPoint);
-    }
-    else{
-        return NULL;
-    }
+    // keep a full window of slack so late spikes still find their triggers
+    while (!openTriggers.empty() && openTriggers.front() + windowSize < currentTimestamp)
+        openTriggers.pop_front();
+    while (!recentSpikes.empty() && recentSpikes.front().timestamp + windowSize < currentTimestamp)
+        recentSpikes.pop_front();
 }
 
-/** count the number of bin instances */
-uint64* EvntTrigAvg::binCount(std::vector<uint64> binData,uint64 numberOfBins)
+void EvntTrigAvg::resetWindows()
 {
-    for (int i = 0 ; i < 1000 ; i++){
-        bins[i]=0;
-    }
-    for (int dataIterator = 0 ; dataIterator < binData.size() ; dataIterator++){
-        bins[binData[dataIterator]] = bins[binData[dataIterator]]+1;
+    openTriggers.clear();
+    pendingTrials.clear();
+    recentSpikes.clear();
+}
+
+/** zeroes every histogram in place, keeping the rows of already seen sorted IDs */
+void EvntTrigAvg::resetHistograms()
+{
+    const ScopedLock myScopedLock(mut);
+    resetWindows();
+    lastTTLCalculated=0;
+    for (size_t electrode = 0 ; electrode < unitHistograms.size() ; electrode++){
+        for (size_t unit = 0 ; unit < unitHistograms[electrode].size() ; unit++){
+            UnitHistogram& h = unitHistograms[electrode][unit];
+            for (int i = 0 ; i < maxBins ; i++)
+                h.row[3+i] = 0;
+            h.row[2] = getNumBins();
+            h.stats[2] = h.stats[3] = h.stats[4] = 0;
+            h.total = 0;
+            h.minCount = 0;
+            h.numAtMin = h.row[2];
+        }
     }
-    return bins;
+}
+
+uint64 EvntTrigAvg::getNumBins()
+{
+    if (binSize == 0)
+        return 0;
+    return jmin(windowSize/binSize, uint64(maxBins));
 }
 
 uint64 EvntTrigAvg::getBinSize()
@@ -484,7 +472,7 @@ std::vector<String> EvntTrigAvg::getElectrodeLabels()
 void EvntTrigAvg::clearHistogramData(uint64 * dataptr)
 {
     const ScopedLock myScopedLock(mut);
-    for(int i = 0 ; i < 1000 ; i++)
+    for(int i = 0 ; i < maxBins ; i++)
         dataptr[i] = 0;
 }
 
@@ -28,11 +28,20 @@
 #include "EvntTrigAvgEditor.h"
 #include <vector>
 #include <map>
+#include <deque>
 
 class EvntTrigAvgEditor;
 
 /**
 Aligns spike times with TTL input.
+
+Histograms are built incrementally: each spike is binned against the trigger
+windows that are open around it, and each trigger against the recent spikes
+that fall inside its window, so every spike/trigger pair is counted exactly
+once by whichever of the two arrives second. Both sides are kept sorted and
+trimmed to the window length, and per-unit counts and min/max/mean are
+updated in place, so the cost per spike does not grow with session length.
+The canvas reads the histogram rows directly.
  
 @see EvntTrigAvgCanvas, EvntTrigAvgEditor
 
@@ -81,15 +90,10 @@ public:
     Array<uint64 *> getHistoData();
     Array<float *> getMinMaxMean();
 
-    //create histogram data
-    uint64* createHistogramData(std::vector<uint64> spikeData, std::vector<uint64> ttlData); // shared data
-    uint64 binDataPoint(uint64 startBin, uint64 endBin, uint64 binSize, uint64 dataPoint); // shared data
-    void processSpikeData(std::vector<std::vector<std::vector<uint64>>> spikeData,std::vector<uint64> ttlData);
-    uint64* binCount(std::vector<uint64> binData, uint64 numberOfBins); // shared data
     bool shouldReadHistoData();
     float findMin(uint64* data_);
     float findMax(uint64* data_);
-    float findMean(uint64* data_); // TODO make running
+    float findMean(uint64* data_);
     
     //TODO electrodeMap is not being used right now, fix it to actually work with SourceInfo instead of just indexes
     //std::map<SourceChannelInfo,int> createElectrodeMap();
@@ -103,28 +107,54 @@ private:
     void initializeMinMaxMean();
     void clearHistogramArray();
     void clearMinMaxMean();
-    void addNewSortedIdHistoData(int electrode, int sortedId);
-    void addNewSortedIdMinMaxMean(int electrode,int sortedID);
+    void addNewSortedId(int electrode, int sortedId);
+    void addSpike(int electrode, int unit, uint64 timestamp);
+    void addTrigger(uint64 timestamp);
+    void addToHistogram(int electrode, int unit, int64 offset);
+    void trimWindows(uint64 currentTimestamp);
+    void resetWindows();
+    void resetHistograms();
+    uint64 getNumBins();
     std::atomic<int> triggerEvent;
     std::atomic<int> triggerChannel;
-
-    uint64 bins[1000]; // workspace for bin counting
+    std::atomic<bool> resetRequested{ false };
 
     int numChannels = 0;
-    bool recalc = false;
     int lastTTLCalculated = 0;
     uint64 windowSize;
     uint64 binSize;
-    
-    std::vector<uint64> ttlTimestampBuffer;
-    std::vector<std::vector<std::vector<uint64>>> spikeData;// channel.sortedID.spikeInstance.timestamp
+
+    /** A spike kept around until no trigger window can still include it. */
+    struct RecentSpike
+    {
+        uint64 timestamp;
+        int electrode;
+        int unit;
+    };
+
+    /** Running statistics for one histogram row. */
+    struct UnitHistogram
+    {
+        uint64* row;
+        float* stats;
+        uint64 total;
+        uint64 minCount;
+        uint64 numAtMin;
+    };
+
+    std::deque<uint64> openTriggers; // sorted, trimmed to one window behind the latest timestamp
+    std::deque<uint64> pendingTrials; // triggers whose window has not closed yet
+    std::deque<RecentSpike> recentSpikes; // sorted by timestamp, trimmed like openTriggers
+    std::vector<std::vector<UnitHistogram>> unitHistograms; // electrode.unit, unit 0 is all spikes
     void clearHistogramData(uint64 * const);
     Array<uint64*> histogramData; // shared data
     Array<float*> minMaxMean; // shared data
     //std::map<SourceChannelInfo,int> electrodeMap; // Used to identify what electrode a spike came from
     std::vector<String> electrodeLabels;
-    std::vector<int> idIndex; //sorted ID, electrode. used to match a sortedID with its electrode
-    std::vector<std::vector<int>> electrodeSortedId; 
+    std::vector<std::vector<int>> electrodeSortedId; // electrode.unit -> sorted ID
+
+    //Compile-time constants
+    const int maxBins{ 1000 };
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EvntTrigAvg);
 
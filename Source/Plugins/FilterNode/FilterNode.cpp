@@ -288,14 +288,23 @@ void FilterNode::setApplyOnADC (bool state)
 }
 
 
+void FilterNode::saveCustomParametersToXml (XmlElement* parentElement)
+{
+    // one element for all channels, rather than one per channel
+    XmlElement* channelParams = parentElement->createNewChildElement ("CHANNELPARAMETERS");
+    channelParams->setAttribute ("count",        highCuts.size());
+    channelParams->setAttribute ("highcut",      channelValuesToString (highCuts));
+    channelParams->setAttribute ("lowcut",       channelValuesToString (lowCuts));
+    channelParams->setAttribute ("shouldFilter", channelFlagsToString (shouldFilterChannel));
+}
+
+
 void FilterNode::saveCustomChannelParametersToXml(XmlElement* channelInfo, int channelNumber, InfoObjectCommon::InfoObjectType channelType)
 {
     if (channelType == InfoObjectCommon::DATA_CHANNEL
         && channelNumber > -1
         && channelNumber < highCuts.size())
     {
-        //std::cout << "Saving custom parameters for filter node." << std::endl;
-
         XmlElement* channelParams = channelInfo->createNewChildElement ("PARAMETERS");
         channelParams->setAttribute ("highcut",         highCuts[channelNumber]);
         channelParams->setAttribute ("lowcut",          lowCuts[channelNumber]);
@@ -304,6 +313,33 @@ void FilterNode::saveCustomChannelParametersToXml(XmlElement* channelInfo, int c
 }
 
 
+void FilterNode::loadCustomParametersFromXml()
+{
+    forEachXmlChildElementWithTagName (*parametersAsXml, channelParams, "CHANNELPARAMETERS")
+    {
+        Array<double> savedHighCuts, savedLowCuts;
+        Array<bool> savedShouldFilter;
+
+        if (! channelValuesFromString (channelParams->getStringAttribute ("highcut"), savedHighCuts)
+            || ! channelValuesFromString (channelParams->getStringAttribute ("lowcut"), savedLowCuts))
+            continue;
+
+        channelFlagsFromString (channelParams->getStringAttribute ("shouldFilter"), savedShouldFilter);
+
+        const int numChannels = jmin (highCuts.size(), savedHighCuts.size(), savedLowCuts.size());
+
+        for (int n = 0; n < numChannels; ++n)
+        {
+            highCuts.set (n, savedHighCuts[n]);
+            lowCuts.set  (n, savedLowCuts[n]);
+            shouldFilterChannel.set (n, n < savedShouldFilter.size() ? savedShouldFilter[n] : true);
+
+            setFilterParameters (lowCuts[n], highCuts[n], n);
+        }
+    }
+}
+
+
 void FilterNode::loadCustomChannelParametersFromXml(XmlElement* channelInfo, InfoObjectCommon::InfoObjectType channelType)
 {
     int channelNum = channelInfo->getIntAttribute ("number");
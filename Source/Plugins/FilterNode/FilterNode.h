@@ -50,7 +50,14 @@ public:
 
     void updateSettings() override;
 
-	void saveCustomChannelParametersToXml(XmlElement* channelInfo, int channelNumber, InfoObjectCommon::InfoObjectType channelTypel) override;
+    void saveCustomParametersToXml (XmlElement* parentElement) override;
+    void loadCustomParametersFromXml() override;
+
+    /** Also writes the per-channel PARAMETERS elements, for tools that read settings files
+        saved before the compact format. */
+	void saveCustomChannelParametersToXml(XmlElement* channelInfo, int channelNumber, InfoObjectCommon::InfoObjectType channelType) override;
+
+    /** Reads the per-channel PARAMETERS elements of settings files saved before the compact format. */
 	void loadCustomChannelParametersFromXml(XmlElement* channelInfo, InfoObjectCommon::InfoObjectType channelType)  override;
 
     double getLowCutValueForChannel  (int chan) const;
@@ -26,3 +26,4 @@ This header provides access to the simple serial library included in the GUI cod
 */
 
 #include "../../Processors/Serial/ofSerial.h"
+#include "../../Processors/Serial/SerialOutputThread.h"
@@ -41,6 +41,13 @@ JuliaEditor::JuliaEditor(GenericProcessor* parentNode, bool useDefaultParameterE
     reloadFileButton->setBounds(100+10,85,60,25);
     addAndMakeVisible(reloadFileButton);
 
+    asyncButton = new UtilityButton("async",Font("Small Text", 13, Font::plain));
+    asyncButton->addListener(this);
+    asyncButton->setBounds(10,60,50,20);
+    asyncButton->setClickingTogglesState(true);
+    asyncButton->setTooltip("Run Julia on its own thread, one block behind, so it can't stall the signal chain");
+    addAndMakeVisible(asyncButton);
+
     fileNameLabel = new Label("FileNameLabel", "No file selected.");
     fileNameLabel->setBounds(10,85+20,140,25);
     addAndMakeVisible(fileNameLabel);
@@ -88,6 +95,12 @@ void JuliaEditor::setFile(String file)
     // repaint();
 }
 
+void JuliaEditor::setAsyncMode(bool async)
+{
+    asyncButton->setToggleState(async, dontSendNotification);
+    juliaProcessor->setAsyncMode(async);
+}
+
 void JuliaEditor::buttonEvent(Button* button)
 {
     if (!acquisitionIsActive)
@@ -116,6 +129,10 @@ void JuliaEditor::buttonEvent(Button* button)
         {
             juliaProcessor->reloadFile();
         }
+        if (button == asyncButton)
+        {
+            juliaProcessor->setAsyncMode(asyncButton->getToggleState());
+        }
     }
 }
 
@@ -26,7 +26,22 @@
 #include <julia.h>
 
 JuliaProcessor::JuliaProcessor()
-    : GenericProcessor("Julia Processor")
+    : GenericProcessor("Julia Processor"),
+      processFunction(nullptr),
+      blockFunction(nullptr),
+      vectorType(nullptr),
+      matrixType(nullptr),
+      dimsType(nullptr),
+      reportedException(false),
+      workCapacity(0),
+      asyncMode(false),
+      inFlightSamples(0),
+      inFlightChannels(0),
+      hasInFlightBlock(false),
+      inFlightDiscarded(false),
+      skippedBlocks(0),
+      fifoRead(0),
+      fifoReady(0)
 {
 	hasJuliaInstance = false;
     dataHistoryBufferNumChannels = 256;
@@ -36,6 +51,7 @@ JuliaProcessor::JuliaProcessor()
 
 JuliaProcessor::~JuliaProcessor()
 {
+	disable();
 	jl_atexit_hook(0);
 	deleteAndZero(dataHistoryBuffer);
 }
@@ -70,6 +86,7 @@ void JuliaProcessor::setFile(String fullpath)
 
 	String juliaString = "include(\"" + filePath + "\")";
 	run_julia_string(juliaString);
+	lookUpFunctions();
 }
 
 void JuliaProcessor::reloadFile()
@@ -78,6 +95,7 @@ void JuliaProcessor::reloadFile()
     {
         String juliaString = "reload(\"" + filePath + "\")";
         run_julia_string(juliaString);
+        lookUpFunctions();
     }
     else
     {
@@ -125,30 +143,314 @@ String JuliaProcessor::getFile()
     return filePath;
 }
 
-void JuliaProcessor::process(AudioSampleBuffer& buffer, MidiBuffer& midiMessages)
+void JuliaProcessor::lookUpFunctions()
 {
-	if (hasJuliaInstance)
+	processFunction = jl_get_function(jl_main_module, "oe_process!");
+	blockFunction = jl_get_function(jl_main_module, "oe_process_block!");
+
+	vectorType = jl_apply_array_type(jl_float32_type, 1);
+	matrixType = jl_apply_array_type(jl_float32_type, 2);
+
+	jl_value_t* dimTypes[] = { (jl_value_t*) jl_long_type, (jl_value_t*) jl_long_type };
+	dimsType = (jl_value_t*) jl_apply_tuple_type_v(dimTypes, 2);
+
+	reportedException = false;
+
+	if (blockFunction != nullptr)
+		std::cout << "Julia: calling oe_process_block! once per block" << std::endl;
+	else if (processFunction != nullptr)
+		std::cout << "Julia: calling oe_process! once per channel" << std::endl;
+	else
+		std::cout << "Julia: " << filePath << " defines neither oe_process_block! nor oe_process!" << std::endl;
+}
+
+void JuliaProcessor::callJulia(float* data, int numSamples, int numChannels, int channelStride)
+{
+	if (blockFunction != nullptr)
 	{
-		jl_function_t *func = jl_get_function(jl_main_module, "oe_process!");    
-	
-		// create 2D array of float64 type
-		jl_value_t *array_type = jl_apply_array_type(jl_float32_type, 1); // last arg is nDims
+		// one call for the whole block: a channelStride x numChannels matrix over
+		// the samples themselves, of which the first numSamples rows are valid
+		jl_value_t** roots;
+		JL_GC_PUSHARGS(roots, 5);
 
-		for (int n = 0; n < getNumOutputs(); n++)
+		roots[0] = jl_box_long(channelStride);
+		roots[1] = jl_box_long(numChannels);
+		roots[2] = jl_new_struct((jl_datatype_t*) dimsType, roots[0], roots[1]);
+		roots[3] = (jl_value_t*) jl_ptr_to_array(matrixType, data, roots[2], 0);
+		roots[4] = jl_box_long(numSamples);
+
+		jl_call2(blockFunction, roots[3], roots[4]);
+
+		JL_GC_POP();
+	}
+	else if (processFunction != nullptr)
+	{
+		for (int n = 0; n < numChannels; n++)
 		{
-			float* ptr = buffer.getWritePointer(n); // to perform in-place edits to the buffer
-			jl_array_t *x = jl_ptr_to_array_1d(array_type, ptr , buffer.getNumSamples(), 0);
+			jl_array_t *x = jl_ptr_to_array_1d(vectorType, data + n * channelStride, numSamples, 0);
 			JL_GC_PUSH1(&x);
-			jl_call1(func, (jl_value_t*)x);
+			jl_call1(processFunction, (jl_value_t*)x);
 			JL_GC_POP();
 		}
 	}
+
+	if (jl_exception_occurred() && ! reportedException)
+	{
+		std::cout << "Julia exception: " << jl_typeof_str(jl_exception_occurred()) << std::endl;
+		reportedException = true;
+	}
+}
+
+bool JuliaProcessor::enable()
+{
+	fifo.setSize(getNumOutputs(), 32768);
+	fifo.clear();
+	fifoRead = 0;
+	fifoReady = 0;
+
+	// allocated here so process() doesn't have to, see growWorkBlocks()
+	growWorkBlocks(getNumOutputs() * maxBlockSamples);
+
+	hasInFlightBlock = false;
+	inFlightDiscarded = false;
+	skippedBlocks = 0;
+
+	if (asyncMode)
+	{
+		blockThread = new JuliaBlockThread(this);
+		blockThread->startThread();
+	}
+
+	return true;
+}
+
+bool JuliaProcessor::disable()
+{
+	if (blockThread != nullptr)
+	{
+		blockThread->signalThreadShouldExit();
+		blockThread->startBlock(); // wake it up
+		blockThread->stopThread(5000);
+		blockThread = nullptr;
+
+		if (skippedBlocks > 0)
+			std::cout << "Julia: " << skippedBlocks << " blocks were not processed in time and were passed through" << std::endl;
+	}
+
+	return true;
+}
+
+void JuliaProcessor::setAsyncMode(bool async)
+{
+	asyncMode = async;
+}
+
+bool JuliaProcessor::getAsyncMode() const
+{
+	return asyncMode;
+}
+
+void JuliaProcessor::growWorkBlocks(int capacity)
+{
+	if (capacity <= workCapacity)
+		return;
+
+	// the Julia thread works on workBlock until it clears its busy flag,
+	// so that memory can't go away before then
+	if (blockThread != nullptr)
+	{
+		while (blockThread->isBusy())
+			Thread::yield();
+	}
+
+	HeapBlock<float> newWorkBlock((size_t) capacity);
+	HeapBlock<float> newInFlightInput((size_t) capacity);
+
+	// the previous block still has to go out on the next call
+	if (hasInFlightBlock)
+	{
+		const int used = inFlightSamples * inFlightChannels;
+		FloatVectorOperations::copy(newWorkBlock, workBlock, used);
+		FloatVectorOperations::copy(newInFlightInput, inFlightInput, used);
+	}
+
+	workBlock.swapWith(newWorkBlock);
+	inFlightInput.swapWith(newInFlightInput);
+	workCapacity = capacity;
+}
+
+void JuliaProcessor::pushToFifo(const float* data, int numSamples, int numChannels, int channelStride)
+{
+	const int capacity = fifo.getNumSamples();
+	numChannels = jmin(numChannels, fifo.getNumChannels());
+	numSamples = jmin(numSamples, capacity);
+
+	// should never happen, but drop the oldest samples rather than the newest
+	if (fifoReady + numSamples > capacity)
+	{
+		const int excess = fifoReady + numSamples - capacity;
+		fifoRead = (fifoRead + excess) % capacity;
+		fifoReady -= excess;
+	}
+
+	const int start = (fifoRead + fifoReady) % capacity;
+	const int first = jmin(numSamples, capacity - start);
+
+	for (int n = 0; n < numChannels; n++)
+	{
+		fifo.copyFrom(n, start, data + n * channelStride, first);
+
+		if (first < numSamples)
+			fifo.copyFrom(n, 0, data + n * channelStride + first, numSamples - first);
+	}
+
+	fifoReady += numSamples;
+}
+
+void JuliaProcessor::popFromFifo(AudioSampleBuffer& buffer, int numSamples, int numChannels)
+{
+	const int capacity = fifo.getNumSamples();
+	const int available = jmin(numSamples, fifoReady);
+	const int missing = numSamples - available; // only before the first block is done
+	const int first = jmin(available, capacity - fifoRead);
+
+	numChannels = jmin(numChannels, fifo.getNumChannels());
+
+	for (int n = 0; n < numChannels; n++)
+	{
+		if (missing > 0)
+			buffer.clear(n, 0, missing);
+
+		buffer.copyFrom(n, missing, fifo, n, fifoRead, first);
+
+		if (first < available)
+			buffer.copyFrom(n, missing + first, fifo, n, 0, available - first);
+	}
+
+	fifoRead = (fifoRead + available) % capacity;
+	fifoReady -= available;
+}
+
+void JuliaProcessor::process(AudioSampleBuffer& buffer)
+{
+	if (!hasJuliaInstance || getNumOutputs() == 0)
+		return;
+
+	const int numChannels = getNumOutputs();
+	const int numSamples = getNumSamples(0);
+
+	if (numSamples * numChannels > workCapacity)
+		growWorkBlocks(numSamples * numChannels);
+
+	if (blockThread == nullptr)
+	{
+		// Julia can work on the buffer in place if its channels are evenly spaced
+		float* data = buffer.getWritePointer(0);
+		const int stride = numChannels > 1 ? int(buffer.getWritePointer(1) - data) : numSamples;
+		bool evenlySpaced = stride >= numSamples;
+
+		for (int n = 2; n < numChannels && evenlySpaced; n++)
+			evenlySpaced = buffer.getWritePointer(n) == data + n * stride;
+
+		if (evenlySpaced)
+		{
+			callJulia(data, numSamples, numChannels, stride);
+		}
+		else
+		{
+			for (int n = 0; n < numChannels; n++)
+				FloatVectorOperations::copy(workBlock + n * numSamples, buffer.getReadPointer(n), numSamples);
+
+			callJulia(workBlock, numSamples, numChannels, numSamples);
+
+			for (int n = 0; n < numChannels; n++)
+				buffer.copyFrom(n, 0, workBlock + n * numSamples, numSamples);
+		}
+
+		return;
+	}
+
+	if (blockThread->isBusy())
+	{
+		// The previous block is late. It goes out unprocessed, and so does this one,
+		// so the output stays exactly one block behind and in order.
+		if (hasInFlightBlock && !inFlightDiscarded)
+		{
+			pushToFifo(inFlightInput, inFlightSamples, inFlightChannels, inFlightSamples);
+			inFlightDiscarded = true;
+			skippedBlocks++;
+		}
+
+		for (int n = 0; n < numChannels; n++)
+			FloatVectorOperations::copy(inFlightInput + n * numSamples, buffer.getReadPointer(n), numSamples);
+
+		popFromFifo(buffer, numSamples, numChannels);
+		pushToFifo(inFlightInput, numSamples, numChannels, numSamples);
+		skippedBlocks++;
+
+		return;
+	}
+
+	if (hasInFlightBlock && !inFlightDiscarded)
+		pushToFifo(workBlock, inFlightSamples, inFlightChannels, inFlightSamples);
+
+	for (int n = 0; n < numChannels; n++)
+	{
+		FloatVectorOperations::copy(workBlock + n * numSamples, buffer.getReadPointer(n), numSamples);
+		FloatVectorOperations::copy(inFlightInput + n * numSamples, buffer.getReadPointer(n), numSamples);
+	}
+
+	inFlightSamples = numSamples;
+	inFlightChannels = numChannels;
+	hasInFlightBlock = true;
+	inFlightDiscarded = false;
+
+	blockThread->startBlock();
+
+	popFromFifo(buffer, numSamples, numChannels);
+}
+
+JuliaProcessor::JuliaBlockThread::JuliaBlockThread(JuliaProcessor* processor_)
+	: Thread("Julia"), processor(processor_)
+{
+}
+
+void JuliaProcessor::JuliaBlockThread::startBlock()
+{
+	busy.set(1);
+	blockReady.signal();
+}
+
+bool JuliaProcessor::JuliaBlockThread::isBusy() const
+{
+	return busy.get() != 0;
+}
+
+void JuliaProcessor::JuliaBlockThread::run()
+{
+	// only this thread enters Julia while acquisition runs in asynchronous mode
+	while (!threadShouldExit())
+	{
+		if (!blockReady.wait(100))
+			continue;
+
+		if (threadShouldExit())
+			break;
+
+		processor->callJulia(processor->workBlock, processor->inFlightSamples,
+		                     processor->inFlightChannels, processor->inFlightSamples);
+
+		busy.set(0);
+	}
 }
 
 void JuliaProcessor::saveCustomParametersToXml(XmlElement* parentElement)
 {
     XmlElement* childNode = parentElement->createNewChildElement("FILENAME");
     childNode->setAttribute("path", getFile());
+
+    XmlElement* modeNode = parentElement->createNewChildElement("MODE");
+    modeNode->setAttribute("async", asyncMode);
 }
 
 void JuliaProcessor::loadCustomParametersFromXml()
@@ -164,6 +466,11 @@ void JuliaProcessor::loadCustomParametersFromXml()
                 JuliaEditor* fre = (JuliaEditor*) getEditor();
                 fre->setFile(filepath);
             }
+            else if (xmlNode->hasTagName("MODE"))
+            {
+                JuliaEditor* fre = (JuliaEditor*) getEditor();
+                fre->setAsyncMode(xmlNode->getBoolAttribute("async", false));
+            }
         }
     }
-}
\ No newline at end of file
+}
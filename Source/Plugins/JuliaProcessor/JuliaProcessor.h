@@ -25,11 +25,25 @@
 
 #include <ProcessorHeaders.h>
 
+// from julia.h, which only the .cpp includes
+struct _jl_value_t;
+
 /**
   Julia Processor.
 
   Allows the user to select a Julia Programming Language file to use as filter
 
+  If the file defines oe_process_block!(data, nsamples), it is called once per
+  block with the whole buffer as a Matrix{Float32} with one column per channel, of
+  which only the first nsamples rows hold the block's samples. The matrix wraps the
+  buffer's own memory when its channels are evenly spaced. Otherwise
+  oe_process!(data) is called once per channel, as before.
+
+  In asynchronous mode the Julia call for a block runs on a separate thread while
+  the next block arrives, and the output lags the input by one block. A block that
+  is not done in time (e.g. during a Julia GC pause) is passed through unprocessed
+  instead of stalling the signal chain.
+
   @see GenericProcessor, JuliaEditor
 */
 
@@ -42,7 +56,7 @@ public:
     void setFile(String fullpath);
     String getFile();
     void reloadFile();
-    void process(AudioSampleBuffer& buffer, MidiBuffer& midiMessages);
+    void process(AudioSampleBuffer& buffer) override;
     void setParameter(int parameterIndex, float newValue);
     void setBuffersize(int bufferSize);
     AudioProcessorEditor* createEditor();
@@ -50,10 +64,40 @@ public:
     {
         return true;
     }
+    bool enable() override;
+    bool disable() override;
     void saveCustomParametersToXml(XmlElement* parentElement);
     void loadCustomParametersFromXml();
 
+    void setAsyncMode(bool async);
+    bool getAsyncMode() const;
+
 private:
+    /** Runs the Julia call for one block at a time, off the audio thread. */
+    class JuliaBlockThread : public Thread
+    {
+    public:
+        JuliaBlockThread(JuliaProcessor* processor);
+        void startBlock();
+        bool isBusy() const;
+        void run() override;
+
+    private:
+        JuliaProcessor* processor;
+        WaitableEvent blockReady;
+        Atomic<int> busy;
+    };
+
+    void lookUpFunctions();
+    void callJulia(float* data, int numSamples, int numChannels, int channelStride);
+
+    /** Grows workBlock and inFlightInput, keeping their contents. Waits for the
+        Julia thread to finish its block first, since it reads workBlock. */
+    void growWorkBlocks(int capacity);
+
+    void pushToFifo(const float* data, int numSamples, int numChannels, int channelStride);
+    void popFromFifo(AudioSampleBuffer& buffer, int numSamples, int numChannels);
+
     bool hasJuliaInstance;
     String filePath;
     int dataHistoryBufferSize;
@@ -61,6 +105,36 @@ private:
     AudioSampleBuffer* dataHistoryBuffer;
     void run_julia_string(String juliaString);
 
+    // looked up when the file is (re)loaded, not for every block
+    _jl_value_t* processFunction;
+    _jl_value_t* blockFunction;
+    _jl_value_t* vectorType;
+    _jl_value_t* matrixType;
+    _jl_value_t* dimsType;
+    bool reportedException;
+
+    // samples x channels copy of the block, for buffers whose channels are not
+    // evenly spaced and for the asynchronous mode
+    HeapBlock<float> workBlock;
+    int workCapacity;
+
+    // larger than any buffer size the audio device offers, larger blocks still work
+    static const int maxBlockSamples = 8192;
+
+    bool asyncMode;
+    ScopedPointer<JuliaBlockThread> blockThread;
+    HeapBlock<float> inFlightInput;
+    int inFlightSamples;
+    int inFlightChannels;
+    bool hasInFlightBlock;
+    bool inFlightDiscarded;
+    int64 skippedBlocks;
+
+    // output of the asynchronous mode, one block behind the input
+    AudioSampleBuffer fifo;
+    int fifoRead;
+    int fifoReady;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(JuliaProcessor);
 };
 
@@ -18,4 +18,12 @@ function oe_process!(data)
 		last = data[i];
 	end
 
-end
\ No newline at end of file
+end
+
+# Alternatively, define oe_process_block! to get the whole buffer in one call.
+# data is a Matrix{Float32} with one column per channel, sharing memory with the
+# signal chain; only the first nsamples rows hold samples of this block.
+#
+#function oe_process_block!(data, nsamples)
+#	@views data[1:nsamples, :] .*= 0.5f0
+#end
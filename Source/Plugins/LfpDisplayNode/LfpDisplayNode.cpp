@@ -299,7 +299,7 @@ void LfpDisplayNode::process (AudioSampleBuffer& buffer)
     ScopedLock displayLock (displayMutex);
     
     initializeEventChannels();
-    checkForEvents (); // see if we got any TTL events
+    checkForEventLanes (TTL_EVENT_LANE); // see if we got any TTL events
     finalizeEventChannels();
 
 
@@ -27,6 +27,8 @@
 
 
 const int MAX_MESSAGE_LENGTH = 64000;
+const int MESSAGE_QUEUE_SIZE = 1 << 20; // bytes, enough for bursts of thousands of short messages
+const uint32 STATUS_MESSAGE_INTERVAL = 100; // ms, throttles status bar updates from high-rate clients
 
 
 #ifdef WIN32
@@ -154,6 +156,74 @@ StringTS::~StringTS()
 }
 
 
+/*********************************************/
+NetworkMessageFifo::NetworkMessageFifo (int capacityBytes)
+    : fifo (capacityBytes)
+{
+    buffer.malloc (capacityBytes);
+}
+
+
+bool NetworkMessageFifo::push (const uint8* data, int len, int64 timestamp)
+{
+    const int total = sizeof (Header) + len;
+    if (fifo.getFreeSpace() < total)
+        return false;
+
+    Header header;
+    header.timestamp = timestamp;
+    header.len = len;
+
+    int pos1, size1, pos2, size2;
+    fifo.prepareToWrite (sizeof (Header), pos1, size1, pos2, size2);
+    write (&header, pos1, size1, pos2, size2);
+    fifo.finishedWrite (sizeof (Header));
+    fifo.prepareToWrite (len, pos1, size1, pos2, size2);
+    write (data, pos1, size1, pos2, size2);
+    fifo.finishedWrite (len);
+    return true;
+}
+
+
+int NetworkMessageFifo::pop (uint8* dest, int maxLen, int64& timestamp)
+{
+    // the producer publishes the header and the message separately, so wait for both
+    Header header;
+    int pos1, size1, pos2, size2;
+    if (fifo.getNumReady() < (int) sizeof (Header))
+        return -1;
+    fifo.prepareToRead (sizeof (Header), pos1, size1, pos2, size2);
+    read (&header, pos1, size1, pos2, size2);
+    if (fifo.getNumReady() < (int) sizeof (Header) + header.len)
+        return -1;
+    fifo.finishedRead (sizeof (Header));
+
+    const int len = jmin (header.len, maxLen);
+    fifo.prepareToRead (len, pos1, size1, pos2, size2);
+    read (dest, pos1, size1, pos2, size2);
+    fifo.finishedRead (header.len); // skips anything truncated
+
+    timestamp = header.timestamp;
+    return len;
+}
+
+
+void NetworkMessageFifo::write (const void* src, int pos1, int size1, int pos2, int size2)
+{
+    memcpy (buffer + pos1, src, size1);
+    if (size2 > 0)
+        memcpy (buffer + pos2, static_cast<const uint8*> (src) + size1, size2);
+}
+
+
+void NetworkMessageFifo::read (void* dest, int pos1, int size1, int pos2, int size2)
+{
+    memcpy (dest, buffer + pos1, size1);
+    if (size2 > 0)
+        memcpy (static_cast<uint8*> (dest) + size1, buffer + pos2, size2);
+}
+
+
 /*********************************************/
 void* NetworkEvents::zmqcontext = nullptr;
 
@@ -163,7 +233,13 @@ NetworkEvents::NetworkEvents()
     , threshold         (200.0)
     , bufferZone        (5.0f)
     , state             (false)
+    , networkMessagesQueue (MESSAGE_QUEUE_SIZE)
+    , droppedMessages   (0)
+    , lastStatusMessageTime (0)
 {
+    processMessageBuffer.malloc (MAX_MESSAGE_LENGTH);
+    messageMetadata.add (new MetaDataValue (MetaDataDescriptor::INT64, 1));
+
     setProcessorType (PROCESSOR_TYPE_SOURCE);
 
     createZmqContext();
@@ -291,9 +367,9 @@ void NetworkEvents::simulateDesignAndTrials ()
         if (currenttime > S.timestamp)
         {
             // handle special messages
-            handleSpecialMessages (S);
+            handleSpecialMessages (S.getString());
 
-            postTimestamppedStringToMidiBuffer (S);
+            postTimestamppedStringToMidiBuffer (S.str, S.len, S.timestamp);
             //getUIComponent()->getLogWindow()->addLineToLog(S.getString());
             simulation.pop();
         }
@@ -305,11 +381,10 @@ void NetworkEvents::simulateDesignAndTrials ()
 
 }
 
-void NetworkEvents::postTimestamppedStringToMidiBuffer (StringTS s)
+void NetworkEvents::postTimestamppedStringToMidiBuffer (const uint8* data, int len, int64 softwareTimestamp)
 {
-	MetaDataValueArray md;
-	md.add(new MetaDataValue(MetaDataDescriptor::INT64, 1, &s.timestamp));
-	TextEventPtr event = TextEvent::createTextEvent(messageChannel, CoreServices::getGlobalTimestamp(), String::fromUTF8(reinterpret_cast<const char*>(s.str), s.len), md);
+	messageMetadata[0]->setValue(softwareTimestamp);
+	TextEventPtr event = TextEvent::createTextEvent(messageChannel, CoreServices::getGlobalTimestamp(), String::fromUTF8(reinterpret_cast<const char*>(data), len), messageMetadata);
 	addEvent(messageChannel, event, 0);
 }
 
@@ -369,7 +444,7 @@ void NetworkEvents::simulateSingleTrial()
 }
 
 
-String NetworkEvents::handleSpecialMessages (StringTS msg)
+String NetworkEvents::handleSpecialMessages (const String& s)
 {
     /*
     std::vector<String> input = msg.splitString(' ');
@@ -423,11 +498,21 @@ String NetworkEvents::handleSpecialMessages (StringTS msg)
     */
 
     /** Start/stop data acquisition */
-    String s = msg.getString();
 
     /** Command is first substring */
-    StringArray inputs = StringArray::fromTokens (s, " ");
-    String cmd = String (inputs[0]);
+    String cmd = s.upToFirstOccurrenceOf (" ", false, false);
+
+    /** Plain event messages are answered right away. Only actual commands wait for the
+        message thread, so high-rate clients don't stall on it */
+    static const char* const commands[] = { "StartAcquisition", "StopAcquisition",
+        "StartRecord", "StopRecord", "IsAcquiring", "IsRecording", "GetRecordingPath",
+        "GetBaseName", "GetRecordingNumber" };
+    bool isCommand = false;
+    for (int i = 0; i < numElementsInArray (commands) && ! isCommand; ++i)
+        isCommand = cmd.compareIgnoreCase (commands[i]) == 0;
+
+    if (! isCommand)
+        return String ("NotHandled");
 
     const MessageManagerLock mmLock;
     if (cmd.compareIgnoreCase ("StartAcquisition") == 0)
@@ -535,16 +620,10 @@ void NetworkEvents::process (AudioSampleBuffer& buffer)
 {
     setTimestampAndSamples(CoreServices::getGlobalTimestamp(),0);
 
-    lock.enter();
-    while (! networkMessagesQueue.empty())
-    {
-        StringTS msg = networkMessagesQueue.front();
-        postTimestamppedStringToMidiBuffer (msg);
-        CoreServices::sendStatusMessage ( ("Network event received: " + msg.getString()).toRawUTF8());
-        networkMessagesQueue.pop();
-    }
-
-    lock.exit();
+    int64 softwareTimestamp;
+    int len;
+    while ((len = networkMessagesQueue.pop (processMessageBuffer, MAX_MESSAGE_LENGTH, softwareTimestamp)) >= 0)
+        postTimestamppedStringToMidiBuffer (processMessageBuffer, len, softwareTimestamp);
 }
 
 
@@ -581,18 +660,31 @@ void NetworkEvents::run()
         if (result < 0) // will only happen when responder dies.
             break;
 
-        StringTS Msg (buffer, result, timestamp_software);
         if (result > 0)
         {
-            lock.enter();
-            networkMessagesQueue.push (Msg);
-            lock.exit();
+            // zmq_recv truncates, but reports the full message length
+            result = jmin (result, MAX_MESSAGE_LENGTH - 1);
+            if (! networkMessagesQueue.push (buffer, result, timestamp_software))
+                ++droppedMessages;
 
             //std::cout << "Received message!" << std::endl;
             // handle special messages
-            String response = handleSpecialMessages (Msg);
+            String msg = String::fromUTF8 (reinterpret_cast<const char*> (buffer), result);
+            String response = handleSpecialMessages (msg);
 
             zmq_send (responder, response.getCharPointer(), response.length(), 0);
+
+            // status updates are posted from here rather than from the audio thread
+            uint32 now = Time::getMillisecondCounter();
+            if (now - lastStatusMessageTime >= STATUS_MESSAGE_INTERVAL)
+            {
+                lastStatusMessageTime = now;
+                int dropped = droppedMessages.exchange (0);
+                if (dropped > 0)
+                    CoreServices::sendStatusMessage ("Network events queue full, dropped " + String (dropped) + " messages");
+                else
+                    CoreServices::sendStatusMessage ("Network event received: " + msg);
+            }
         }
         else
         {
@@ -62,6 +62,40 @@ public:
 };
 
 
+/**
+ Single producer, single consumer queue of network messages, each stored with its
+ software timestamp in a preallocated byte ring. Neither side locks or allocates,
+ so the network thread can push while process() pops on the audio thread.
+*/
+class NetworkMessageFifo
+{
+public:
+    NetworkMessageFifo (int capacityBytes);
+
+    /** Called from the network thread. Returns false if the message doesn't fit */
+    bool push (const uint8* data, int len, int64 timestamp);
+
+    /** Called from the audio thread. Copies the next message into dest, which must hold
+        maxLen bytes, and returns its length, or -1 if the queue is empty */
+    int pop (uint8* dest, int maxLen, int64& timestamp);
+
+private:
+    struct Header
+    {
+        int64 timestamp;
+        int len;
+    };
+
+    void write (const void* src, int pos1, int size1, int pos2, int size2);
+    void read (void* dest, int pos1, int size1, int pos2, int size2);
+
+    HeapBlock<uint8> buffer;
+    AbstractFifo fifo;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (NetworkMessageFifo);
+};
+
+
 /**
  Sends incoming TCP/IP messages from 0MQ to the events buffer
 
@@ -100,7 +134,7 @@ public:
 
     //int64 getExtrapolatedHardwareTimestamp (int64 softwareTS) const;
 
-    String handleSpecialMessages    (StringTS msg);
+    String handleSpecialMessages    (const String& s);
     std::vector<String> splitString (String S, char sep);
 
     void initSimulation();
@@ -112,7 +146,9 @@ public:
     void opensocket();
     bool closesocket();
 
-    void postTimestamppedStringToMidiBuffer (StringTS s);
+    /** Posts a message as a text event, with its software timestamp as metadata. Doesn't allocate
+        anything but the event itself. */
+    void postTimestamppedStringToMidiBuffer (const uint8* data, int len, int64 softwareTimestamp);
     void setNewListeningPort (int port);
 
     int urlport;
@@ -140,7 +176,11 @@ private:
 
     Time timer;
 
-    std::queue<StringTS> networkMessagesQueue;
+    NetworkMessageFifo networkMessagesQueue;
+    HeapBlock<uint8> processMessageBuffer;
+    MetaDataValueArray messageMetadata;
+    std::atomic<int> droppedMessages;
+    uint32 lastStatusMessageTime;
     std::queue<StringTS> simulation;
 
     CriticalSection lock;
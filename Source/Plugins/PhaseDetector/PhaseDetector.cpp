@@ -59,13 +59,13 @@ void PhaseDetector::addModule()
     m.outputChan = -1;
     m.gateChan = -1;
     m.isActive = true;
-    m.lastSample = 0.0f;
+    m.leadTime = 0.0f;
     m.type = NONE;
     m.samplesSinceTrigger = 5000;
     m.wasTriggered = false;
-    m.phase = NO_PHASE;
 
     modules.add (m);
+    estimators.add (new PhaseEstimator());
 }
 
 
@@ -108,6 +108,8 @@ void PhaseDetector::setParameter (int parameterIndex, float newValue)
             default:
                 module.type = NONE;
         }
+
+        estimators[activeModule]->setTargetPhase (getTargetPhase (module.type));
     }
     else if (parameterIndex == 2)   // inputChan
     {
@@ -129,6 +131,25 @@ void PhaseDetector::setParameter (int parameterIndex, float newValue)
             module.isActive = false;
         }
     }
+    else if (parameterIndex == 5)   // lead time (ms)
+    {
+        module.leadTime = newValue;
+        estimators[activeModule]->setLeadTime (newValue);
+    }
+}
+
+
+double PhaseDetector::getTargetPhase (int moduleType)
+{
+    // phase of cos(phi), as used by PhaseEstimator
+    switch (moduleType)
+    {
+        case PEAK:          return 0.0;
+        case FALLING_ZERO:  return double_Pi / 2.0;
+        case TROUGH:        return double_Pi;
+        case RISING_ZERO:   return 3.0 * double_Pi / 2.0;
+        default:            return 0.0;
+    }
 }
 
 //Usually, to be more ordered, we'd create the event channels overriding the createEventChannels() method.
@@ -182,6 +203,20 @@ void PhaseDetector::updateSettings()
 
 bool PhaseDetector::enable()
 {
+    for (int i = 0; i < modules.size(); ++i)
+    {
+        const DetectorModule& module = modules.getReference (i);
+        const DataChannel* in = getDataChannel (module.inputChan);
+
+        PhaseEstimator* estimator = estimators[i];
+        estimator->setSampleRate (in != nullptr ? in->getSampleRate() : CoreServices::getGlobalSampleRate());
+        estimator->setTargetPhase (getTargetPhase (module.type));
+        estimator->setLeadTime (module.leadTime);
+
+        modules.getReference (i).samplesSinceTrigger = TTL_LENGTH_SAMPLES;
+        modules.getReference (i).wasTriggered = false;
+    }
+
     return true;
 }
 
@@ -219,99 +254,65 @@ void PhaseDetector::handleEvent (const EventChannel* channelInfo, const MidiMess
 
 void PhaseDetector::process (AudioSampleBuffer& buffer)
 {
-    checkForEvents ();
+    checkForEventLanes (TTL_EVENT_LANE);
 
     // loop through the modules
     for (int m = 0; m < modules.size(); ++m)
     {
         DetectorModule& module = modules.getReference (m);
 
-        // check to see if it's active and has a channel
-        if (module.isActive && module.outputChan >= 0
-            && module.inputChan >= 0
-            && module.inputChan < buffer.getNumChannels())
+        if (module.type == NONE
+            || module.inputChan < 0
+            || module.inputChan >= buffer.getNumChannels())
+            continue;
+
+        const int nSamples = getNumSamples (module.inputChan);
+        const int64 timestamp = getTimestamp (module.inputChan);
+
+        // the estimator keeps running while gated, so it is settled when the gate opens
+        int numTriggers = estimators[m]->process (buffer.getReadPointer (module.inputChan), nSamples,
+                                                  triggerSamples, MAX_TRIGGERS_PER_BLOCK);
+
+        if (! module.isActive || module.outputChan < 0)
+            numTriggers = 0;
+
+        // merge the trigger onsets with the pending TTL offsets, in sample order
+        int pos = 0;
+        int t = 0;
+
+        while (true)
         {
-            for (int i = 0; i < getNumSamples (module.inputChan); ++i)
+            const int offPos = module.wasTriggered ? pos + TTL_LENGTH_SAMPLES - module.samplesSinceTrigger : nSamples;
+            const int onPos = t < numTriggers ? triggerSamples[t] : nSamples;
+
+            if (offPos < onPos && offPos < nSamples)
             {
-                const float sample = *buffer.getReadPointer (module.inputChan, i);
-
-                if (sample < module.lastSample
-                    && sample > 0
-                    && module.phase != FALLING_POS)
-                {
-                    if (module.type == PEAK)
-                    {
-						uint8 ttlData = 1 << module.outputChan;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
-                        module.samplesSinceTrigger = 0;
-                        module.wasTriggered = true;
-                    }
-
-                    module.phase = FALLING_POS;
-                }
-                else if (sample < 0
-                         && module.lastSample >= 0
-                         && module.phase != FALLING_NEG)
-                {
-                    if (module.type == FALLING_ZERO)
-                    {
-						uint8 ttlData = 1 << module.outputChan;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
-                        module.samplesSinceTrigger = 0;
-                        module.wasTriggered = true;
-                    }
-
-                    module.phase = FALLING_NEG;
-                }
-                else if (sample > module.lastSample && sample < 0 && module.phase != RISING_NEG)
-                {
-                    if (module.type == TROUGH)
-                    {
-						uint8 ttlData = 1 << module.outputChan;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
-                        module.samplesSinceTrigger = 0;
-                        module.wasTriggered = true;
-                    }
-
-                    module.phase = RISING_NEG;
-                }
-                else if (sample > 0
-                         && module.lastSample <= 0
-                         && module.phase != RISING_POS)
-                {
-                    if (module.type == RISING_ZERO)
-                    {
-						uint8 ttlData = 1 << module.outputChan;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
-                        module.samplesSinceTrigger = 0;
-                        module.wasTriggered = true;
-                    }
-
-                    module.phase = RISING_POS;
-                }
-
-                module.lastSample = sample;
-
-                if (module.wasTriggered)
-                {
-                    if (module.samplesSinceTrigger > 1000)
-                    {
-						uint8 ttlData = 0;
-						TTLEventPtr event = TTLEvent::createTTLEvent(moduleEventChannels[m], getTimestamp(module.inputChan) + i, &ttlData, sizeof(uint8), module.outputChan);
-						addEvent(moduleEventChannels[m], event, i);
-                        module.wasTriggered = false;
-                    }
-                    else
-                    {
-                        module.samplesSinceTrigger++;
-                    }
-                }
+                uint8 ttlData = 0;
+                TTLEventPtr event = TTLEvent::createTTLEvent (moduleEventChannels[m], timestamp + offPos, &ttlData, sizeof (uint8), module.outputChan);
+                addEvent (moduleEventChannels[m], event, offPos);
+
+                module.samplesSinceTrigger += offPos - pos;
+                module.wasTriggered = false;
+                pos = offPos;
+            }
+            else if (onPos < nSamples)
+            {
+                uint8 ttlData = 1 << module.outputChan;
+                TTLEventPtr event = TTLEvent::createTTLEvent (moduleEventChannels[m], timestamp + onPos, &ttlData, sizeof (uint8), module.outputChan);
+                addEvent (moduleEventChannels[m], event, onPos);
+
+                module.samplesSinceTrigger = 0;
+                module.wasTriggered = true;
+                pos = onPos;
+                ++t;
+            }
+            else
+            {
+                break;
             }
         }
+
+        module.samplesSinceTrigger += nSamples - pos;
     }
 }
 
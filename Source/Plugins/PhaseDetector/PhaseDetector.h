@@ -26,13 +26,21 @@
 
 
 #include <ProcessorHeaders.h>
+#include "PhaseEstimator.h"
 
 #define NUM_INTERVALS 5
+#define MAX_TRIGGERS_PER_BLOCK 64
+#define TTL_LENGTH_SAMPLES 1000
 
 
 /**
 
-    Uses peaks to estimate the phase of a continuous signal.
+    Estimates the phase of a continuous signal and sends a TTL pulse when it reaches
+    the selected phase, ahead of time by the configured lead time.
+
+    Each module runs its own PhaseEstimator over the whole block, so the per-sample
+    work is a tight loop over contiguous data and triggers come out as a short list
+    of sample positions.
 
     @see GenericProcessor, PhaseDetectorEditor
 */
@@ -62,16 +70,13 @@ private:
 
     void estimateFrequency();
 
+    static double getTargetPhase (int moduleType);
+
     enum ModuleType
     {
         NONE, PEAK, FALLING_ZERO, TROUGH, RISING_ZERO
     };
 
-    enum PhaseType
-    {
-        NO_PHASE, RISING_POS, FALLING_POS, FALLING_NEG, RISING_NEG
-    };
-
     struct DetectorModule
     {
         int inputChan;
@@ -79,16 +84,18 @@ private:
         int outputChan;
         int samplesSinceTrigger;
 
-        float lastSample;
+        float leadTime;
 
         bool isActive;
         bool wasTriggered;
 
         ModuleType type;
-        PhaseType phase;
     };
 
     Array<DetectorModule> modules;
+    OwnedArray<PhaseEstimator> estimators;
+
+    int triggerSamples[MAX_TRIGGERS_PER_BLOCK];
 
     int activeModule;
 
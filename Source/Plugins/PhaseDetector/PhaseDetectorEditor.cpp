@@ -189,6 +189,7 @@ void PhaseDetectorEditor::saveCustomParameters(XmlElement* xml)
         d->setAttribute("INPUT",interfaces[i]->getInputChan());
         d->setAttribute("GATE",interfaces[i]->getGateChan());
         d->setAttribute("OUTPUT",interfaces[i]->getOutputChan());
+        d->setAttribute("LEAD",interfaces[i]->getLeadTime());
     }
 }
 
@@ -211,6 +212,7 @@ void PhaseDetectorEditor::loadCustomParameters(XmlElement* xml)
             interfaces[i]->setInputChan(xmlNode->getIntAttribute("INPUT"));
             interfaces[i]->setGateChan(xmlNode->getIntAttribute("GATE"));
             interfaces[i]->setOutputChan(xmlNode->getIntAttribute("OUTPUT"));
+            interfaces[i]->setLeadTime((float) xmlNode->getDoubleAttribute("LEAD", 0.0));
 
             i++;
         }
@@ -293,6 +295,15 @@ DetectorInterface::DetectorInterface(PhaseDetector* pd, Colour c, int id) :
     outputSelector->setSelectedId(1);
     addAndMakeVisible(outputSelector);
 
+    leadTimeEditable = new Label("lead time", "0");
+    leadTimeEditable->setEditable(true, false, false);
+    leadTimeEditable->addListener(this);
+    leadTimeEditable->setBounds(5,62,30,16);
+    leadTimeEditable->setColour(Label::backgroundColourId, Colours::grey);
+    leadTimeEditable->setColour(Label::textColourId, Colours::white);
+    leadTimeEditable->setTooltip("How many ms before the selected phase the output should fire");
+    addAndMakeVisible(leadTimeEditable);
+
 
     std::cout << "Updating channels" << std::endl;
 
@@ -352,6 +363,16 @@ void DetectorInterface::buttonClicked(Button* b)
 
 }
 
+void DetectorInterface::labelTextChanged(Label* label)
+{
+    if (label == leadTimeEditable)
+    {
+        float leadTime = jlimit(0.0f, 500.0f, label->getText().getFloatValue());
+
+        setLeadTime(leadTime);
+    }
+}
+
 void DetectorInterface::updateChannels(int numChannels)
 {
 
@@ -383,6 +404,7 @@ void DetectorInterface::paint(Graphics& g)
     g.drawText("INPUT",50,10,85,10,Justification::right, true);
     g.drawText("GATE",50,35,85,10,Justification::right, true);
     g.drawText("OUTPUT",50,60,85,10,Justification::right, true);
+    g.drawText("MS LEAD",38,65,50,10,Justification::left, true);
 
 }
 
@@ -434,6 +456,15 @@ void DetectorInterface::setGateChan(int chan)
     processor->setParameter(4, (float) chan);
 }
 
+void DetectorInterface::setLeadTime(float ms)
+{
+    leadTimeEditable->setText(String(ms), dontSendNotification);
+
+    processor->setActiveModule(idNum);
+
+    processor->setParameter(5, ms);
+}
+
 int DetectorInterface::getInputChan()
 {
     return inputSelector->getSelectedId()-2;
@@ -448,9 +479,16 @@ int DetectorInterface::getGateChan()
 {
     return gateSelector->getSelectedId()-2;
 }
+
+float DetectorInterface::getLeadTime()
+{
+    return leadTimeEditable->getText().getFloatValue();
+}
+
 void DetectorInterface::setEnableStatus(bool status)
 {
 	inputSelector->setEnabled(status);
+	leadTimeEditable->setEnabled(status);
 	for (int i = 0; i < phaseButtons.size(); i++)
 		phaseButtons[i]->setEnabled(status);
 }
\ No newline at end of file
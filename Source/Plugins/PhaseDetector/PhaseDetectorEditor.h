@@ -85,7 +85,8 @@ private:
 
 class DetectorInterface : public Component,
     public ComboBox::Listener,
-    public Button::Listener
+    public Button::Listener,
+    public Label::Listener
 {
 public:
     DetectorInterface(PhaseDetector*, Colour, int);
@@ -95,6 +96,7 @@ public:
 
     void comboBoxChanged(ComboBox*);
     void buttonClicked(Button*);
+    void labelTextChanged(Label*);
 
     void updateChannels(int);
 
@@ -102,11 +104,13 @@ public:
     void setInputChan(int);
     void setOutputChan(int);
     void setGateChan(int);
+    void setLeadTime(float);
 
     int getPhase();
     int getInputChan();
     int getOutputChan();
     int getGateChan();
+    float getLeadTime();
 
 	void setEnableStatus(bool status);
 
@@ -127,6 +131,8 @@ private:
     ScopedPointer<ComboBox> gateSelector;
     ScopedPointer<ComboBox> outputSelector;
 
+    ScopedPointer<Label> leadTimeEditable;
+
 };
 
 #endif  // __PHASEDETECTOREDITOR_H_136829C6__
@@ -0,0 +1,486 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PhaseEstimator.h"
+
+#include <cmath>
+#include <vector>
+
+PhaseEstimator::PhaseEstimator()
+    : sampleRate(0.0f), decimation(1), decimatedRate(1.0f),
+      decimationCount(0), decimationSum(0.0f),
+      numCoefficients(0), filterLength(0), historyPos(0), samplesSeen(0),
+      targetPhase(0.0), leadTime(0.0),
+      lastPhase(0.0), omega(0.0), gainOmega(-1.0), hilbertGain(1.0),
+      meanAmplitude(0.0), lastPredictionError(0.0), hasLastPrediction(false),
+      samplesSinceTrigger(0)
+{
+    setSampleRate(30000.0f);
+}
+
+PhaseEstimator::~PhaseEstimator()
+{
+}
+
+double PhaseEstimator::wrapPhase(double phase)
+{
+    return phase - 2.0 * double_Pi * std::floor((phase + double_Pi) / (2.0 * double_Pi));
+}
+
+void PhaseEstimator::setSampleRate(float rate)
+{
+    sampleRate = rate > 0.0f ? rate : 30000.0f;
+
+    decimation = jmax(1, roundToInt(sampleRate / targetDecimatedRate));
+    decimatedRate = sampleRate / decimation;
+
+    filterLength = 2 * hilbertHalfLength + 1;
+    numCoefficients = (hilbertHalfLength + 1) / 2;
+
+    // ideal Hilbert transformer 2 / (pi m) at odd offsets m, Blackman windowed
+    coefficients.malloc(numCoefficients);
+
+    for (int j = 0; j < numCoefficients; j++)
+    {
+        int m = 2 * j + 1;
+        double r = double(m) / (hilbertHalfLength + 1);
+        double window = 0.42 + 0.5 * std::cos(double_Pi * r) + 0.08 * std::cos(2.0 * double_Pi * r);
+
+        coefficients[j] = float(2.0 / (double_Pi * m) * window);
+    }
+
+    history.malloc(2 * filterLength);
+
+    reset();
+}
+
+void PhaseEstimator::setTargetPhase(double phase)
+{
+    targetPhase = wrapPhase(phase);
+}
+
+void PhaseEstimator::setLeadTime(double milliseconds)
+{
+    leadTime = jmax(0.0, milliseconds);
+}
+
+void PhaseEstimator::reset()
+{
+    history.clear(2 * filterLength);
+    historyPos = 0;
+    samplesSeen = 0;
+
+    decimationCount = 0;
+    decimationSum = 0.0f;
+
+    lastPhase = 0.0;
+    omega = 2.0 * double_Pi * 8.0 / decimatedRate; // start from theta
+    gainOmega = -1.0;
+    hilbertGain = 1.0;
+    meanAmplitude = 0.0;
+    hasLastPrediction = false;
+    samplesSinceTrigger = 0;
+}
+
+double PhaseEstimator::getFilterDelay() const
+{
+    return (hilbertHalfLength + 0.5 * (decimation - 1) / decimation) / decimatedRate * 1000.0;
+}
+
+double PhaseEstimator::getFrequency() const
+{
+    return omega * decimatedRate / (2.0 * double_Pi);
+}
+
+int PhaseEstimator::process(const float* data, int numSamples, int* triggerSamples, int maxTriggers)
+{
+    int numTriggers = 0;
+    int i = 0;
+
+    while (i < numSamples)
+    {
+        const int n = jmin(decimation - decimationCount, numSamples - i);
+
+        float sum = 0.0f;
+
+        for (int k = 0; k < n; k++)
+            sum += data[i + k];
+
+        decimationSum += sum;
+        decimationCount += n;
+        i += n;
+
+        if (decimationCount == decimation)
+        {
+            processDecimatedSample(decimationSum / decimation, i, triggerSamples, maxTriggers, numTriggers);
+
+            decimationSum = 0.0f;
+            decimationCount = 0;
+        }
+    }
+
+    return numTriggers;
+}
+
+void PhaseEstimator::processDecimatedSample(float x, int blockPos, int* triggerSamples, int maxTriggers, int& numTriggers)
+{
+    // newest sample first, so h[k] is the sample k steps ago
+    if (--historyPos < 0)
+        historyPos += filterLength;
+
+    history[historyPos] = history[historyPos + filterLength] = x;
+
+    if (++samplesSeen < filterLength)
+        return;
+
+    const float* h = history + historyPos;
+    const int centre = hilbertHalfLength;
+
+    float re = h[centre];
+    float im = 0.0f;
+
+    for (int j = 0; j < numCoefficients; j++)
+    {
+        int m = 2 * j + 1;
+        im += coefficients[j] * (h[centre + m] - h[centre - m]);
+    }
+
+    // the windowed filter loses gain at low frequencies; correct it at the current frequency
+    if (std::abs(omega - gainOmega) > 0.01 * omega)
+    {
+        double gain = 0.0;
+
+        for (int j = 0; j < numCoefficients; j++)
+            gain += 2.0 * coefficients[j] * std::sin(omega * (2 * j + 1));
+
+        hilbertGain = jmax(gain, 0.1);
+        gainOmega = omega;
+    }
+
+    im /= float(hilbertGain);
+
+    const double phase = std::atan2(double(im), double(re));
+    const double amplitude = std::sqrt(double(re) * re + double(im) * im);
+
+    if (samplesSeen > filterLength)
+    {
+        omega += frequencySmoothing * (wrapPhase(phase - lastPhase) - omega);
+        omega = jlimit(2.0 * double_Pi * minFrequency / decimatedRate, double_Pi / 2.0, omega);
+
+        meanAmplitude += amplitudeSmoothing * (amplitude - meanAmplitude);
+    }
+    else
+    {
+        meanAmplitude = amplitude;
+    }
+
+    lastPhase = phase;
+    samplesSinceTrigger++;
+
+    // bridge the filter delay, the time from the middle of the box-car to the last input
+    // sample, and the requested lead time
+    const double advance = hilbertHalfLength
+                           + 0.5 * (decimation - 1) / decimation
+                           + leadTime * 0.001 * decimatedRate;
+
+    const double error = wrapPhase(phase + omega * advance - targetPhase);
+
+    // upward crossing of the target, not the jump where the error wraps around
+    if (hasLastPrediction && lastPredictionError < 0.0 && error >= 0.0
+        && error - lastPredictionError < double_Pi)
+    {
+        if (amplitude >= minRelativeAmplitude * meanAmplitude
+            && samplesSinceTrigger * omega >= double_Pi
+            && numTriggers < maxTriggers)
+        {
+            const double fraction = -lastPredictionError / (error - lastPredictionError);
+            const int pos = blockPos - decimation + roundToInt(fraction * decimation);
+
+            triggerSamples[numTriggers++] = jlimit(0, blockPos - 1, pos);
+            samplesSinceTrigger = 0;
+        }
+    }
+
+    lastPredictionError = error;
+    hasLastPrediction = true;
+}
+
+// ----------------------------------------------------------------------------
+
+namespace
+{
+    /** The raw sign-change detection PhaseDetector used before, for comparison. */
+    int runLegacyDetector(const float* data, int numSamples, int type, std::vector<int64>& triggers)
+    {
+        enum { FALLING_POS = 1, FALLING_NEG, RISING_NEG, RISING_POS };
+
+        int state = 0;
+        float lastSample = 0.0f;
+
+        for (int i = 0; i < numSamples; i++)
+        {
+            const float sample = data[i];
+            int newState = 0;
+
+            if (sample < lastSample && sample > 0 && state != FALLING_POS)
+                newState = FALLING_POS;
+            else if (sample < 0 && lastSample >= 0 && state != FALLING_NEG)
+                newState = FALLING_NEG;
+            else if (sample > lastSample && sample < 0 && state != RISING_NEG)
+                newState = RISING_NEG;
+            else if (sample > 0 && lastSample <= 0 && state != RISING_POS)
+                newState = RISING_POS;
+
+            if (newState != 0)
+            {
+                if (newState == type)
+                    triggers.push_back(i);
+
+                state = newState;
+            }
+
+            lastSample = sample;
+        }
+
+        return (int) triggers.size();
+    }
+
+    struct PhaseErrorStats
+    {
+        int numTriggers;
+        double triggersPerCycle;
+        double meanError;
+        double circularSpread;
+        double fractionWithin30;
+    };
+}
+
+void PhaseEstimator::runBenchmark(const float* data, int numSamples, float sampleRate,
+                                  double targetPhase, double leadTimeMs)
+{
+    PhaseEstimator estimator;
+    estimator.setSampleRate(sampleRate);
+    estimator.setTargetPhase(targetPhase);
+    estimator.setLeadTime(leadTimeMs);
+
+    const int R = estimator.decimation;
+    const int numDecimated = numSamples / R;
+    const int refHalfLength = 4 * estimator.hilbertHalfLength;
+
+    if (numDecimated < 4 * refHalfLength)
+    {
+        std::cout << "PhaseEstimator benchmark: recording too short." << std::endl;
+        return;
+    }
+
+    // reference phase: same decimation, but a much longer Hilbert filter applied non-causally
+    std::vector<double> decimated(numDecimated);
+
+    for (int k = 0; k < numDecimated; k++)
+    {
+        double sum = 0.0;
+
+        for (int j = 0; j < R; j++)
+            sum += data[k * R + j];
+
+        decimated[k] = sum / R;
+    }
+
+    std::vector<double> refCoefficients((refHalfLength + 1) / 2);
+
+    for (int j = 0; j < (int) refCoefficients.size(); j++)
+    {
+        int m = 2 * j + 1;
+        double r = double(m) / (refHalfLength + 1);
+        refCoefficients[j] = 2.0 / (double_Pi * m) * (0.42 + 0.5 * std::cos(double_Pi * r) + 0.08 * std::cos(2.0 * double_Pi * r));
+    }
+
+    std::vector<double> refPhase(numDecimated, 0.0);
+    double unwrapOffset = 0.0;
+    int numCycles = 0;
+
+    for (int k = refHalfLength; k < numDecimated - refHalfLength; k++)
+    {
+        double im = 0.0;
+
+        for (int j = 0; j < (int) refCoefficients.size(); j++)
+        {
+            int m = 2 * j + 1;
+            im += refCoefficients[j] * (decimated[k - m] - decimated[k + m]);
+        }
+
+        double phase = std::atan2(im, decimated[k]);
+
+        if (k > refHalfLength)
+        {
+            double previous = refPhase[k - 1];
+            double unwrapped = previous + wrapPhase(phase + unwrapOffset - previous);
+            unwrapOffset = unwrapped - phase;
+
+            // count reference crossings of the target phase
+            if (std::floor((unwrapped - targetPhase) / (2.0 * double_Pi)) > std::floor((previous - targetPhase) / (2.0 * double_Pi)))
+                numCycles++;
+
+            refPhase[k] = unwrapped;
+        }
+        else
+        {
+            refPhase[k] = phase;
+        }
+    }
+
+    // reference phase at an input sample; the decimated sample k is centred on k * R + (R - 1) / 2
+    auto phaseAt = [&](double sample, double& phase) -> bool
+    {
+        double k = (sample - 0.5 * (R - 1)) / R;
+        int k0 = (int) std::floor(k);
+
+        if (k0 <= refHalfLength || k0 + 1 >= numDecimated - refHalfLength)
+            return false;
+
+        double f = k - k0;
+        phase = refPhase[k0] + f * (refPhase[k0 + 1] - refPhase[k0]);
+        return true;
+    };
+
+    const double leadSamples = leadTimeMs * 0.001 * sampleRate;
+
+    auto evaluate = [&](const std::vector<int64>& triggers) -> PhaseErrorStats
+    {
+        PhaseErrorStats stats = { 0, 0.0, 0.0, 0.0, 0.0 };
+        double sumSin = 0.0, sumCos = 0.0;
+        int within = 0;
+
+        for (size_t t = 0; t < triggers.size(); t++)
+        {
+            double phase;
+
+            if (!phaseAt(double(triggers[t]) + leadSamples, phase))
+                continue;
+
+            double err = wrapPhase(phase - targetPhase);
+            sumSin += std::sin(err);
+            sumCos += std::cos(err);
+
+            if (std::abs(err) <= double_Pi / 6.0)
+                within++;
+
+            stats.numTriggers++;
+        }
+
+        if (stats.numTriggers > 0)
+        {
+            double n = stats.numTriggers;
+            double resultant = std::sqrt(sumSin * sumSin + sumCos * sumCos) / n;
+
+            stats.meanError = std::atan2(sumSin, sumCos);
+            stats.circularSpread = std::sqrt(-2.0 * std::log(jmax(resultant, 1e-9)));
+            stats.fractionWithin30 = within / n;
+        }
+
+        stats.triggersPerCycle = numCycles > 0 ? double(stats.numTriggers) / numCycles : 0.0;
+
+        return stats;
+    };
+
+    // run the estimator in acquisition-sized blocks
+    const int blockSize = 1024;
+    std::vector<int64> triggers;
+    int blockTriggers[64];
+
+    int64 start = Time::getHighResolutionTicks();
+
+    for (int pos = 0; pos < numSamples; pos += blockSize)
+    {
+        int n = jmin(blockSize, numSamples - pos);
+        int numTriggers = estimator.process(data + pos, n, blockTriggers, 64);
+
+        for (int t = 0; t < numTriggers; t++)
+            triggers.push_back(pos + blockTriggers[t]);
+    }
+
+    double seconds = Time::highResolutionTicksToSeconds(Time::getHighResolutionTicks() - start);
+    double usPerBlock = seconds * 1e6 * blockSize / numSamples;
+
+    // the legacy detector only knows the four cardinal phases; pick the closest one
+    int quadrant = roundToInt(wrapPhase(targetPhase) / (double_Pi / 2.0)) & 3;
+    const int legacyTypes[4] = { 1, 2, 3, 4 }; // peak, falling zero, trough, rising zero
+    std::vector<int64> legacyTriggers;
+    runLegacyDetector(data, numSamples, legacyTypes[quadrant], legacyTriggers);
+
+    PhaseErrorStats hilbert = evaluate(triggers);
+    PhaseErrorStats legacy = evaluate(legacyTriggers);
+
+    const double deg = 180.0 / double_Pi;
+
+    std::cout << "PhaseEstimator benchmark: " << numSamples / sampleRate << " s at " << sampleRate << " Hz, target "
+              << targetPhase * deg << " deg, lead " << leadTimeMs << " ms, " << numCycles << " reference cycles" << std::endl;
+    std::cout << "  filter delay bridged by prediction: " << estimator.getFilterDelay() << " ms, "
+              << usPerBlock << " us per " << blockSize << "-sample block" << std::endl;
+    std::cout << "  hilbert: " << hilbert.numTriggers << " triggers (" << hilbert.triggersPerCycle << " per cycle), mean error "
+              << hilbert.meanError * deg << " deg, circular SD " << hilbert.circularSpread * deg << " deg, "
+              << hilbert.fractionWithin30 * 100.0 << "% within 30 deg" << std::endl;
+    std::cout << "  sign-change (legacy): " << legacy.numTriggers << " triggers (" << legacy.triggersPerCycle << " per cycle), mean error "
+              << legacy.meanError * deg << " deg, circular SD " << legacy.circularSpread * deg << " deg, "
+              << legacy.fractionWithin30 * 100.0 << "% within 30 deg" << std::endl;
+}
+
+void PhaseEstimator::runSyntheticBenchmark(float sampleRate, double durationSecs)
+{
+    const int numSamples = int(durationSecs * sampleRate);
+    HeapBlock<float> data(numSamples);
+
+    Random random(42);
+
+    auto gaussian = [&random]()
+    {
+        double u = jmax(random.nextDouble(), 1e-12);
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * double_Pi * random.nextDouble());
+    };
+
+    double phase = 0.0;
+    double frequency = 8.0;
+    double pink = 0.0;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        double t = i / sampleRate;
+
+        // frequency wanders between roughly 6 and 10 Hz
+        frequency += (8.0 - frequency) * 0.5 / sampleRate + gaussian() * 0.004;
+        frequency = jlimit(5.0, 11.0, frequency);
+        phase += 2.0 * double_Pi * frequency / sampleRate;
+
+        double amplitude = 100.0 * (1.0 + 0.5 * std::sin(2.0 * double_Pi * 0.3 * t));
+
+        // slow 1/f-like background plus broadband noise, in microvolts
+        pink = 0.9999 * pink + gaussian() * 0.5;
+
+        data[i] = float(amplitude * std::cos(phase) + pink + gaussian() * 20.0);
+    }
+
+    const double targets[4] = { 0.0, double_Pi / 2.0, double_Pi, 3.0 * double_Pi / 2.0 };
+
+    for (int t = 0; t < 4; t++)
+        runBenchmark(data, numSamples, sampleRate, targets[t], 5.0);
+}
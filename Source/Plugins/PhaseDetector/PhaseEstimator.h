@@ -0,0 +1,139 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef PHASEESTIMATOR_H_INCLUDED
+#define PHASEESTIMATOR_H_INCLUDED
+
+#include <BasicJuceHeader.h>
+
+/**
+
+    Streaming estimate of the phase of a narrow-band signal, such as theta.
+
+    Each block is box-car averaged down to roughly 250 Hz. The analytic signal is
+    formed with a windowed FIR Hilbert transformer, which gives the phase a fixed
+    delay of half the filter length. That delay, plus the requested lead time, is
+    bridged by advancing the phase at the smoothed instantaneous frequency. When
+    the predicted phase crosses the target phase, process() reports the input
+    sample where the crossing falls.
+
+    A trigger also needs the envelope to be a reasonable fraction of its running
+    average, and comes at least half a cycle after the previous one. This keeps
+    noise around the target phase from firing repeated triggers.
+
+    Phase conventions: for x = cos (phi), 0 is the peak, pi/2 the falling zero
+    crossing, pi the trough and 3*pi/2 the rising zero crossing.
+
+    @see PhaseDetector
+
+*/
+
+class PhaseEstimator
+{
+public:
+    PhaseEstimator();
+    ~PhaseEstimator();
+
+    /** Sets the input sample rate and builds the decimator and Hilbert filter.
+        Allocates, so it must be called outside of process(). */
+    void setSampleRate (float sampleRate);
+
+    /** Target phase in radians. */
+    void setTargetPhase (double phase);
+
+    /** How far ahead of the target phase the trigger should come, e.g. to cover
+        the output hardware latency. */
+    void setLeadTime (double milliseconds);
+
+    /** Clears the signal history, so the estimate has to settle again. */
+    void reset();
+
+    /** Processes a block of samples. Writes the position of each trigger within the
+        block to triggerSamples and returns how many there were. */
+    int process (const float* data, int numSamples, int* triggerSamples, int maxTriggers);
+
+    /** Delay of the analytic signal that the prediction has to bridge, in ms. */
+    double getFilterDelay() const;
+
+    /** Most recent smoothed frequency estimate, in Hz. */
+    double getFrequency() const;
+
+    /** Compares this estimator and the raw sign-change detection it replaces on a
+        recorded channel. Phase errors are measured against a non-causal reference
+        phase computed from the whole recording, at the time the output lands
+        (trigger time plus lead time). Prints the results to stdout.
+        open-ephys-benchmark --phase runs it on a .kwd recording. */
+    static void runBenchmark (const float* data, int numSamples, float sampleRate,
+                              double targetPhase, double leadTimeMs);
+
+    /** Runs runBenchmark() on a generated theta-like signal with a drifting frequency,
+        amplitude modulation and 1/f and white noise. */
+    static void runSyntheticBenchmark (float sampleRate, double durationSecs);
+
+private:
+    void processDecimatedSample (float x, int blockPos, int* triggerSamples, int maxTriggers, int& numTriggers);
+
+    static double wrapPhase (double phase);
+
+    //Compile-time constants
+    const float targetDecimatedRate{ 250.0f };
+    const int hilbertHalfLength{ 16 };
+    const double frequencySmoothing{ 0.02 };
+    const double amplitudeSmoothing{ 0.002 };
+    const double minRelativeAmplitude{ 0.3 };
+    const double minFrequency{ 1.0 };
+
+    float sampleRate;
+    int decimation;
+    float decimatedRate;
+
+    int decimationCount;
+    float decimationSum;
+
+    // Hilbert coefficients for the odd offsets 1, 3, 5... from the centre tap
+    HeapBlock<float> coefficients;
+    int numCoefficients;
+
+    // decimated history, stored twice so the last filterLength samples are always contiguous
+    HeapBlock<float> history;
+    int filterLength;
+    int historyPos;
+    int samplesSeen;
+
+    double targetPhase;
+    double leadTime;
+
+    double lastPhase;
+    double omega;
+    double gainOmega;
+    double hilbertGain;
+    double meanAmplitude;
+    double lastPredictionError;
+    bool hasLastPrediction;
+    int samplesSinceTrigger;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PhaseEstimator);
+};
+
+
+#endif  // PHASEESTIMATOR_H_INCLUDED
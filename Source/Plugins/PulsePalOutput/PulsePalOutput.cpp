@@ -29,6 +29,9 @@
 PulsePalOutput::PulsePalOutput()
     : GenericProcessor  ("Pulse Pal")
     , channelToChange   (0)
+    , outputThread      ("Pulse Pal Output", this)
+    , blockStartTime    (0)
+    , blockSize         (0)
 {
     setProcessorType (PROCESSOR_TYPE_SINK);
 
@@ -47,6 +50,8 @@ PulsePalOutput::PulsePalOutput()
 
 PulsePalOutput::~PulsePalOutput()
 {
+    outputThread.stopOutput();
+
     pulsePal.updateDisplay ("PULSE PAL v1.0","Click for menu");
 }
 
@@ -76,7 +81,9 @@ void PulsePalOutput::handleEvent (const EventChannel* eventInfo, const MidiMessa
                 && eventChannel == channelTtlTrigger[i]
                 && channelState[i])
             {
-                pulsePal.triggerChannel (i + 1);
+                outputThread.post (i + 1, 1, ttl->getTimestamp(),
+                                   SerialOutputThread::getDetectionTime (blockStartTime, sampleNum, blockSize,
+                                                                         eventInfo->getSampleRate()));
             }
 
             if (eventChannel == channelTtlGate[i])
@@ -91,6 +98,29 @@ void PulsePalOutput::handleEvent (const EventChannel* eventInfo, const MidiMessa
 }
 
 
+void PulsePalOutput::fireSerialOutput (const SerialOutputThread::Command& command)
+{
+    pulsePal.triggerChannel (command.channel);
+}
+
+
+bool PulsePalOutput::enable()
+{
+    outputThread.resetLatencyStats();
+    outputThread.startOutput();
+
+    return true;
+}
+
+
+bool PulsePalOutput::disable()
+{
+    outputThread.stopOutput();
+
+    return true;
+}
+
+
 void PulsePalOutput::setParameter (int parameterIndex, float newValue)
 {
     editor->updateParameterButtons (parameterIndex);
@@ -127,5 +157,8 @@ void PulsePalOutput::setParameter (int parameterIndex, float newValue)
 
 void PulsePalOutput::process (AudioSampleBuffer& buffer)
 {
-    checkForEvents ();
+    blockStartTime = Time::getMillisecondCounterHiRes();
+    blockSize = buffer.getNumSamples();
+
+    checkForEventLanes (TTL_EVENT_LANE);
 }
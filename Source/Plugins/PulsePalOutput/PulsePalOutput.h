@@ -26,15 +26,20 @@
 #include <ProcessorHeaders.h>
 #include "PulsePalOutputEditor.h"
 #include "serial/PulsePal.h"
+#include <SerialLib.h>
 
 
 /**
     Allows the signal chain to send outputs to the Pulse Pal
     from Lucid Biosystems (www.lucidbiosystems.com)
 
-    @see GenericProcessor, PulsePalOutputEditor, PulsePal
+    Triggers are posted to a SerialOutputThread so the audio thread never
+    waits on the serial port.
+
+    @see GenericProcessor, PulsePalOutputEditor, PulsePal, SerialOutputThread
 */
 class PulsePalOutput : public GenericProcessor
+                     , public SerialOutputThread::Target
 {
 public:
     PulsePalOutput();
@@ -48,6 +53,12 @@ public:
 
     void handleEvent (const EventChannel* eventInfo, const MidiMessage& event, int sampleNum) override;
 
+    bool enable() override;
+    bool disable() override;
+
+    /** Triggers the Pulse Pal channel on the output thread. */
+    void fireSerialOutput (const SerialOutputThread::Command& command) override;
+
 
 private:
     Array<int> channelTtlTrigger;
@@ -58,6 +69,11 @@ private:
 
     PulsePal pulsePal;
 
+    SerialOutputThread outputThread;
+
+    double blockStartTime;
+    int blockSize;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PulsePalOutput);
 };
 
@@ -28,6 +28,7 @@
 RecordControl::RecordControl()
     : GenericProcessor  ("Record Control")
     , triggerChannel    (0)
+    , preTriggerSeconds (0.0f)
 {
     setProcessorType (PROCESSOR_TYPE_UTILITY);
 }
@@ -63,18 +64,26 @@ void RecordControl::setParameter (int parameterIndex, float newValue)
     {
         triggerEdge = (Edges)((int)newValue - 1);
     }
+    else if (parameterIndex == 4)
+    {
+        preTriggerSeconds = newValue;
+
+        if (CoreServices::getAcquisitionStatus())
+            CoreServices::RecordNode::setPreTriggerSeconds(preTriggerSeconds);
+    }
 }
 
 
 bool RecordControl::enable()
 {
+    CoreServices::RecordNode::setPreTriggerSeconds(preTriggerSeconds);
     return true;
 }
 
 
 void RecordControl::process (AudioSampleBuffer& buffer)
 {
-    checkForEvents ();
+    checkForEventLanes (TTL_EVENT_LANE);
 }
 
 
@@ -89,22 +98,20 @@ void RecordControl::handleEvent (const EventChannel* eventInfo, const MidiMessag
 			int eventId = ttl->getState() ? 1 : 0;
 			int edge = triggerEdge == RISING ? 1 : 0;
 
-			const MessageManagerLock mmLock;
+			// recording starts or stops at the event's own sample; the record node
+			// hands the rest over to the message thread, so nothing here blocks
+			const int64 timestamp = ttl->getTimestamp();
+			const uint16 sourceNodeId = eventInfo->getSourceNodeID();
+			const uint16 subProcessorIdx = eventInfo->getSubProcessorIdx();
 
 			if (triggerType == SET)
 			{
-				if (eventId == edge)
-				{
-					CoreServices::setRecordingStatus(true);
-				}
-				else
-				{
-					CoreServices::setRecordingStatus(false);
-				}
+				CoreServices::RecordNode::setRecordingStatusAt(eventId == edge, timestamp, sourceNodeId, subProcessorIdx);
 			}
 			else if (triggerType == TOGGLE && eventId == edge)
 			{
-				CoreServices::setRecordingStatus(!CoreServices::getRecordingStatus());
+				CoreServices::RecordNode::setRecordingStatusAt(!CoreServices::RecordNode::isRecordingRequested(),
+															   timestamp, sourceNodeId, subProcessorIdx);
 			}
 		}
     }
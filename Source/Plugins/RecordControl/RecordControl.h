@@ -57,6 +57,9 @@ private:
     Edges triggerEdge;
     Types triggerType;
 
+    /** Seconds before each trigger kept in the recording */
+    float preTriggerSeconds;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RecordControl);
 };
 
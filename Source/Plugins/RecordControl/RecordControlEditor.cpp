@@ -28,7 +28,7 @@
 RecordControlEditor::RecordControlEditor(GenericProcessor* parentNode, bool useDefaultParameterEditors=true)
     : GenericEditor(parentNode, useDefaultParameterEditors)
 {
-    desiredWidth = 170;
+    desiredWidth = 250;
 
     //channelSelector->eventsOnly = true;
 
@@ -85,6 +85,23 @@ RecordControlEditor::RecordControlEditor(GenericProcessor* parentNode, bool useD
 
     addAndMakeVisible(triggerPol);
 
+    preTriggerLabel = new Label("Pre-trigger Text", "Pre-trigger:");
+    preTriggerLabel->setEditable(false);
+    preTriggerLabel->setJustificationType(Justification::centredLeft);
+    preTriggerLabel->setBounds(150, 20, 90, 20);
+
+    addAndMakeVisible(preTriggerLabel);
+
+    preTrigger = new ComboBox("Pre-trigger");
+
+    preTrigger->setEditableText(false);
+    preTrigger->setJustificationType(Justification::centredLeft);
+    preTrigger->addListener(this);
+    preTrigger->setBounds(155, 40, 80, 20);
+    preTrigger->setTooltip("Continuous data kept in each recording from before its trigger. Events and spikes from before it are not kept");
+
+    addAndMakeVisible(preTrigger);
+
     availableChans->addItem("None",1);
   /*  for (int i = 0; i < 10 ; i++)
     {
@@ -101,6 +118,14 @@ RecordControlEditor::RecordControlEditor(GenericProcessor* parentNode, bool useD
     triggerPol->addItem("Rising", 1);
     triggerPol->addItem("Falling", 2);
     triggerPol->setSelectedId(1, sendNotification);
+
+    preTrigger->addItem("None", 1);
+    preTrigger->addItem("1 s", 2);
+    preTrigger->addItem("5 s", 3);
+    preTrigger->addItem("10 s", 4);
+    preTrigger->addItem("30 s", 5);
+    preTrigger->addItem("60 s", 6);
+    preTrigger->setSelectedId(1, sendNotification);
 }
 
 RecordControlEditor::~RecordControlEditor()
@@ -132,6 +157,11 @@ void RecordControlEditor::comboBoxChanged(ComboBox* comboBox)
     {
         getProcessor()->setParameter(3, comboBox->getSelectedId());
     }
+    else if (comboBox == preTrigger)
+    {
+        const float seconds[] = { 0.0f, 1.0f, 5.0f, 10.0f, 30.0f, 60.0f };
+        getProcessor()->setParameter(4, seconds[jlimit(1, 6, comboBox->getSelectedId()) - 1]);
+    }
 }
 
 
@@ -177,6 +207,7 @@ void RecordControlEditor::saveCustomParameters(XmlElement* xml)
     info->setAttribute("Channel",availableChans->getSelectedId());
     info->setAttribute("Mode", triggerMode->getSelectedId());
     info->setAttribute("Edge", triggerPol->getSelectedId());
+    info->setAttribute("PreTrigger", preTrigger->getSelectedId());
 
 }
 
@@ -191,6 +222,7 @@ void RecordControlEditor::loadCustomParameters(XmlElement* xml)
             availableChans->setSelectedId(xmlNode->getIntAttribute("Channel"), sendNotification);
             triggerMode->setSelectedId(xmlNode->getIntAttribute("Mode", 1), sendNotification);
             triggerPol->setSelectedId(xmlNode->getIntAttribute("Edge", 1), sendNotification);
+            preTrigger->setSelectedId(xmlNode->getIntAttribute("PreTrigger", 1), sendNotification);
         }
 
     }
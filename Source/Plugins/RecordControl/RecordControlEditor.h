@@ -53,8 +53,8 @@ private:
 	};
 
 	Array<EventSources> eventSourceArray;
-    ScopedPointer<ComboBox> availableChans, triggerMode, triggerPol;
-    ScopedPointer<Label> chanSel, triggerLabel, polLabel;
+    ScopedPointer<ComboBox> availableChans, triggerMode, triggerPol, preTrigger;
+    ScopedPointer<Label> chanSel, triggerLabel, polLabel, preTriggerLabel;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RecordControlEditor);
 
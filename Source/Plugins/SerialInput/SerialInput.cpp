@@ -24,7 +24,6 @@
 
 #include <stdio.h>
 #include "SerialInput.h"
-#define MAX_MSG_SIZE 10000
 
 const int SerialInput::BAUDRATES[12] = 
 {
@@ -44,17 +43,27 @@ const int SerialInput::BAUDRATES[12] =
 
 
 SerialInput::SerialInput()
-    : GenericProcessor  ("Serial Port")
-    , baudrate          (0)
-	, lastRecv			(0)
+    : GenericProcessor      ("Serial Port")
+    , Thread                ("SerialInput")
+    , baudrate              (0)
+    , messageFifo           (MESSAGE_QUEUE_SIZE)
+    , readError             (false)
+    , lastRecv              (0)
+    , lastEventTimestamp    (0)
 {
     setProcessorType (PROCESSOR_TYPE_SOURCE);
-	dataBuffer.calloc(MAX_MSG_SIZE);
+    dataBuffer.calloc (MAX_MSG_SIZE);
+    messages.allocate (MESSAGE_QUEUE_SIZE, false);
+    readBuffer.malloc (MAX_MSG_SIZE);
+    pendingMessage.length = 0;
+
+    readBytesMetadata.add (new MetaDataValue (MetaDataDescriptor::UINT64, 1));
 }
 
 
 SerialInput::~SerialInput()
 {
+    stopThread (1000);
     serial.close();
 }
 
@@ -116,57 +125,140 @@ bool SerialInput::isReady()
         AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, "SerialInput connection error!", "Could not connect to specified serial device. Check log files for details.");
         return false;
     }
+
+    messageFifo.reset();
+    pendingMessage.length = 0;
+    readError = false;
+    lastRecv = MAX_MSG_SIZE;
+    lastEventTimestamp = 0;
+    startThread();
+
     return true;
 }
 
 
 bool SerialInput::disable()
 {
+    stopThread (1000);
     serial.close();
     return true;
 }
 
 
-void SerialInput::process (AudioSampleBuffer&)
+void SerialInput::run()
 {
-	int64 timestamp = CoreServices::getGlobalTimestamp();
-	setTimestampAndSamples(timestamp, 0);
+    // a message without a newline ends when nothing arrives for about four characters
+    const int64 gapTicks = Time::secondsToHighResolutionTicks (jmax (0.005, 40.0 / baudrate));
+    int64 lastByteTicks = 0;
+
+    while (! threadShouldExit())
+    {
+        const int bytesAvailable = serial.available();
+
+        if (bytesAvailable == OF_SERIAL_ERROR)
+        {
+            readError = true;
+            return;
+        }
+
+        if (bytesAvailable <= 0)
+        {
+            if (pendingMessage.length > 0 && Time::getHighResolutionTicks() - lastByteTicks > gapTicks)
+                queueMessage();
+
+            wait (1);
+            continue;
+        }
+
+        const int bytesRead = serial.readBytes (readBuffer, jmin (bytesAvailable, (int) MAX_MSG_SIZE));
+
+        if (bytesRead < 0)
+        {
+            readError = true;
+            return;
+        }
+
+        lastByteTicks = Time::getHighResolutionTicks();
 
-    int bytesAvailable = serial.available();
+        for (int i = 0; i < bytesRead; ++i)
+        {
+            if (pendingMessage.length == 0)
+                pendingMessage.ticks = lastByteTicks;
+
+            pendingMessage.data[pendingMessage.length++] = readBuffer[i];
+
+            if (readBuffer[i] == '\n' || pendingMessage.length == MAX_MSG_SIZE)
+                queueMessage();
+        }
+    }
+}
 
-    if (bytesAvailable == OF_SERIAL_ERROR)
+
+void SerialInput::queueMessage()
+{
+    int start1, size1, start2, size2;
+    messageFifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    // process() has not caught up yet: the OS keeps buffering the port in the meantime
+    while (size1 + size2 < 1)
+    {
+        if (threadShouldExit())
+            return;
+
+        wait (1);
+        messageFifo.prepareToWrite (1, start1, size1, start2, size2);
+    }
+
+    SerialMessage& msg = messages[size1 > 0 ? start1 : start2];
+    msg.ticks = pendingMessage.ticks;
+    msg.length = pendingMessage.length;
+    memcpy (msg.data, pendingMessage.data, pendingMessage.length);
+    messageFifo.finishedWrite (1);
+
+    pendingMessage.length = 0;
+}
+
+
+void SerialInput::process (AudioSampleBuffer&)
+{
+    const int64 timestamp = CoreServices::getGlobalTimestamp();
+    const int64 nowTicks = Time::getHighResolutionTicks();
+    const double samplesPerTick = CoreServices::getGlobalSampleRate() / (double) Time::getHighResolutionTicksPerSecond();
+    setTimestampAndSamples (timestamp, 0);
+
+    if (readError.exchange (false))
     {
         // ToDo: Properly warn about problem here!
         AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, "SerialInput device access error!", "Could not access serial device.");
-        return;
     }
 
-    if (bytesAvailable > 0)
+    const EventChannel* chan = getEventChannel (getEventChannelIndex (0, getNodeId()));
+
+    int start1, size1, start2, size2;
+    messageFifo.prepareToRead (messageFifo.getNumReady(), start1, size1, start2, size2);
+
+    for (int i = 0; i < size1 + size2; ++i)
     {
+        const SerialMessage& msg = messages[i < size1 ? start1 + i : start2 + i - size1];
 
-        int bytesRead = serial.readBytes (dataBuffer, bytesAvailable);
+        // place the message at the sample it arrived, keeping events in order
+        int64 eventTimestamp = timestamp - (int64) ((nowTicks - msg.ticks) * samplesPerTick);
+        eventTimestamp = jlimit (lastEventTimestamp, jmax (lastEventTimestamp, timestamp), eventTimestamp);
+        lastEventTimestamp = eventTimestamp;
 
-        if (bytesRead > 0)
-        {
-			//Clear the rest of the buffer so we don't send garbage.
-			if (bytesRead < lastRecv)
-				zeromem(dataBuffer.getData() + bytesRead, lastRecv - bytesRead);
-			lastRecv = bytesRead;
-			MetaDataValueArray metadata;
-			MetaDataValuePtr bufferRead = new MetaDataValue(MetaDataDescriptor::UINT64, 1);
-			bufferRead->setValue(static_cast<uint64>(bytesRead));
-			metadata.add(bufferRead);
-			const EventChannel* chan = getEventChannel(getEventChannelIndex(0, getNodeId()));
-			BinaryEventPtr event = BinaryEvent::createBinaryEvent(chan, timestamp, static_cast<uint8*>(dataBuffer.getData()), MAX_MSG_SIZE, metadata);
-			addEvent(chan, event, 0);
-        }
-        else if (bytesRead < 0)
-        {
-            // ToDo: Properly warn about problem here!
-            AlertWindow::showMessageBoxAsync (AlertWindow::WarningIcon, "SerialInput device read error!", "Could not read serial input, even though data should be available.");
-            return;
-        }
+        memcpy (dataBuffer.getData(), msg.data, msg.length);
+
+        //Clear the rest of the buffer so we don't send garbage.
+        if (msg.length < lastRecv)
+            zeromem (dataBuffer.getData() + msg.length, lastRecv - msg.length);
+        lastRecv = msg.length;
+
+        readBytesMetadata[0]->setValue (static_cast<uint64> (msg.length));
+        BinaryEventPtr event = BinaryEvent::createBinaryEvent (chan, eventTimestamp, static_cast<uint8*> (dataBuffer.getData()), MAX_MSG_SIZE, readBytesMetadata);
+        addEvent (chan, event, 0);
     }
+
+    messageFifo.finishedRead (size1 + size2);
 }
 
 
@@ -37,9 +37,19 @@
 /**
     This source processor allows you to pipe binary serial data input straight to the event cue/buffer.
 
+    The port is read on a separate thread, which splits the bytes into messages,
+    stamps each with the high-resolution clock when its first byte is picked up
+    and hands it to process() through a lock-free queue. The audio thread never
+    makes a serial call, and each message is timestamped at the sample it arrived
+    rather than at the start of the block it was delivered in.
+
+    A message ends with a newline, when the line goes quiet for a few characters'
+    time, or when it reaches MAX_MSG_SIZE bytes.
+
     @see SerialInputEditor
 */
 class SerialInput : public GenericProcessor
+                  , public Thread
 {
 public:
     /** The class constructor, used to initialize any members. */
@@ -89,6 +99,9 @@ public:
 
     /** Setter, that allows you to set the baudrate that will be used during acquisition */
     void setBaudrate (int baudrate);
+
+    /** Reads the serial port, splits what arrives into messages and queues them for process(). */
+    void run() override;
 protected:
 	void createEventChannels() override;
 
@@ -106,8 +119,37 @@ private:
     // List of baudrates that are available by default.
     static const int BAUDRATES[12];
 
-	HeapBlock<unsigned char> dataBuffer;
-	int lastRecv;
+    static const int MAX_MSG_SIZE = 10000;
+
+    /** Queues the message being assembled by run(), waiting for room if process() is behind */
+    void queueMessage();
+
+    /** One message from the port, stamped when its first byte was picked up. */
+    struct SerialMessage
+    {
+        int64 ticks;
+        int length;
+        uint8 data[MAX_MSG_SIZE];
+    };
+
+    // Messages passed from the reader thread to process()
+    HeapBlock<SerialMessage> messages;
+    AbstractFifo messageFifo;
+
+    // Used by the reader thread only
+    HeapBlock<uint8> readBuffer;
+    SerialMessage pendingMessage;
+
+    // Set by the reader thread when the port fails
+    std::atomic<bool> readError;
+
+    HeapBlock<unsigned char> dataBuffer;
+    int lastRecv;
+
+    int64 lastEventTimestamp;
+    MetaDataValueArray readBytesMetadata;
+
+    static const int MESSAGE_QUEUE_SIZE = 64;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SerialInput);
 };
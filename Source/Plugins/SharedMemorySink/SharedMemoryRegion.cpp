@@ -0,0 +1,160 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemoryRegion.h"
+
+#ifdef _WIN32
+ #include <Windows.h>
+#else
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+ #include <errno.h>
+ #include <string.h>
+#endif
+
+static_assert (offsetof (SharedMemoryHeader, writeIndex) == 64, "writeIndex must stay at offset 64");
+static_assert (offsetof (SharedMemoryHeader, writeEnd) == 72, "writeEnd must stay at offset 72");
+static_assert (sizeof (SharedMemoryHeader) == 256, "the channel table must start at offset 256");
+
+SharedMemoryRegion::SharedMemoryRegion()
+    : data(nullptr),
+      size(0),
+#ifdef _WIN32
+      handle(nullptr)
+#else
+      fd(-1)
+#endif
+{
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    close();
+}
+
+bool SharedMemoryRegion::create(const String& name_, size_t size_)
+{
+    close();
+
+#ifdef _WIN32
+    const String mappingName = "Local\\" + name_;
+
+    handle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                DWORD(uint64(size_) >> 32), DWORD(size_ & 0xffffffff),
+                                mappingName.toRawUTF8());
+
+    if (handle == NULL)
+    {
+        std::cout << "Couldn't create shared memory " << mappingName << ", error " << (int) GetLastError() << std::endl;
+        handle = nullptr;
+        return false;
+    }
+
+    data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size_);
+
+    if (data == nullptr)
+    {
+        std::cout << "Couldn't map shared memory " << mappingName << ", error " << (int) GetLastError() << std::endl;
+        CloseHandle(handle);
+        handle = nullptr;
+        return false;
+    }
+#else
+    const String shmName = "/" + name_;
+
+    // a stale region from a crashed session may be of the wrong size
+    shm_unlink(shmName.toRawUTF8());
+
+    fd = shm_open(shmName.toRawUTF8(), O_CREAT | O_RDWR, 0644);
+
+    if (fd < 0)
+    {
+        std::cout << "Couldn't create shared memory " << shmName << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (ftruncate(fd, (off_t) size_) != 0)
+    {
+        std::cout << "Couldn't resize shared memory " << shmName << ": " << strerror(errno) << std::endl;
+        ::close(fd);
+        fd = -1;
+        shm_unlink(shmName.toRawUTF8());
+        return false;
+    }
+
+    data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (data == MAP_FAILED)
+    {
+        std::cout << "Couldn't map shared memory " << shmName << ": " << strerror(errno) << std::endl;
+        data = nullptr;
+        ::close(fd);
+        fd = -1;
+        shm_unlink(shmName.toRawUTF8());
+        return false;
+    }
+#endif
+
+    name = name_;
+    size = size_;
+
+    return true;
+}
+
+void SharedMemoryRegion::close()
+{
+    if (data == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(handle);
+    handle = nullptr;
+#else
+    munmap(data, size);
+    ::close(fd);
+    fd = -1;
+    shm_unlink(("/" + name).toRawUTF8());
+#endif
+
+    data = nullptr;
+    size = 0;
+    name = String::empty;
+}
+
+void* SharedMemoryRegion::getData() const
+{
+    return data;
+}
+
+size_t SharedMemoryRegion::getSize() const
+{
+    return size;
+}
+
+const String& SharedMemoryRegion::getName() const
+{
+    return name;
+}
@@ -0,0 +1,114 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYREGION_H_INCLUDED
+#define SHAREDMEMORYREGION_H_INCLUDED
+
+#include <BasicJuceHeader.h>
+
+/**
+    Header at the start of the shared memory ring. All fields are little-endian.
+    Resources/C/open_ephys_shm.h and Resources/Python/continuous_reader.py
+    describe the same layout for readers; keep the three in step.
+
+    After the header come capacity frames of numChannels float32 samples, in
+    microvolts, frame after frame, and then capacity int64 timestamps, one per
+    frame. Frame n lives at slot n % capacity.
+
+    Writing works like a seqlock. Before it touches the ring, the writer stores
+    writeEnd = writeIndex + n, followed by a release fence. It then fills frames
+    [writeIndex, writeIndex + n), which overwrites frames older than
+    writeEnd - capacity, and only then publishes writeIndex + n with release
+    semantics. A reader loads writeIndex with acquire semantics and reads the
+    frames it finds there up to it. Frames older than writeEnd - capacity are
+    gone, or about to be, so the reader starts no earlier than that. When it is
+    done with them, it issues an acquire fence and loads writeEnd again. If that
+    is beyond (first frame read + capacity), some of them may have been
+    overwritten meanwhile.
+*/
+struct SharedMemoryHeader
+{
+    char magic[8];            // "OESHM01"
+    uint32 version;           // 2; 1 had no writeEnd
+    uint32 headerSize;        // bytes before the first frame, a multiple of 4096
+    uint32 numChannels;
+    uint32 capacity;          // frames in the ring, a power of two
+    double sampleRate;
+    uint64 generation;        // changes every time acquisition starts
+    uint64 dataOffset;        // == headerSize
+    uint64 timestampOffset;   // dataOffset + capacity * numChannels * 4
+    uint32 state;             // see States
+    uint32 reserved0;
+
+    // from offset 64, alone on their cache line: the only fields written while running
+    uint64 writeIndex;        // frames written since acquisition started
+    uint64 writeEnd;          // frames written once the block being written is done
+    uint8 reserved1[176];
+
+    // followed by numChannels uint32 indices of the published channels in the
+    // processor's input, from offset 256
+
+    enum States
+    {
+        STOPPED = 0,
+        RUNNING = 1,
+        CLOSED = 2        // the region was replaced; readers should open it again
+    };
+};
+
+/** A named block of memory that other processes can map: POSIX shm_open()
+    on Linux and OS X, a named file mapping on Windows. */
+class SharedMemoryRegion
+{
+public:
+    SharedMemoryRegion();
+    ~SharedMemoryRegion();
+
+    /** Creates, or takes over, the region called name and maps size bytes of it.
+        Returns false and prints why on failure. */
+    bool create (const String& name, size_t size);
+
+    /** Unmaps the region and removes its name, so new readers can't open it.
+        Readers that have it mapped keep their mapping. */
+    void close();
+
+    void* getData() const;
+    size_t getSize() const;
+    const String& getName() const;
+
+private:
+    String name;
+    void* data;
+    size_t size;
+
+#ifdef _WIN32
+    void* handle;
+#else
+    int fd;
+#endif
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedMemoryRegion);
+};
+
+
+#endif  // SHAREDMEMORYREGION_H_INCLUDED
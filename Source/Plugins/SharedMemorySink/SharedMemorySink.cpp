@@ -0,0 +1,256 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemorySink.h"
+#include "SharedMemorySinkEditor.h"
+
+#include <atomic>
+
+SharedMemorySink::SharedMemorySink()
+    : GenericProcessor("Shared Memory"),
+      regionName("open-ephys-continuous"),
+      bufferSeconds(1.0f),
+      header(nullptr),
+      ring(nullptr),
+      timestampRing(nullptr),
+      capacity(0),
+      writeIndex(0)
+{
+    setProcessorType(PROCESSOR_TYPE_SINK);
+}
+
+SharedMemorySink::~SharedMemorySink()
+{
+    setState(SharedMemoryHeader::CLOSED);
+}
+
+AudioProcessorEditor* SharedMemorySink::createEditor()
+{
+    editor = new SharedMemorySinkEditor(this);
+    return editor;
+}
+
+void SharedMemorySink::setState(uint32 state)
+{
+    if (header == nullptr)
+        return;
+
+    std::atomic_thread_fence(std::memory_order_release);
+    *static_cast<volatile uint32*>(&header->state) = state;
+}
+
+bool SharedMemorySink::enable()
+{
+    channels.clear();
+
+    if (editor != nullptr)
+        channels = editor->getActiveChannels();
+
+    if (channels.size() == 0)
+    {
+        for (int i = 0; i < getNumInputs(); i++)
+            channels.add(i);
+    }
+
+    if (channels.size() == 0)
+    {
+        std::cout << "Shared memory: no input channels, nothing to publish." << std::endl;
+        return true;
+    }
+
+    // a reader can only make sense of frames if every channel has the same rate
+    const float sampleRate = getDataChannel(channels[0])->getSampleRate();
+
+    for (int i = channels.size(); --i > 0;)
+    {
+        if (getDataChannel(channels[i])->getSampleRate() != sampleRate)
+        {
+            std::cout << "Shared memory: channel " << channels[i] + 1 << " has a different sample rate and is not published." << std::endl;
+            channels.remove(i);
+        }
+    }
+
+    const uint32 numChannels = (uint32) channels.size();
+    const uint32 newCapacity = (uint32) nextPowerOfTwo(jmax(1024, roundToInt(sampleRate * bufferSeconds)));
+    const uint32 headerSize = (uint32) ((sizeof(SharedMemoryHeader) + numChannels * sizeof(uint32) + 4095) & ~size_t(4095));
+
+    const uint64 dataSize = uint64(newCapacity) * numChannels * sizeof(float);
+    const size_t size = size_t(headerSize + dataSize + uint64(newCapacity) * sizeof(int64));
+
+    // readers keep a mapping of the old region, so tell them it is gone first
+    if (region.getData() == nullptr || region.getName() != regionName || region.getSize() != size)
+    {
+        setState(SharedMemoryHeader::CLOSED);
+        header = nullptr;
+
+        if (! region.create(regionName, size))
+            return false;
+
+        header = static_cast<SharedMemoryHeader*>(region.getData());
+    }
+
+    zerostruct(*header);
+    memcpy(header->magic, "OESHM01", 8);
+    header->version = 2;
+    header->headerSize = headerSize;
+    header->numChannels = numChannels;
+    header->capacity = newCapacity;
+    header->sampleRate = sampleRate;
+    header->generation = (uint64) Time::currentTimeMillis();
+    header->dataOffset = headerSize;
+    header->timestampOffset = headerSize + dataSize;
+
+    uint32* channelTable = reinterpret_cast<uint32*>(header + 1);
+
+    for (int i = 0; i < channels.size(); i++)
+        channelTable[i] = (uint32) channels[i];
+
+    char* base = static_cast<char*>(region.getData());
+    ring = reinterpret_cast<float*>(base + header->dataOffset);
+    timestampRing = reinterpret_cast<int64*>(base + header->timestampOffset);
+    capacity = newCapacity;
+
+    readPointers.malloc(channels.size());
+    writeIndex = 0;
+
+    setState(SharedMemoryHeader::RUNNING);
+
+    std::cout << "Shared memory: publishing " << channels.size() << " channels at " << sampleRate
+              << " Hz to " << regionName << " (" << capacity << " frames, " << size / (1024 * 1024) << " MB)" << std::endl;
+
+    return true;
+}
+
+bool SharedMemorySink::disable()
+{
+    setState(SharedMemoryHeader::STOPPED);
+    return true;
+}
+
+void SharedMemorySink::process(AudioSampleBuffer& continuousBuffer)
+{
+    if (header == nullptr || channels.size() == 0)
+        return;
+
+    const int numChannels = channels.size();
+    const int numSamples = (int) getNumSamples(channels[0]);
+    const int64 timestamp = (int64) getTimestamp(channels[0]);
+
+    for (int c = 0; c < numChannels; c++)
+        readPointers[c] = continuousBuffer.getReadPointer(channels[c]);
+
+    // tell readers which frames are about to be overwritten before touching them
+    *static_cast<volatile uint64*>(&header->writeEnd) = writeIndex + numSamples;
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // a block longer than the ring only leaves its end in it
+    int done = jmax(0, numSamples - (int) capacity);
+
+    while (done < numSamples)
+    {
+        const uint32 slot = uint32((writeIndex + done) & (capacity - 1));
+        const int length = jmin(numSamples - done, int(capacity - slot));
+
+        float* frames = ring + size_t(slot) * numChannels;
+
+        // transpose in tiles of 16 frames, so the writes stay within a few KB
+        for (int i0 = 0; i0 < length; i0 += 16)
+        {
+            const int tile = jmin(16, length - i0);
+
+            for (int c = 0; c < numChannels; c++)
+            {
+                const float* src = readPointers[c] + done + i0;
+                float* dest = frames + size_t(i0) * numChannels + c;
+
+                for (int i = 0; i < tile; i++)
+                    dest[i * numChannels] = src[i];
+            }
+        }
+
+        for (int i = 0; i < length; i++)
+            timestampRing[slot + i] = timestamp + done + i;
+
+        done += length;
+    }
+
+    writeIndex += numSamples;
+
+    // publish the frames only after they are all written
+    std::atomic_thread_fence(std::memory_order_release);
+    *static_cast<volatile uint64*>(&header->writeIndex) = writeIndex;
+}
+
+void SharedMemorySink::setRegionName(const String& name)
+{
+    // POSIX names are a single path component
+    const String cleaned = name.trim().removeCharacters("/\\");
+
+    if (cleaned.isNotEmpty())
+        regionName = cleaned;
+}
+
+const String& SharedMemorySink::getRegionName() const
+{
+    return regionName;
+}
+
+void SharedMemorySink::setBufferSeconds(float seconds)
+{
+    bufferSeconds = jlimit(0.1f, 60.0f, seconds);
+}
+
+float SharedMemorySink::getBufferSeconds() const
+{
+    return bufferSeconds;
+}
+
+int SharedMemorySink::getNumPublishedChannels() const
+{
+    return channels.size();
+}
+
+void SharedMemorySink::saveCustomParametersToXml(XmlElement* parentElement)
+{
+    XmlElement* mainNode = parentElement->createNewChildElement("SHAREDMEMORY");
+    mainNode->setAttribute("name", regionName);
+    mainNode->setAttribute("seconds", bufferSeconds);
+}
+
+void SharedMemorySink::loadCustomParametersFromXml()
+{
+    if (parametersAsXml)
+    {
+        forEachXmlChildElement(*parametersAsXml, mainNode)
+        {
+            if (mainNode->hasTagName("SHAREDMEMORY"))
+            {
+                setRegionName(mainNode->getStringAttribute("name", regionName));
+                setBufferSeconds((float) mainNode->getDoubleAttribute("seconds", bufferSeconds));
+            }
+        }
+    }
+
+    if (editor != nullptr)
+        static_cast<SharedMemorySinkEditor*>(getEditor())->updateFields();
+}
@@ -0,0 +1,93 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYSINK_H_INCLUDED
+#define SHAREDMEMORYSINK_H_INCLUDED
+
+#include <ProcessorHeaders.h>
+#include "SharedMemoryRegion.h"
+
+/**
+
+    Publishes continuous data to other processes on the same machine through a
+    ring buffer in shared memory.
+
+    The channels selected in the editor's channel selector (all of them if none
+    are) are written frame by frame, in microvolts, with one timestamp per frame.
+    Only channels with the sample rate of the first selected channel are
+    published. Any number of readers can map the region and read it without
+    copies; the writer never waits for them. See SharedMemoryHeader for the
+    layout, and Resources/Python/continuous_reader.py and Resources/C/open_ephys_shm.h
+    for readers.
+
+    @see EventBroadcaster
+
+*/
+
+class SharedMemorySink : public GenericProcessor
+{
+public:
+    SharedMemorySink();
+    ~SharedMemorySink();
+
+    AudioProcessorEditor* createEditor() override;
+
+    bool enable() override;
+    bool disable() override;
+
+    void process (AudioSampleBuffer& continuousBuffer) override;
+
+    void saveCustomParametersToXml (XmlElement* parentElement) override;
+    void loadCustomParametersFromXml() override;
+
+    /** The region is called /name under POSIX (/dev/shm/name on Linux). */
+    void setRegionName (const String& name);
+    const String& getRegionName() const;
+
+    /** How much data the ring holds; readers that fall further behind lose data. */
+    void setBufferSeconds (float seconds);
+    float getBufferSeconds() const;
+
+    int getNumPublishedChannels() const;
+
+private:
+    void setState (uint32 state);
+
+    String regionName;
+    float bufferSeconds;
+
+    SharedMemoryRegion region;
+    SharedMemoryHeader* header;
+    float* ring;
+    int64* timestampRing;
+    uint32 capacity;
+
+    Array<int> channels;
+    HeapBlock<const float*> readPointers;
+    uint64 writeIndex;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedMemorySink);
+};
+
+
+#endif  // SHAREDMEMORYSINK_H_INCLUDED
@@ -0,0 +1,110 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SharedMemorySinkEditor.h"
+#include "SharedMemorySink.h"
+
+SharedMemorySinkEditor::SharedMemorySinkEditor(GenericProcessor* parentNode)
+    : GenericEditor(parentNode, false)
+{
+    desiredWidth = 180;
+
+    nameLabel = new Label("Name label", "Name:");
+    nameLabel->setBounds(10, 30, 60, 20);
+    nameLabel->setFont(Font("Small Text", 12, Font::plain));
+    nameLabel->setColour(Label::textColourId, Colours::darkgrey);
+    addAndMakeVisible(nameLabel);
+
+    nameEditable = new Label("Name", "");
+    nameEditable->setBounds(70, 30, 100, 20);
+    nameEditable->setEditable(true, false, false);
+    nameEditable->setColour(Label::backgroundColourId, Colours::grey);
+    nameEditable->setColour(Label::textColourId, Colours::white);
+    nameEditable->setTooltip("Name of the shared memory region readers open");
+    nameEditable->addListener(this);
+    addAndMakeVisible(nameEditable);
+
+    secondsLabel = new Label("Seconds label", "Seconds:");
+    secondsLabel->setBounds(10, 56, 60, 20);
+    secondsLabel->setFont(Font("Small Text", 12, Font::plain));
+    secondsLabel->setColour(Label::textColourId, Colours::darkgrey);
+    addAndMakeVisible(secondsLabel);
+
+    secondsEditable = new Label("Seconds", "");
+    secondsEditable->setBounds(70, 56, 50, 20);
+    secondsEditable->setEditable(true, false, false);
+    secondsEditable->setColour(Label::backgroundColourId, Colours::grey);
+    secondsEditable->setColour(Label::textColourId, Colours::white);
+    secondsEditable->setTooltip("Data kept in the ring; slower readers lose samples");
+    secondsEditable->addListener(this);
+    addAndMakeVisible(secondsEditable);
+
+    statusLabel = new Label("Status", "");
+    statusLabel->setBounds(10, 86, 160, 20);
+    statusLabel->setFont(Font("Small Text", 11, Font::plain));
+    statusLabel->setColour(Label::textColourId, Colours::darkgrey);
+    addAndMakeVisible(statusLabel);
+
+    updateFields();
+}
+
+SharedMemorySinkEditor::~SharedMemorySinkEditor()
+{
+}
+
+void SharedMemorySinkEditor::updateFields()
+{
+    SharedMemorySink* p = static_cast<SharedMemorySink*>(getProcessor());
+
+    nameEditable->setText(p->getRegionName(), dontSendNotification);
+    secondsEditable->setText(String(p->getBufferSeconds()), dontSendNotification);
+}
+
+void SharedMemorySinkEditor::labelTextChanged(Label* label)
+{
+    SharedMemorySink* p = static_cast<SharedMemorySink*>(getProcessor());
+
+    if (label == nameEditable)
+        p->setRegionName(label->getText());
+    else if (label == secondsEditable)
+        p->setBufferSeconds(label->getText().getFloatValue());
+
+    // show what was actually set, after clamping
+    updateFields();
+}
+
+void SharedMemorySinkEditor::startAcquisition()
+{
+    SharedMemorySink* p = static_cast<SharedMemorySink*>(getProcessor());
+
+    nameEditable->setEnabled(false);
+    secondsEditable->setEnabled(false);
+    statusLabel->setText(String(p->getNumPublishedChannels()) + " channels published", dontSendNotification);
+}
+
+void SharedMemorySinkEditor::stopAcquisition()
+{
+    nameEditable->setEnabled(true);
+    secondsEditable->setEnabled(true);
+    statusLabel->setText(String::empty, dontSendNotification);
+}
@@ -0,0 +1,64 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2017 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SHAREDMEMORYSINKEDITOR_H_INCLUDED
+#define SHAREDMEMORYSINKEDITOR_H_INCLUDED
+
+#include <EditorHeaders.h>
+
+/**
+
+    User interface for the shared memory sink: the region name and how many
+    seconds of data it holds. The channels to publish are picked with the
+    channel selector.
+
+    @see SharedMemorySink
+
+*/
+
+class SharedMemorySinkEditor : public GenericEditor,
+    public Label::Listener
+{
+public:
+    SharedMemorySinkEditor (GenericProcessor* parentNode);
+    ~SharedMemorySinkEditor();
+
+    void labelTextChanged (Label* label) override;
+
+    void startAcquisition() override;
+    void stopAcquisition() override;
+
+    void updateFields();
+
+private:
+    ScopedPointer<Label> nameLabel;
+    ScopedPointer<Label> nameEditable;
+    ScopedPointer<Label> secondsLabel;
+    ScopedPointer<Label> secondsEditable;
+    ScopedPointer<Label> statusLabel;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedMemorySinkEditor);
+};
+
+
+#endif  // SHAREDMEMORYSINKEDITOR_H_INCLUDED
@@ -22,6 +22,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <stdio.h>
+#include <float.h>
 #include <algorithm>
 #include "SpikeSortBoxes.h"
 #include "SpikeSorter.h"
@@ -605,6 +606,9 @@ SpikeSortBoxes::SpikeSortBoxes(UniqueIDgenerator* uniqueIDgenerator_,PCAcomputin
     selectedUnit = -1;
     selectedBox = -1;
     bRePCA = false;
+    bTemplatesStale = true;
+    spikesSinceSeeding = 0;
+    bSeedingJobSubmitted = false;
     pc1min = -1;
     pc2min = -1;
     pc1max = 1;
@@ -645,6 +649,7 @@ void SpikeSortBoxes::resizeWaveform(int numSamples)
     {
         boxUnits[k].resizeWaveform(waveformLength);
     }
+    bTemplatesStale = true;
     //EndCriticalSection();
 }
 
@@ -754,6 +759,7 @@ void SpikeSortBoxes::loadCustomParametersFromXml(XmlElement* electrodeNode)
             }
         }
     }
+    bTemplatesStale = true;
 }
 
 void SpikeSortBoxes::saveCustomParametersToXml(XmlElement* electrodeNode)
@@ -922,6 +928,7 @@ void SpikeSortBoxes::RePCA()
     bPCAcomputed = false;
     bPCAJobSubmitted = false;
     bRePCA = true;
+    bTemplatesStale = true;
 }
 
 void SpikeSortBoxes::addPCAunit(PCAUnit unit)
@@ -929,6 +936,7 @@ void SpikeSortBoxes::addPCAunit(PCAUnit unit)
     const ScopedLock myScopedLock(mut);
     //StartCriticalSection();
     pcaUnits.push_back(unit);
+    bTemplatesStale = true;
     //EndCriticalSection();
 }
 
@@ -1045,6 +1053,7 @@ void SpikeSortBoxes::generateNewIDs()
     {
         pcaUnits[k].UnitID = generateUnitID();
     }
+    bTemplatesStale = true;
 }
 
 void SpikeSortBoxes::removeAllUnits()
@@ -1052,6 +1061,7 @@ void SpikeSortBoxes::removeAllUnits()
     const ScopedLock myScopedLock(mut);
     boxUnits.clear();
     pcaUnits.clear();
+    bTemplatesStale = true;
 }
 
 bool SpikeSortBoxes::removeUnit(int unitID)
@@ -1073,6 +1083,7 @@ bool SpikeSortBoxes::removeUnit(int unitID)
         if (pcaUnits[k].getUnitID() == unitID)
         {
             pcaUnits.erase(pcaUnits.begin()+k);
+            bTemplatesStale = true;
             //EndCriticalSection();
             return true;
         }
@@ -1149,6 +1160,7 @@ void SpikeSortBoxes::updatePCAUnits(std::vector<PCAUnit> _units)
     //StartCriticalSection();
     const ScopedLock myScopedLock(mut);
     pcaUnits = _units;
+    bTemplatesStale = true;
     //EndCriticalSection();
 }
 
@@ -1228,6 +1240,253 @@ bool SpikeSortBoxes::sortSpike(SorterSpikePtr so, bool PCAfirst)
     return false;
 }
 
+// assigns a candidate spike to the unit with the nearest template
+bool SpikeSortBoxes::matchSpikeToTemplates(SorterSpikePtr so, int64& matchTicks, int& numMatched)
+{
+    const ScopedLock myScopedLock(mut);
+
+    if (bSeedingJobSubmitted && seedingJob->finished)
+    {
+        bSeedingJobSubmitted = false;
+
+        // templates seeded from units that have changed since are thrown away
+        if (!bTemplatesStale)
+        {
+            templateMatcher.swapWith(seedingJob->matcher);
+
+            for (int k = 0; k < templateMatcher.getNumUnits(); k++)
+            {
+                if (templateMatcher.getUnitID(k) < 0)
+                    templateMatcher.setUnitID(k, uniqueIDgenerator->generateUniqueID());
+            }
+        }
+    }
+
+    // while there is nothing to match against, retry once per buffer of spikes
+    if (!bSeedingJobSubmitted && (bTemplatesStale || (templateMatcher.getNumUnits() == 0 && ++spikesSinceSeeding >= bufferSize)))
+        submitSeedingJob();
+
+    if (so->getChannel()->getNumChannels() * so->getChannel()->getTotalSamples() != templateMatcher.getNumSamples())
+        return false;
+
+    const int64 startTicks = Time::getHighResolutionTicks();
+    const int unit = templateMatcher.match(so->getData());
+    matchTicks += Time::getHighResolutionTicks() - startTicks;
+    numMatched++;
+
+    if (unit < 0)
+        return false;
+
+    const uint8* color = templateMatcher.getUnitColor(unit);
+    so->sortedId = templateMatcher.getUnitID(unit);
+    so->color[0] = color[0];
+    so->color[1] = color[1];
+    so->color[2] = color[2];
+
+    for (int k=0; k<pcaUnits.size(); k++)
+    {
+        if (pcaUnits[k].getUnitID() == so->sortedId)
+        {
+            pcaUnits[k].updateWaveform(so);
+            break;
+        }
+    }
+    return true;
+}
+
+// Drops the current templates and has new ones seeded on the PCA thread, once the
+// principal components are known. Call with mut held.
+void SpikeSortBoxes::submitSeedingJob()
+{
+    templateMatcher.clear();
+    bTemplatesStale = false;
+    spikesSinceSeeding = 0;
+
+    if (!bPCAcomputed)
+        return;
+
+    seedingJob = new TemplateSeedingJob(spikeBuffer, pc1, pc2, numChannels * waveformLength, pcaUnits, generateLocalID());
+    bSeedingJobSubmitted = true;
+    computingThread->addSeedingJob(seedingJob);
+}
+
+// Splits the points into at most numClusters groups with k-means, starting from
+// centres picked as far apart as possible. Returns the number of clusters.
+static int clusterPoints(const std::vector<PointD>& points, int numClusters, std::vector<int>& labels)
+{
+    labels.assign(points.size(), 0);
+
+    if (points.size() == 0)
+        return 0;
+
+    std::vector<PointD> centres(1, points[0]);
+
+    while (centres.size() < numClusters)
+    {
+        int farthest = -1;
+        float farthestDistance = 0;
+
+        for (int n = 0; n < points.size(); n++)
+        {
+            float distance = FLT_MAX;
+
+            for (int c = 0; c < centres.size(); c++)
+            {
+                const PointD d = points[n] - centres[c];
+                distance = jmin(distance, d.X * d.X + d.Y * d.Y);
+            }
+
+            if (distance > farthestDistance)
+            {
+                farthest = n;
+                farthestDistance = distance;
+            }
+        }
+
+        if (farthest < 0)
+            break;
+
+        centres.push_back(points[farthest]);
+    }
+
+    for (int iteration = 0; iteration < 20; iteration++)
+    {
+        bool changed = false;
+
+        for (int n = 0; n < points.size(); n++)
+        {
+            int nearest = 0;
+            float nearestDistance = FLT_MAX;
+
+            for (int c = 0; c < centres.size(); c++)
+            {
+                const PointD d = points[n] - centres[c];
+                const float distance = d.X * d.X + d.Y * d.Y;
+
+                if (distance < nearestDistance)
+                {
+                    nearest = c;
+                    nearestDistance = distance;
+                }
+            }
+
+            changed |= labels[n] != nearest;
+            labels[n] = nearest;
+        }
+
+        if (iteration > 0 && !changed)
+            break;
+
+        for (int c = 0; c < centres.size(); c++)
+        {
+            PointD sum;
+            int count = 0;
+
+            for (int n = 0; n < points.size(); n++)
+            {
+                if (labels[n] == c)
+                {
+                    sum += points[n];
+                    count++;
+                }
+            }
+
+            if (count > 0)
+                centres[c] = PointD(sum.X / count, sum.Y / count);
+        }
+    }
+
+    return (int) centres.size();
+}
+
+TemplateSeedingJob::TemplateSeedingJob(SorterSpikeArray& _spikes, const float* _pc1, const float* _pc2, int _dim,
+                                       const std::vector<PCAUnit>& pcaUnits, int _firstLocalID)
+    : finished(false), spikes(_spikes), pc1(_pc1, _pc1 + _dim), pc2(_pc2, _pc2 + _dim), dim(_dim), firstLocalID(_firstLocalID)
+{
+    for (int k=0; k<pcaUnits.size(); k++)
+    {
+        Unit unit;
+        unit.ID = pcaUnits[k].UnitID;
+        unit.color[0] = pcaUnits[k].ColorRGB[0];
+        unit.color[1] = pcaUnits[k].ColorRGB[1];
+        unit.color[2] = pcaUnits[k].ColorRGB[2];
+        unit.poly = pcaUnits[k].poly;
+        units.push_back(unit);
+    }
+}
+
+// Seeds one template per PCA unit from the buffered spikes inside its polygon.
+// Without PCA units, the buffered spikes are clustered on the first two principal
+// components instead, and every large enough cluster becomes a unit.
+void TemplateSeedingJob::seed()
+{
+    const int maxAutomaticUnits = 3;
+
+    std::vector<const float*> waveforms;
+    std::vector<PointD> projections;
+
+    for (int n = 0; n < spikes.size(); n++)
+    {
+        SorterSpikePtr so = spikes[n];
+
+        if (so == nullptr || so->getChannel()->getNumChannels() * so->getChannel()->getTotalSamples() != dim)
+            continue;
+
+        // spikes buffered before the PCA finished were never projected
+        PointD p;
+        for (int k=0; k<dim; k++)
+        {
+            p.X += pc1[k] * so->getData()[k];
+            p.Y += pc2[k] * so->getData()[k];
+        }
+
+        waveforms.push_back(so->getData());
+        projections.push_back(p);
+    }
+
+    if (units.size() > 0)
+    {
+        for (int k=0; k<units.size(); k++)
+        {
+            std::vector<const float*> members;
+
+            for (int n = 0; n < projections.size(); n++)
+            {
+                if (units[k].poly.isPointInside(projections[n]))
+                    members.push_back(waveforms[n]);
+            }
+
+            matcher.addUnit(units[k].ID, units[k].color, members, dim);
+        }
+    }
+    else
+    {
+        std::vector<int> labels;
+        const int numClusters = clusterPoints(projections, maxAutomaticUnits, labels);
+        int localID = firstLocalID;
+
+        for (int c = 0; c < numClusters; c++)
+        {
+            std::vector<const float*> members;
+
+            for (int n = 0; n < projections.size(); n++)
+            {
+                if (labels[n] == c)
+                    members.push_back(waveforms[n]);
+            }
+
+            if ((int) members.size() < TemplateMatcher::minSpikesPerUnit)
+                continue;
+
+            uint8 color[3];
+            BoxUnit::setDefaultColors(color, localID++);
+            matcher.addUnit(-1, color, members, dim);
+        }
+    }
+
+    finished = true;
+}
+
 
 bool  SpikeSortBoxes::removeBoxFromUnit(int unitID, int boxIndex)
 {
@@ -2152,24 +2411,45 @@ void PCAcomputingThread::addPCAjob(PCAJobPtr job)
     }
 }
 
+void PCAcomputingThread::addSeedingJob(TemplateSeedingJobPtr job)
+{
+	{
+		ScopedLock critical(lock);
+		seedingJobs.add(job);
+	}
+
+    if (!isThreadRunning())
+    {
+        startThread();
+    }
+}
+
 void PCAcomputingThread::run()
 {
-    while (jobs.size() > 0)
+    while (jobs.size() > 0 || seedingJobs.size() > 0)
     {
 		lock.enter();
         PCAJobPtr J = jobs.removeAndReturn(0);
-	if (J == nullptr) continue;
+        TemplateSeedingJobPtr S = seedingJobs.removeAndReturn(0);
 		lock.exit();
-        // compute PCA
-        // 1. Compute Covariance matrix
-        // 2. Apply SVD on covariance matrix
-        // 3. Extract the two principal components corresponding to the largest singular values
 
-        J->computeCov();
-        J->computeSVD();
+        if (J != nullptr)
+        {
+            // compute PCA
+            // 1. Compute Covariance matrix
+            // 2. Apply SVD on covariance matrix
+            // 3. Extract the two principal components corresponding to the largest singular values
+
+            J->computeCov();
+            J->computeSVD();
+
+            // 4. Report to the spike sorting electrode that PCA is finished
+            J->reportDone = true;
+        }
 
-        // 4. Report to the spike sorting electrode that PCA is finished
-        J->reportDone = true;
+        // the electrode swaps the templates in once finished is set
+        if (S != nullptr)
+            S->seed();
     }
 }
 
@@ -25,6 +25,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define __SPIKESORTBOXES_H
 
 #include "SpikeSorterEditor.h"
+#include "TemplateMatcher.h"
 #include <algorithm>    // std::sort
 #include <list>
 #include <queue>
@@ -211,15 +212,49 @@ public:
 
 
 
+class PCAUnit;
+
+// Builds the templates of an electrode on the PCA thread, from copies of its spike
+// buffer, principal components and PCA units, so the audio thread only swaps them in.
+// Units found by clustering get their unit ID when they are swapped in.
+class TemplateSeedingJob : public ReferenceCountedObject
+{
+public:
+    TemplateSeedingJob(SorterSpikeArray& _spikes, const float* _pc1, const float* _pc2, int _dim,
+                       const std::vector<PCAUnit>& pcaUnits, int _firstLocalID);
+    void seed();
+
+    TemplateMatcher matcher;
+    std::atomic<bool> finished;
+private:
+    struct Unit
+    {
+        int ID;
+        uint8 color[3];
+        cPolygon poly;
+    };
+
+    SorterSpikeArray spikes;
+    std::vector<float> pc1, pc2;
+    int dim;
+    std::vector<Unit> units;
+    int firstLocalID;
+};
+
+typedef ReferenceCountedObjectPtr<TemplateSeedingJob> TemplateSeedingJobPtr;
+typedef ReferenceCountedArray<TemplateSeedingJob, CriticalSection> TemplateSeedingJobArray;
+
 class PCAcomputingThread : juce::Thread
 {
 public:
     PCAcomputingThread();
-    void run(); // computes PCA on waveforms
+    void run(); // computes PCA on waveforms, and seeds templates
     void addPCAjob(PCAJobPtr job);
+    void addSeedingJob(TemplateSeedingJobPtr job);
 
 private:
     PCAJobArray jobs;
+    TemplateSeedingJobArray seedingJobs;
 	CriticalSection lock;
 };
 
@@ -261,6 +296,12 @@ public:
 
 	void projectOnPrincipalComponents(SorterSpikePtr so);
 	bool sortSpike(SorterSpikePtr so, bool PCAfirst);
+    /** Automatic alternative to sortSpike: assigns the spike to the unit with the
+        nearest mean waveform. Templates are seeded from the PCA units, or by
+        clustering the principal components if no unit has been drawn, on the
+        PCA thread. matchTicks and numMatched add up the time spent matching and
+        the spikes it was spent on. */
+    bool matchSpikeToTemplates(SorterSpikePtr so, int64& matchTicks, int& numMatched);
     void RePCA();
     void addPCAunit(PCAUnit unit);
     int addBoxUnit(int channel);
@@ -293,6 +334,7 @@ public:
     void saveCustomParametersToXml(XmlElement* electrodeNode);
     void loadCustomParametersFromXml(XmlElement* electrodeNode);
 private:
+    void submitSeedingJob();
     //void  StartCriticalSection();
     //void  EndCriticalSection();
     UniqueIDgenerator* uniqueIDgenerator;
@@ -308,6 +350,11 @@ private:
     PCAcomputingThread* computingThread;
     bool bPCAJobSubmitted,bPCAcomputed,bRePCA;
     std::atomic<bool> bPCAjobFinished ;
+    TemplateMatcher templateMatcher;
+    bool bTemplatesStale;
+    int spikesSinceSeeding;
+    TemplateSeedingJobPtr seedingJob;
+    bool bSeedingJobSubmitted;
 
 
 };
@@ -47,6 +47,11 @@ SpikeSorter::SpikeSorter()
     autoDACassignment = false;
     syncThresholds = false;
     flipSignal = false;
+    templateMatching = false;
+    templateMatchingTicks = 0;
+    lastTemplateRateUpdate = 0;
+    templateMatchingSpikes = 0;
+    templateMatchingRate = 0;
 }
 
 bool SpikeSorter::getFlipSignalState()
@@ -70,6 +75,21 @@ void SpikeSorter::setFlipSignalState(bool state)
 
 }
 
+bool SpikeSorter::getTemplateMatchingState()
+{
+    return templateMatching;
+}
+
+void SpikeSorter::setTemplateMatchingState(bool state)
+{
+    templateMatching = state;
+}
+
+float SpikeSorter::getTemplateMatchingRate()
+{
+    return templateMatchingRate;
+}
+
 int SpikeSorter::getNumPreSamples()
 {
     return numPreSamples;
@@ -661,6 +681,11 @@ bool SpikeSorter::enable()
     for (int i = 0; i < electrodes.size(); i++)
         useOverflowBuffer.add(false);
 
+    templateMatchingTicks = 0;
+    templateMatchingSpikes = 0;
+    templateMatchingRate = 0;
+    lastTemplateRateUpdate = Time::getHighResolutionTicks();
+
 
     SpikeSorterEditor* editor = (SpikeSorterEditor*) getEditor();
     editor->enable();
@@ -684,6 +709,9 @@ bool SpikeSorter::disable()
     }
     //editor->disable();
     mut.exit();
+
+    if (templateMatching && templateMatchingRate > 0)
+        std::cout << "SpikeSorter: template matching ran at " << templateMatchingRate << " spikes/s per core" << std::endl;
     return true;
 }
 
@@ -953,7 +981,14 @@ void SpikeSorter::process(AudioSampleBuffer& buffer)
 						electrode->spikeSort->projectOnPrincipalComponents(sorterSpike);
 
                         // Add spike to drawing buffer....
-						electrode->spikeSort->sortSpike(sorterSpike, PCAbeforeBoxes);
+                        if (templateMatching)
+                        {
+                            electrode->spikeSort->matchSpikeToTemplates(sorterSpike, templateMatchingTicks, templateMatchingSpikes);
+                        }
+                        else
+                        {
+                            electrode->spikeSort->sortSpike(sorterSpike, PCAbeforeBoxes);
+                        }
 
 
                         // transfer buffered spikes to spike plot
@@ -1018,6 +1053,18 @@ void SpikeSorter::process(AudioSampleBuffer& buffer)
 
     } // end cycle through electrodes
 
+    // publish the matching throughput about once a second
+    const int64 now = Time::getHighResolutionTicks();
+
+    if (now - lastTemplateRateUpdate > ticksPerSec)
+    {
+        if (templateMatchingTicks > 0)
+            templateMatchingRate = templateMatchingSpikes * ticksPerSec / templateMatchingTicks;
+
+        templateMatchingTicks = 0;
+        templateMatchingSpikes = 0;
+        lastTemplateRateUpdate = now;
+    }
 
     mut.exit();
     //printf("Exitting Spike Detector::process\n");
@@ -1184,6 +1231,7 @@ void SpikeSorter::saveCustomParametersToXml(XmlElement* parentElement)
     mainNode->setAttribute("syncThresholds",syncThresholds);
     mainNode->setAttribute("uniqueID",uniqueID);
     mainNode->setAttribute("flipSignal",flipSignal);
+    mainNode->setAttribute("templateMatching",templateMatching);
 
     XmlElement* countNode = mainNode->createNewChildElement("ELECTRODE_COUNTER");
 
@@ -1246,6 +1294,7 @@ void SpikeSorter::loadCustomParametersFromXml()
                 syncThresholds = mainNode->getBoolAttribute("syncThresholds");
                 uniqueID = mainNode->getIntAttribute("uniqueID");
                 flipSignal = mainNode->getBoolAttribute("flipSignal");
+                templateMatching = mainNode->getBoolAttribute("templateMatching", false);
 
                 forEachXmlChildElement(*mainNode, xmlNode)
                 {
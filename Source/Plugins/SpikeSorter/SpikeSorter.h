@@ -353,6 +353,10 @@ public:
     void setThresholdSyncStatus(bool status);
     bool getFlipSignalState();
     void setFlipSignalState(bool state);
+    bool getTemplateMatchingState();
+    void setTemplateMatchingState(bool state);
+    /** spikes matched per second of processing time on the sorting thread */
+    float getTemplateMatchingRate();
     void startRecording();
     std::vector<float> getElectrodeVoltageScales(int electrodeID);
     //void getElectrodePCArange(int electrodeID, float &minX,float &maxX,float &minY,float &maxY);
@@ -428,6 +432,10 @@ private:
     bool syncThresholds;
  //   RHD2000Thread* getRhythmAccess();
     bool flipSignal;
+    bool templateMatching;
+    int64 templateMatchingTicks, lastTemplateRateUpdate;
+    int templateMatchingSpikes;
+    std::atomic<float> templateMatchingRate;
 
 	bool sorterReady{ false };
 
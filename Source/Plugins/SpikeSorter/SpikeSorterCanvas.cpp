@@ -167,6 +167,17 @@ void SpikeSorterCanvas::paint(Graphics& g)
 
     g.fillAll(Colours::darkgrey);
 
+    if (processor->getTemplateMatchingState())
+    {
+        g.setFont(Font("Small Text", 13, Font::plain));
+        g.setColour(Colours::white);
+        g.drawText("Template matching", 0, 330, 120, 20, Justification::left, false);
+
+        const float rate = processor->getTemplateMatchingRate();
+        if (rate > 0)
+            g.drawText(String(roundFloatToInt(rate)) + " spikes/s/core", 0, 350, 120, 20, Justification::left, false);
+    }
+
 }
 
 void SpikeSorterCanvas::refresh()
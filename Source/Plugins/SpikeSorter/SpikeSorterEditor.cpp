@@ -316,6 +316,7 @@ void SpikeSorterEditor::buttonEvent(Button* button)
         configMenu.addSubMenu("Waveform",waveSizeMenu,true);
         configMenu.addItem(5,"Current Channel => Audio",true,processor->getAutoDacAssignmentStatus());
         configMenu.addItem(6,"Threshold => All channels",true,processor->getThresholdSyncStatus());
+        configMenu.addItem(8,"Template matching",true,processor->getTemplateMatchingState());
 
         const int result = configMenu.show();
         switch (result)
@@ -342,6 +343,9 @@ void SpikeSorterEditor::buttonEvent(Button* button)
             case 7:
                 processor->setFlipSignalState(!processor->getFlipSignalState());
                 break;
+            case 8:
+                processor->setTemplateMatchingState(!processor->getTemplateMatchingState());
+                break;
         }
 
     }
@@ -0,0 +1,200 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "TemplateMatcher.h"
+
+const float TemplateMatcher::updateRate = 0.02f;
+const float TemplateMatcher::maxDistanceRatio = 2.0f;
+
+TemplateMatcher::TemplateMatcher()
+    : numSamples(0), numUnits(0), stride(0)
+{
+}
+
+void TemplateMatcher::clear()
+{
+    numSamples = 0;
+    numUnits = 0;
+    stride = 0;
+
+    templates.clear();
+    norms.clear();
+    spreads.clear();
+    products.clear();
+    unitIDs.clear();
+    colors.clear();
+}
+
+void TemplateMatcher::setStride(int newStride)
+{
+    std::vector<float> newTemplates(size_t(numSamples) * newStride, 0.0f);
+
+    for (int i = 0; i < numSamples; i++)
+        for (int k = 0; k < numUnits; k++)
+            newTemplates[size_t(i) * newStride + k] = templates[size_t(i) * stride + k];
+
+    templates.swap(newTemplates);
+
+    // padding units have a zero template, and are never looked at
+    norms.resize(newStride, 0.0f);
+    spreads.resize(newStride, 0.0f);
+    products.resize(newStride, 0.0f);
+
+    stride = newStride;
+}
+
+bool TemplateMatcher::addUnit(int unitID, const uint8 color[3], const std::vector<const float*>& waveforms, int n)
+{
+    if (int(waveforms.size()) < minSpikesPerUnit || n <= 0 || (numUnits > 0 && n != numSamples))
+        return false;
+
+    numSamples = n;
+
+    // keep the row of every sample a whole number of SIMD registers long
+    if (numUnits == stride)
+        setStride(stride + 8);
+
+    const int k = numUnits++;
+    const float scale = 1.0f / waveforms.size();
+    float norm = 0;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        float mean = 0;
+
+        for (size_t s = 0; s < waveforms.size(); s++)
+            mean += waveforms[s][i];
+
+        mean *= scale;
+        templates[size_t(i) * stride + k] = mean;
+        norm += mean * mean;
+    }
+
+    float spread = 0;
+
+    for (size_t s = 0; s < waveforms.size(); s++)
+    {
+        for (int i = 0; i < numSamples; i++)
+        {
+            const float d = waveforms[s][i] - templates[size_t(i) * stride + k];
+            spread += d * d;
+        }
+    }
+
+    norms[k] = norm;
+    spreads[k] = jmax(1.0f, spread * scale);
+
+    unitIDs.push_back(unitID);
+    colors.insert(colors.end(), color, color + 3);
+
+    return true;
+}
+
+int TemplateMatcher::match(const float* waveform)
+{
+    if (numUnits == 0)
+        return -1;
+
+    float* p = products.data();
+    float energy = 0;
+
+    FloatVectorOperations::clear(p, stride);
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        FloatVectorOperations::addWithMultiply(p, templates.data() + size_t(i) * stride, waveform[i], stride);
+        energy += waveform[i] * waveform[i];
+    }
+
+    int best = 0;
+    float bestDistance = energy - 2.0f * p[0] + norms[0];
+
+    for (int k = 1; k < numUnits; k++)
+    {
+        const float distance = energy - 2.0f * p[k] + norms[k];
+
+        if (distance < bestDistance)
+        {
+            best = k;
+            bestDistance = distance;
+        }
+    }
+
+    bestDistance = jmax(0.0f, bestDistance);
+
+    if (bestDistance > maxDistanceRatio * spreads[best])
+        return -1;
+
+    float* t = templates.data() + best;
+    float norm = 0;
+
+    for (int i = 0; i < numSamples; i++)
+    {
+        t[size_t(i) * stride] += updateRate * (waveform[i] - t[size_t(i) * stride]);
+        norm += t[size_t(i) * stride] * t[size_t(i) * stride];
+    }
+
+    norms[best] = norm;
+    spreads[best] = jmax(1.0f, spreads[best] + updateRate * (bestDistance - spreads[best]));
+
+    return best;
+}
+
+void TemplateMatcher::swapWith(TemplateMatcher& other)
+{
+    std::swap(numSamples, other.numSamples);
+    std::swap(numUnits, other.numUnits);
+    std::swap(stride, other.stride);
+
+    templates.swap(other.templates);
+    norms.swap(other.norms);
+    spreads.swap(other.spreads);
+    products.swap(other.products);
+    unitIDs.swap(other.unitIDs);
+    colors.swap(other.colors);
+}
+
+void TemplateMatcher::setUnitID(int unit, int unitID)
+{
+    unitIDs[unit] = unitID;
+}
+
+int TemplateMatcher::getNumUnits() const
+{
+    return numUnits;
+}
+
+int TemplateMatcher::getNumSamples() const
+{
+    return numSamples;
+}
+
+int TemplateMatcher::getUnitID(int unit) const
+{
+    return unitIDs[unit];
+}
+
+const uint8* TemplateMatcher::getUnitColor(int unit) const
+{
+    return colors.data() + 3 * unit;
+}
@@ -0,0 +1,97 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TEMPLATEMATCHER_H
+#define TEMPLATEMATCHER_H
+
+#include <BasicJuceHeader.h>
+#include <vector>
+
+/**
+    Sorts the spikes of one electrode by matching them against the mean
+    waveform of every unit.
+
+    The templates are stored sample by sample, with all units of a sample next
+    to each other, so a single pass over the spike accumulates its dot product
+    with every template at once. The squared distance to each unit is then
+    |x|^2 - 2 x.t + |t|^2, and the spike belongs to the nearest unit if that
+    distance is within maxDistanceRatio times the unit's running spread. The
+    matched template and its spread follow the spikes by exponential averaging,
+    so units can drift slowly without being redrawn.
+
+    Not thread safe. A TemplateSeedingJob builds one on the PCA thread, and
+    SpikeSortBoxes swaps it in and matches against it under its own lock.
+
+    @see SpikeSortBoxes
+*/
+class TemplateMatcher
+{
+public:
+    TemplateMatcher();
+
+    /** Removes all units. */
+    void clear();
+
+    /** Adds a unit whose template is the mean of the given waveforms, each of
+        the given number of samples (all channels). Returns false, without
+        adding it, if there are fewer than minSpikesPerUnit of them. */
+    bool addUnit(int unitID, const uint8 color[3], const std::vector<const float*>& waveforms, int numSamples);
+
+    /** Returns the index of the unit the waveform belongs to, or -1 if none is
+        close enough. The matched unit's template is updated. */
+    int match(const float* waveform);
+
+    /** Exchanges the units of the two matchers, without allocating. */
+    void swapWith(TemplateMatcher& other);
+
+    void setUnitID(int unit, int unitID);
+
+    int getNumUnits() const;
+    int getNumSamples() const;
+    int getUnitID(int unit) const;
+    const uint8* getUnitColor(int unit) const;
+
+    /** Weight of every new spike in its unit's template and spread */
+    static const float updateRate;
+
+    /** Largest squared distance accepted, relative to the unit's mean one */
+    static const float maxDistanceRatio;
+
+    static const int minSpikesPerUnit = 10;
+
+private:
+    void setStride(int newStride);
+
+    int numSamples;
+    int numUnits;
+    int stride;
+
+    std::vector<float> templates;   // numSamples * stride, sample-major
+    std::vector<float> norms;       // |t|^2 of every template
+    std::vector<float> spreads;     // running mean squared distance of matched spikes
+    std::vector<float> products;    // x.t of the current spike
+    std::vector<int> unitIDs;
+    std::vector<uint8> colors;
+};
+
+#endif // TEMPLATEMATCHER_H
@@ -0,0 +1,387 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SyntheticSignalGenerator.h"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    /** Second-order Butterworth section, in the form of the RBJ audio EQ cookbook. */
+    struct Biquad
+    {
+        Biquad (double frequency, double sampleRate, bool highPass)
+            : z1(0.0), z2(0.0)
+        {
+            const double w0 = 2.0 * double_Pi * frequency / sampleRate;
+            const double alpha = std::sin(w0) / (2.0 * std::sqrt(0.5));
+            const double cosW0 = std::cos(w0);
+            const double a0 = 1.0 + alpha;
+
+            if (highPass)
+            {
+                b0 = (1.0 + cosW0) / 2.0 / a0;
+                b1 = -(1.0 + cosW0) / a0;
+            }
+            else
+            {
+                b0 = (1.0 - cosW0) / 2.0 / a0;
+                b1 = (1.0 - cosW0) / a0;
+            }
+            b2 = b0;
+            a1 = -2.0 * cosW0 / a0;
+            a2 = (1.0 - alpha) / a0;
+        }
+
+        double process (double x)
+        {
+            const double y = b0 * x + z1;
+            z1 = b1 * x - a1 * y + z2;
+            z2 = b2 * x - a2 * y;
+            return y;
+        }
+
+        double b0, b1, b2, a1, a2;
+        double z1, z2;
+    };
+}
+
+SyntheticSignalGenerator::SyntheticSignalGenerator(const SyntheticSignalSettings& s, int64 seed)
+    : settings(s), sampleNumber(0), numSpikes(0), groundTruth(nullptr), subProcessorIdx(0)
+{
+    settings.numChannels = jmax(1, settings.numChannels);
+    settings.channelsPerGroup = jlimit(1, (int) maxChannelsPerGroup, settings.channelsPerGroup);
+    settings.unitsPerGroup = jmax(0, settings.unitsPerGroup);
+
+    samplesPerSecond = jmax(1000, roundToInt(settings.sampleRate));
+    const double fs = samplesPerSecond;
+    const int numChannels = settings.numChannels;
+
+    Random random(seed);
+
+    auto gaussian = [&random]()
+    {
+        double u = jmax(random.nextDouble(), 1e-12);
+        return std::sqrt(-2.0 * std::log(u)) * std::cos(2.0 * double_Pi * random.nextDouble());
+    };
+
+    // 1. band-limited noise, 300 Hz to 6 kHz. The table is filtered twice round so
+    // the filter has settled and the end joins the start without a step.
+    noiseTable.malloc(noiseTableLength);
+
+    for (int i = 0; i < noiseTableLength; i++)
+        noiseTable[i] = float(gaussian());
+
+    Biquad highPass(300.0, fs, true);
+    Biquad lowPass(jmin(6000.0, 0.45 * fs), fs, false);
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < noiseTableLength; i++)
+        {
+            double y = lowPass.process(highPass.process(noiseTable[i]));
+
+            if (pass == 1)
+                noiseTable[i] = float(y);
+        }
+    }
+
+    double sumSquares = 0.0;
+
+    for (int i = 0; i < noiseTableLength; i++)
+        sumSquares += noiseTable[i] * noiseTable[i];
+
+    const float noiseScale = float(settings.noiseAmplitude / jmax(1e-9, std::sqrt(sumSquares / noiseTableLength)));
+
+    for (int i = 0; i < noiseTableLength; i++)
+        noiseTable[i] *= noiseScale;
+
+    noiseOffsets.malloc(numChannels);
+
+    for (int c = 0; c < numChannels; c++)
+        noiseOffsets[c] = random.nextInt(noiseTableLength);
+
+    // 2. theta with some gamma on top; both are whole numbers of Hz, so the pattern
+    // repeats every second. The table holds two seconds so a channel's offset never
+    // needs wrapping. Channels read it with a growing delay, which looks like a
+    // travelling wave across the array.
+    lfpTable.malloc(2 * samplesPerSecond);
+
+    for (int i = 0; i < 2 * samplesPerSecond; i++)
+    {
+        double t = i / fs;
+        lfpTable[i] = float(settings.lfpAmplitude * (std::cos(2.0 * double_Pi * 8.0 * t)
+                                                     + 0.2 * std::cos(2.0 * double_Pi * 40.0 * t)));
+    }
+
+    lfpOffsets.malloc(numChannels);
+    lfpGains.malloc(numChannels);
+
+    for (int c = 0; c < numChannels; c++)
+    {
+        lfpOffsets[c] = int((int64) c * (samplesPerSecond / 8) / numChannels);
+        lfpGains[c] = 0.7f + 0.3f * random.nextFloat();
+    }
+
+    // 3. biphasic waveforms, 1.6 ms long with the trough a third of the way in
+    waveformLength = jmax(16, roundToInt(0.0016 * fs));
+    waveformPeak = waveformLength / 3;
+    waveforms.calloc(numWaveforms * waveformLength);
+
+    for (int w = 0; w < numWaveforms; w++)
+    {
+        const double troughWidth = fs * (0.00010 + 0.00006 * random.nextDouble());
+        const double reboundWidth = fs * (0.00025 + 0.00015 * random.nextDouble());
+        const double reboundDelay = fs * (0.00030 + 0.00020 * random.nextDouble());
+        const double reboundSize = 0.15 + 0.25 * random.nextDouble();
+
+        float* waveform = waveforms + w * waveformLength;
+
+        for (int i = 0; i < waveformLength; i++)
+        {
+            double x = i - waveformPeak;
+            double y = -std::exp(-0.5 * (x / troughWidth) * (x / troughWidth))
+                       + reboundSize * std::exp(-0.5 * ((x - reboundDelay) / reboundWidth) * ((x - reboundDelay) / reboundWidth));
+
+            // taper the last quarter so the waveform ends at zero
+            double fromEnd = (waveformLength - 1 - i) / (0.25 * waveformLength);
+
+            if (fromEnd < 1.0)
+                y *= 0.5 - 0.5 * std::cos(double_Pi * fromEnd);
+
+            waveform[i] = float(y);
+        }
+    }
+
+    // 4. Poisson intervals with a refractory period at least as long as a waveform,
+    // so only the last spike of a unit in a block can run over into the next one
+    intervals.malloc(numIntervals);
+
+    const int refractory = jmax(waveformLength, roundToInt(0.002 * fs));
+    const double meanInterval = settings.spikeRate > 0.0f ? fs / settings.spikeRate : 0.0;
+    const double randomPart = jmax(1.0, meanInterval - refractory);
+
+    for (int i = 0; i < numIntervals; i++)
+    {
+        double u = jmax(random.nextDouble(), 1e-12);
+        intervals[i] = refractory + int(jmin(-std::log(u) * randomPart, 3600.0 * fs));
+    }
+
+    // 5. units
+    const int channelsPerGroup = settings.channelsPerGroup;
+    const int numGroups = (numChannels + channelsPerGroup - 1) / channelsPerGroup;
+
+    for (int g = 0; g < numGroups; g++)
+    {
+        for (int n = 0; n < settings.unitsPerGroup; n++)
+        {
+            Unit unit;
+            unit.firstChannel = g * channelsPerGroup;
+            unit.numChannels = jmin(channelsPerGroup, numChannels - unit.firstChannel);
+            unit.waveform = random.nextInt(numWaveforms);
+
+            const int peak = random.nextInt(unit.numChannels);
+            const float size = settings.spikeAmplitude * (0.6f + 0.8f * random.nextFloat());
+
+            for (int j = 0; j < unit.numChannels; j++)
+                unit.gains[j] = size * (j == peak ? 1.0f : 0.2f + 0.6f * random.nextFloat());
+
+            unit.peakChannel = unit.firstChannel + peak;
+            unit.lastSpike = -waveformLength;
+            unit.intervalIndex = random.nextInt(numIntervals);
+
+            if (meanInterval > 0.0)
+                unit.nextSpike = random.nextInt(jmax(1, int(meanInterval)));
+            else
+                unit.nextSpike = std::numeric_limits<int64>::max();
+
+            units.add(unit);
+        }
+    }
+}
+
+SyntheticSignalGenerator::~SyntheticSignalGenerator()
+{
+}
+
+void SyntheticSignalGenerator::setGroundTruthStream(OutputStream* stream, int subProcessor)
+{
+    groundTruth = stream;
+    subProcessorIdx = subProcessor;
+}
+
+int64 SyntheticSignalGenerator::getSampleNumber() const
+{
+    return sampleNumber;
+}
+
+int64 SyntheticSignalGenerator::getNumSpikesGenerated() const
+{
+    return numSpikes;
+}
+
+int SyntheticSignalGenerator::getNumUnits() const
+{
+    return units.size();
+}
+
+void SyntheticSignalGenerator::fillBlock(float* data, uint64* ttl, int numSamples)
+{
+    const int numChannels = settings.numChannels;
+    const int64 blockStart = sampleNumber;
+    const int64 blockEnd = blockStart + numSamples;
+
+    // TTL patterns
+    const int pulsePeriod = samplesPerSecond / 10;
+    const int pulseLength = samplesPerSecond / 100;
+    int secondPos = int(blockStart % samplesPerSecond);
+    int pulsePos = int(blockStart % pulsePeriod);
+
+    for (int k = 0; k < numSamples; k++)
+    {
+        uint64 word = 0;
+
+        if (secondPos < samplesPerSecond / 2)
+            word |= 1;
+
+        if (pulsePos < pulseLength)
+            word |= 4;
+
+        ttl[k] = word;
+
+        if (++secondPos == samplesPerSecond)
+            secondPos = 0;
+
+        if (++pulsePos == pulsePeriod)
+            pulsePos = 0;
+    }
+
+    // noise and LFP, a frame at a time so the writes stay sequential. Going a channel
+    // at a time instead strides through the block, which is much slower for
+    // power-of-two channel counts.
+    const int noiseMask = noiseTableLength - 1;
+    int lfpPos = int(blockStart % samplesPerSecond);
+
+    for (int k = 0; k < numSamples; k++)
+    {
+        float* out = data + (size_t) k * numChannels;
+        const int noisePos = int((blockStart + k) & noiseMask);
+        const float* lfp = lfpTable + lfpPos;
+
+        for (int c = 0; c < numChannels; c++)
+            out[c] = noiseTable[(noiseOffsets[c] + noisePos) & noiseMask] + lfpGains[c] * lfp[lfpOffsets[c]];
+
+        if (++lfpPos == samplesPerSecond)
+            lfpPos = 0;
+    }
+
+    // spikes
+    for (int u = 0; u < units.size(); u++)
+    {
+        Unit& unit = units.getReference(u);
+
+        // tail of a spike that started in the previous block
+        if (unit.lastSpike + waveformLength > blockStart)
+            addSpike(unit, unit.lastSpike, u == 0, data, ttl, blockStart, numSamples);
+
+        while (unit.nextSpike < blockEnd)
+        {
+            addSpike(unit, unit.nextSpike, u == 0, data, ttl, blockStart, numSamples);
+
+            if (groundTruth != nullptr)
+                *groundTruth << (unit.nextSpike + waveformPeak) << "," << subProcessorIdx << ","
+                             << u << "," << unit.peakChannel << "\n";
+
+            numSpikes++;
+
+            unit.lastSpike = unit.nextSpike;
+            unit.nextSpike += intervals[unit.intervalIndex];
+
+            if (++unit.intervalIndex == numIntervals)
+                unit.intervalIndex = 0;
+        }
+    }
+
+    sampleNumber = blockEnd;
+}
+
+void SyntheticSignalGenerator::addSpike(const Unit& unit, int64 spikeStart, bool markTtl,
+                                        float* data, uint64* ttl, int64 blockStart, int numSamples)
+{
+    const int from = int(jmax(spikeStart, blockStart) - blockStart);
+    const int to = int(jmin(spikeStart + waveformLength, blockStart + numSamples) - blockStart);
+
+    if (from >= to)
+        return;
+
+    const int numChannels = settings.numChannels;
+    const float* waveform = waveforms + unit.waveform * waveformLength + (blockStart + from - spikeStart);
+
+    for (int j = 0; j < unit.numChannels; j++)
+    {
+        float* out = data + unit.firstChannel + j;
+        const float gain = unit.gains[j];
+
+        for (int k = from; k < to; k++)
+            out[k * numChannels] += gain * waveform[k - from];
+    }
+
+    if (markTtl)
+    {
+        for (int k = from; k < to; k++)
+            ttl[k] |= 2;
+    }
+}
+
+double SyntheticSignalGenerator::runBenchmark(int numChannels, float sampleRate, double durationSecs)
+{
+    SyntheticSignalSettings settings;
+    settings.numChannels = numChannels;
+    settings.sampleRate = sampleRate;
+
+    const double setupStart = Time::getMillisecondCounterHiRes();
+    SyntheticSignalGenerator generator(settings, 1);
+    const double setupTime = Time::getMillisecondCounterHiRes() - setupStart;
+
+    const int blockSize = jmax(1, roundToInt(sampleRate / 100.0f));
+    const int64 totalSamples = int64(durationSecs * sampleRate);
+
+    HeapBlock<float> data((size_t) blockSize * numChannels);
+    HeapBlock<uint64> ttl(blockSize);
+
+    const double start = Time::getMillisecondCounterHiRes();
+
+    while (generator.getSampleNumber() < totalSamples)
+        generator.fillBlock(data, ttl, (int) jmin<int64>(blockSize, totalSamples - generator.getSampleNumber()));
+
+    const double elapsed = (Time::getMillisecondCounterHiRes() - start) / 1000.0;
+    const double realTimeFactor = durationSecs / jmax(1e-9, elapsed);
+
+    std::cout << "Synthetic source: " << numChannels << " channels at " << sampleRate << " Hz, "
+              << generator.getNumUnits() << " units, " << generator.getNumSpikesGenerated() << " spikes" << std::endl;
+    std::cout << "  tables built in " << setupTime << " ms, " << durationSecs << " s of data generated in "
+              << elapsed << " s (" << realTimeFactor << "x real time)" << std::endl;
+
+    return realTimeFactor;
+}
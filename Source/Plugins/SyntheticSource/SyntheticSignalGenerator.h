@@ -0,0 +1,144 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SYNTHETICSIGNALGENERATOR_H_INCLUDED
+#define SYNTHETICSIGNALGENERATOR_H_INCLUDED
+
+#include <BasicJuceHeader.h>
+
+/** What SyntheticSignalGenerator produces. Amplitudes are in microvolts. */
+struct SyntheticSignalSettings
+{
+    int numChannels{ 64 };
+    float sampleRate{ 30000.0f };
+
+    /** Neighbouring channels that share units, as on a tetrode or a probe shank. */
+    int channelsPerGroup{ 4 };
+    int unitsPerGroup{ 2 };
+
+    /** Mean firing rate of each unit, in Hz. */
+    float spikeRate{ 5.0f };
+
+    float spikeAmplitude{ 120.0f };
+    float noiseAmplitude{ 10.0f };
+    float lfpAmplitude{ 150.0f };
+};
+
+/**
+
+    Generates interleaved multichannel data that looks enough like an extracellular
+    recording to exercise the signal chain: band-limited noise, theta and gamma
+    oscillations, and spikes from units with fixed waveforms and channel footprints.
+
+    Everything expensive is worked out in the constructor. The noise, the LFP and the
+    spike waveforms are precomputed tables, and inter-spike intervals come from a
+    precomputed exponential table, so fillBlock() only reads tables and adds.
+
+    Spikes are Poisson with a refractory period. The sample at which each spike's
+    waveform peaks is written to the ground-truth stream, if one is set, as
+    "sample,subprocessor,unit,channel" lines, with channel being the one the unit is
+    largest on.
+
+    TTL word: bit 0 is a 1 Hz square wave, bit 1 is high while unit 0 is firing,
+    bit 2 is a 10 Hz train of 10 ms pulses.
+
+    @see SyntheticThread
+
+*/
+
+class SyntheticSignalGenerator
+{
+public:
+    SyntheticSignalGenerator (const SyntheticSignalSettings& settings, int64 seed);
+    ~SyntheticSignalGenerator();
+
+    /** Writes numSamples frames of numChannels floats to data, and one TTL word per
+        frame to ttl. Consecutive calls continue the same signal. */
+    void fillBlock (float* data, uint64* ttl, int numSamples);
+
+    /** Ground-truth spike times are written to stream, which is not owned. */
+    void setGroundTruthStream (OutputStream* stream, int subProcessorIdx);
+
+    /** Number of frames generated so far. */
+    int64 getSampleNumber() const;
+
+    int64 getNumSpikesGenerated() const;
+
+    int getNumUnits() const;
+
+    /** Generates durationSecs of data in blocks of 10 ms and returns how many
+        times faster than real time that was. Prints the results to stdout.
+        open-ephys-benchmark --generator runs it. */
+    static double runBenchmark (int numChannels, float sampleRate, double durationSecs);
+
+private:
+    struct Unit
+    {
+        int firstChannel;
+        int numChannels;
+        int peakChannel;
+        int waveform;
+        float gains[8];
+        int64 lastSpike;
+        int64 nextSpike;
+        int intervalIndex;
+    };
+
+    void addSpike (const Unit& unit, int64 spikeStart, bool markTtl,
+                   float* data, uint64* ttl, int64 blockStart, int numSamples);
+
+    //Compile-time constants
+    static const int noiseTableLength = 1 << 17;
+    static const int numWaveforms = 8;
+    static const int numIntervals = 4096;
+    static const int maxChannelsPerGroup = 8;
+
+    SyntheticSignalSettings settings;
+    int samplesPerSecond;
+
+    HeapBlock<float> noiseTable;
+    HeapBlock<int> noiseOffsets;
+
+    HeapBlock<float> lfpTable;
+    HeapBlock<int> lfpOffsets;
+    HeapBlock<float> lfpGains;
+
+    HeapBlock<float> waveforms;
+    int waveformLength;
+    int waveformPeak;
+
+    HeapBlock<int> intervals;
+
+    Array<Unit> units;
+
+    int64 sampleNumber;
+    int64 numSpikes;
+
+    OutputStream* groundTruth;
+    int subProcessorIdx;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SyntheticSignalGenerator);
+};
+
+
+#endif  // SYNTHETICSIGNALGENERATOR_H_INCLUDED
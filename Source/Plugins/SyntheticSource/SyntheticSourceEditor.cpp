@@ -0,0 +1,124 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SyntheticSourceEditor.h"
+#include "SyntheticThread.h"
+
+SyntheticSourceEditor::SyntheticSourceEditor(GenericProcessor* parentNode, SyntheticThread* t)
+    : GenericEditor(parentNode, false), thread(t)
+{
+    desiredWidth = 170;
+
+    channelsEditable = addField("Channels", "Continuous channels per subprocessor", 30);
+    subProcessorsEditable = addField("Subprocessors", "Independent streams, each with its own units", 52);
+    sampleRateEditable = addField("Sample rate", "Samples per second for every subprocessor", 74);
+    spikeRateEditable = addField("Spike rate", "Mean firing rate of each unit, in Hz", 96);
+
+    updateFields();
+}
+
+SyntheticSourceEditor::~SyntheticSourceEditor()
+{
+}
+
+Label* SyntheticSourceEditor::addField(const String& name, const String& tooltip, int y)
+{
+    Label* caption = new Label(name + " label", name + ":");
+    caption->setBounds(8, y, 90, 18);
+    caption->setFont(Font("Small Text", 12, Font::plain));
+    caption->setColour(Label::textColourId, Colours::darkgrey);
+    addAndMakeVisible(caption);
+    captions.add(caption);
+
+    Label* editable = new Label(name, "");
+    editable->setEditable(true, false, false);
+    editable->addListener(this);
+    editable->setBounds(100, y, 60, 18);
+    editable->setColour(Label::backgroundColourId, Colours::grey);
+    editable->setColour(Label::textColourId, Colours::white);
+    editable->setTooltip(tooltip);
+    addAndMakeVisible(editable);
+
+    return editable;
+}
+
+void SyntheticSourceEditor::updateFields()
+{
+    channelsEditable->setText(String(thread->getNumChannels()), dontSendNotification);
+    subProcessorsEditable->setText(String(thread->getNumSubProcessors()), dontSendNotification);
+    sampleRateEditable->setText(String(thread->getSampleRate(0)), dontSendNotification);
+    spikeRateEditable->setText(String(thread->getSpikeRate()), dontSendNotification);
+}
+
+void SyntheticSourceEditor::labelTextChanged(Label* label)
+{
+    if (label == channelsEditable)
+        thread->setNumChannels(label->getText().getIntValue());
+    else if (label == subProcessorsEditable)
+        thread->setNumSubProcessors(label->getText().getIntValue());
+    else if (label == sampleRateEditable)
+        thread->setSampleRate(label->getText().getFloatValue());
+    else if (label == spikeRateEditable)
+        thread->setSpikeRate(label->getText().getFloatValue());
+
+    // show what was actually set, after clamping
+    updateFields();
+
+    CoreServices::updateSignalChain(this);
+}
+
+void SyntheticSourceEditor::startAcquisition()
+{
+    channelsEditable->setEnabled(false);
+    subProcessorsEditable->setEnabled(false);
+    sampleRateEditable->setEnabled(false);
+    spikeRateEditable->setEnabled(false);
+}
+
+void SyntheticSourceEditor::stopAcquisition()
+{
+    channelsEditable->setEnabled(true);
+    subProcessorsEditable->setEnabled(true);
+    sampleRateEditable->setEnabled(true);
+    spikeRateEditable->setEnabled(true);
+}
+
+void SyntheticSourceEditor::saveCustomParameters(XmlElement* xml)
+{
+    xml->setAttribute("Channels", thread->getNumChannels());
+    xml->setAttribute("SubProcessors", (int) thread->getNumSubProcessors());
+    xml->setAttribute("SampleRate", thread->getSampleRate(0));
+    xml->setAttribute("SpikeRate", thread->getSpikeRate());
+}
+
+void SyntheticSourceEditor::loadCustomParameters(XmlElement* xml)
+{
+    thread->setNumChannels(xml->getIntAttribute("Channels", thread->getNumChannels()));
+    thread->setNumSubProcessors(xml->getIntAttribute("SubProcessors", thread->getNumSubProcessors()));
+    thread->setSampleRate(xml->getDoubleAttribute("SampleRate", thread->getSampleRate(0)));
+    thread->setSpikeRate(xml->getDoubleAttribute("SpikeRate", thread->getSpikeRate()));
+
+    updateFields();
+
+    CoreServices::updateSignalChain(this);
+}
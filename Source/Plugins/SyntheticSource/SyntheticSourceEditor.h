@@ -0,0 +1,72 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SYNTHETICSOURCEEDITOR_H_INCLUDED
+#define SYNTHETICSOURCEEDITOR_H_INCLUDED
+
+#include <EditorHeaders.h>
+
+class SyntheticThread;
+
+/**
+
+    User interface for the synthetic data source: channel count, number of
+    subprocessors, sample rate and firing rate per unit.
+
+    @see SyntheticThread
+
+*/
+
+class SyntheticSourceEditor : public GenericEditor,
+    public Label::Listener
+{
+public:
+    SyntheticSourceEditor (GenericProcessor* parentNode, SyntheticThread* thread);
+    ~SyntheticSourceEditor();
+
+    void labelTextChanged (Label* label) override;
+
+    void startAcquisition() override;
+    void stopAcquisition() override;
+
+    void saveCustomParameters (XmlElement* xml) override;
+    void loadCustomParameters (XmlElement* xml) override;
+
+private:
+    Label* addField (const String& name, const String& tooltip, int y);
+    void updateFields();
+
+    OwnedArray<Label> captions;
+
+    ScopedPointer<Label> channelsEditable;
+    ScopedPointer<Label> subProcessorsEditable;
+    ScopedPointer<Label> sampleRateEditable;
+    ScopedPointer<Label> spikeRateEditable;
+
+    SyntheticThread* thread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SyntheticSourceEditor);
+};
+
+
+#endif  // SYNTHETICSOURCEEDITOR_H_INCLUDED
@@ -0,0 +1,230 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SyntheticThread.h"
+#include "SyntheticSourceEditor.h"
+
+SyntheticThread::SyntheticThread(SourceNode* sn)
+    : DataThread(sn),
+      numSubProcessors(1),
+      maxBlockSize(0),
+      startTicks(0),
+      samplesGenerated(0),
+      samplesDropped(0)
+{
+}
+
+SyntheticThread::~SyntheticThread()
+{
+    if (isThreadRunning())
+        stopAcquisition();
+}
+
+bool SyntheticThread::foundInputSource()
+{
+    return true;
+}
+
+bool SyntheticThread::startAcquisition()
+{
+    // the tables are rebuilt for every run, so the ground truth always starts at sample 0
+    generators.clear();
+
+    File groundTruthFile = CoreServices::getDefaultUserSaveDirectory().getChildFile(
+        "synthetic_ground_truth_" + Time::getCurrentTime().formatted("%Y-%m-%d_%H-%M-%S") + ".csv");
+
+    groundTruthStream = new FileOutputStream(groundTruthFile, 1 << 16);
+
+    if (groundTruthStream->failedToOpen())
+    {
+        std::cout << "Couldn't open " << groundTruthFile.getFullPathName() << ", ground truth will not be saved." << std::endl;
+        groundTruthStream = nullptr;
+    }
+    else
+    {
+        *groundTruthStream << "# sample rate " << settings.sampleRate << " Hz, samples count from the start of acquisition\n";
+        *groundTruthStream << "sample,subprocessor,unit,channel\n";
+        std::cout << "Writing synthetic ground truth to " << groundTruthFile.getFullPathName() << std::endl;
+    }
+
+    for (int sub = 0; sub < numSubProcessors; sub++)
+    {
+        SyntheticSignalGenerator* generator = new SyntheticSignalGenerator(settings, 1000 + sub);
+        generator->setGroundTruthStream(groundTruthStream, sub);
+        generators.add(generator);
+
+        sourceBuffers[sub]->clear();
+    }
+
+    // up to 10 ms per call; more only piles up in the DataBuffer
+    maxBlockSize = jmax(1, roundToInt(settings.sampleRate / 100.0f));
+    blockData.malloc((size_t) maxBlockSize * settings.numChannels);
+    blockTtl.malloc(maxBlockSize);
+    blockTimestamps.malloc(maxBlockSize);
+
+    samplesGenerated = 0;
+    samplesDropped = 0;
+    startTicks = Time::getHighResolutionTicks();
+
+    startThread();
+
+    return true;
+}
+
+bool SyntheticThread::stopAcquisition()
+{
+    if (isThreadRunning())
+        signalThreadShouldExit();
+
+    waitForThreadToExit(500);
+
+    int64 numSpikes = 0;
+
+    for (int sub = 0; sub < generators.size(); sub++)
+        numSpikes += generators[sub]->getNumSpikesGenerated();
+
+    std::cout << "Synthetic source generated " << samplesGenerated << " samples and " << numSpikes << " spikes";
+
+    if (samplesDropped > 0)
+        std::cout << "; " << samplesDropped << " samples did not fit in the buffers and were dropped";
+
+    std::cout << "." << std::endl;
+
+    generators.clear();
+    groundTruthStream = nullptr;
+
+    for (int sub = 0; sub < sourceBuffers.size(); sub++)
+        sourceBuffers[sub]->clear();
+
+    return true;
+}
+
+bool SyntheticThread::updateBuffer()
+{
+    const int64 elapsedTicks = Time::getHighResolutionTicks() - startTicks;
+    const int64 samplesDue = int64(double(elapsedTicks) * settings.sampleRate / Time::getHighResolutionTicksPerSecond());
+
+    const int numSamples = int(jmin<int64>(maxBlockSize, samplesDue - samplesGenerated));
+
+    if (numSamples <= 0)
+    {
+        wait(1);
+        return true;
+    }
+
+    for (int i = 0; i < numSamples; i++)
+        blockTimestamps[i] = samplesGenerated + i;
+
+    for (int sub = 0; sub < generators.size(); sub++)
+    {
+        generators[sub]->fillBlock(blockData, blockTtl, numSamples);
+
+        int numWritten = sourceBuffers[sub]->addToBuffer(blockData, blockTimestamps, blockTtl, numSamples, 1);
+        samplesDropped += numSamples - numWritten;
+    }
+
+    samplesGenerated += numSamples;
+
+    return true;
+}
+
+int SyntheticThread::getNumDataOutputs(DataChannel::DataChannelTypes type, int subProcessorIdx) const
+{
+    if (type == DataChannel::HEADSTAGE_CHANNEL && subProcessorIdx < numSubProcessors)
+        return settings.numChannels;
+
+    return 0;
+}
+
+int SyntheticThread::getNumTTLOutputs(int subProcessorIdx) const
+{
+    return 8;
+}
+
+float SyntheticThread::getSampleRate(int subProcessorIdx) const
+{
+    return settings.sampleRate;
+}
+
+unsigned int SyntheticThread::getNumSubProcessors() const
+{
+    return numSubProcessors;
+}
+
+float SyntheticThread::getBitVolts(const DataChannel* chan) const
+{
+    // same resolution as an Intan headstage, so recordings of synthetic data look familiar
+    return 0.195f;
+}
+
+void SyntheticThread::resizeBuffers()
+{
+    // 100 ms per subprocessor, which at thousands of channels is already tens of MB
+    const int bufferSize = jmax(1000, roundToInt(settings.sampleRate / 10.0f));
+
+    while (sourceBuffers.size() > numSubProcessors)
+        sourceBuffers.removeLast();
+
+    for (int sub = 0; sub < numSubProcessors; sub++)
+    {
+        if (sub < sourceBuffers.size())
+            sourceBuffers[sub]->resize(settings.numChannels, bufferSize);
+        else
+            sourceBuffers.add(new DataBuffer(settings.numChannels, bufferSize));
+    }
+}
+
+GenericEditor* SyntheticThread::createEditor(SourceNode* sn)
+{
+    return new SyntheticSourceEditor(sn, this);
+}
+
+void SyntheticThread::setNumChannels(int numChannels)
+{
+    settings.numChannels = jlimit(1, 8192, numChannels);
+}
+
+void SyntheticThread::setNumSubProcessors(int num)
+{
+    numSubProcessors = jlimit(1, 16, num);
+}
+
+void SyntheticThread::setSampleRate(float sampleRate)
+{
+    settings.sampleRate = jlimit(1000.0f, 100000.0f, sampleRate);
+}
+
+void SyntheticThread::setSpikeRate(float spikeRate)
+{
+    settings.spikeRate = jlimit(0.0f, 200.0f, spikeRate);
+}
+
+int SyntheticThread::getNumChannels() const
+{
+    return settings.numChannels;
+}
+
+float SyntheticThread::getSpikeRate() const
+{
+    return settings.spikeRate;
+}
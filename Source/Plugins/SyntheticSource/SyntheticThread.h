@@ -0,0 +1,104 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SYNTHETICTHREAD_H_INCLUDED
+#define SYNTHETICTHREAD_H_INCLUDED
+
+#include <DataThreadHeaders.h>
+
+#include "SyntheticSignalGenerator.h"
+
+/**
+
+    Source that needs no hardware: generates synthetic neural data for any number
+    of channels and subprocessors, paced to the chosen sample rate. Meant for load
+    testing the signal chain at channel counts no device on the bench provides.
+
+    Each subprocessor has its own SyntheticSignalGenerator. The times of all
+    generated spikes are written to a CSV file in the default save directory, so
+    spike detectors and sorters can be scored on the same run they are timed on.
+    If the chain falls behind and a DataBuffer fills up, the samples that did not
+    fit are counted and reported when acquisition stops.
+
+    @see SyntheticSignalGenerator, SyntheticSourceEditor
+
+*/
+
+class SyntheticThread : public DataThread
+{
+public:
+    SyntheticThread (SourceNode* sn);
+    ~SyntheticThread();
+
+    bool updateBuffer() override;
+
+    bool foundInputSource() override;
+
+    bool startAcquisition() override;
+
+    bool stopAcquisition() override;
+
+    int getNumDataOutputs (DataChannel::DataChannelTypes type, int subProcessorIdx) const override;
+
+    int getNumTTLOutputs (int subProcessorIdx) const override;
+
+    float getSampleRate (int subProcessorIdx) const override;
+
+    unsigned int getNumSubProcessors() const override;
+
+    float getBitVolts (const DataChannel* chan) const override;
+
+    void resizeBuffers() override;
+
+    GenericEditor* createEditor (SourceNode* sn) override;
+
+    /** These can only change while acquisition is stopped, followed by a signal chain update. */
+    void setNumChannels (int numChannels);
+    void setNumSubProcessors (int numSubProcessors);
+    void setSampleRate (float sampleRate);
+    void setSpikeRate (float spikeRate);
+
+    int getNumChannels() const;
+    float getSpikeRate() const;
+
+private:
+    SyntheticSignalSettings settings;
+    int numSubProcessors;
+
+    OwnedArray<SyntheticSignalGenerator> generators;
+    ScopedPointer<FileOutputStream> groundTruthStream;
+
+    HeapBlock<float> blockData;
+    HeapBlock<uint64> blockTtl;
+    HeapBlock<int64> blockTimestamps;
+    int maxBlockSize;
+
+    int64 startTicks;
+    int64 samplesGenerated;
+    int64 samplesDropped;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SyntheticThread);
+};
+
+
+#endif  // SYNTHETICTHREAD_H_INCLUDED
@@ -26,7 +26,8 @@
 #include "AudioNode.h"
 
 AudioNode::AudioNode()
-    : GenericProcessor("Audio Node"), audioEditor(0), volume(0.00001f), noiseGateLevel(0.0f)
+    : GenericProcessor("Audio Node"), audioEditor(0), volume(0.00001f), noiseGateLevel(0.0f),
+      destBufferSampleRate(44100.0), estimatedSamples(1024), maxPendingSamples(0)
 {
 
     settings.numInputs = 4096;
@@ -37,8 +38,6 @@ AudioNode::AudioNode()
 
     nextAvailableChannel = 2; // keep first two channels empty
 
-    tempBuffer = new AudioSampleBuffer(16, 1024);
-
 }
 
 
@@ -169,36 +168,25 @@ void AudioNode::prepareToPlay(double sampleRate_, int estimatedSamplesPerBlock)
 
 void AudioNode::recreateBuffers()
 {
-	numSamplesExpected.clear();
-    samplesInBackupBuffer.clear();
-    samplesInOverflowBuffer.clear();
-    ratio.clear();
-    filters.clear();
-    bufferA.clear();
-    bufferB.clear();
-    bufferSwap.clear();
+    resamplers.clear();
+    pendingBuffers.clear();
+    samplesPending.clear();
+    wasMonitored.clear();
+
+    // up to two device blocks can be kept back to absorb jitter in how many samples each block brings
+    maxPendingSamples = 2 * estimatedSamples;
 
     for (int i = 0; i < dataChannelArray.size(); i++)
     {
-        // processor sample rate divided by sound card sample rate
-        numSamplesExpected.add((int)(dataChannelArray[i]->getSampleRate()/destBufferSampleRate*float(estimatedSamples)) + 1);
-        samplesInBackupBuffer.add(0);
-        samplesInOverflowBuffer.add(0);
-        sourceBufferSampleRate.add(dataChannelArray[i]->getSampleRate());
-
-        filters.add(new Dsp::SmoothedFilterDesign<Dsp::RBJ::Design::LowPass, 1> (1024));
-
-        ratio.add(float(numSamplesExpected[i])/float(estimatedSamples));
-        updateFilter(i);
-
-        bufferA.add(new AudioSampleBuffer(1,10000));
-        bufferB.add(new AudioSampleBuffer(1,10000));
-        bufferSwap.add(false);
-
+        PolyphaseResampler* resampler = new PolyphaseResampler();
+        resampler->setRates(dataChannelArray[i]->getSampleRate(), destBufferSampleRate);
+        resamplers.add(resampler);
+
+        int capacity = resampler->getMaxOutputSamples(estimatedSamples) + maxPendingSamples;
+        pendingBuffers.add(new AudioSampleBuffer(1, capacity));
+        samplesPending.add(0);
+        wasMonitored.add(false);
     }
-
-//    tempBuffer->setSize(getNumInputs(), 4096);
-    tempBuffer->setSize(1, 4096);
 }
 
 bool AudioNode::enable()
@@ -207,24 +195,6 @@ bool AudioNode::enable()
 	return true;
 }
 
-void AudioNode::updateFilter(int i)
-{
-
-    double cutoffFreq = (ratio[i] > 1.0) ? 2 * destBufferSampleRate  // downsample
-                        : destBufferSampleRate / 2; // upsample
-
-    double sampleFreq = (ratio[i] > 1.0) ? sourceBufferSampleRate[i] // downsample
-                        : destBufferSampleRate;  // upsample
-
-    Dsp::Params params;
-    params[0] = sampleFreq; // sample rate
-    params[1] = cutoffFreq; // cutoff frequency
-    params[2] = 1.25; //Q //
-
-    filters[i]->setParams(params);
-
-}
-
 void AudioNode::process(AudioSampleBuffer& buffer)
 {
     float gain;
@@ -236,238 +206,94 @@ void AudioNode::process(AudioSampleBuffer& buffer)
     buffer.clear(0,0,buffer.getNumSamples());
     buffer.clear(1,0,buffer.getNumSamples());
 
-    if (1)
+    if (dataChannelArray.size() > 0) // we have some channels
     {
+        int numChannels = jmin(buffer.getNumChannels() - 2, resamplers.size());
 
-        AudioSampleBuffer* overflowBuffer;
-        AudioSampleBuffer* backupBuffer;
-
-        if (dataChannelArray.size() > 0) // we have some channels
+        for (int i = 0; i < numChannels; i++) // cycle through them all
         {
-
-//            tempBuffer->clear();
-
-            for (int i = 0; i < buffer.getNumChannels()-2; i++) // cycle through them all
+            if (dataChannelArray[i]->isMonitored())
             {
-                
-                if (dataChannelArray[i]->isMonitored())
-                {
-                    tempBuffer->clear();
-                    //std::cout << "Processing channel " << i << std::endl;
-
-                    if (!bufferSwap[i])
-                    {
-                        overflowBuffer = bufferA[i];
-                        backupBuffer = bufferB[i];
+                gain = volume/(float(0x7fff) * dataChannelArray[i]->getBitVolts());
+                // Data are floats in units of microvolts, so dividing by bitVolts and 0x7fff (max value for 16b signed)
+                // rescales to between -1 and +1. Audio output starts So, maximum gain applied to maximum data would be 10.
 
-                        bufferSwap.set(i,true);
-                    }
-                    else
-                    {
-                        overflowBuffer = bufferB[i];
-                        backupBuffer = bufferA[i];
+                PolyphaseResampler* resampler = resamplers[i];
 
-                        bufferSwap.set(i,false);
-                    }
-
-                    backupBuffer->clear();
-
-                    samplesInOverflowBuffer.set(i,samplesInBackupBuffer[i]); // size of buffer after last round
-                    samplesInBackupBuffer.set(i,0);
-
-                    int orphanedSamples = 0;
-
-                    // 1. copy overflow buffer
-
-                    int samplesToCopyFromOverflowBuffer =
-                        ((samplesInOverflowBuffer[i] <= numSamplesExpected[i]) ?
-                         samplesInOverflowBuffer[i] :
-                         numSamplesExpected[i]);
-
-                    //std::cout << "Copying " << samplesToCopyFromOverflowBuffer << " samples from overflow buffer of " << samplesInOverflowBuffer[i] << " samples." << std::endl;
-
-                    if (samplesToCopyFromOverflowBuffer > 0) // need to re-add samples from backup buffer
-                    {
-
-                        tempBuffer->addFrom(0,    // destination channel
-                                            0,                // destination start sample
-                                            *overflowBuffer,  // source
-                                            0,                // source channel
-                                            0,                // source start sample
-                                            samplesToCopyFromOverflowBuffer,    // number of samples
-                                            1.0f              // gain to apply
-                                           );
-
-                        int leftoverSamples = samplesInOverflowBuffer[i] - samplesToCopyFromOverflowBuffer;
-
-                        // std::cout << "Samples remaining in overflow buffer: " << leftoverSamples << std::endl;
-
-                        if (leftoverSamples > 0) // move remaining samples to the backup buffer
-                        {
-
-                            backupBuffer->addFrom(0, // destination channel
-                                                  0,                     // destination start sample
-                                                  *overflowBuffer,       // source
-                                                  0,                     // source channel
-                                                  samplesToCopyFromOverflowBuffer,         // source start sample
-                                                  leftoverSamples,       // number of samples
-                                                  1.0f                   // gain to apply
-                                                 );
-                        }
-
-                        samplesInBackupBuffer.set(i,leftoverSamples);
-                    }
-
-                    gain = volume/(float(0x7fff) * dataChannelArray[i]->getBitVolts());
-                    // Data are floats in units of microvolts, so dividing by bitVolts and 0x7fff (max value for 16b signed)
-                    // rescales to between -1 and +1. Audio output starts So, maximum gain applied to maximum data would be 10.
-
-                    int remainingSamples = numSamplesExpected[i] - samplesToCopyFromOverflowBuffer;
+                // the history of a channel that was not being fed is stale
+                if (! wasMonitored[i])
+                {
+                    resampler->reset();
+                    samplesPending.set(i, 0);
+                    wasMonitored.set(i, true);
+                }
 
-                    int samplesAvailable = getNumSourceSamples(dataChannelArray[i]->getSourceNodeID(), dataChannelArray[i]->getSubProcessorIdx());
+                float* pending = pendingBuffers[i]->getWritePointer(0);
+                int capacity = pendingBuffers[i]->getNumSamples();
+                int numPending = samplesPending[i];
 
-                    int samplesToCopyFromIncomingBuffer = ((remainingSamples <= samplesAvailable) ?
-                                                           remainingSamples :
-                                                           samplesAvailable);
+                int samplesAvailable = getNumSourceSamples(dataChannelArray[i]->getSourceNodeID(), dataChannelArray[i]->getSubProcessorIdx());
+                samplesAvailable = jmin(samplesAvailable, buffer.getNumSamples());
 
-                    //std::cout << "Copying " << samplesToCopyFromIncomingBuffer << " samples from incoming buffer of " << samplesAvailable << " samples." << std::endl;
+                int maxOutput = resampler->getMaxOutputSamples(samplesAvailable);
 
+                if (maxOutput > capacity)
+                {
+                    // larger block than prepareToPlay announced, which some devices do;
+                    // only keep what fits
+                    samplesAvailable = int(int64(capacity - 1) * resampler->getDownsamplingFactor() / resampler->getUpsamplingFactor());
+                    maxOutput = resampler->getMaxOutputSamples(samplesAvailable);
+                }
 
-                    if (samplesToCopyFromIncomingBuffer > 0)
-                    {
+                if (numPending + maxOutput > capacity)
+                {
+                    // drop the oldest samples rather than let the latency grow
+                    int samplesToDrop = numPending + maxOutput - capacity;
+                    memmove(pending, pending + samplesToDrop, (numPending - samplesToDrop) * sizeof(float));
+                    numPending -= samplesToDrop;
+                }
 
-                        //tempBuffer->addFrom(i,       // destination channel
-                        tempBuffer->addFrom(0,       // destination channel
-                                            samplesToCopyFromOverflowBuffer,           // destination start sample
-                                            buffer,      // source
-                                            i+2,           // source channel (add 2 to account for output channels)
-                                            0,           // source start sample
-                                            samplesToCopyFromIncomingBuffer, //  number of samples
-                                            gain       // gain to apply
-                                           );
+                // 1. resample the incoming block (source channel is offset by the 2 output channels)
+                numPending += resampler->process(buffer.getReadPointer(i+2), samplesAvailable, pending + numPending, gain);
 
-                        //if (destBufferPos == 0)
-                        //  std::cout << "Temp buffer 0 value: " << *tempBuffer->getReadPointer(i,0) << std::endl;
+                // 2. mix what the device needs into the left channel
+                int samplesToCopy = jmin(numPending, valuesNeeded);
 
-                    }
+                buffer.addFrom(0,               // destination channel
+                               0,               // destination start sample
+                               pending,         // source
+                               samplesToCopy);  // number of samples
 
-                    orphanedSamples = samplesAvailable - samplesToCopyFromIncomingBuffer;
+                // 3. keep the rest for the next block, up to the latency limit
+                int leftoverSamples = numPending - samplesToCopy;
+                int samplesToDrop = jmax(0, leftoverSamples - maxPendingSamples);
 
-                    // std::cout << "Samples remaining in incoming buffer: " << orphanedSamples << std::endl;
+                leftoverSamples -= samplesToDrop;
 
-                    if (orphanedSamples > 0 && (samplesInBackupBuffer[i] + orphanedSamples < backupBuffer->getNumSamples()))
-                    {
+                if (leftoverSamples > 0)
+                    memmove(pending, pending + samplesToCopy + samplesToDrop, leftoverSamples * sizeof(float));
 
-                        backupBuffer->addFrom(0,                            // destination channel
-                                              samplesInBackupBuffer[i],     // destination start sample
-                                              buffer,                       // source
-                                              i+2,                          // source channel (add 2 to account for output channels)
-                                              remainingSamples,             // source start sample
-                                              orphanedSamples,              //  number of samples
-                                              gain                          // gain to apply
-                                             );
+                samplesPending.set(i, leftoverSamples);
 
-                        samplesInBackupBuffer.set(i, samplesInBackupBuffer[i] + orphanedSamples);
-
-                    }
-
-                    // now that our tempBuffer is ready, we can filter it and copy it into the
-                    // original buffer
-
-                    //std::cout << "Ratio = " << ratio[i] << ", gain = " << gain << std::endl;
-                    //std::cout << "Values needed = " << valuesNeeded << ", channel = " << i << std::endl;
-
-                    if (ratio[i] > 1.00001)
-                    {
-                        // pre-apply filter before downsampling
-                        float* ptr = tempBuffer->getWritePointer(i);
-                        filters[i]->process(numSamplesExpected[i], &ptr);
-                    }
-
-                    // initialize variables
-                    int sourceBufferPos = 0;
-                    int sourceBufferSize = numSamplesExpected[i];
-                    float subSampleOffset = 0.0;
-                    int nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-
-                    int destBufferPos;
-
-                    // code modified from "juce_ResamplingAudioSource.cpp":
-
-                    for (destBufferPos = 0; destBufferPos < valuesNeeded; destBufferPos++)
-                    {
-                        float gain = 1.0;
-                        float alpha = (float) subSampleOffset;
-                        float invAlpha = 1.0f - alpha;
-
-                        // std::cout << "Copying sample " << sourceBufferPos << std::endl;
-
-                        buffer.addFrom(0,    // destChannel
-                                       destBufferPos,  // destSampleOffset
-                                       *tempBuffer,     // source
-                                       //i,    // sourceChannel
-                                       0,       // sourceChannel
-                                       sourceBufferPos,// sourceSampleOffset
-                                       1,        // number of samples
-                                       invAlpha*gain);      // gain to apply to source
-
-                        buffer.addFrom(0,    // destChannel
-                                       destBufferPos,   // destSampleOffset
-                                       *tempBuffer,     // source
-                                       //i,      // sourceChannel
-                                       0,      // sourceChannel
-                                       nextPos,      // sourceSampleOffset
-                                       1,        // number of samples
-                                       alpha*gain);       // gain to apply to source
-
-                        // if (destBufferPos == 0)
-                        //std::cout << "Output buffer 0 value: " << *buffer.getReadPointer(i+2,destBufferPos) << std::endl;
-
-                        subSampleOffset += ratio[i];
-
-                        while (subSampleOffset >= 1.0)
-                        {
-                            if (++sourceBufferPos >= sourceBufferSize)
-                                sourceBufferPos = 0;
-
-                            nextPos = (sourceBufferPos + 1) % sourceBufferSize;
-                            subSampleOffset -= 1.0;
-                        }
-                    }
-
-                    if (ratio[i] < 0.99999)
-                    {
-                        // apply the filter after upsampling
-                        float* ptr = buffer.getWritePointer(0);
-                        filters[i]->process(destBufferPos, &ptr);
-                    }
-
-                    // now copy the channel into the output zone
-
-                    // buffer.addFrom(0,    // destChannel
-                    //                0,  // destSampleOffset
-                    //                buffer,     // source
-                    //                 i+2,    // sourceChannel
-                    //                 0,// sourceSampleOffset
-                    //                 valuesNeeded,        // number of samples
-                    //                 1.0);      // gain to apply to source
-
-                } // if channelPointers[i]->isMonitored
-            } // end cycling through channels
-
-            // Simple implementation of a "noise gate" on audio output
-            expander.process(buffer.getWritePointer(0), // expand the left channel
-                             buffer.getNumSamples());
-
-            // copy the signal into the right channel (no stereo audio yet!)
-            buffer.addFrom(1,    // destChannel
-                           0,  // destSampleOffset
-                           buffer,     // source
-                           0,    // sourceChannel
-                           0,// sourceSampleOffset
-                           valuesNeeded,        // number of samples
-                           1.0);      // gain to apply to source
-        }
+            } // if channelPointers[i]->isMonitored
+            else
+            {
+                wasMonitored.set(i, false);
+            }
+        } // end cycling through channels
+
+        // Simple implementation of a "noise gate" on audio output
+        expander.process(buffer.getWritePointer(0), // expand the left channel
+                         buffer.getNumSamples());
+
+        // copy the signal into the right channel (no stereo audio yet!)
+        buffer.addFrom(1,    // destChannel
+                       0,  // destSampleOffset
+                       buffer,     // source
+                       0,    // sourceChannel
+                       0,// sourceSampleOffset
+                       valuesNeeded,        // number of samples
+                       1.0);      // gain to apply to source
     }
 }
 
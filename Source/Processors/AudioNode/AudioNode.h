@@ -30,7 +30,7 @@
 
 #include "../GenericProcessor/GenericProcessor.h"
 #include "AudioEditor.h"
-#include "../Dsp/Dsp.h"
+#include "PolyphaseResampler.h"
 
 
 class AudioEditor;
@@ -119,8 +119,6 @@ public:
 
     void prepareToPlay(double sampleRate_, int estimatedSamplesPerBlock) override;
 
-    void updateFilter(int i);
-
 	bool enable() override;
 
 	//Called by ProcessorGraph
@@ -134,29 +132,21 @@ private:
     float volume;
     float noiseGateLevel; // in microvolts
 
-    OwnedArray<AudioSampleBuffer> bufferA;
-    OwnedArray<AudioSampleBuffer> bufferB;
-
-    Array<int> numSamplesExpected;
-
-    Array<int> samplesInBackupBuffer;
-    Array<int> samplesInOverflowBuffer;
-    Array<double> sourceBufferSampleRate;
     double destBufferSampleRate;
 	int estimatedSamples;
 
-    Array<bool> bufferSwap;
-
     Expander expander;
 
-    // sample rate, timebase, and ratio info:
-    Array<double> ratio;
+    // one resampler per input channel, converting from the channel's rate to the device rate
+    OwnedArray<PolyphaseResampler> resamplers;
 
-    // major objects:
-    OwnedArray<Dsp::Filter> filters;
+    // resampled samples waiting to be played, in case a block produces more than the device asked for
+    OwnedArray<AudioSampleBuffer> pendingBuffers;
+    Array<int> samplesPending;
+    Array<bool> wasMonitored;
 
-    // Temporary buffer for data
-    ScopedPointer<AudioSampleBuffer> tempBuffer;
+    // pending samples beyond this are dropped, which bounds the monitoring latency
+    int maxPendingSamples;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AudioNode);
 
@@ -0,0 +1,227 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PolyphaseResampler.h"
+
+#include <cmath>
+
+PolyphaseResampler::PolyphaseResampler()
+    : upFactor(1), downFactor(1), tapsPerPhase(0), phase(0)
+{
+    setRates(1.0, 1.0);
+}
+
+PolyphaseResampler::~PolyphaseResampler()
+{
+}
+
+void PolyphaseResampler::getRationalRatio(double ratio, int maxDenominator, int& num, int& den)
+{
+    // best rational approximation from the continued fraction expansion,
+    // keeping both terms within maxDenominator
+    int64 p0 = 0, q0 = 1, p1 = 1, q1 = 0;
+    double x = ratio;
+
+    for (int i = 0; i < 32; i++)
+    {
+        int64 a = (int64) std::floor(x);
+        int64 p2 = a * p1 + p0;
+        int64 q2 = a * q1 + q0;
+
+        if (p2 > maxDenominator || q2 > maxDenominator)
+            break;
+
+        p0 = p1; q0 = q1;
+        p1 = p2; q1 = q2;
+
+        double frac = x - a;
+
+        if (frac < 1e-9 || std::abs(double(p1) / double(q1) - ratio) < 1e-12)
+            break;
+
+        x = 1.0 / frac;
+    }
+
+    if (q1 == 0 || p1 == 0)
+    {
+        p1 = 1;
+        q1 = 1;
+    }
+
+    num = (int) p1;
+    den = (int) q1;
+}
+
+double PolyphaseResampler::besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    double halfX = x / 2.0;
+
+    for (int k = 1; k < 50; k++)
+    {
+        term *= (halfX / k) * (halfX / k);
+        sum += term;
+
+        if (term < sum * 1e-12)
+            break;
+    }
+
+    return sum;
+}
+
+void PolyphaseResampler::setRates(double sourceRate, double destRate)
+{
+    if (sourceRate <= 0 || destRate <= 0)
+    {
+        jassertfalse;
+        sourceRate = destRate = 1.0;
+    }
+
+    // integer rates, the usual case, give an exact ratio
+    if (sourceRate == std::floor(sourceRate) && destRate == std::floor(destRate))
+    {
+        int64 a = (int64) destRate;
+        int64 b = (int64) sourceRate;
+
+        while (b != 0)
+        {
+            int64 t = a % b;
+            a = b;
+            b = t;
+        }
+
+        upFactor = int(int64(destRate) / a);
+        downFactor = int(int64(sourceRate) / a);
+    }
+    else
+    {
+        upFactor = downFactor = 0;
+    }
+
+    if (upFactor < 1 || downFactor < 1 || upFactor > maxPhases || downFactor > maxPhases)
+        getRationalRatio(destRate / sourceRate, maxPhases, upFactor, downFactor);
+
+    // a lower cutoff needs a proportionally longer filter for the same transition width
+    tapsPerPhase = jlimit(minTapsPerPhase, maxTapsPerPhase,
+                          minTapsPerPhase * ((downFactor + upFactor - 1) / upFactor));
+
+    const int numTaps = upFactor * tapsPerPhase;
+    const double centre = (numTaps - 1) / 2.0;
+
+    // cutoff in cycles per sample at the upsampled rate
+    const double cutoff = cutoffMargin * 0.5 / jmax(upFactor, downFactor);
+    const double windowNorm = besselI0(kaiserBeta);
+
+    HeapBlock<double> prototype(numTaps);
+    double sum = 0.0;
+
+    for (int n = 0; n < numTaps; n++)
+    {
+        double t = n - centre;
+        double sinc = (t == 0.0) ? 2.0 * cutoff
+                                 : std::sin(2.0 * double_Pi * cutoff * t) / (double_Pi * t);
+
+        double r = t / (centre + 1.0);
+        double window = besselI0(kaiserBeta * std::sqrt(jmax(0.0, 1.0 - r * r))) / windowNorm;
+
+        prototype[n] = sinc * window;
+        sum += prototype[n];
+    }
+
+    // unity gain at DC for every phase on average; zero stuffing loses a factor of upFactor
+    const double scale = double(upFactor) / sum;
+
+    coefficients.malloc(numTaps);
+
+    // each phase is stored oldest tap first, to run forwards over the input buffer
+    for (int p = 0; p < upFactor; p++)
+        for (int k = 0; k < tapsPerPhase; k++)
+            coefficients[p * tapsPerPhase + k] = float(prototype[p + (tapsPerPhase - 1 - k) * upFactor] * scale);
+
+    history.malloc(tapsPerPhase - 1 + chunkSize);
+
+    reset();
+}
+
+void PolyphaseResampler::reset()
+{
+    history.clear(tapsPerPhase - 1 + chunkSize);
+    phase = 0;
+}
+
+int PolyphaseResampler::getMaxOutputSamples(int numInputSamples) const
+{
+    return int(int64(numInputSamples) * upFactor / downFactor) + 1;
+}
+
+int PolyphaseResampler::getLatencyInSourceSamples() const
+{
+    return tapsPerPhase / 2;
+}
+
+int PolyphaseResampler::process(const float* input, int numInputSamples, float* output, float gain)
+{
+    const int historySize = tapsPerPhase - 1;
+    int numOutputSamples = 0;
+
+    for (int start = 0; start < numInputSamples; start += chunkSize)
+    {
+        const int n = jmin(chunkSize, numInputSamples - start);
+
+        // the input is appended after the samples kept from the previous chunk,
+        // so every filter window below is a contiguous run of the buffer
+        memcpy(history + historySize, input + start, n * sizeof(float));
+
+        for (int i = 0; i < n; i++)
+        {
+            const float* x = history + i;
+
+            // every output that falls between this input and the next one
+            while (phase < upFactor)
+            {
+                const float* h = coefficients + phase * tapsPerPhase;
+
+                // eight independent partial sums, which the compiler maps onto two SIMD registers
+                // so consecutive multiply-adds don't wait on each other (tapsPerPhase is a multiple of 8)
+                float acc[8] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+
+                for (int k = 0; k < tapsPerPhase; k += 8)
+                    for (int j = 0; j < 8; j++)
+                        acc[j] += h[k + j] * x[k + j];
+
+                float y = ((acc[0] + acc[4]) + (acc[1] + acc[5])) + ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+
+                output[numOutputSamples++] = y * gain;
+
+                phase += downFactor;
+            }
+
+            phase -= upFactor;
+        }
+
+        memmove(history, history + n, historySize * sizeof(float));
+    }
+
+    return numOutputSamples;
+}
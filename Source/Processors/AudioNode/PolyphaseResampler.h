@@ -0,0 +1,101 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef POLYPHASERESAMPLER_H_INCLUDED
+#define POLYPHASERESAMPLER_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+/**
+
+  Streaming rational-ratio resampler built on a polyphase windowed-sinc filter.
+
+  setRates() approximates destRate / sourceRate by a ratio L / M and precomputes
+  a Kaiser-windowed sinc lowpass split into L phases, with the cutoff placed below
+  the lower of the two Nyquist frequencies. process() then produces each output
+  sample with a single short dot product against the input history, so
+  anti-aliasing and interpolation happen in one pass.
+
+  The latency is fixed at half the filter length, in source samples. process()
+  does not allocate and keeps its history between calls, so consecutive blocks
+  are resampled without discontinuities.
+
+  @see AudioNode, AudioResamplingNode
+
+*/
+
+class PolyphaseResampler
+{
+public:
+    PolyphaseResampler();
+    ~PolyphaseResampler();
+
+    /** Builds the filter tables for the given rates and resets the history. Allocates,
+        so it must be called outside of process(). */
+    void setRates (double sourceRate, double destRate);
+
+    /** Clears the input history. */
+    void reset();
+
+    /** Upper bound on the number of samples process() writes for numInputSamples inputs. */
+    int getMaxOutputSamples (int numInputSamples) const;
+
+    /** Resamples a block of input, multiplying it by gain. Returns the number of samples
+        written to output, which must have room for getMaxOutputSamples (numInputSamples). */
+    int process (const float* input, int numInputSamples, float* output, float gain = 1.0f);
+
+    /** Group delay of the filter, in source samples. */
+    int getLatencyInSourceSamples() const;
+
+    int getUpsamplingFactor() const     { return upFactor; }
+    int getDownsamplingFactor() const   { return downFactor; }
+
+private:
+    static void getRationalRatio (double ratio, int maxDenominator, int& num, int& den);
+    static double besselI0 (double x);
+
+    //Compile-time constants
+    const int minTapsPerPhase{ 32 };
+    const int maxTapsPerPhase{ 256 };
+    const int maxPhases{ 1024 };
+    const int chunkSize{ 1024 };
+    const double kaiserBeta{ 8.0 };
+    const double cutoffMargin{ 0.9 };
+
+    int upFactor;
+    int downFactor;
+    int tapsPerPhase;
+
+    // coefficients [phase * tapsPerPhase + tap]
+    HeapBlock<float> coefficients;
+
+    // the last tapsPerPhase - 1 input samples, followed by room for one chunk of new input
+    HeapBlock<float> history;
+
+    int phase;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PolyphaseResampler);
+};
+
+
+#endif  // POLYPHASERESAMPLER_H_INCLUDED
@@ -25,19 +25,17 @@
 #define __AUDIORESAMPLINGNODE_H_CFAB182E__
 
 #include "../../../JuceLibraryCode/JuceHeader.h"
-#include "../Dsp/Dsp.h"
 #include "../GenericProcessor/GenericProcessor.h"
+#include "../AudioNode/PolyphaseResampler.h"
 
 /**
 
   Changes the sample rate of continuous data, specialized for increasing
   the sample rate to 44.1 kHz for audio output.
 
-  Code is based on Juce's ResamplingAudioSource class.
-
-  This processor could be vastly improved by implementing a scheme to handle
-  inputs that do not provide the same amount of samples in each buffer. At the
-  moment, the resampling process shifts the pitch of the incoming signal.
+  Each channel goes through a PolyphaseResampler, which keeps its history
+  between blocks, so inputs that provide a different number of samples in
+  each buffer are resampled without shifting the pitch.
 
   @see GenericProcessor
 
@@ -55,7 +53,7 @@ public:
     {
         return destBuffer;
     }
-    void updateFilter();
+    void updateResamplers();
 
     void prepareToPlay(double sampleRate, int estimatedSamplesPerBlock);
     void releaseResources();
@@ -72,12 +70,12 @@ private:
 
     // sample rate, timebase, and ratio info:
     double sourceBufferSampleRate, destBufferSampleRate;
-    double ratio, lastRatio;
+    double ratio;
     double destBufferTimebaseSecs;
     int destBufferWidth;
 
     // major objects:
-    Dsp::Filter* filter;
+    OwnedArray<PolyphaseResampler> resamplers;
     AudioSampleBuffer* destBuffer;
     AudioSampleBuffer* tempBuffer;
 
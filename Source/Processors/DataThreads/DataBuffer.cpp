@@ -65,6 +65,33 @@ int DataBuffer::addToBuffer (float* data, int64* timestamps, uint64* eventCodes,
     int idx = 0;
     int blkIdx;
 
+    if (chunkSize == 1)
+    {
+        // interleaved frames: copy each channel with a strided loop instead of
+        // a one-sample copyFrom per channel per frame
+        for (int i = 0; bs[i] != 0; ++i)
+        {
+            for (int chan = 0; chan < numChans; ++chan)
+            {
+                float* dest = buffer.getWritePointer (chan, si[i]);
+                const float* src = data + (idx * numChans) + chan;
+
+                for (int k = 0; k < bs[i]; ++k)
+                    dest[k] = src[k * numChans];
+            }
+
+            for (int k = 0; k < bs[i]; ++k)
+            {
+                timestampBuffer[si[i] + k] = timestamps[idx + k];
+                eventCodeBuffer[si[i] + k] = eventCodes[idx + k];
+            }
+            idx += bs[i];
+        }
+
+        abstractFifo.finishedWrite (idx);
+        return idx;
+    }
+
     for (int i = 0; bs[i] != 0; ++i)
     {                                // for each of the dest blocks we can write to...
         blkIdx = 0;
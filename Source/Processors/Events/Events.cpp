@@ -135,6 +135,12 @@ SystemEventType SystemEvent::getSystemEventType(const MidiMessage& msg)
 }
 
 size_t SystemEvent::fillTimestampAndSamplesData(HeapBlock<char>& data, const GenericProcessor* proc, int16 subProcessorIdx, int64 timestamp, uint32 nSamples)
+{
+	data.malloc(TIMESTAMP_AND_SAMPLES_SIZE);
+	return fillTimestampAndSamplesData(data.getData(), proc, subProcessorIdx, timestamp, nSamples);
+}
+
+size_t SystemEvent::fillTimestampAndSamplesData(char* data, const GenericProcessor* proc, int16 subProcessorIdx, int64 timestamp, uint32 nSamples)
 {
 	/** Event packet structure
 	* SYSTEM_EVENT - 1 byte
@@ -145,17 +151,15 @@ size_t SystemEvent::fillTimestampAndSamplesData(HeapBlock<char>& data, const Gen
 	* Timestamp - 8 bytes
 	* Buffer sample number - 4 bytes
 	*/
-	const int eventSize = 20;
-	data.malloc(eventSize);
 	data[0] = SYSTEM_EVENT;
 	data[1] = TIMESTAMP_AND_SAMPLES;
-	*reinterpret_cast<uint16*>(data.getData() + 2) = proc->getNodeId();
-	*reinterpret_cast<uint16*>(data.getData() + 4) = subProcessorIdx;
+	*reinterpret_cast<uint16*>(data + 2) = proc->getNodeId();
+	*reinterpret_cast<uint16*>(data + 4) = subProcessorIdx;
 	data[6] = 0;
 	data[7] = 0;
-	*reinterpret_cast<int64*>(data.getData() + 8) = timestamp;
-	*reinterpret_cast<uint32*>(data.getData() + 16) = nSamples;
-	return eventSize;
+	*reinterpret_cast<int64*>(data + 8) = timestamp;
+	*reinterpret_cast<uint32*>(data + 16) = nSamples;
+	return TIMESTAMP_AND_SAMPLES_SIZE;
 }
 
 size_t SystemEvent::fillTimestampSyncTextData(HeapBlock<char>& data, const GenericProcessor* proc, int16 subProcessorIdx, int64 timestamp, bool softwareTime)
@@ -188,16 +192,29 @@ size_t SystemEvent::fillTimestampSyncTextData(HeapBlock<char>& data, const Gener
 			+ String(proc->getSampleRate())
 			+ "Hz";
 	}
-	size_t textSize = eventString.getNumBytesAsUTF8();
-	size_t dataSize = 17 + textSize;
+	return fillSyncTextData(data, proc->getNodeId(), subProcessorIdx, timestamp, eventString);
+}
+
+size_t SystemEvent::fillSyncTextData(HeapBlock<char>& data, uint16 sourceID, uint16 subProcessorIdx, int64 timestamp, const String& text)
+{
+	size_t dataSize = 17 + text.getNumBytesAsUTF8();
 	data.allocate(dataSize, true);
+	return fillSyncTextData(data.getData(), dataSize, sourceID, subProcessorIdx, timestamp, text.toUTF8());
+}
+
+size_t SystemEvent::fillSyncTextData(char* data, size_t maxSize, uint16 sourceID, uint16 subProcessorIdx, int64 timestamp, const char* text)
+{
+	jassert(maxSize > 16);
+	size_t textSize = jmin(strlen(text), maxSize - 17);
 	data[0] = SYSTEM_EVENT;
 	data[1] = TIMESTAMP_SYNC_TEXT;
-	*reinterpret_cast<uint16*>(data.getData() + 2) = proc->getNodeId();
-	*reinterpret_cast<uint16*>(data.getData() + 4) = subProcessorIdx;
-	*reinterpret_cast<int64*>(data.getData() + 8) = timestamp;
-	memcpy(data.getData() + 16, eventString.toUTF8(), textSize);
-	return dataSize;
+	*reinterpret_cast<uint16*>(data + 2) = sourceID;
+	*reinterpret_cast<uint16*>(data + 4) = subProcessorIdx;
+	data[6] = data[7] = 0;
+	*reinterpret_cast<int64*>(data + 8) = timestamp;
+	memmove(data + 16, text, textSize);
+	data[16 + textSize] = 0;
+	return 17 + textSize;
 }
 
 uint32 SystemEvent::getNumSamples(const MidiMessage& msg)
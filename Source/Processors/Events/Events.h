@@ -119,7 +119,15 @@ class PLUGIN_API SystemEvent
 {
 public:
 	static size_t fillTimestampAndSamplesData(HeapBlock<char>& data, const GenericProcessor* proc, int16 subProcessorIdx, int64 timestamp, uint32 nSamples);
+	/** Same, into a buffer of at least TIMESTAMP_AND_SAMPLES_SIZE bytes, so no allocation is needed */
+	static size_t fillTimestampAndSamplesData(char* data, const GenericProcessor* proc, int16 subProcessorIdx, int64 timestamp, uint32 nSamples);
+	static const size_t TIMESTAMP_AND_SAMPLES_SIZE = 20;
 	static size_t fillTimestampSyncTextData(HeapBlock<char>& data, const GenericProcessor* proc, int16 subProcessorIdx, int64 timestamp, bool softwareTime = false);
+	/** A TIMESTAMP_SYNC_TEXT message with any text, about the given source */
+	static size_t fillSyncTextData(HeapBlock<char>& data, uint16 sourceID, uint16 subProcessorIdx, int64 timestamp, const String& text);
+	/** The same into a buffer of maxSize bytes that is already there, for the audio thread.
+	    The text may already be in place, at data + 16. Text that doesn't fit is cut */
+	static size_t fillSyncTextData(char* data, size_t maxSize, uint16 sourceID, uint16 subProcessorIdx, int64 timestamp, const char* text);
 	static SystemEventType getSystemEventType(const MidiMessage& msg);
 	static uint32 getNumSamples(const MidiMessage& msg);
 	static String getSyncText(const MidiMessage& msg);
@@ -49,10 +49,8 @@ FileReader::FileReader()
     const int numFileSources = AccessClass::getPluginManager()->getNumFileSources();
     for (int i = 0; i < numFileSources; ++i)
     {
-        Plugin::FileSourceInfo info = AccessClass::getPluginManager()->getFileSourceInfo (i);
-
         StringArray extensions;
-        extensions.addTokens (info.extensions, ";", "\"");
+        extensions.addTokens (AccessClass::getPluginManager()->getFileSourceExtensions (i), ";", "\"");
 
         const int numExtensions = extensions.size();
         for (int j = 0; j < numExtensions; ++j)
@@ -163,6 +161,13 @@ bool FileReader::setFile (String fullpath)
     {
         const int index = supportedExtensions[ext] - 1;
         Plugin::FileSourceInfo sourceInfo = AccessClass::getPluginManager()->getFileSourceInfo (index);
+
+        if (sourceInfo.creator == nullptr)
+        {
+            CoreServices::sendStatusMessage ("Could not load the plugin for this file type");
+            return false;
+        }
+
         input = sourceInfo.creator();
     }
     else
@@ -41,6 +41,8 @@ GenericProcessor::GenericProcessor (const String& name)
     , editor                        (nullptr)
     , parametersAsXml               (nullptr)
     , sendSampleCount               (true)
+    , m_eventLanesValid                 (false)
+    , m_eventScratchSize                (0)
     , m_processorType                   (PROCESSOR_TYPE_UTILITY)
     , m_name                            (name)
     , m_isParamsWereLoaded              (false)
@@ -445,6 +447,12 @@ void GenericProcessor::updateChannelIndexes(bool updateNodeID)
 		uint32 sourceID = getProcessorFullId(channel->getSourceNodeID(), channel->getSubProcessorIdx());
 		spikeChannelMap[sourceID][channel->getSourceIndex()] = i;
 	}
+
+	updateBlockInfoIndexes();
+
+	// the lanes are filled on the audio thread, so give them room up front
+	for (int lane = 0; lane < NUM_EVENT_LANES; lane++)
+		m_eventLanes[lane].ensureStorageAllocated(eventLaneCapacity);
 }
 
 void GenericProcessor::createDataChannels()
@@ -567,67 +575,42 @@ void GenericProcessor::disableEditor()
 /** Used to get the number of samples in a given buffer, for a given channel. */
 uint32 GenericProcessor::getNumSamples (int channelNum) const
 {
-    int sourceNodeId = 0;
-	int subProcessorId = 0;
-    int nSamples     = 0;
-
     if (channelNum >= 0
-        && channelNum < dataChannelArray.size())
-    {
-        sourceNodeId = dataChannelArray[channelNum]->getSourceNodeID();
-		subProcessorId = dataChannelArray[channelNum]->getSubProcessorIdx();
-    }
-    else
-    {
-        return 0;
-    }
-
-    // std::cout << "Requesting samples for channel " << channelNum << " with source node " << sourceNodeId << std::endl;
-	uint32 sourceID = getProcessorFullId(sourceNodeId, subProcessorId);
-    try
+        && channelNum < dataChannelBlockInfo.size())
     {
-        nSamples = numSamples.at (sourceID);
+        return blockInfo.getReference (dataChannelBlockInfo.getUnchecked (channelNum)).numSamples;
     }
-    catch (...)
+    else if (channelNum >= 0
+        && channelNum < dataChannelArray.size())
     {
-        return 0;
+        // channels added since the last update
+        const DataChannel* channel = dataChannelArray[channelNum];
+        const BlockInfo* info = findBlockInfo (getProcessorFullId (channel->getSourceNodeID(), channel->getSubProcessorIdx()));
+        return info != nullptr ? info->numSamples : 0;
     }
 
-    //std::cout << nSamples << " were found." << std::endl;
-
-    return nSamples;
+    return 0;
 }
 
 
 /** Used to get the timestamp for a given buffer, for a given source node. */
 uint64 GenericProcessor::getTimestamp (int channelNum) const
 {
-    int sourceNodeId = 0;
-	int subProcessorIdx = 0;
-    int64 ts         = 0;
-
-    if (channelNum >= 0 
-        && channelNum < dataChannelArray.size())
-    {
-        sourceNodeId = dataChannelArray[channelNum]->getSourceNodeID();
-		subProcessorIdx = dataChannelArray[channelNum]->getSubProcessorIdx();
-    }
-    else
-    {
-        return 0;
-    }
-
-	uint32 sourceID = getProcessorFullId(sourceNodeId, subProcessorIdx);
-    try
+    if (channelNum >= 0
+        && channelNum < dataChannelBlockInfo.size())
     {
-        ts = timestamps.at (sourceID);
+        return blockInfo.getReference (dataChannelBlockInfo.getUnchecked (channelNum)).timestamp;
     }
-    catch (...)
+    else if (channelNum >= 0
+        && channelNum < dataChannelArray.size())
     {
-        return 0;
+        // channels added since the last update
+        const DataChannel* channel = dataChannelArray[channelNum];
+        const BlockInfo* info = findBlockInfo (getProcessorFullId (channel->getSourceNodeID(), channel->getSubProcessorIdx()));
+        return info != nullptr ? info->timestamp : 0;
     }
 
-    return ts;
+    return 0;
 }
 
 uint32 GenericProcessor::getNumSourceSamples(uint16 processorID, uint16 subProcessorIdx) const
@@ -637,16 +620,8 @@ uint32 GenericProcessor::getNumSourceSamples(uint16 processorID, uint16 subProce
 
 uint32 GenericProcessor::getNumSourceSamples(uint32 fullSourceID) const
 {
-	uint32 nSamples;
-	try
-	{
-		nSamples = numSamples.at(fullSourceID);
-	}
-	catch (...)
-	{
-		return 0;
-	}
-	return nSamples;
+	const BlockInfo* info = findBlockInfo(fullSourceID);
+	return info != nullptr ? info->numSamples : 0;
 }
 
 uint64 GenericProcessor::getSourceTimestamp(uint16 processorID, uint16 subProcessorIdx) const
@@ -656,16 +631,49 @@ uint64 GenericProcessor::getSourceTimestamp(uint16 processorID, uint16 subProces
 
 uint64 GenericProcessor::getSourceTimestamp(uint32 fullSourceID) const
 {
-	uint64 ts;
-	try
-	{
-		ts = timestamps.at(fullSourceID);
-	}
-	catch (...)
+	const BlockInfo* info = findBlockInfo(fullSourceID);
+	return info != nullptr ? info->timestamp : 0;
+}
+
+int GenericProcessor::getBlockInfoIndex(uint32 fullSourceID)
+{
+	std::unordered_map<uint32, int>::const_iterator it = blockInfoIndexes.find(fullSourceID);
+	if (it != blockInfoIndexes.end())
+		return it->second;
+
+	//only sources that none of the channels come from get here, and then only once
+	BlockInfo info = { 0, 0 };
+	blockInfo.add(info);
+	blockInfoIndexes[fullSourceID] = blockInfo.size() - 1;
+	return blockInfo.size() - 1;
+}
+
+const GenericProcessor::BlockInfo* GenericProcessor::findBlockInfo(uint32 fullSourceID) const
+{
+	std::unordered_map<uint32, int>::const_iterator it = blockInfoIndexes.find(fullSourceID);
+	if (it == blockInfoIndexes.end())
+		return nullptr;
+	return &blockInfo.getReference(it->second);
+}
+
+void GenericProcessor::updateBlockInfoIndexes()
+{
+	//Give every source a slot up front, and every data channel the index of its source's
+	//slot, so getTimestamp() and getNumSamples() are plain array reads.
+	//Values already received are kept, as they were before the update.
+	for (int i = 0; i < getNumSubProcessors(); i++)
+		getBlockInfoIndex(getProcessorFullId(nodeId, i));
+
+	dataChannelBlockInfo.clearQuick();
+	for (int i = 0; i < dataChannelArray.size(); i++)
 	{
-		return 0;
+		const DataChannel* channel = dataChannelArray[i];
+		dataChannelBlockInfo.add(getBlockInfoIndex(getProcessorFullId(channel->getSourceNodeID(), channel->getSubProcessorIdx())));
 	}
-	return ts;
+	for (int i = 0; i < eventChannelArray.size(); i++)
+		getBlockInfoIndex(getProcessorFullId(eventChannelArray[i]->getSourceNodeID(), eventChannelArray[i]->getSubProcessorIdx()));
+	for (int i = 0; i < spikeChannelArray.size(); i++)
+		getBlockInfoIndex(getProcessorFullId(spikeChannelArray[i]->getSourceNodeID(), spikeChannelArray[i]->getSubProcessorIdx()));
 }
 
 
@@ -676,17 +684,19 @@ void GenericProcessor::setTimestampAndSamples(uint64 timestamp, uint32 nSamples,
 	MidiBuffer& eventBuffer = *m_currentMidiBuffer;
     //std::cout << "Setting timestamp to " << timestamp << std:;endl;
 
-	HeapBlock<char> data;
-	size_t dataSize = SystemEvent::fillTimestampAndSamplesData(data, this, subProcessorIdx, timestamp, nSamples);
+	int64 data[(SystemEvent::TIMESTAMP_AND_SAMPLES_SIZE + 7) / 8]; //on the stack, aligned
+	size_t dataSize = SystemEvent::fillTimestampAndSamplesData(reinterpret_cast<char*>(data), this, subProcessorIdx, timestamp, nSamples);
 	
 
 	eventBuffer.addEvent(data, dataSize, 0);
+	m_eventLanesValid = false;
 
 	uint32 sourceID = getProcessorFullId(nodeId, subProcessorIdx);
 
     //since the processor generating the timestamp won't get the event, add it to the map
-    timestamps[sourceID] = timestamp;
-	numSamples[sourceID] = nSamples;
+	BlockInfo& info = blockInfo.getReference(getBlockInfoIndex(sourceID));
+	info.timestamp = timestamp;
+	info.numSamples = nSamples;
 
     if (m_needsToSendTimestampMessages[subProcessorIdx])
     {
@@ -710,10 +720,16 @@ int GenericProcessor::processEventBuffer()
 	// This approach is not ideal, as it will become a problem if we allow
 	// the sample rate to change at different points in the signal chain.
 	//
+	// All other messages are sorted into the event lanes in the same pass, so that
+	// checkForEvents() only has to visit the classes a processor asks for.
+	//
 	int numRead = 0;
 
 	MidiBuffer& eventBuffer = *m_currentMidiBuffer;
 
+	for (int lane = 0; lane < NUM_EVENT_LANES; lane++)
+		m_eventLanes[lane].clearQuick();
+
 	if (eventBuffer.getNumEvents() > 0)
 	{
 		MidiBuffer::Iterator i(eventBuffer);
@@ -722,6 +738,7 @@ int GenericProcessor::processEventBuffer()
 		int dataSize;
 
 		int samplePosition = -1;
+		int order = 0;
 
 		while (i.getNextEvent(dataptr, dataSize, samplePosition))
 		{
@@ -732,10 +749,13 @@ int GenericProcessor::processEventBuffer()
 				uint16 sourceSubProcessorIdx = *reinterpret_cast<const uint16*>(dataptr + 4);
 				uint32 sourceID = getProcessorFullId(sourceNodeID, sourceSubProcessorIdx);
 
-				uint64 timestamp = *reinterpret_cast<const uint64*>(dataptr + 8);
-				uint32 nSamples = *reinterpret_cast<const uint32*>(dataptr + 16);
-				numSamples[sourceID] = nSamples;
-				timestamps[sourceID] = timestamp;
+				BlockInfo& info = blockInfo.getReference(getBlockInfoIndex(sourceID));
+				info.timestamp = *reinterpret_cast<const uint64*>(dataptr + 8);
+				info.numSamples = *reinterpret_cast<const uint32*>(dataptr + 16);
+			}
+			else
+			{
+				sortIntoEventLane(dataptr, dataSize, samplePosition, order++);
 			}
 			//set the "recorded" bit on the first byte. This will go away when the probe system is implemented.
 			//doing a const cast is always a bad idea, but there's no better way to do this until whe change the event record system
@@ -744,54 +764,128 @@ int GenericProcessor::processEventBuffer()
 		}
 	}
 
+	m_eventLanesValid = true;
+
 	return numRead;
 }
 
+void GenericProcessor::sortIntoEventLane(const uint8* data, int size, int samplePosition, int order)
+{
+	const EventRef ref = { data, size, samplePosition, order };
+
+	switch (static_cast<EventType>(*data & 0x7F))
+	{
+	case PROCESSOR_EVENT:
+		if (static_cast<EventChannel::EventChannelTypes>(*(data + 1)) == EventChannel::TTL)
+			m_eventLanes[TTL_LANE_INDEX].add(ref);
+		else
+			m_eventLanes[DATA_LANE_INDEX].add(ref);
+		break;
+	case SPIKE_EVENT:
+		m_eventLanes[SPIKE_LANE_INDEX].add(ref);
+		break;
+	case SYSTEM_EVENT:
+		if (static_cast<SystemEventType>(*(data + 1)) == TIMESTAMP_SYNC_TEXT)
+			m_eventLanes[SYNC_TEXT_LANE_INDEX].add(ref);
+		break;
+	}
+}
+
+void GenericProcessor::buildEventLanes()
+{
+	//Only needed if this processor added messages to the buffer before looking at its events
+	for (int lane = 0; lane < NUM_EVENT_LANES; lane++)
+		m_eventLanes[lane].clearQuick();
+
+	MidiBuffer::Iterator i(*m_currentMidiBuffer);
+
+	const uint8* dataptr;
+	int dataSize;
+	int samplePosition;
+	int order = 0;
+
+	while (i.getNextEvent(dataptr, dataSize, samplePosition))
+		sortIntoEventLane(dataptr, dataSize, samplePosition, order++);
+
+	m_eventLanesValid = true;
+}
+
 
 int GenericProcessor::checkForEvents(bool checkForSpikes)
+{
+	return checkForEventLanes(checkForSpikes ? (TTL_EVENT_LANE | DATA_EVENT_LANE | SPIKE_EVENT_LANE) : (TTL_EVENT_LANE | DATA_EVENT_LANE));
+}
+
+int GenericProcessor::checkForEventLanes(int lanes)
 {
     if (m_currentMidiBuffer->getNumEvents() > 0)
     {
-		//Since adding events to the buffer inside this loop could be dangerous, create a temporal event buffer
+		if (!m_eventLanesValid)
+			buildEventLanes();
+
+		//Since adding events to the buffer inside this loop could be dangerous, use a temporal event buffer
 		//so any call to addEvent will operate on it;
-		MidiBuffer temporalEventBuffer;
+		m_addedEventBuffer.clear();
 		MidiBuffer* originalEventBuffer = m_currentMidiBuffer;
-		m_currentMidiBuffer = &temporalEventBuffer;
-        // int m = midiMessages.getNumEvents();
-        //std::cout << m << " events received by node " << getNodeId() << std::endl;
+		m_currentMidiBuffer = &m_addedEventBuffer;
 
-		MidiBuffer::Iterator i(*originalEventBuffer);
-        MidiMessage message (0xf4);
+		//the requested lanes, plus the sync texts that handleTimestampSyncTexts() always gets
+		const Array<EventRef>* selected[NUM_EVENT_LANES];
+		int next[NUM_EVENT_LANES];
+		int numSelected = 0;
 
-        int samplePosition = 0;
-        i.setNextSamplePosition (samplePosition);
+		if (lanes & TTL_EVENT_LANE)
+			selected[numSelected++] = &m_eventLanes[TTL_LANE_INDEX];
+		if (lanes & DATA_EVENT_LANE)
+			selected[numSelected++] = &m_eventLanes[DATA_LANE_INDEX];
+		if (lanes & SPIKE_EVENT_LANE)
+			selected[numSelected++] = &m_eventLanes[SPIKE_LANE_INDEX];
+		selected[numSelected++] = &m_eventLanes[SYNC_TEXT_LANE_INDEX];
+
+		for (int l = 0; l < numSelected; l++)
+			next[l] = 0;
+
+		for (;;)
+		{
+			//merge the lanes back into buffer order
+			int lane = -1;
+			for (int l = 0; l < numSelected; l++)
+			{
+				if (next[l] < selected[l]->size()
+					&& (lane < 0 || selected[l]->getReference(next[l]).order < selected[lane]->getReference(next[lane]).order))
+					lane = l;
+			}
+			if (lane < 0)
+				break;
+
+			const EventRef& ref = selected[lane]->getReference(next[lane]++);
+			MidiMessage message(ref.data, ref.size, ref.samplePosition);
 
-        while (i.getNextEvent (message, samplePosition))
-        {
 			uint16 sourceId = EventBase::getSourceID(message);
 			uint16 subProc = EventBase::getSubProcessorIdx(message);
 			uint16 index = EventBase::getSourceIndex(message);
-			if (EventBase::getBaseType(message) == EventType::PROCESSOR_EVENT)
-			{
-				int eventIndex = getEventChannelIndex(index, sourceId, subProc);
-				if (eventIndex >= 0)
-					handleEvent(eventChannelArray[eventIndex], message, samplePosition);
-			}
-			else if (EventBase::getBaseType(message) == EventType::SYSTEM_EVENT && SystemEvent::getSystemEventType(message) == SystemEventType::TIMESTAMP_SYNC_TEXT)
+			if (selected[lane] == &m_eventLanes[SYNC_TEXT_LANE_INDEX])
 			{
 				handleTimestampSyncTexts(message);
 			}
-			else if (checkForSpikes && EventBase::getBaseType(message) == EventType::SPIKE_EVENT)
+			else if (selected[lane] == &m_eventLanes[SPIKE_LANE_INDEX])
 			{
 				int spikeIndex = getSpikeChannelIndex(index, sourceId, subProc);
 				if (spikeIndex >= 0)
-					handleSpike(spikeChannelArray[index], message, samplePosition);
+					handleSpike(spikeChannelArray[spikeIndex], message, ref.samplePosition);
 			}
-        }
+			else
+			{
+				int eventIndex = getEventChannelIndex(index, sourceId, subProc);
+				if (eventIndex >= 0)
+					handleEvent(eventChannelArray[eventIndex], message, ref.samplePosition);
+			}
+		}
 		//Restore the original buffer pointer and, if some new event has been added here, copy it to the original buffer
 		m_currentMidiBuffer = originalEventBuffer;
-		if (temporalEventBuffer.getNumEvents() > 0)
-			m_currentMidiBuffer->addEvents(temporalEventBuffer, 0, -1, 0);
+		if (m_addedEventBuffer.getNumEvents() > 0)
+			m_currentMidiBuffer->addEvents(m_addedEventBuffer, 0, -1, 0);
+		m_eventLanesValid = m_addedEventBuffer.getNumEvents() == 0;
 
 		return 0;
     }
@@ -799,6 +893,16 @@ int GenericProcessor::checkForEvents(bool checkForSpikes)
     return -1;
 }
 
+char* GenericProcessor::getEventScratch(size_t size)
+{
+	if (size > m_eventScratchSize)
+	{
+		m_eventScratch.malloc(size);
+		m_eventScratchSize = size;
+	}
+	return m_eventScratch;
+}
+
 void GenericProcessor::addEvent(int channelIndex, const Event* event, int sampleNum)
 {
 	addEvent(eventChannelArray[channelIndex], event, sampleNum);
@@ -807,9 +911,10 @@ void GenericProcessor::addEvent(int channelIndex, const Event* event, int sample
 void GenericProcessor::addEvent(const EventChannel* channel, const Event* event, int sampleNum)
 {
 	size_t size = channel->getDataSize() + channel->getTotalEventMetaDataSize() + EVENT_BASE_SIZE;
-	HeapBlock<char> buffer(size);
+	char* buffer = getEventScratch(size);
 	event->serialize(buffer, size);
 	m_currentMidiBuffer->addEvent(buffer, size, sampleNum);
+	m_eventLanesValid = false;
 }
 
 void GenericProcessor::addSpike(int channelIndex, const SpikeEvent* event, int sampleNum)
@@ -820,12 +925,12 @@ void GenericProcessor::addSpike(int channelIndex, const SpikeEvent* event, int s
 void GenericProcessor::addSpike(const SpikeChannel* channel, const SpikeEvent* event, int sampleNum)
 {
 	size_t size = channel->getDataSize() + channel->getTotalEventMetaDataSize() + SPIKE_BASE_SIZE + channel->getNumChannels()*sizeof(float);
-	HeapBlock<char> buffer(size);
+	char* buffer = getEventScratch(size);
 	event->serialize(buffer, size);
 	m_currentMidiBuffer->addEvent(buffer, size, sampleNum);
+	m_eventLanesValid = false;
 }
 
-
 void GenericProcessor::processBlock (AudioSampleBuffer& buffer, MidiBuffer& eventBuffer)
 {
 	m_currentMidiBuffer = &eventBuffer;
@@ -937,24 +1042,19 @@ void GenericProcessor::saveToXml (XmlElement* parentElement)
     saveCustomParametersToXml (parentElement);
 
     // loop through the channels
-
-    for (int i = 0; i < dataChannelArray.size(); ++i)
+    if (! isSplitter() && ! isMerger())
     {
-        if (! isSplitter() && ! isMerger())
+        saveChannelSelectionStatesToXml (parentElement);
+
+        for (int i = 0; i < dataChannelArray.size(); ++i)
             saveChannelParametersToXml (parentElement, i, InfoObjectCommon::DATA_CHANNEL);
-    }
 
-    for (int i = 0; i < eventChannelArray.size(); ++i)
-    {
-        if (! isSplitter() && ! isMerger())
+        for (int i = 0; i < eventChannelArray.size(); ++i)
             saveChannelParametersToXml (parentElement, i, InfoObjectCommon::EVENT_CHANNEL);
-    }
 
-	for (int i = 0; i < spikeChannelArray.size(); ++i)
-	{
-		if (!isSplitter() && !isMerger())
-			saveChannelParametersToXml(parentElement, i, InfoObjectCommon::SPIKE_CHANNEL);
-	}
+        for (int i = 0; i < spikeChannelArray.size(); ++i)
+            saveChannelParametersToXml (parentElement, i, InfoObjectCommon::SPIKE_CHANNEL);
+    }
 
     // Save editor parameters:
     XmlElement* editorChildNode = parentElement->createNewChildElement ("EDITOR");
@@ -968,13 +1068,25 @@ void GenericProcessor::saveCustomParametersToXml (XmlElement* parentElement)
 
 void GenericProcessor::saveChannelParametersToXml (XmlElement* parentElement, int channelNumber, InfoObjectCommon::InfoObjectType type)
 {
-	XmlElement* channelInfo;
-    if ( type == InfoObjectCommon::DATA_CHANNEL)
-    {
-        channelInfo = parentElement->createNewChildElement ("CHANNEL");
-        channelInfo->setAttribute ("name", String (channelNumber));
-        channelInfo->setAttribute ("number", channelNumber);
+    String tagName;
 
+    if (type == InfoObjectCommon::DATA_CHANNEL)
+        tagName = "CHANNEL";
+    else if (type == InfoObjectCommon::EVENT_CHANNEL)
+        tagName = "EVENTCHANNEL";
+    else if (type == InfoObjectCommon::SPIKE_CHANNEL)
+        tagName = "SPIKECHANNEL";
+    else
+        return;
+
+    // most processors have no custom event or spike channel parameters, so only keep the element if something was written
+    ScopedPointer<XmlElement> channelInfo = new XmlElement (tagName);
+    channelInfo->setAttribute ("name", String (channelNumber));
+    channelInfo->setAttribute ("number", channelNumber);
+
+    if (type == InfoObjectCommon::DATA_CHANNEL)
+    {
+        // the same as CHANNELSTATES, for tools that read settings files saved before it
         bool p, r, a;
 
         getEditor()->getChannelSelectionState (channelNumber, &p, &r, &a);
@@ -984,21 +1096,12 @@ void GenericProcessor::saveChannelParametersToXml (XmlElement* parentElement, in
         selectionState->setAttribute ("record", r);
         selectionState->setAttribute ("audio", a);
     }
-	else if (type == InfoObjectCommon::EVENT_CHANNEL)
-    {
-        channelInfo = parentElement->createNewChildElement ("EVENTCHANNEL");
-        channelInfo->setAttribute ("name", String (channelNumber));
-        channelInfo->setAttribute ("number", channelNumber);
 
-    }
-	else if (type == InfoObjectCommon::SPIKE_CHANNEL)
-	{
-		channelInfo = parentElement->createNewChildElement("SPIKECHANNEL");
-		channelInfo->setAttribute("name", String(channelNumber));
-		channelInfo->setAttribute("number", channelNumber);
-	}
 	saveCustomChannelParametersToXml(channelInfo, channelNumber, type);
 
+    if (channelInfo->getNumAttributes() > 2 || channelInfo->getFirstChildElement() != nullptr)
+        parentElement->addChildElement (channelInfo.release());
+
     // deprecated parameter configuration:
     //std::cout <<"Creating Parameters" << std::endl;
     // int maxsize = parameters.size();
@@ -1025,6 +1128,78 @@ void GenericProcessor::saveCustomChannelParametersToXml (XmlElement* channelInfo
 }
 
 
+void GenericProcessor::saveChannelSelectionStatesToXml (XmlElement* parentElement)
+{
+    const int numChannels = dataChannelArray.size();
+
+    Array<bool> param, record, audio;
+    param.ensureStorageAllocated (numChannels);
+    record.ensureStorageAllocated (numChannels);
+    audio.ensureStorageAllocated (numChannels);
+
+    for (int i = 0; i < numChannels; ++i)
+    {
+        bool p, r, a;
+        getEditor()->getChannelSelectionState (i, &p, &r, &a);
+
+        param.add (p);
+        record.add (r);
+        audio.add (a);
+    }
+
+    XmlElement* states = parentElement->createNewChildElement ("CHANNELSTATES");
+    states->setAttribute ("count", numChannels);
+    states->setAttribute ("param",  channelFlagsToString (param));
+    states->setAttribute ("record", channelFlagsToString (record));
+    states->setAttribute ("audio",  channelFlagsToString (audio));
+}
+
+
+String GenericProcessor::channelFlagsToString (const Array<bool>& flags)
+{
+    const int numFlags = flags.size();
+    HeapBlock<char> text (numFlags + 1);
+
+    for (int i = 0; i < numFlags; ++i)
+        text[i] = flags.getUnchecked (i) ? '1' : '0';
+
+    text[numFlags] = 0;
+
+    return String (CharPointer_ASCII (text.getData()));
+}
+
+
+void GenericProcessor::channelFlagsFromString (const String& text, Array<bool>& flags)
+{
+    flags.clearQuick();
+
+    for (const char* c = text.toRawUTF8(); *c != 0; ++c)
+        flags.add (*c == '1');
+}
+
+
+String GenericProcessor::channelValuesToString (const Array<double>& values)
+{
+    MemoryBlock block (values.begin(), sizeof (double) * values.size());
+
+    return block.toBase64Encoding();
+}
+
+
+bool GenericProcessor::channelValuesFromString (const String& text, Array<double>& values)
+{
+    MemoryBlock block;
+
+    if (! block.fromBase64Encoding (text) || block.getSize() % sizeof (double) != 0)
+        return false;
+
+    values.clearQuick();
+    values.addArray (static_cast<const double*> (block.getData()), (int) (block.getSize() / sizeof (double)));
+
+    return true;
+}
+
+
 void GenericProcessor::loadFromXml()
 {
     update(); // make sure settings are updated
@@ -1049,7 +1224,11 @@ void GenericProcessor::loadFromXml()
 
             forEachXmlChildElement (*parametersAsXml, xmlNode)
             {
-                if (xmlNode->hasTagName ("CHANNEL"))
+                if (xmlNode->hasTagName ("CHANNELSTATES"))
+                {
+                    loadChannelSelectionStatesFromXml (xmlNode);
+                }
+                else if (xmlNode->hasTagName ("CHANNEL"))
                 {
                     loadChannelParametersFromXml (xmlNode, InfoObjectCommon::DATA_CHANNEL);
                 }
@@ -1091,6 +1270,21 @@ void GenericProcessor::loadChannelParametersFromXml (XmlElement* channelInfo, In
 }
 
 
+void GenericProcessor::loadChannelSelectionStatesFromXml (XmlElement* statesElement)
+{
+    Array<bool> param, record, audio;
+    channelFlagsFromString (statesElement->getStringAttribute ("param"),  param);
+    channelFlagsFromString (statesElement->getStringAttribute ("record"), record);
+    channelFlagsFromString (statesElement->getStringAttribute ("audio"),  audio);
+
+    const int numChannels = jmin (statesElement->getIntAttribute ("count"), dataChannelArray.size());
+
+    // setChannelSelectionState adds one to the index; this matches loadChannelParametersFromXml
+    for (int i = 0; i < numChannels; ++i)
+        getEditor()->setChannelSelectionState (i - 1, param[i], record[i], audio[i]);
+}
+
+
 void GenericProcessor::loadCustomParametersFromXml() { }
 void GenericProcessor::loadCustomChannelParametersFromXml (XmlElement* channelInfo, InfoObjectCommon::InfoObjectType type) { }
 
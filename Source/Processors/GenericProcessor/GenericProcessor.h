@@ -440,9 +440,14 @@ public:
     /** Saving custom settings to XML. */
     virtual void saveCustomParametersToXml (XmlElement* parentElement);
 
-    /** Saving generic settings for each channel (called by all processors). */
+    /** Saving generic settings for each channel (called by all processors).
+        The channel element is only added if saveCustomChannelParametersToXml writes something into it;
+        the selection state of all channels is saved at once by saveChannelSelectionStatesToXml. */
 	void saveChannelParametersToXml(XmlElement* parentElement, int channelNumber, InfoObjectCommon::InfoObjectType channelType);
 
+    /** Saves the param/record/audio state of all data channels as one element with a flag string per state. */
+    void saveChannelSelectionStatesToXml (XmlElement* parentElement);
+
     /** Saving custom settings for each channel. */
 	virtual void saveCustomChannelParametersToXml(XmlElement* channelElement, int channelNumber, InfoObjectCommon::InfoObjectType channelType);
 
@@ -455,6 +460,17 @@ public:
     /** Load generic parameters for each channel (called by all processors). */
     void loadChannelParametersFromXml (XmlElement* channelElement, InfoObjectCommon::InfoObjectType channelType);
 
+    /** Restores the channel selection states written by saveChannelSelectionStatesToXml. */
+    void loadChannelSelectionStatesFromXml (XmlElement* statesElement);
+
+    /** Per-channel values stored as a single attribute, so large channel counts do not need
+        one XML element per channel. Flags are stored as a string of '0' and '1', values as
+        a base-64 blob of doubles. */
+    static String channelFlagsToString (const Array<bool>& flags);
+    static void channelFlagsFromString (const String& text, Array<bool>& flags);
+    static String channelValuesToString (const Array<double>& values);
+    static bool channelValuesFromString (const String& text, Array<double>& values);
+
     /** Load custom parameters for each channel. */
 	virtual void loadCustomChannelParametersFromXml(XmlElement* channelElement, InfoObjectCommon::InfoObjectType channelType);
 
@@ -544,6 +560,19 @@ protected:
 	Set respondToSpikes to true if the processor should also search for spikes*/
 	virtual int checkForEvents(bool respondToSpikes = false);
 
+	/** Classes of incoming events, sorted into separate lanes as each block arrives */
+	enum EventLaneFlags
+	{
+		TTL_EVENT_LANE = 1,
+		DATA_EVENT_LANE = 2, //text and binary events
+		SPIKE_EVENT_LANE = 4
+	};
+
+	/** Like checkForEvents(), but only calls handleEvent() and handleSpike() for the classes
+	in lanes, a combination of EventLaneFlags. Events of other classes are not visited at all.
+	Events are handed over in the order they have in the buffer. */
+	int checkForEventLanes(int lanes);
+
 	/** Makes it easier for processors to respond to incoming events, such as TTLs.
 
 	Called by checkForEvents(). */
@@ -600,8 +629,52 @@ protected:
 	void updateChannelIndexes(bool updateNodeID = true);
 
 private:
-	std::map<uint32, uint32> numSamples;
-	std::map<uint32, int64> timestamps;
+	/** Timestamp and sample count of the current block of one source */
+	struct BlockInfo
+	{
+		int64 timestamp;
+		uint32 numSamples;
+	};
+
+	/** Where to find a message of the current block in the event buffer */
+	struct EventRef
+	{
+		const uint8* data;
+		int size;
+		int samplePosition;
+		int order; //position in the buffer
+	};
+
+	enum EventLaneIndex
+	{
+		TTL_LANE_INDEX,
+		DATA_LANE_INDEX,
+		SPIKE_LANE_INDEX,
+		SYNC_TEXT_LANE_INDEX,
+		NUM_EVENT_LANES
+	};
+
+	/** Events each lane holds before it has to grow on the audio thread */
+	static const int eventLaneCapacity = 256;
+
+	/** Returns the index in blockInfo for a source, adding it if it was not known */
+	int getBlockInfoIndex(uint32 fullSourceID);
+	const BlockInfo* findBlockInfo(uint32 fullSourceID) const;
+	void updateBlockInfoIndexes();
+
+	void sortIntoEventLane(const uint8* data, int size, int samplePosition, int order);
+	void buildEventLanes();
+	char* getEventScratch(size_t size);
+
+	Array<BlockInfo> blockInfo;
+	std::unordered_map<uint32, int> blockInfoIndexes;
+	Array<int> dataChannelBlockInfo;
+
+	Array<EventRef> m_eventLanes[NUM_EVENT_LANES];
+	bool m_eventLanesValid;
+	MidiBuffer m_addedEventBuffer;
+	HeapBlock<char> m_eventScratch;
+	size_t m_eventScratchSize;
 
 	int64 m_lastProcessTime;
 
@@ -614,7 +687,8 @@ private:
     calls the process(), where custom actions take place.*/
     virtual void processBlock (AudioSampleBuffer& buffer, MidiBuffer& midiMessages);
 
-    /** Extracts sample counts and timestamps from the MidiBuffer. */
+    /** Extracts sample counts and timestamps from the MidiBuffer, and sorts the other
+    messages into the event lanes. */
     int processEventBuffer ();
 
     /** The type of the processor. */
@@ -70,7 +70,143 @@ static void errorMsg(const char *file, int line, const char *msg) {
 #define ERROR_MSG(msg) errorMsg(__FILE__, __LINE__, msg)
 
 
+static bool openLibrary(const String& pluginLoc, decltype(LoadedLibInfo::handle)& handle,
+                        Plugin::LibraryInfo& libInfo, PluginInfoFunction& piFunction)
+{
+	/*
+	Load in the selected processor. This takes the
+	dynamic object (.so) and copies it into RAM
+	Dynamic linker requires a C-style string, so we
+	we have to convert first.
+	*/
+	const char* processorLocCString = static_cast<const char*>(pluginLoc.toUTF8());
+
+#ifdef WIN32
+	handle = LoadLibrary(processorLocCString);
+#elif defined(__APPLE__)
+    CFURLRef bundleURL = CFURLCreateFromFileSystemRepresentation(kCFAllocatorDefault,
+                                                                 reinterpret_cast<const UInt8 *>(processorLocCString),
+                                                                 strlen(processorLocCString),
+                                                                 true);
+    assert(bundleURL);
+    handle = CFBundleCreate(kCFAllocatorDefault, bundleURL);
+    CFRelease(bundleURL);
+#else
+	// Clear errors
+	dlerror();
+
+	/*
+	Symbols are resolved on first use. Resolving everything up front made startup
+	slow on network file systems; a missing symbol now shows up when the plugin is
+	first used rather than when the GUI starts.
+	*/
+	handle = dlopen(processorLocCString,RTLD_GLOBAL|RTLD_LAZY);
+#endif
+
+	if (!handle) {
+		ERROR_MSG("Failed to load plugin DLL");
+		closeHandle(handle);
+		return false;
+	}
+
+	LibraryInfoFunction infoFunction = 0;
+#ifdef WIN32
+	infoFunction = (LibraryInfoFunction)GetProcAddress(handle, "getLibInfo");
+#elif defined(__APPLE__)
+    infoFunction = (LibraryInfoFunction)CFBundleGetFunctionPointerForName(handle, CFSTR("getLibInfo"));
+#else
+    dlerror();
+	infoFunction = (LibraryInfoFunction)(dlsym(handle, "getLibInfo"));
+#endif
+
+	if (!infoFunction)
+	{
+		ERROR_MSG("Failed to load function 'getLibInfo'");
+		closeHandle(handle);
+		return false;
+	}
+
+	infoFunction(&libInfo);
+
+	if (libInfo.apiVersion != PLUGIN_API_VER)
+	{
+		std::cerr << pluginLoc << " invalid version" << std::endl;
+		closeHandle(handle);
+		return false;
+	}
+
+	piFunction = 0;
+#ifdef WIN32
+	piFunction = (PluginInfoFunction)GetProcAddress(handle, "getPluginInfo");
+#elif defined(__APPLE__)
+    piFunction = (PluginInfoFunction)CFBundleGetFunctionPointerForName(handle, CFSTR("getPluginInfo"));
+#else
+    dlerror();
+	piFunction = (PluginInfoFunction)(dlsym(handle, "getPluginInfo"));
+#endif
+
+	if (!piFunction)
+	{
+        ERROR_MSG("Failed to load function 'getPluginInfo'");
+		closeHandle(handle);
+		return false;
+	}
+
+	return true;
+}
+
+
+/*
+	 Checks that a new or changed library looks like a shared library for this
+	 platform, and reads it through once. Reading pulls the file into the OS cache,
+	 so the dynamic loader (which only opens one library at a time) does not wait
+	 on slow or network file systems. Several of these run in parallel at startup.
+ */
+class LibraryValidationJob : public ThreadPoolJob
+{
+public:
+	LibraryValidationJob(const File& library, const File& binary)
+		: ThreadPoolJob("Plugin validation"), libraryFile(library), binaryFile(binary), isValid(false)
+	{
+	}
+
+	JobStatus runJob() override
+	{
+		FileInputStream stream(binaryFile);
+
+		if (stream.failedToOpen())
+			return jobHasFinished;
+
+		uint8 header[4] = { 0, 0, 0, 0 };
+
+		if (stream.read(header, 4) != 4)
+			return jobHasFinished;
+
+#ifdef WIN32
+		isValid = (header[0] == 'M' && header[1] == 'Z');
+#elif defined(__APPLE__)
+		const uint32 magic = ByteOrder::littleEndianInt(header);
+		isValid = (magic == 0xfeedface || magic == 0xfeedfacf || magic == 0xcefaedfe
+		           || magic == 0xcffaedfe || magic == 0xcafebabe || magic == 0xbebafeca);
+#else
+		isValid = (header[0] == 0x7f && header[1] == 'E' && header[2] == 'L' && header[3] == 'F');
+#endif
+
+		HeapBlock<char> buffer(1 << 16);
+
+		while (!shouldExit() && stream.read(buffer, 1 << 16) > 0) {}
+
+		return jobHasFinished;
+	}
+
+	const File libraryFile;
+	const File binaryFile;
+	bool isValid;
+};
+
+
 PluginManager::PluginManager()
+	: numLazyLibraries(0), lazyLoadTime(0.0)
 {
 }
 
@@ -90,6 +226,8 @@ void PluginManager::loadAllPlugins()
 	paths.add(File::getSpecialLocation(File::currentApplicationFile).getParentDirectory().getChildFile("plugins"));
 #endif
 
+    const double start = Time::getMillisecondCounterHiRes();
+
     for (auto &pluginPath : paths) {
         if (!pluginPath.isDirectory()) {
             std::cout << "Plugin path not found: " << pluginPath.getFullPathName() << std::endl;
@@ -97,9 +235,21 @@ void PluginManager::loadAllPlugins()
             loadPlugins(pluginPath);
         }
     }
+
+    std::cout << "Plugin startup took " << Time::getMillisecondCounterHiRes() - start << " ms for "
+              << libArray.size() << " libraries" << std::endl;
 }
 
+/*
+	 Libraries whose path, size and modification time match the manifest stored
+	 next to them are registered from the manifest without being opened. Their
+	 code is loaded the first time one of their plugins is instantiated.
+	 New or changed libraries are validated in parallel, loaded, and written back
+	 to the manifest.
+ */
 void PluginManager::loadPlugins(const File &pluginPath) {
+    const double startTime = Time::getMillisecondCounterHiRes();
+
     Array<File> foundDLLs;
     
 #ifdef WIN32
@@ -116,121 +266,159 @@ void PluginManager::loadPlugins(const File &pluginPath) {
 	pluginPath.findChildFiles(foundDLLs, File::findFiles, true, pluginExt);
 #endif
 
+	const double scanTime = Time::getMillisecondCounterHiRes();
+
+	const File manifestFile = getManifestFile(pluginPath);
+	ScopedPointer<XmlElement> manifest;
+
+	if (manifestFile.existsAsFile())
+	{
+		manifest = XmlDocument::parse(manifestFile);
+
+		if (manifest != nullptr && (!manifest->hasTagName("PLUGINMANIFEST")
+		                            || manifest->getIntAttribute("apiVersion") != PLUGIN_API_VER))
+			manifest = nullptr;
+	}
+
+	ScopedPointer<XmlElement> newManifest = new XmlElement("PLUGINMANIFEST");
+	newManifest->setAttribute("apiVersion", PLUGIN_API_VER);
+
+	Array<File> changedDLLs;
+	int numCached = 0;
+
 	for (int i = 0; i < foundDLLs.size(); i++)
 	{
-		std::cout << "Loading Plugin: " << foundDLLs[i].getFileNameWithoutExtension() << "... " << std::flush;
-		int res = loadPlugin(foundDLLs[i].getFullPathName());
-		if (res < 0)
+		const File binary = getLibraryBinary(foundDLLs[i]);
+		const String relativePath = foundDLLs[i].getRelativePathFrom(pluginPath);
+		const String modified = String(binary.getLastModificationTime().toMilliseconds());
+		const String size = String(binary.getSize());
+
+		const XmlElement* cached = nullptr;
+
+		if (manifest != nullptr)
 		{
-			std::cout << " DLL Load FAILED" << std::endl;
+			forEachXmlChildElementWithTagName(*manifest, libXml, "LIBRARY")
+			{
+				if (libXml->getStringAttribute("path") == relativePath
+				    && libXml->getStringAttribute("modified") == modified
+				    && libXml->getStringAttribute("size") == size)
+				{
+					cached = libXml;
+					break;
+				}
+			}
+		}
+
+		if (cached != nullptr && registerCachedLibrary(foundDLLs[i].getFullPathName(), cached) >= 0)
+		{
+			newManifest->addChildElement(new XmlElement(*cached));
+			numCached++;
 		}
 		else
 		{
-			std::cout << "Loaded with " << res << " plugins" << std::endl;
+			changedDLLs.add(foundDLLs[i]);
 		}
 	}
-}
 
-/*
-	 Takes the user-specified plugin and begins
-	 dynamic loading process. We want to ensure that
-	 no step is exectured without a checkpoint
-	 because dynamic loading calls for rellocation of RAM
-	 and works inside the same POSIX thread as the GUI.
- */
+	const double manifestTime = Time::getMillisecondCounterHiRes();
 
-int PluginManager::loadPlugin(const String& pluginLoc) {
-	/*
-	Load in the selected processor. This takes the
-	dynamic object (.so) and copies it into RAM
-	Dynamic linker requires a C-style string, so we
-	we have to convert first.
-	*/
-	const char* processorLocCString = static_cast<const char*>(pluginLoc.toUTF8());
+	OwnedArray<LibraryValidationJob> jobs;
 
-#ifdef WIN32
-	HINSTANCE handle;
-	handle = LoadLibrary(processorLocCString);
-#elif defined(__APPLE__)
-    CFURLRef bundleURL = CFURLCreateFromFileSystemRepresentation(kCFAllocatorDefault,
-                                                                 reinterpret_cast<const UInt8 *>(processorLocCString),
-                                                                 strlen(processorLocCString),
-                                                                 true);
-    assert(bundleURL);
-    CFBundleRef handle = CFBundleCreate(kCFAllocatorDefault, bundleURL);
-    CFRelease(bundleURL);
-#else
-	// Clear errors
-	dlerror();
+	if (changedDLLs.size() > 0)
+	{
+		ThreadPool pool(jlimit(1, 8, changedDLLs.size()));
 
-	/*
-	Changing this to resolve all variables immediately upon loading.
-	This will provide for quicker testing of the custom
-	processor stability and to ensure that it doesn't crash due
-	to memory mishaps.
-	*/
-	void *handle = 0;
-	handle = dlopen(processorLocCString,RTLD_GLOBAL|RTLD_NOW);
-#endif
+		for (int i = 0; i < changedDLLs.size(); i++)
+		{
+			LibraryValidationJob* job = new LibraryValidationJob(changedDLLs[i], getLibraryBinary(changedDLLs[i]));
+			jobs.add(job);
+			pool.addJob(job, false);
+		}
 
-	if (!handle) {
-		ERROR_MSG("Failed to load plugin DLL");
-		closeHandle(handle);
-		return -1;
+		for (int i = 0; i < jobs.size(); i++)
+			pool.waitForJobToFinish(jobs[i], -1);
 	}
 
-	LibraryInfoFunction infoFunction = 0;
-#ifdef WIN32
-	infoFunction = (LibraryInfoFunction)GetProcAddress(handle, "getLibInfo");
-#elif defined(__APPLE__)
-    infoFunction = (LibraryInfoFunction)CFBundleGetFunctionPointerForName(handle, CFSTR("getLibInfo"));
-#else
-    dlerror();
-	infoFunction = (LibraryInfoFunction)(dlsym(handle, "getLibInfo"));
-#endif
+	const double validationTime = Time::getMillisecondCounterHiRes();
 
-	if (!infoFunction)
+	for (int i = 0; i < jobs.size(); i++)
 	{
-		ERROR_MSG("Failed to load function 'getLibInfo'");
-		closeHandle(handle);
-		return -1;
+		const File& library = jobs[i]->libraryFile;
+
+		std::cout << "Loading Plugin: " << library.getFileNameWithoutExtension() << "... " << std::flush;
+
+		if (!jobs[i]->isValid)
+		{
+			std::cout << " not a plugin library, skipped" << std::endl;
+			continue;
+		}
+
+		int res = loadPlugin(library.getFullPathName());
+		if (res < 0)
+		{
+			std::cout << " DLL Load FAILED" << std::endl;
+		}
+		else
+		{
+			std::cout << "Loaded with " << res << " plugins" << std::endl;
+
+			XmlElement* libXml = newManifest->createNewChildElement("LIBRARY");
+			libXml->setAttribute("path", library.getRelativePathFrom(pluginPath));
+			libXml->setAttribute("modified", String(jobs[i]->binaryFile.getLastModificationTime().toMilliseconds()));
+			libXml->setAttribute("size", String(jobs[i]->binaryFile.getSize()));
+			fillPluginInfo(libXml, libArray.size() - 1);
+		}
 	}
 
-	Plugin::LibraryInfo libInfo;
-	infoFunction(&libInfo);
+	const double loadTime = Time::getMillisecondCounterHiRes();
 
-	if (libInfo.apiVersion != PLUGIN_API_VER)
+	if (manifest == nullptr || !newManifest->isEquivalentTo(manifest, false))
 	{
-		std::cerr << pluginLoc << " invalid version" << std::endl;
-		closeHandle(handle);
-		return -1;
+		if (!newManifest->writeToFile(manifestFile, String::empty))
+			std::cout << "Could not write plugin manifest " << manifestFile.getFullPathName()
+			          << ", all plugins will be loaded at every start" << std::endl;
 	}
 
+	std::cout << "Plugins in " << pluginPath.getFullPathName() << ": "
+	          << numCached << " libraries from manifest (loaded on first use), "
+	          << changedDLLs.size() << " new or changed" << std::endl;
+	std::cout << "  scan " << scanTime - startTime << " ms, manifest " << manifestTime - scanTime
+	          << " ms, validation " << validationTime - manifestTime << " ms, loading " << loadTime - validationTime
+	          << " ms, total " << Time::getMillisecondCounterHiRes() - startTime << " ms" << std::endl;
+}
+
+/*
+	 Takes the user-specified plugin and begins
+	 dynamic loading process. We want to ensure that
+	 no step is exectured without a checkpoint
+	 because dynamic loading calls for rellocation of RAM
+	 and works inside the same POSIX thread as the GUI.
+ */
+
+int PluginManager::loadPlugin(const String& pluginLoc) {
+	decltype(LoadedLibInfo::handle) handle = 0;
+	Plugin::LibraryInfo libInfo;
 	PluginInfoFunction piFunction = 0;
-#ifdef WIN32
-	piFunction = (PluginInfoFunction)GetProcAddress(handle, "getPluginInfo");
-#elif defined(__APPLE__)
-    piFunction = (PluginInfoFunction)CFBundleGetFunctionPointerForName(handle, CFSTR("getPluginInfo"));
-#else
-    dlerror();
-	piFunction = (PluginInfoFunction)(dlsym(handle, "getPluginInfo"));
-#endif
 
-	if (!piFunction)
-	{
-        ERROR_MSG("Failed to load function 'getPluginInfo'");
-		closeHandle(handle);
+	if (!openLibrary(pluginLoc, handle, libInfo, piFunction))
 		return -1;
-	}
 
+	return registerLibrary(pluginLoc, handle, libInfo, piFunction);
+}
+
+int PluginManager::registerLibrary(const String& path, decltype(LoadedLibInfo::handle) handle, const Plugin::LibraryInfo& libInfo, PluginInfoFunction piFunction)
+{
 	LoadedLibInfo lib;
 	lib.apiVersion = libInfo.apiVersion;
-	lib.name = libInfo.name;
+	lib.nameString = libInfo.name;
+	lib.name = lib.nameString.toRawUTF8();
 	lib.libVersion = libInfo.libVersion;
 	lib.numPlugins = libInfo.numPlugins;
 	lib.handle = handle;
+	lib.path = path;
 
 	libArray.add(lib);
+	const int libIndex = libArray.size() - 1;
 
 	Plugin::PluginInfo pInfo;
 	for (int i = 0; i < lib.numPlugins; i++)
@@ -243,9 +431,11 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 		{
 			LoadedPluginInfo<Plugin::ProcessorInfo> info;
 			info.creator = pInfo.processor.creator;
-			info.name = pInfo.processor.name;
+			info.nameString = pInfo.processor.name;
+			info.name = info.nameString.toRawUTF8();
 			info.type = pInfo.processor.type;
-			info.libIndex = libArray.size()-1;
+			info.libIndex = libIndex;
+			info.pluginIndex = i;
 			processorPlugins.add(info);
 			break;
 		}
@@ -253,8 +443,10 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 		{
 			LoadedPluginInfo<Plugin::RecordEngineInfo> info;
 			info.creator = pInfo.recordEngine.creator;
-			info.name = pInfo.recordEngine.name;
-			info.libIndex = libArray.size();
+			info.nameString = pInfo.recordEngine.name;
+			info.name = info.nameString.toRawUTF8();
+			info.libIndex = libIndex;
+			info.pluginIndex = i;
 			recordEnginePlugins.add(info);
 			break;
 		}
@@ -262,8 +454,10 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 		{
 			LoadedPluginInfo<Plugin::DataThreadInfo> info;
 			info.creator = pInfo.dataThread.creator;
-			info.name = pInfo.dataThread.name;
-			info.libIndex = libArray.size();
+			info.nameString = pInfo.dataThread.name;
+			info.name = info.nameString.toRawUTF8();
+			info.libIndex = libIndex;
+			info.pluginIndex = i;
 			dataThreadPlugins.add(info);
 			break;
 		}
@@ -271,15 +465,18 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 		{
 			LoadedPluginInfo<Plugin::FileSourceInfo> info;
 			info.creator = pInfo.fileSource.creator;
-			info.name = pInfo.fileSource.name;
-			info.extensions = pInfo.fileSource.extensions;
-			info.libIndex = libArray.size();
+			info.nameString = pInfo.fileSource.name;
+			info.name = info.nameString.toRawUTF8();
+			info.extensionsString = pInfo.fileSource.extensions;
+			info.extensions = info.extensionsString.toRawUTF8();
+			info.libIndex = libIndex;
+			info.pluginIndex = i;
 			fileSourcePlugins.add(info);
 			break;
 		}
 		default:
 		{
-			std::cerr << pluginLoc << " invalid plugin type: " << pInfo.type << std::endl;
+			std::cerr << path << " invalid plugin type: " << pInfo.type << std::endl;
 			break;
 		}
 		}
@@ -287,6 +484,214 @@ int PluginManager::loadPlugin(const String& pluginLoc) {
 	return lib.numPlugins;
 }
 
+int PluginManager::registerCachedLibrary(const String& path, const XmlElement* libXml)
+{
+	if (!libXml->hasAttribute("name"))
+		return -1;
+
+	LoadedLibInfo lib;
+	lib.apiVersion = PLUGIN_API_VER;
+	lib.nameString = libXml->getStringAttribute("name");
+	lib.name = lib.nameString.toRawUTF8();
+	lib.libVersion = libXml->getIntAttribute("libVersion");
+	lib.numPlugins = libXml->getIntAttribute("numPlugins");
+	lib.handle = 0;
+	lib.path = path;
+
+	libArray.add(lib);
+	const int libIndex = libArray.size() - 1;
+
+	forEachXmlChildElementWithTagName(*libXml, pluginXml, "PLUGIN")
+	{
+		const int pluginIndex = pluginXml->getIntAttribute("index");
+		const String name = pluginXml->getStringAttribute("name");
+
+		switch (pluginXml->getIntAttribute("type"))
+		{
+		case Plugin::PLUGIN_TYPE_PROCESSOR:
+		{
+			LoadedPluginInfo<Plugin::ProcessorInfo> info;
+			info.creator = nullptr;
+			info.nameString = name;
+			info.name = info.nameString.toRawUTF8();
+			info.type = (Plugin::ProcessorType) pluginXml->getIntAttribute("processorType", Plugin::InvalidProcessor);
+			info.libIndex = libIndex;
+			info.pluginIndex = pluginIndex;
+			processorPlugins.add(info);
+			break;
+		}
+		case Plugin::PLUGIN_TYPE_RECORD_ENGINE:
+		{
+			LoadedPluginInfo<Plugin::RecordEngineInfo> info;
+			info.creator = nullptr;
+			info.nameString = name;
+			info.name = info.nameString.toRawUTF8();
+			info.libIndex = libIndex;
+			info.pluginIndex = pluginIndex;
+			recordEnginePlugins.add(info);
+			break;
+		}
+		case Plugin::PLUGIN_TYPE_DATA_THREAD:
+		{
+			LoadedPluginInfo<Plugin::DataThreadInfo> info;
+			info.creator = nullptr;
+			info.nameString = name;
+			info.name = info.nameString.toRawUTF8();
+			info.libIndex = libIndex;
+			info.pluginIndex = pluginIndex;
+			dataThreadPlugins.add(info);
+			break;
+		}
+		case Plugin::PLUGIN_TYPE_FILE_SOURCE:
+		{
+			LoadedPluginInfo<Plugin::FileSourceInfo> info;
+			info.creator = nullptr;
+			info.nameString = name;
+			info.name = info.nameString.toRawUTF8();
+			info.extensionsString = pluginXml->getStringAttribute("extensions");
+			info.extensions = info.extensionsString.toRawUTF8();
+			info.libIndex = libIndex;
+			info.pluginIndex = pluginIndex;
+			fileSourcePlugins.add(info);
+			break;
+		}
+		default:
+			break;
+		}
+	}
+
+	std::cout << "Found Plugin: " << lib.nameString << " (" << lib.numPlugins << " plugins, from manifest)" << std::endl;
+
+	return lib.numPlugins;
+}
+
+bool PluginManager::loadLibraryForPlugins(int libIndex)
+{
+	LoadedLibInfo& lib = libArray.getReference(libIndex);
+
+	if (lib.handle)
+		return true;
+
+	const double start = Time::getMillisecondCounterHiRes();
+
+	decltype(LoadedLibInfo::handle) handle = 0;
+	Plugin::LibraryInfo libInfo;
+	PluginInfoFunction piFunction = 0;
+
+	if (!openLibrary(lib.path, handle, libInfo, piFunction))
+		return false;
+
+	if (lib.nameString != libInfo.name || lib.libVersion != libInfo.libVersion)
+	{
+		std::cerr << lib.path << " has changed since the plugin manifest was written, restart to use it" << std::endl;
+		closeHandle(handle);
+		return false;
+	}
+
+	lib.handle = handle;
+
+	Plugin::PluginInfo pInfo;
+
+	for (int i = 0; i < processorPlugins.size(); i++)
+	{
+		LoadedPluginInfo<Plugin::ProcessorInfo>& info = processorPlugins.getReference(i);
+		if (info.libIndex == libIndex && !piFunction(info.pluginIndex, &pInfo) && pInfo.type == Plugin::PLUGIN_TYPE_PROCESSOR)
+			info.creator = pInfo.processor.creator;
+	}
+	for (int i = 0; i < recordEnginePlugins.size(); i++)
+	{
+		LoadedPluginInfo<Plugin::RecordEngineInfo>& info = recordEnginePlugins.getReference(i);
+		if (info.libIndex == libIndex && !piFunction(info.pluginIndex, &pInfo) && pInfo.type == Plugin::PLUGIN_TYPE_RECORD_ENGINE)
+			info.creator = pInfo.recordEngine.creator;
+	}
+	for (int i = 0; i < dataThreadPlugins.size(); i++)
+	{
+		LoadedPluginInfo<Plugin::DataThreadInfo>& info = dataThreadPlugins.getReference(i);
+		if (info.libIndex == libIndex && !piFunction(info.pluginIndex, &pInfo) && pInfo.type == Plugin::PLUGIN_TYPE_DATA_THREAD)
+			info.creator = pInfo.dataThread.creator;
+	}
+	for (int i = 0; i < fileSourcePlugins.size(); i++)
+	{
+		LoadedPluginInfo<Plugin::FileSourceInfo>& info = fileSourcePlugins.getReference(i);
+		if (info.libIndex == libIndex && !piFunction(info.pluginIndex, &pInfo) && pInfo.type == Plugin::PLUGIN_TYPE_FILE_SOURCE)
+			info.creator = pInfo.fileSource.creator;
+	}
+
+	const double elapsed = Time::getMillisecondCounterHiRes() - start;
+	numLazyLibraries++;
+	lazyLoadTime += elapsed;
+
+	std::cout << "Loaded plugin library " << lib.nameString << " on first use in " << elapsed << " ms ("
+	          << numLazyLibraries << " deferred libraries loaded so far, " << lazyLoadTime << " ms total)" << std::endl;
+
+	return true;
+}
+
+void PluginManager::fillPluginInfo(XmlElement* libXml, int libIndex) const
+{
+	const LoadedLibInfo& lib = libArray.getReference(libIndex);
+
+	libXml->setAttribute("name", lib.nameString);
+	libXml->setAttribute("libVersion", lib.libVersion);
+	libXml->setAttribute("numPlugins", lib.numPlugins);
+
+	for (int i = 0; i < processorPlugins.size(); i++)
+	{
+		if (processorPlugins[i].libIndex != libIndex)
+			continue;
+		XmlElement* p = libXml->createNewChildElement("PLUGIN");
+		p->setAttribute("index", processorPlugins[i].pluginIndex);
+		p->setAttribute("type", Plugin::PLUGIN_TYPE_PROCESSOR);
+		p->setAttribute("name", processorPlugins[i].nameString);
+		p->setAttribute("processorType", processorPlugins[i].type);
+	}
+	for (int i = 0; i < recordEnginePlugins.size(); i++)
+	{
+		if (recordEnginePlugins[i].libIndex != libIndex)
+			continue;
+		XmlElement* p = libXml->createNewChildElement("PLUGIN");
+		p->setAttribute("index", recordEnginePlugins[i].pluginIndex);
+		p->setAttribute("type", Plugin::PLUGIN_TYPE_RECORD_ENGINE);
+		p->setAttribute("name", recordEnginePlugins[i].nameString);
+	}
+	for (int i = 0; i < dataThreadPlugins.size(); i++)
+	{
+		if (dataThreadPlugins[i].libIndex != libIndex)
+			continue;
+		XmlElement* p = libXml->createNewChildElement("PLUGIN");
+		p->setAttribute("index", dataThreadPlugins[i].pluginIndex);
+		p->setAttribute("type", Plugin::PLUGIN_TYPE_DATA_THREAD);
+		p->setAttribute("name", dataThreadPlugins[i].nameString);
+	}
+	for (int i = 0; i < fileSourcePlugins.size(); i++)
+	{
+		if (fileSourcePlugins[i].libIndex != libIndex)
+			continue;
+		XmlElement* p = libXml->createNewChildElement("PLUGIN");
+		p->setAttribute("index", fileSourcePlugins[i].pluginIndex);
+		p->setAttribute("type", Plugin::PLUGIN_TYPE_FILE_SOURCE);
+		p->setAttribute("name", fileSourcePlugins[i].nameString);
+		p->setAttribute("extensions", fileSourcePlugins[i].extensionsString);
+	}
+}
+
+File PluginManager::getManifestFile(const File& pluginPath)
+{
+	return pluginPath.getChildFile("pluginManifest.xml");
+}
+
+File PluginManager::getLibraryBinary(const File& library)
+{
+#ifdef __APPLE__
+	// the bundle directory's timestamp does not change when the code inside is rebuilt
+	Array<File> binaries;
+	library.getChildFile("Contents/MacOS").findChildFiles(binaries, File::findFiles, false);
+	if (binaries.size() > 0)
+		return binaries[0];
+#endif
+	return library;
+}
+
 int PluginManager::getNumProcessors() const
 {
 	return processorPlugins.size();
@@ -307,72 +712,108 @@ int PluginManager::getNumFileSources() const
 	return fileSourcePlugins.size();
 }
 
-Plugin::ProcessorInfo PluginManager::getProcessorInfo(int index) const
+Plugin::ProcessorInfo PluginManager::getProcessorInfo(int index)
 {
-	if (index < processorPlugins.size())
-		return processorPlugins[index];
+	if (index >= 0 && index < processorPlugins.size())
+		return getPluginInfo(processorPlugins, index);
 	else
 		return getEmptyProcessorInfo();
 }
 
-Plugin::DataThreadInfo PluginManager::getDataThreadInfo(int index) const
+Plugin::DataThreadInfo PluginManager::getDataThreadInfo(int index)
 {
-	if (index < dataThreadPlugins.size())
-		return dataThreadPlugins[index];
+	if (index >= 0 && index < dataThreadPlugins.size())
+		return getPluginInfo(dataThreadPlugins, index);
 	else
 		return getEmptyDatathreadInfo();
 }
 
-Plugin::RecordEngineInfo PluginManager::getRecordEngineInfo(int index) const
+Plugin::RecordEngineInfo PluginManager::getRecordEngineInfo(int index)
 {
-	if (index < recordEnginePlugins.size())
-		return recordEnginePlugins[index];
+	if (index >= 0 && index < recordEnginePlugins.size())
+		return getPluginInfo(recordEnginePlugins, index);
 	else 
 		return getEmptyRecordengineInfo();
 }
 
-Plugin::FileSourceInfo PluginManager::getFileSourceInfo(int index) const
+Plugin::FileSourceInfo PluginManager::getFileSourceInfo(int index)
 {
-	if (index < fileSourcePlugins.size())
-		return fileSourcePlugins[index];
+	if (index >= 0 && index < fileSourcePlugins.size())
+		return getPluginInfo(fileSourcePlugins, index);
 	else
 		return getEmptyFileSourceInfo();
 }
 
-Plugin::ProcessorInfo PluginManager::getProcessorInfo(String name, String libName) const
+Plugin::ProcessorInfo PluginManager::getProcessorInfo(String name, String libName)
 {
 	Plugin::ProcessorInfo i = getEmptyProcessorInfo();
 	findPlugin<Plugin::ProcessorInfo>(name, libName, processorPlugins, i);
 	return i;
 }
 
-Plugin::DataThreadInfo PluginManager::getDataThreadInfo(String name, String libName) const
+Plugin::DataThreadInfo PluginManager::getDataThreadInfo(String name, String libName)
 {
 	Plugin::DataThreadInfo i = getEmptyDatathreadInfo();
 	findPlugin<Plugin::DataThreadInfo>(name, libName, dataThreadPlugins, i);
 	return i;
 }
 
-Plugin::RecordEngineInfo PluginManager::getRecordEngineInfo(String name, String libName) const
+Plugin::RecordEngineInfo PluginManager::getRecordEngineInfo(String name, String libName)
 {
 	Plugin::RecordEngineInfo i = getEmptyRecordengineInfo();
 	findPlugin<Plugin::RecordEngineInfo>(name, libName, recordEnginePlugins, i);
 	return i;
 }
 
-Plugin::FileSourceInfo PluginManager::getFileSourceInfo(String name, String libName) const
+Plugin::FileSourceInfo PluginManager::getFileSourceInfo(String name, String libName)
 {
 	Plugin::FileSourceInfo i = getEmptyFileSourceInfo();
 	findPlugin<Plugin::FileSourceInfo>(name, libName, fileSourcePlugins, i);
 	return i;
 }
 
+String PluginManager::getPluginName(Plugin::PluginType type, int index) const
+{
+	if (index < 0)
+		return String::empty;
+
+	switch (type)
+	{
+	case Plugin::PLUGIN_TYPE_PROCESSOR:
+		return index < processorPlugins.size() ? processorPlugins[index].nameString : String::empty;
+	case Plugin::PLUGIN_TYPE_RECORD_ENGINE:
+		return index < recordEnginePlugins.size() ? recordEnginePlugins[index].nameString : String::empty;
+	case Plugin::PLUGIN_TYPE_DATA_THREAD:
+		return index < dataThreadPlugins.size() ? dataThreadPlugins[index].nameString : String::empty;
+	case Plugin::PLUGIN_TYPE_FILE_SOURCE:
+		return index < fileSourcePlugins.size() ? fileSourcePlugins[index].nameString : String::empty;
+	default:
+		return String::empty;
+	}
+}
+
+Plugin::ProcessorType PluginManager::getProcessorType(int index) const
+{
+	if (index >= 0 && index < processorPlugins.size())
+		return processorPlugins[index].type;
+	else
+		return Plugin::InvalidProcessor;
+}
+
+String PluginManager::getFileSourceExtensions(int index) const
+{
+	if (index >= 0 && index < fileSourcePlugins.size())
+		return fileSourcePlugins[index].extensionsString;
+	else
+		return String::empty;
+}
+
 String PluginManager::getLibraryName(int index) const
 {
 	if (index < 0 || index >= libArray.size())
 		return String::empty;
 	else
-		return libArray[index].name;
+		return libArray[index].nameString;
 }
 
 int PluginManager::getLibraryVersion(int index) const
@@ -434,15 +875,15 @@ Plugin::FileSourceInfo PluginManager::getEmptyFileSourceInfo()
 }
 
 template<class T>
-bool PluginManager::findPlugin(String name, String libName, const Array<LoadedPluginInfo<T>>& pluginArray, T& pluginInfo) const
+bool PluginManager::findPlugin(String name, String libName, Array<LoadedPluginInfo<T>>& pluginArray, T& pluginInfo)
 {
 	for (int i = 0; i < pluginArray.size(); i++)
 	{
-		if (String(pluginArray[i].name) == name)
+		if (pluginArray[i].nameString == name)
 		{
-			if ((libName.isEmpty()) || (libName == String(libArray[pluginArray[i].libIndex].name)))
+			if ((libName.isEmpty()) || (libName == libArray[pluginArray[i].libIndex].nameString))
 			{
-				pluginInfo = pluginArray[i];
+				pluginInfo = getPluginInfo(pluginArray, i);
 				return true;
 			}
 		}
@@ -450,6 +891,15 @@ bool PluginManager::findPlugin(String name, String libName, const Array<LoadedPl
 	return false;
 }
 
+template<class T>
+T PluginManager::getPluginInfo(Array<LoadedPluginInfo<T>>& pluginArray, int index)
+{
+	if (pluginArray[index].creator == nullptr)
+		loadLibraryForPlugins(pluginArray[index].libIndex);
+
+	return pluginArray.getReference(index);
+}
+
 
 #if 0
 PluginManager::Plugin::Plugin() {
@@ -46,12 +46,19 @@ struct LoadedLibInfo : public Plugin::LibraryInfo
 #else
 	void* handle;
 #endif
+	String path;
+	String nameString; //owns name, so libraries restored from the manifest do not need to be loaded
 };
 
+/* Plugins listed in the manifest are registered with a null creator; the library is only
+opened when the creator is first requested through one of the get*Info methods. */
 template<class T>
 struct LoadedPluginInfo : public T
 {
 	int libIndex;
+	int pluginIndex; //index passed to the library's getPluginInfo
+	String nameString;
+	String extensionsString;
 };
 
 
@@ -71,14 +78,19 @@ public:
 	int getNumDataThreads() const;
 	int getNumRecordEngines() const;
 	int getNumFileSources() const;
-	Plugin::ProcessorInfo getProcessorInfo(int index) const;
-	Plugin::ProcessorInfo getProcessorInfo(String name, String libName = String::empty) const;
-	Plugin::DataThreadInfo getDataThreadInfo(int index) const;
-	Plugin::DataThreadInfo getDataThreadInfo(String name, String libName = String::empty) const;
-	Plugin::RecordEngineInfo getRecordEngineInfo(int index) const;
-	Plugin::RecordEngineInfo getRecordEngineInfo(String name, String libName = String::empty) const;
-	Plugin::FileSourceInfo getFileSourceInfo(int index) const;
-	Plugin::FileSourceInfo getFileSourceInfo(String name, String libName = String::empty) const;
+	/* These load the plugin's library if it has not been loaded yet, so the returned creator is valid
+	(or null if the library failed to load). Use the name/type getters below to only list plugins. */
+	Plugin::ProcessorInfo getProcessorInfo(int index);
+	Plugin::ProcessorInfo getProcessorInfo(String name, String libName = String::empty);
+	Plugin::DataThreadInfo getDataThreadInfo(int index);
+	Plugin::DataThreadInfo getDataThreadInfo(String name, String libName = String::empty);
+	Plugin::RecordEngineInfo getRecordEngineInfo(int index);
+	Plugin::RecordEngineInfo getRecordEngineInfo(String name, String libName = String::empty);
+	Plugin::FileSourceInfo getFileSourceInfo(int index);
+	Plugin::FileSourceInfo getFileSourceInfo(String name, String libName = String::empty);
+	String getPluginName(Plugin::PluginType type, int index) const;
+	Plugin::ProcessorType getProcessorType(int index) const;
+	String getFileSourceExtensions(int index) const;
 	String getLibraryName(int index) const;
 	int getLibraryVersion(int index) const;
 	int getLibraryIndexFromPlugin(Plugin::PluginType type, int index);
@@ -90,8 +102,21 @@ private:
 	Array<LoadedPluginInfo<Plugin::RecordEngineInfo>> recordEnginePlugins;
 	Array<LoadedPluginInfo<Plugin::FileSourceInfo>> fileSourcePlugins;
 
+	int numLazyLibraries;
+	double lazyLoadTime;
+
+	template<class T>
+	bool findPlugin(String name, String libName, Array<LoadedPluginInfo<T>>& pluginArray, T& pluginInfo);
 	template<class T>
-	bool findPlugin(String name, String libName, const Array<LoadedPluginInfo<T>>& pluginArray, T& pluginInfo) const;
+	T getPluginInfo(Array<LoadedPluginInfo<T>>& pluginArray, int index);
+
+	int registerLibrary(const String& path, decltype(LoadedLibInfo::handle) handle, const Plugin::LibraryInfo& libInfo, PluginInfoFunction piFunction);
+	int registerCachedLibrary(const String& path, const XmlElement* libXml);
+	bool loadLibraryForPlugins(int libIndex);
+	void fillPluginInfo(XmlElement* libXml, int libIndex) const;
+
+	static File getManifestFile(const File& pluginPath);
+	static File getLibraryBinary(const File& library);
 
 	/* Making the info structures have a constructor complicates the DLL interface. 
 	It's easier to just add some static methods to create empty structures for when the calls fail*/
@@ -217,9 +217,11 @@ Array<GenericProcessor*> ProcessorGraph::getListOfProcessors()
 
 }
 
-void ProcessorGraph::clearConnections()
+void ProcessorGraph::resetProcessorConnections()
 {
 
+    m_pendingConnections.clearQuick();
+
     for (int i = 0; i < getNumNodes(); i++)
     {
         Node* node = getNode(i);
@@ -227,15 +229,8 @@ void ProcessorGraph::clearConnections()
 
         if (nodeId != OUTPUT_NODE_ID)
         {
-
-            if (nodeId != RECORD_NODE_ID && nodeId != AUDIO_NODE_ID)
-            {
-                disconnectNode(node->nodeId);
-            }
-
             GenericProcessor* p = (GenericProcessor*) node->getProcessor();
             p->resetConnections();
-
         }
     }
 
@@ -243,19 +238,20 @@ void ProcessorGraph::clearConnections()
     for (int n = 0; n < 2; n++)
     {
 
-        addConnection(AUDIO_NODE_ID, n,
-                      OUTPUT_NODE_ID, n);
+        addPendingConnection(AUDIO_NODE_ID, n,
+                             OUTPUT_NODE_ID, n);
 
     }
 
-    addConnection(MESSAGE_CENTER_ID, midiChannelIndex,
-                  RECORD_NODE_ID, midiChannelIndex);
+    addPendingConnection(MESSAGE_CENTER_ID, midiChannelIndex,
+                         RECORD_NODE_ID, midiChannelIndex);
 }
 
 
 void ProcessorGraph::updateConnections(Array<SignalChainTabButton*, CriticalSection> tabs)
 {
-    clearConnections(); // clear processor graph
+    // the graph itself is left alone until applyPendingConnections()
+    resetProcessorConnections();
 
     std::cout << "Updating connections:" << std::endl;
     std::cout << std::endl;
@@ -380,6 +376,8 @@ void ProcessorGraph::updateConnections(Array<SignalChainTabButton*, CriticalSect
     Array<EventChannel*> extraChannels;
     getMessageCenter()->addSpecialProcessorChannels(extraChannels);
     getRecordNode()->addSpecialProcessorChannels(extraChannels);
+
+    applyPendingConnections();
 } // end method
 
 void ProcessorGraph::connectProcessors(GenericProcessor* source, GenericProcessor* dest)
@@ -411,20 +409,20 @@ void ProcessorGraph::connectProcessors(GenericProcessor* source, GenericProcesso
         {
             //std::cout << chan << " ";
 
-            addConnection(source->getNodeId(),         // sourceNodeID
-                          chan,                        // sourceNodeChannelIndex
-                          dest->getNodeId(),           // destNodeID
-                          dest->getNextChannel(true)); // destNodeChannelIndex
+            addPendingConnection(source->getNodeId(),         // sourceNodeID
+                                 chan,                        // sourceNodeChannelIndex
+                                 dest->getNodeId(),           // destNodeID
+                                 dest->getNextChannel(true)); // destNodeChannelIndex
         }
     }
 
     // 2. connect event channel
     if (connectEvents)
     {
-        addConnection(source->getNodeId(),    // sourceNodeID
-                      midiChannelIndex,       // sourceNodeChannelIndex
-                      dest->getNodeId(),      // destNodeID
-                      midiChannelIndex);      // destNodeChannelIndex
+        addPendingConnection(source->getNodeId(),    // sourceNodeID
+                             midiChannelIndex,       // sourceNodeChannelIndex
+                             dest->getNodeId(),      // destNodeID
+                             midiChannelIndex);      // destNodeChannelIndex
     }
 
 }
@@ -448,37 +446,114 @@ void ProcessorGraph::connectProcessorToAudioAndRecordNodes(GenericProcessor* sou
         //TODO: See if this causes problems with the newer architectures
         //getAudioNode()->settings.sampleRate = source->getSampleRate();
 
-        addConnection(source->getNodeId(),                   // sourceNodeID
-                      chan,                                  // sourceNodeChannelIndex
-                      AUDIO_NODE_ID,                         // destNodeID
-                      getAudioNode()->getNextChannel(true)); // destNodeChannelIndex
+        addPendingConnection(source->getNodeId(),                   // sourceNodeID
+                             chan,                                  // sourceNodeChannelIndex
+                             AUDIO_NODE_ID,                         // destNodeID
+                             getAudioNode()->getNextChannel(true)); // destNodeChannelIndex
 
         getRecordNode()->addInputChannel(source, chan);
 
-        addConnection(source->getNodeId(),                    // sourceNodeID
-                      chan,                                   // sourceNodeChannelIndex
-                      RECORD_NODE_ID,                         // destNodeID
-                      getRecordNode()->getNextChannel(true)); // destNodeChannelIndex
+        addPendingConnection(source->getNodeId(),                    // sourceNodeID
+                             chan,                                   // sourceNodeChannelIndex
+                             RECORD_NODE_ID,                         // destNodeID
+                             getRecordNode()->getNextChannel(true)); // destNodeChannelIndex
 
     }
 
     // connect event channel
-    addConnection(source->getNodeId(),    // sourceNodeID
-                  midiChannelIndex,       // sourceNodeChannelIndex
-                  RECORD_NODE_ID,         // destNodeID
-                  midiChannelIndex);      // destNodeChannelIndex
+    addPendingConnection(source->getNodeId(),    // sourceNodeID
+                         midiChannelIndex,       // sourceNodeChannelIndex
+                         RECORD_NODE_ID,         // destNodeID
+                         midiChannelIndex);      // destNodeChannelIndex
 
     // connect event channel
-    addConnection(source->getNodeId(),    // sourceNodeID
-                  midiChannelIndex,       // sourceNodeChannelIndex
-                  AUDIO_NODE_ID,          // destNodeID
-                  midiChannelIndex);      // destNodeChannelIndex
+    addPendingConnection(source->getNodeId(),    // sourceNodeID
+                         midiChannelIndex,       // sourceNodeChannelIndex
+                         AUDIO_NODE_ID,          // destNodeID
+                         midiChannelIndex);      // destNodeChannelIndex
 
 
     getRecordNode()->addInputChannel(source, midiChannelIndex);
 
 }
 
+void ProcessorGraph::addPendingConnection(uint32 sourceNodeId, int sourceChannelIndex,
+                                          uint32 destNodeId, int destChannelIndex)
+{
+    m_pendingConnections.add(Connection(sourceNodeId, sourceChannelIndex,
+                                        destNodeId, destChannelIndex));
+}
+
+/** Same ordering AudioProcessorGraph keeps its own connection list in. */
+struct PendingConnectionSorter
+{
+    static int compareElements(const AudioProcessorGraph::Connection& first,
+                               const AudioProcessorGraph::Connection& second) noexcept
+    {
+        if (first.sourceNodeId < second.sourceNodeId)                return -1;
+        if (first.sourceNodeId > second.sourceNodeId)                return 1;
+        if (first.destNodeId < second.destNodeId)                    return -1;
+        if (first.destNodeId > second.destNodeId)                    return 1;
+        if (first.sourceChannelIndex < second.sourceChannelIndex)    return -1;
+        if (first.sourceChannelIndex > second.sourceChannelIndex)    return 1;
+        if (first.destChannelIndex < second.destChannelIndex)        return -1;
+        if (first.destChannelIndex > second.destChannelIndex)        return 1;
+
+        return 0;
+    }
+};
+
+void ProcessorGraph::applyPendingConnections()
+{
+    const double start = Time::getMillisecondCounterHiRes();
+
+    PendingConnectionSorter sorter;
+    m_pendingConnections.sort(sorter);
+
+    // both lists are sorted the same way, so one pass finds what has to go and what is new
+    Array<int> staleConnections;
+    Array<Connection> newConnections;
+
+    const int numExisting = getNumConnections();
+    int existing = 0;
+
+    for (int i = 0; i < m_pendingConnections.size(); i++)
+    {
+        const Connection& wanted = m_pendingConnections.getReference(i);
+
+        if (i > 0 && sorter.compareElements(m_pendingConnections.getReference(i - 1), wanted) == 0)
+            continue; // queued twice
+
+        while (existing < numExisting && sorter.compareElements(*getConnection(existing), wanted) < 0)
+            staleConnections.add(existing++);
+
+        if (existing < numExisting && sorter.compareElements(*getConnection(existing), wanted) == 0)
+            existing++;
+        else
+            newConnections.add(wanted);
+    }
+
+    while (existing < numExisting)
+        staleConnections.add(existing++);
+
+    for (int i = staleConnections.size(); --i >= 0;)
+        removeConnection(staleConnections[i]);
+
+    for (int i = 0; i < newConnections.size(); i++)
+    {
+        const Connection& c = newConnections.getReference(i);
+        addConnection(c.sourceNodeId, c.sourceChannelIndex, c.destNodeId, c.destChannelIndex);
+    }
+
+    m_pendingConnections.clearQuick();
+
+    if (staleConnections.size() == 0 && newConnections.size() == 0)
+        std::cout << "Signal chain unchanged, keeping all " << numExisting << " connections." << std::endl;
+    else
+        std::cout << "Removed " << staleConnections.size() << " and added " << newConnections.size()
+                  << " connections in " << Time::getMillisecondCounterHiRes() - start << " ms." << std::endl;
+}
+
 GenericProcessor* ProcessorGraph::createProcessorFromDescription(Array<var>& description)
 {
     GenericProcessor* processor = nullptr;
@@ -609,6 +684,8 @@ bool ProcessorGraph::enableProcessors()
         }
     }
 
+    pinSourceThreads();
+
     for (int i = 0; i < getNumNodes(); i++)
     {
 
@@ -786,6 +863,43 @@ float ProcessorGraph::getGlobalSampleRate(bool softwareOnly) const
     }
 }
 
+void ProcessorGraph::setSyncLine(int line)
+{
+    m_syncLine = line;
+}
+
+int ProcessorGraph::getSyncLine() const
+{
+    return m_syncLine;
+}
+
+void ProcessorGraph::pinSourceThreads()
+{
+    Array<DataThread*> threads;
+
+    for (int i = 0; i < getNumNodes(); i++)
+    {
+        SourceNode* source = dynamic_cast<SourceNode*>(getNode(i)->getProcessor());
+
+        if (source != nullptr && source->getThread() != nullptr)
+            threads.add(source->getThread());
+    }
+
+    // one source keeps the default, as does everything when cores are short;
+    // the lowest cores are left to the audio and message threads
+    const int numCpus = SystemStats::getNumCpus();
+    const bool pin = threads.size() > 1 && numCpus >= threads.size() + 2 && numCpus <= 32;
+
+    for (int i = 0; i < threads.size(); i++)
+    {
+        const int core = numCpus - 1 - i;
+        threads[i]->setAffinityMask(pin ? (uint32(1) << core) : 0);
+
+        if (pin)
+            std::cout << "Data thread " << i << " runs on core " << core << std::endl;
+    }
+}
+
 void ProcessorGraph::setTimestampWindow(TimestampSourceSelectionWindow* window)
 {
     m_timestampWindow = window;
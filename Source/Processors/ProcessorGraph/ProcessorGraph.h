@@ -101,6 +101,12 @@ public:
 
     void setTimestampWindow(TimestampSourceSelectionWindow* window);
 
+    /** Sets the TTL line that carries a sync signal shared by all sources, -1 for none.
+        The record node uses it to align the clocks of the sources to the timestamp source. */
+    void setSyncLine(int line);
+
+    int getSyncLine() const;
+
 private:
     int currentNodeId;
 
@@ -112,16 +118,32 @@ private:
         MESSAGE_CENTER_ID = 904
     };
 
-    void clearConnections();
+    void resetProcessorConnections();
+
+    /** Gives the data thread of each source node a core of its own, when there are
+        several sources and enough cores to spare. */
+    void pinSourceThreads();
 
     void connectProcessors(GenericProcessor* source, GenericProcessor* dest);
     void connectProcessorToAudioAndRecordNodes(GenericProcessor* source);
 
+    /** Queues a connection for the next call to applyPendingConnections(). */
+    void addPendingConnection(uint32 sourceNodeId, int sourceChannelIndex,
+                              uint32 destNodeId, int destChannelIndex);
+
+    /** Diffs the queued connections against the graph's current ones and only
+        adds or removes the difference, so an unchanged signal chain does not
+        make the graph rebuild its rendering sequence. */
+    void applyPendingConnections();
+
+    Array<Connection> m_pendingConnections;
+
     int64 m_startSoftTimestamp{ 0 };
     const GenericProcessor* m_timestampSource{ nullptr };
     int m_timestampSourceSubIdx;
     Array<const GenericProcessor*> m_validTimestampSources;
     WeakReference<TimestampSourceSelectionWindow> m_timestampWindow;
+    int m_syncLine{ -1 };
 };
 
 
@@ -0,0 +1,328 @@
+/*
+	------------------------------------------------------------------
+
+	This file is part of the Open Ephys GUI
+	Copyright (C) 2017 Open Ephys
+
+	------------------------------------------------------------------
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	*/
+
+#include "ClockAligner.h"
+
+#include <cmath>
+#include <cstdio>
+
+const double ClockAligner::fitTolerance = 0.002;
+const double ClockAligner::blockTolerance = 0.2;
+
+// each pair counts this much less than the one after it: the fit mostly
+// reflects the last few hundred edges, and so follows slow changes of drift
+static const double forgetting = 0.995;
+
+// seconds of source time between two reports of the same source
+static const double reportInterval = 10.0;
+
+ClockAligner::ClockAligner()
+	: m_referenceIndex(-1),
+	  m_syncLine(-1),
+	  m_numReferenceEdges(0)
+{
+}
+
+ClockAligner::~ClockAligner()
+{
+}
+
+void ClockAligner::setSources(const Array<uint32>& sourceIds, const Array<float>& sampleRates, int referenceIndex, int syncLine)
+{
+	m_sources.clearQuick();
+
+	for (int i = 0; i < sourceIds.size(); i++)
+	{
+		Source s;
+		zerostruct(s);
+		s.id = sourceIds[i];
+		s.sampleRate = sampleRates[i];
+		m_sources.add(s);
+	}
+
+	m_referenceIndex = isPositiveAndBelow(referenceIndex, m_sources.size()) ? referenceIndex : -1;
+	m_syncLine = syncLine;
+	m_numReferenceEdges = 0;
+
+	for (int i = 0; i < m_sources.size(); i++)
+		resetFit(m_sources.getReference(i));
+}
+
+bool ClockAligner::isEnabled() const
+{
+	return m_syncLine >= 0 && m_referenceIndex >= 0 && m_sources.size() > 1;
+}
+
+int ClockAligner::getSyncLine() const
+{
+	return m_syncLine;
+}
+
+int ClockAligner::getNumSources() const
+{
+	return m_sources.size();
+}
+
+int ClockAligner::getReferenceIndex() const
+{
+	return m_referenceIndex;
+}
+
+uint32 ClockAligner::getSourceId(int source) const
+{
+	return m_sources.getReference(source).id;
+}
+
+int ClockAligner::findSource(uint32 sourceId) const
+{
+	for (int i = 0; i < m_sources.size(); i++)
+	{
+		if (m_sources.getReference(i).id == sourceId)
+			return i;
+	}
+	return -1;
+}
+
+void ClockAligner::setBlockTimestamp(int source, int64 timestamp)
+{
+	Source& s = m_sources.getReference(source);
+	s.blockTimestamp = timestamp;
+	s.hasBlock = true;
+
+	// edges still waiting for a reference edge that cannot come any more
+	if (source == m_referenceIndex)
+	{
+		for (int i = 0; i < m_sources.size(); i++)
+		{
+			if (i != m_referenceIndex)
+				resolvePending(m_sources.getReference(i));
+		}
+	}
+}
+
+void ClockAligner::addEdge(int source, int64 timestamp)
+{
+	if (!isEnabled())
+		return;
+
+	if (source == m_referenceIndex)
+	{
+		if (m_numReferenceEdges == MAX_REFERENCE_EDGES)
+		{
+			memmove(m_referenceEdges, m_referenceEdges + 1, (MAX_REFERENCE_EDGES - 1) * sizeof(int64));
+			m_numReferenceEdges--;
+		}
+		m_referenceEdges[m_numReferenceEdges++] = timestamp;
+
+		for (int i = 0; i < m_sources.size(); i++)
+		{
+			if (i != m_referenceIndex)
+				resolvePending(m_sources.getReference(i));
+		}
+		return;
+	}
+
+	Source& s = m_sources.getReference(source);
+	double predicted;
+
+	if (!predict(s, timestamp, predicted))
+		return;
+
+	if (s.numPending == MAX_PENDING)
+	{
+		memmove(s.pending, s.pending + 1, (MAX_PENDING - 1) * sizeof(int64));
+		memmove(s.predicted, s.predicted + 1, (MAX_PENDING - 1) * sizeof(double));
+		s.numPending--;
+	}
+	s.pending[s.numPending] = timestamp;
+	s.predicted[s.numPending] = predicted;
+	s.numPending++;
+
+	resolvePending(s);
+}
+
+bool ClockAligner::predict(const Source& s, int64 timestamp, double& predicted) const
+{
+	if (s.numPairs > 0)
+	{
+		predicted = double(s.y0) + s.offset + s.drift * double(timestamp - s.x0);
+		return true;
+	}
+
+	// no fit yet: the blocks both sources delivered in this callback end at about the same time
+	const Source& ref = m_sources.getReference(m_referenceIndex);
+
+	if (!s.hasBlock || !ref.hasBlock)
+		return false;
+
+	predicted = double(ref.blockTimestamp) + double(timestamp - s.blockTimestamp) * ref.sampleRate / s.sampleRate;
+	return true;
+}
+
+double ClockAligner::getTolerance(const Source& s) const
+{
+	return (s.numPairs > 0 ? fitTolerance : blockTolerance) * m_sources.getReference(m_referenceIndex).sampleRate;
+}
+
+void ClockAligner::resolvePending(Source& s)
+{
+	const Source& ref = m_sources.getReference(m_referenceIndex);
+	int done = 0;
+
+	while (done < s.numPending)
+	{
+		const double predicted = s.predicted[done];
+		const double tolerance = getTolerance(s);
+
+		// wait until every reference edge that could pair with this one has arrived
+		const bool decided = (m_numReferenceEdges > 0 && m_referenceEdges[m_numReferenceEdges - 1] >= predicted + tolerance)
+			|| (ref.hasBlock && ref.blockTimestamp >= predicted + tolerance);
+
+		if (!decided)
+			break;
+
+		int nearest = -1;
+		for (int i = 0; i < m_numReferenceEdges; i++)
+		{
+			if (nearest < 0 || std::abs(m_referenceEdges[i] - predicted) < std::abs(m_referenceEdges[nearest] - predicted))
+				nearest = i;
+		}
+
+		if (nearest >= 0 && std::abs(m_referenceEdges[nearest] - predicted) <= tolerance)
+			addPair(s, s.pending[done], m_referenceEdges[nearest]);
+		else if (s.numPairs > 0 && ++s.numMisses >= MAX_MISSES)
+			resetFit(s); // a source restarted, or the fit went wrong
+
+		done++;
+	}
+
+	if (done > 0)
+	{
+		s.numPending -= done;
+		memmove(s.pending, s.pending + done, s.numPending * sizeof(int64));
+		memmove(s.predicted, s.predicted + done, s.numPending * sizeof(double));
+	}
+}
+
+void ClockAligner::addPair(Source& s, int64 timestamp, int64 referenceTimestamp)
+{
+	if (s.numPairs == 0)
+	{
+		s.x0 = timestamp;
+		s.y0 = referenceTimestamp;
+		s.drift = m_sources.getReference(m_referenceIndex).sampleRate / s.sampleRate;
+		s.offset = 0;
+	}
+	else
+	{
+		const double residual = double(referenceTimestamp - s.y0) - s.offset - s.drift * double(timestamp - s.x0);
+		s.meanSquaredResidual = (s.numPairs == 1) ? residual * residual : 0.9 * s.meanSquaredResidual + 0.1 * residual * residual;
+	}
+
+	// relative to the first pair, so that the sums keep their precision
+	const double dx = double(timestamp - s.x0);
+	const double dy = double(referenceTimestamp - s.y0);
+
+	s.w = forgetting * s.w + 1.0;
+	s.sx = forgetting * s.sx + dx;
+	s.sy = forgetting * s.sy + dy;
+	s.sxx = forgetting * s.sxx + dx * dx;
+	s.sxy = forgetting * s.sxy + dx * dy;
+
+	const double den = s.w * s.sxx - s.sx * s.sx;
+
+	if (s.numPairs > 0 && den > 0)
+	{
+		s.drift = (s.w * s.sxy - s.sx * s.sy) / den;
+		s.offset = (s.sy - s.drift * s.sx) / s.w;
+	}
+
+	s.numPairs++;
+	s.numMisses = 0;
+
+	// report once the drift is fitted, then every so often
+	if (s.numPairs == 2 || (s.numPairs > 2 && timestamp - s.lastReported >= int64(reportInterval * s.sampleRate)))
+	{
+		s.updated = true;
+		s.lastReported = timestamp;
+	}
+}
+
+void ClockAligner::resetFit(Source& s)
+{
+	s.numPending = 0;
+	s.w = s.sx = s.sy = s.sxx = s.sxy = 0;
+	s.offset = 0;
+	s.drift = 1;
+	s.meanSquaredResidual = 0;
+	s.numPairs = 0;
+	s.numMisses = 0;
+	s.updated = false;
+}
+
+void ClockAligner::getUpdatedSources(Array<int>& updated)
+{
+	updated.clearQuick();
+
+	for (int i = 0; i < m_sources.size(); i++)
+	{
+		Source& s = m_sources.getReference(i);
+
+		if (s.updated)
+		{
+			updated.add(i);
+			s.updated = false;
+		}
+	}
+}
+
+bool ClockAligner::isAligned(int source) const
+{
+	return source == m_referenceIndex || m_sources.getReference(source).numPairs > 1;
+}
+
+int64 ClockAligner::toReference(int source, int64 timestamp) const
+{
+	const Source& s = m_sources.getReference(source);
+
+	if (source == m_referenceIndex || s.numPairs == 0)
+		return timestamp;
+
+	return s.y0 + (int64) std::floor(s.offset + s.drift * double(timestamp - s.x0) + 0.5);
+}
+
+int ClockAligner::formatFitText(int source, int64 timestamp, char* dest, size_t maxBytes) const
+{
+	const Source& s = m_sources.getReference(source);
+	const Source& ref = m_sources.getReference(m_referenceIndex);
+
+	const int length = std::snprintf(dest, maxBytes,
+		"Clock alignment to Id: %u subProcessor: %u timestamp = %.3f + %.12f * (source timestamp - %lld)"
+		" from %d sync edges, rms residual %.3f ms; source timestamp %lld is reference timestamp %lld",
+		(unsigned int) (ref.id >> 16), (unsigned int) (ref.id & 0xFFFF),
+		double(s.y0) + s.offset, s.drift, (long long) s.x0,
+		s.numPairs, std::sqrt(s.meanSquaredResidual) * 1000.0 / ref.sampleRate,
+		(long long) timestamp, (long long) toReference(source, timestamp));
+
+	return jlimit(0, int(maxBytes) - 1, length);
+}
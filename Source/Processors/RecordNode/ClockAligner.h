@@ -0,0 +1,131 @@
+/*
+	------------------------------------------------------------------
+
+	This file is part of the Open Ephys GUI
+	Copyright (C) 2017 Open Ephys
+
+	------------------------------------------------------------------
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	*/
+
+#ifndef CLOCKALIGNER_H_INCLUDED
+#define CLOCKALIGNER_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Fits, while acquiring, a linear mapping from the clock of each source to the
+	clock of a reference source, using a sync signal wired to a TTL input of all of them.
+
+	The rising edges of the sync line are paired across sources: the first ones by
+	where they fall relative to the blocks each source delivered in the same callback,
+	the later ones by where the current fit puts them. Each pair updates an
+	exponentially weighted least squares fit of offset and drift, so slow changes of
+	drift are followed. If a source stops matching, its fit starts again.
+
+	Only used from the audio thread, after setSources().
+
+	@see RecordNode
+*/
+class ClockAligner
+{
+public:
+	ClockAligner();
+	~ClockAligner();
+
+	/** Sets the sources to align, by full source ID (see GenericProcessor::getProcessorFullId()),
+	    which of them is the reference and the TTL line that carries the sync signal, -1 for none.
+	    Forgets all edges and fits. */
+	void setSources(const Array<uint32>& sourceIds, const Array<float>& sampleRates, int referenceIndex, int syncLine);
+
+	bool isEnabled() const;
+	int getSyncLine() const;
+
+	int getNumSources() const;
+	int getReferenceIndex() const;
+	uint32 getSourceId(int source) const;
+	int findSource(uint32 sourceId) const;
+
+	/** Tells the aligner where the current block of a source starts, to pair its first edges */
+	void setBlockTimestamp(int source, int64 timestamp);
+
+	/** Adds a rising edge of the sync line */
+	void addEdge(int source, int64 timestamp);
+
+	/** Moves the sources whose fit is due to be reported into updated */
+	void getUpdatedSources(Array<int>& updated);
+
+	bool isAligned(int source) const;
+
+	/** Maps a timestamp of a source to the clock of the reference, in reference samples */
+	int64 toReference(int source, int64 timestamp) const;
+
+	/** Describes the current fit of a source, and what the given timestamp of it maps to on
+	    the reference, for the sync messages of a recording. Writes at most maxBytes, including
+	    the terminating null, and allocates nothing. Returns the length of the text. */
+	int formatFitText(int source, int64 timestamp, char* dest, size_t maxBytes) const;
+
+	/** Pairs further apart than this, in seconds, are not the same edge once a fit exists */
+	static const double fitTolerance;
+	/** The same before the first pair, when the sources are only lined up by their blocks */
+	static const double blockTolerance;
+
+private:
+	enum { MAX_PENDING = 8, MAX_REFERENCE_EDGES = 32, MAX_MISSES = 5 };
+
+	struct Source
+	{
+		uint32 id;
+		double sampleRate;
+		bool hasBlock;
+		int64 blockTimestamp;
+
+		// edges not paired yet, and where they should appear on the reference
+		int64 pending[MAX_PENDING];
+		double predicted[MAX_PENDING];
+		int numPending;
+
+		// fit of reference = y0 + offset + drift * (timestamp - x0), in samples
+		int64 x0;
+		int64 y0;
+		double w, sx, sy, sxx, sxy;
+		double offset;
+		double drift;
+		double meanSquaredResidual;
+		int numPairs;
+		int numMisses;
+		int64 lastReported;
+		bool updated;
+	};
+
+	bool predict(const Source& s, int64 timestamp, double& predicted) const;
+	double getTolerance(const Source& s) const;
+	void resolvePending(Source& s);
+	void addPair(Source& s, int64 timestamp, int64 referenceTimestamp);
+	void resetFit(Source& s);
+
+	Array<Source> m_sources;
+	int m_referenceIndex;
+	int m_syncLine;
+
+	int64 m_referenceEdges[MAX_REFERENCE_EDGES];
+	int m_numReferenceEdges;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ClockAligner);
+};
+
+
+#endif  // CLOCKALIGNER_H_INCLUDED
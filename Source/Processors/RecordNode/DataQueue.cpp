@@ -109,8 +109,11 @@ void DataQueue::fillTimestamps(int channel, int index, int size, int64 timestamp
 	}
 }
 
-void DataQueue::writeChannel(const AudioSampleBuffer& buffer, int channel, int sourceChannel, int nSamples, int64 timestamp)
+void DataQueue::writeChannel(const AudioSampleBuffer& buffer, int channel, int sourceChannel, int nSamples, int64 timestamp, int sourceStartSample)
 {
+	if (nSamples <= 0)
+		return;
+
 	int index1, size1, index2, size2;
 	m_fifos[channel]->prepareToWrite(nSamples, index1, size1, index2, size2);
 	if ((size1 + size2) < nSamples)
@@ -121,7 +124,7 @@ void DataQueue::writeChannel(const AudioSampleBuffer& buffer, int channel, int s
 		index1,
 		buffer,
 		sourceChannel,
-		0,
+		sourceStartSample,
 		size1);
 	
 	fillTimestamps(channel, index1, size1, timestamp);
@@ -132,7 +135,7 @@ void DataQueue::writeChannel(const AudioSampleBuffer& buffer, int channel, int s
 			index2,
 			buffer,
 			sourceChannel,
-			size1,
+			sourceStartSample + size1,
 			size2);
 
 		fillTimestamps(channel, index2, size2, timestamp + size1);
@@ -0,0 +1,169 @@
+/*
+	------------------------------------------------------------------
+
+	This file is part of the Open Ephys GUI
+	Copyright (C) 2017 Open Ephys
+
+	------------------------------------------------------------------
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	*/
+
+#include "PreTriggerBuffer.h"
+
+namespace
+{
+	// written so the compiler can vectorise it: no calls, no branches it can't turn into selects
+	void convertToInt16(const float* src, int16* dest, int n, float scale)
+	{
+		for (int i = 0; i < n; ++i)
+		{
+			float v = src[i] * scale;
+			v = v < -32768.0f ? -32768.0f : (v > 32767.0f ? 32767.0f : v);
+			dest[i] = (int16)(v + (v < 0.0f ? -0.5f : 0.5f));
+		}
+	}
+}
+
+PreTriggerBuffer::PreTriggerBuffer() :
+m_storageSize(0)
+{}
+
+PreTriggerBuffer::~PreTriggerBuffer()
+{}
+
+void PreTriggerBuffer::setChannels(const Array<float>& sampleRates, const Array<float>& bitVolts, float seconds)
+{
+	m_rings.clearQuick();
+
+	size_t total = 0;
+
+	for (int i = 0; i < sampleRates.size(); ++i)
+	{
+		Ring r;
+		r.data = nullptr;
+		r.capacity = seconds > 0 ? roundToInt(seconds * sampleRates[i]) : 0;
+		r.written = 0;
+		r.numFlushSamples = 0;
+		r.bitVolts = bitVolts[i] > 0 ? bitVolts[i] : 1.0f;
+		r.scale = 1.0f / r.bitVolts;
+		m_rings.add(r);
+
+		total += size_t(r.capacity);
+	}
+
+	if (total != m_storageSize)
+	{
+		m_storage.free();
+
+		if (total > 0)
+			m_storage.malloc(total);
+
+		m_storageSize = total;
+	}
+
+	int16* next = m_storage;
+
+	for (int i = 0; i < m_rings.size(); ++i)
+	{
+		m_rings.getReference(i).data = next;
+		next += m_rings[i].capacity;
+	}
+}
+
+bool PreTriggerBuffer::isEnabled() const
+{
+	return m_storageSize > 0;
+}
+
+void PreTriggerBuffer::write(int channel, const float* data, int nSamples)
+{
+	Ring& r = m_rings.getReference(channel);
+
+	if (r.capacity == 0 || nSamples <= 0)
+		return;
+
+	r.written += nSamples;
+
+	// only the end of a block longer than the whole window is kept
+	if (nSamples > r.capacity)
+	{
+		data += nSamples - r.capacity;
+		nSamples = r.capacity;
+	}
+
+	const int pos = int((r.written - nSamples) % r.capacity);
+	const int size1 = jmin(nSamples, r.capacity - pos);
+
+	convertToInt16(data, r.data + pos, size1, r.scale);
+	convertToInt16(data + size1, r.data, nSamples - size1, r.scale);
+}
+
+int PreTriggerBuffer::getWindowSamples(int channel) const
+{
+	return m_rings[channel].capacity;
+}
+
+int PreTriggerBuffer::getNumSamples(int channel) const
+{
+	const Ring& r = m_rings.getReference(channel);
+	return int(jmin<int64>(r.written, r.capacity));
+}
+
+void PreTriggerBuffer::setNumFlushSamples(int channel, int nSamples)
+{
+	m_rings.getReference(channel).numFlushSamples = jlimit(0, getNumSamples(channel), nSamples);
+}
+
+int PreTriggerBuffer::getNumFlushSamples(int channel) const
+{
+	return m_rings[channel].numFlushSamples;
+}
+
+void PreTriggerBuffer::append(int channel, const float* data, int nSamples)
+{
+	Ring& r = m_rings.getReference(channel);
+
+	if (r.capacity == 0 || nSamples <= 0)
+		return;
+
+	const int pos = int(r.written % r.capacity);
+	const int size1 = jmin(nSamples, r.capacity - pos);
+
+	convertToInt16(data, r.data + pos, size1, r.scale);
+	convertToInt16(data + size1, r.data, nSamples - size1, r.scale);
+
+	r.written += nSamples;
+	r.numFlushSamples += nSamples;
+}
+
+void PreTriggerBuffer::read(int channel, int start, float* dest, int n) const
+{
+	const Ring& r = m_rings.getReference(channel);
+
+	int pos = int((r.written - r.numFlushSamples + start) % r.capacity);
+
+	while (n > 0)
+	{
+		const int size = jmin(n, r.capacity - pos);
+
+		for (int i = 0; i < size; ++i)
+			dest[i] = r.data[pos + i] * r.bitVolts;
+
+		dest += size;
+		n -= size;
+		pos = 0;
+	}
+}
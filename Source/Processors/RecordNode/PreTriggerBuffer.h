@@ -0,0 +1,98 @@
+/*
+	------------------------------------------------------------------
+
+	This file is part of the Open Ephys GUI
+	Copyright (C) 2017 Open Ephys
+
+	------------------------------------------------------------------
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	*/
+
+#ifndef PRETRIGGERBUFFER_H_INCLUDED
+#define PRETRIGGERBUFFER_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Keeps the last few seconds of every recorded channel while nothing is being
+	recorded, so a recording can begin before the moment it was started.
+
+	Samples are held as int16 in units of each channel's bitVolts, which is how
+	the record engines store them anyway, at half the memory of floats.
+
+	The audio thread calls write() for every block while not recording. When a
+	recording starts it stops writing, sets how many of the held samples go in
+	front of the recording with setNumFlushSamples(), and the record thread
+	reads them back with read() before the queued data. While it does, it moves
+	the data queued meanwhile behind them with append().
+
+	Only continuous data is kept; events and spikes from before the start of a
+	recording are not.
+
+	@see RecordNode, RecordThread
+*/
+class PreTriggerBuffer
+{
+public:
+	PreTriggerBuffer();
+	~PreTriggerBuffer();
+
+	/** Sizes one ring per recorded channel to hold the given number of seconds,
+	    and empties them. Must not be called while either thread uses the buffer. */
+	void setChannels(const Array<float>& sampleRates, const Array<float>& bitVolts, float seconds);
+
+	bool isEnabled() const;
+
+	/** Appends a block of a channel. One conversion pass, no allocation. */
+	void write(int channel, const float* data, int nSamples);
+
+	/** The window length of a channel, in samples */
+	int getWindowSamples(int channel) const;
+
+	/** The number of samples held for a channel, at most the window length */
+	int getNumSamples(int channel) const;
+
+	/** Sets how many of the newest held samples are written in front of the recording */
+	void setNumFlushSamples(int channel, int nSamples);
+	int getNumFlushSamples(int channel) const;
+
+	/** Adds samples after those to be flushed. No more than the window length may be
+	    waiting to be read afterwards. */
+	void append(int channel, const float* data, int nSamples);
+
+	/** Copies n samples, starting at the given one of those to be flushed, converted back to floats */
+	void read(int channel, int start, float* dest, int n) const;
+
+private:
+	struct Ring
+	{
+		int16* data;
+		int capacity;
+		int64 written;
+		int numFlushSamples;
+		float scale;
+		float bitVolts;
+	};
+
+	HeapBlock<int16> m_storage;
+	size_t m_storageSize;
+	Array<Ring> m_rings;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(PreTriggerBuffer);
+};
+
+
+#endif  // PRETRIGGERBUFFER_H_INCLUDED
@@ -142,7 +142,7 @@ int RecordEngine::getChannelNumInProc (int channel) const
     return chanOrderMap[channel];
 }
 
-const String& RecordEngine::getLatestSettingsXml() const
+String RecordEngine::getLatestSettingsXml() const
 {
     return AccessClass::getProcessorGraph()->getRecordNode()->getLastSettingsXml();
 }
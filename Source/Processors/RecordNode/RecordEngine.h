@@ -204,10 +204,9 @@ protected:
     int getChannelNumInProc (int channel) const;
 
     /** Gets the last created settings.xml in text form. Should be called at file opening to
-     get the latest version. Since the string will be large, returns a const reference. It
-     should never be const_casted.
+     get the latest version.
     */
-    const String& getLatestSettingsXml() const;
+    String getLatestSettingsXml() const;
 
 private:
     Array<int64> timestamps;
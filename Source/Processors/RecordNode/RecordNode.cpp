@@ -29,19 +29,32 @@
 #include "RecordEngine.h"
 #include "RecordThread.h"
 #include "DataQueue.h"
+#include "PreTriggerBuffer.h"
+#include "ClockAligner.h"
+#include "SettingsWriter.h"
 
 #define EVERY_ENGINE for(int eng = 0; eng < engineArray.size(); eng++) engineArray[eng]
 
 
 RecordNode::RecordNode()
     : GenericProcessor("Record Node"),
-      newDirectoryNeeded(true),  timestamp(0)
+      newDirectoryNeeded(true),  timestamp(0), preTriggerSeconds(0.0f)
 {
 
     isProcessing = false;
     isRecording = false;
     setFirstBlock = false;
 
+    startPending = false;
+    stopPending = false;
+    recordingRequested = false;
+    isQueueing = false;
+    stopQueued = false;
+    trimStart = false;
+    trimStop = false;
+    startNeeded = false;
+    stopNeeded = false;
+
     settings.numInputs = 2048;
     settings.numOutputs = 0;
 
@@ -57,7 +70,11 @@ RecordNode::RecordNode()
     m_dataQueue = new DataQueue(WRITE_BLOCK_LENGTH, DATA_BUFFER_NBLOCKS);
     m_eventQueue = new EventMsgQueue(EVENT_BUFFER_NEVENTS);
     m_spikeQueue = new SpikeMsgQueue(SPIKE_BUFFER_NSPIKES);
-    m_recordThread->setQueuePointers(m_dataQueue, m_eventQueue, m_spikeQueue);
+    m_preTrigger = new PreTriggerBuffer();
+    m_clockAligner = new ClockAligner();
+    m_syncTextData.allocate(SYNC_TEXT_DATA_SIZE, true);
+    m_recordThread->setQueuePointers(m_dataQueue, m_eventQueue, m_spikeQueue, m_preTrigger);
+    m_settingsWriter = new SettingsWriter();
 }
 
 
@@ -100,6 +117,9 @@ void RecordNode::resetConnections()
     eventChannelArray.clear();
     spikeChannelArray.clear();
 
+    // a processor that wants a pre-trigger window sets it again when it is enabled
+    preTriggerSeconds = 0.0f;
+
     EVERY_ENGINE->resetChannels();
 
 }
@@ -107,11 +127,16 @@ void RecordNode::resetConnections()
 void RecordNode::filenameComponentChanged(FilenameComponent* fnc)
 {
 
-    dataDirectory = fnc->getCurrentFile();
-    newDirectoryNeeded = true;
+    setDataDirectory(fnc->getCurrentFile());
 
 }
 
+void RecordNode::setDataDirectory(const File& directory)
+{
+    dataDirectory = directory;
+    newDirectoryNeeded = true;
+}
+
 
 void RecordNode::getChannelNamesAndRecordingStatus(StringArray& names, Array<bool>& recording)
 {
@@ -280,56 +305,59 @@ void RecordNode::setParameter(int parameterIndex, float newValue)
         String settingsFileName = rootFolder.getFullPathName() + File::separator + baseName;
         settingsFileName += getRecordingNumberString(recordingNumber) + ".settings.xml";
         std::cout << "WRITING FILE: " << settingsFileName << std::endl;
-        AccessClass::getEditorViewport()->saveState(File(settingsFileName),
-                                                    m_lastSettingsText);
+
+        // only the snapshot is taken here; formatting and writing happen on the settings writer thread
+        const double snapshotStart = Time::getMillisecondCounterHiRes();
+        XmlElement* settingsSnapshot = AccessClass::getEditorViewport()->createSettingsXml();
+        std::cout << "Settings snapshot took " << Time::getMillisecondCounterHiRes() - snapshotStart << " ms" << std::endl;
+
+        m_settingsWriter->writeSettings(settingsSnapshot, File(settingsFileName));
 
         m_recordThread->setFileComponents(rootFolder, baseName, recordingNumber);
 
-        channelMap.clear();
-        int totChans = dataChannelArray.size(); // across all processors? comes to 201 for me..
+        // the queues were prepared when acquisition started, and a trigger may have been
+        // queueing data since its sample; the record thread picks up whatever is there.
+        // Preparing them again here would also throw away the pre-trigger buffer.
+        // The first block flags were cleared when the queues were last prepared, so nothing
+        // here needs queueLock, which would only hold up the audio thread. stopQueued is
+        // left alone too: a short trigger may already have queued its stop.
+
         OwnedArray<RecordProcessorInfo> procInfo;
         Array<int> chanProcessorMap;
         Array<int> chanOrderinProc;
         int lastProcessor = -1;
         int procIndex = -1;
         int chanProcOrder = 0;
-        for (int ch = 0; ch < totChans; ++ch)
+        for (int i = 0; i < channelMap.size(); ++i)
         {
-            DataChannel* chan = dataChannelArray[ch];
-            if (chan->getRecordState())
+            DataChannel* chan = dataChannelArray[channelMap[i]];
+
+            // this assumes that all chans from the same processor are added contiguously:
+            if (chan->getCurrentNodeID() != lastProcessor)
             {
-                channelMap.add(ch);
-                // this assumes that all chans from the same processor are added contiguously:
-                if (chan->getCurrentNodeID() != lastProcessor)
-                {
-                    lastProcessor = chan->getCurrentNodeID();
-                    RecordProcessorInfo* pi = new RecordProcessorInfo();
-                    pi->processorId = chan->getCurrentNodeID();
-                    procInfo.add(pi);
-                    procIndex++;
-                    chanProcOrder = 0;
-                }
-                procInfo.getLast()->recordedChannels.add(channelMap.size()-1);
-                chanProcessorMap.add(procIndex);
-                chanOrderinProc.add(chanProcOrder);
-                chanProcOrder++;
+                lastProcessor = chan->getCurrentNodeID();
+                RecordProcessorInfo* pi = new RecordProcessorInfo();
+                pi->processorId = chan->getCurrentNodeID();
+                procInfo.add(pi);
+                procIndex++;
+                chanProcOrder = 0;
             }
+            procInfo.getLast()->recordedChannels.add(i);
+            chanProcessorMap.add(procIndex);
+            chanOrderinProc.add(chanProcOrder);
+            chanProcOrder++;
         }
         std::cout << "Number of recording processors: " << procInfo.size() << std::endl;
-        int numRecordedChannels = channelMap.size();
 
         //WARNING: If at some point we record at more that one recordEngine at once, we should change this, as using OwnedArrays only works for the first
         EVERY_ENGINE->setChannelMapping(channelMap, chanProcessorMap, chanOrderinProc, procInfo);
         m_recordThread->setChannelMap(channelMap);
-        m_dataQueue->setChannels(numRecordedChannels);
-        m_eventQueue->reset();
-        m_spikeQueue->reset();
-        m_recordThread->setFirstBlockFlag(false);
 
-        setFirstBlock = false;
         m_recordThread->startThread();
 
         isRecording = true;
+        isQueueing = false;
+        recordingRequested = true;
         hasRecorded = true;
 
     }
@@ -337,6 +365,9 @@ void RecordNode::setParameter(int parameterIndex, float newValue)
     {
         std::cout << "STOP RECORDING." << std::endl << std::endl;
 
+        recordingRequested = false;
+        startNeeded = false;
+
         if (isRecording)
         {
             isRecording = false;
@@ -362,6 +393,16 @@ void RecordNode::setParameter(int parameterIndex, float newValue)
             }
 
         }
+
+        // drop anything a trigger queued that was never handed to the record thread,
+        // and get the queues ready for the next start
+        if (isProcessing)
+        {
+            const ScopedLock sl(queueLock);
+            isQueueing = false;
+            stopQueued = false;
+            prepareQueues();
+        }
     }
     else if (parameterIndex == 2)
     {
@@ -371,7 +412,9 @@ void RecordNode::setParameter(int parameterIndex, float newValue)
 
             std::cout << "Toggling channel " << currentChannel << std::endl;
 
-            if (isRecording)
+            const ScopedLock sl(queueLock);
+
+            if (isRecording || isQueueing)
             {
                 //Toggling channels while recording isn't allowed. Code shouldn't reach here.
                 //In case it does, display an error and exit.
@@ -388,6 +431,8 @@ void RecordNode::setParameter(int parameterIndex, float newValue)
             {
                 dataChannelArray[currentChannel]->setRecordState(true);
             }
+
+            prepareQueues();
         }
     }
 }
@@ -404,7 +449,21 @@ bool RecordNode::enable()
     recordingNumber = -1;
     EVERY_ENGINE->configureEngine();
     EVERY_ENGINE->startAcquisition();
+
+    {
+        const ScopedLock sl(queueLock);
+        startPending = false;
+        stopPending = false;
+        recordingRequested = isRecording.load();
+        isQueueing = false;
+        stopQueued = false;
+        prepareQueues();
+    }
+
+    prepareClockAlignment();
+
     isProcessing = true;
+    startTimer(50);
     return true;
 }
 
@@ -414,11 +473,102 @@ bool RecordNode::disable()
     // close files if necessary
     setParameter(0, 10.0f);
 
+    stopTimer();
+    startNeeded = false;
+    stopNeeded = false;
+
     isProcessing = false;
 
     return true;
 }
 
+void RecordNode::prepareQueues()
+{
+    channelMap.clear();
+    Array<float> sampleRates;
+    Array<float> bitVolts;
+
+    for (int ch = 0; ch < dataChannelArray.size(); ++ch)
+    {
+        if (dataChannelArray[ch]->getRecordState())
+        {
+            channelMap.add(ch);
+            sampleRates.add(dataChannelArray[ch]->getSampleRate());
+            bitVolts.add(dataChannelArray[ch]->getBitVolts());
+        }
+    }
+
+    // the record thread moves what is queued during the pre-trigger flush into the
+    // pre-trigger buffer, so the queue never has to hold more than usual
+    m_dataQueue->setChannels(channelMap.size());
+    m_recordThread->setFirstBlockFlag(false);
+    setFirstBlock = false;
+    m_eventQueue->reset();
+    m_spikeQueue->reset();
+    m_preTrigger->setChannels(sampleRates, bitVolts, preTriggerSeconds);
+}
+
+void RecordNode::setPreTriggerSeconds(float seconds)
+{
+    seconds = jmax(0.0f, seconds);
+
+    if (seconds == preTriggerSeconds)
+        return;
+
+    preTriggerSeconds = seconds;
+
+    if (isProcessing)
+    {
+        const ScopedLock sl(queueLock);
+
+        if (!isRecording && !isQueueing)
+            prepareQueues();
+    }
+}
+
+float RecordNode::getPreTriggerSeconds() const
+{
+    return preTriggerSeconds;
+}
+
+void RecordNode::setRecordingStatusAt(bool enable, int64 timestamp, uint16 sourceNodeId, uint16 subProcessorIdx)
+{
+    if (enable == recordingRequested)
+        return;
+
+    RecordTrigger& trigger = enable ? startTrigger : stopTrigger;
+    trigger.timestamp = timestamp;
+    trigger.sourceNodeId = sourceNodeId;
+    trigger.subProcessorIdx = subProcessorIdx;
+
+    recordingRequested = enable;
+
+    if (enable)
+        startPending = true;
+    else
+        stopPending = true;
+}
+
+bool RecordNode::isRecordingRequested() const
+{
+    return recordingRequested;
+}
+
+bool RecordNode::isTriggerSource(const RecordTrigger& trigger, uint16 sourceNodeId, uint16 subProcessorIdx)
+{
+    return trigger.sourceNodeId == sourceNodeId && trigger.subProcessorIdx == subProcessorIdx;
+}
+
+void RecordNode::timerCallback()
+{
+    // the control panel drives the rest of the start and stop, same as for its own button
+    if (startNeeded.exchange(false) && !isRecording)
+        CoreServices::setRecordingStatus(true);
+
+    if (stopNeeded.exchange(false) && isRecording)
+        CoreServices::setRecordingStatus(false);
+}
+
 float RecordNode::getFreeSpace() const
 {
     return 1.0f - float(dataDirectory.getBytesFreeOnVolume())/float(dataDirectory.getVolumeTotalSize());
@@ -428,12 +578,25 @@ float RecordNode::getFreeSpace() const
 void RecordNode::handleEvent(const EventChannel* eventInfo, const MidiMessage& event,
                              int samplePosition)
 {
-    if (isRecording)
+    if (eventInfo && m_clockAligner->isEnabled())
+        addSyncEdge(eventInfo, event);
+
+    if ((isRecording || isQueueing) && !stopQueued)
     {
             if ((*(event.getRawData()+0) & 0x80) == 0)
             // saving flag > 0 (i.e., event has not already been processed)
             {
                 int64 timestamp = Event::getTimestamp(event);
+
+                // in the block a trigger falls in, keep only the events on its side of it
+                const uint16 sourceId = Event::getSourceID(event);
+                const uint16 subProcessorIdx = Event::getSubProcessorIdx(event);
+
+                if (trimStart && isTriggerSource(startTrigger, sourceId, subProcessorIdx) && timestamp < startTrigger.timestamp)
+                    return;
+                if (trimStop && isTriggerSource(stopTrigger, sourceId, subProcessorIdx) && timestamp >= stopTrigger.timestamp)
+                    return;
+
                 int eventIndex;
                 if (eventInfo)
                     eventIndex = getEventChannelIndex(Event::getSourceIndex(event),
@@ -453,19 +616,80 @@ void RecordNode::handleTimestampSyncTexts(const MidiMessage& event)
 
 void RecordNode::process(AudioSampleBuffer& buffer)
 {
+    const bool startRequested = startPending.exchange(false);
+    const bool stopRequested = stopPending.exchange(false);
+
+    // the lock is only held while the queues are rebuilt, which never happens while anything
+    // is being queued, so recording goes on without it. Starting, and the pre-trigger buffer,
+    // have to wait for the rebuild to finish.
+    const ScopedTryLock sl(queueLock);
+    const bool queuesReady = sl.isLocked();
+
+    if (startRequested && !queuesReady)
+        startPending = true;
+
+    // a trigger starts queueing right away; the files are opened later, from timerCallback
+    if (startRequested && queuesReady && isProcessing && !isRecording && !isQueueing)
+    {
+        isQueueing = true;
+        stopQueued = false;
+        setFirstBlock = false;
+        trimStart = true;
+        startNeeded = true;
+    }
+
+    trimStop = stopRequested && (isRecording || isQueueing) && !stopQueued;
+
+    if (m_clockAligner->isEnabled())
+    {
+        for (int i = 0; i < m_clockAligner->getNumSources(); ++i)
+            m_clockAligner->setBlockTimestamp(i, getSourceTimestamp(m_clockAligner->getSourceId(i)));
+    }
+
     // FIRST: cycle through events -- extract the TTLs and the timestamps
     checkForEvents();
 
-    if (isRecording)
+    if (m_clockAligner->isEnabled())
+        queueClockAlignment(!setFirstBlock);
+
+    if ((isRecording || isQueueing) && !stopQueued)
     {
-        // SECOND: write channel data
+        // SECOND: write channel data, from the start trigger and up to the stop trigger
+        // for channels of the source the trigger came from
         int recordChans = channelMap.size();
         for (int chan = 0; chan < recordChans; ++chan)
         {
             int realChan = channelMap[chan];
             int nSamples = getNumSamples(realChan);
-            int timestamp = getTimestamp(realChan);
-            m_dataQueue->writeChannel(buffer, chan, realChan, nSamples, timestamp);
+            int64 timestamp = getTimestamp(realChan);
+            const DataChannel* channel = dataChannelArray[realChan];
+
+            int first = 0;
+            int last = nSamples;
+
+            if (!setFirstBlock && m_preTrigger->isEnabled())
+            {
+                // the recording begins a window before the trigger sample, or before
+                // this block if it was started some other way; the pre-trigger buffer
+                // holds what came before this block
+                int fromBuffer = m_preTrigger->getWindowSamples(chan);
+
+                if (trimStart && isTriggerSource(startTrigger, channel->getSourceNodeID(), channel->getSubProcessorIdx()))
+                {
+                    const int64 start = startTrigger.timestamp - m_preTrigger->getWindowSamples(chan);
+                    first = (int) jlimit<int64>(0, nSamples, start - timestamp);
+                    fromBuffer = (int) jlimit<int64>(0, fromBuffer, timestamp - start);
+                }
+
+                m_preTrigger->setNumFlushSamples(chan, fromBuffer);
+            }
+            else if (trimStart && isTriggerSource(startTrigger, channel->getSourceNodeID(), channel->getSubProcessorIdx()))
+                first = (int) jlimit<int64>(0, nSamples, startTrigger.timestamp - timestamp);
+
+            if (trimStop && isTriggerSource(stopTrigger, channel->getSourceNodeID(), channel->getSubProcessorIdx()))
+                last = (int) jlimit<int64>(first, nSamples, stopTrigger.timestamp - timestamp);
+
+            m_dataQueue->writeChannel(buffer, chan, realChan, last - first, timestamp + first, first);
         }
 
         //  std::cout << nSamples << " " << samplesWritten << " " << blockIndex << std::endl;
@@ -474,7 +698,111 @@ void RecordNode::process(AudioSampleBuffer& buffer)
             m_recordThread->setFirstBlockFlag(true);
             setFirstBlock = true;
         }
-        
+
+        if (trimStop)
+        {
+            stopQueued = true;
+            stopNeeded = true;
+        }
+    }
+
+    else if (queuesReady && !isRecording && !isQueueing && m_preTrigger->isEnabled()
+             && !m_recordThread->isThreadRunning()) // it may still be flushing the buffer
+    {
+        // nothing is being recorded: keep the last few seconds in case a recording starts
+        for (int chan = 0; chan < channelMap.size(); ++chan)
+        {
+            int realChan = channelMap[chan];
+            m_preTrigger->write(chan, buffer.getReadPointer(realChan), getNumSamples(realChan));
+        }
+    }
+
+    trimStart = false;
+    trimStop = false;
+}
+
+void RecordNode::prepareClockAlignment()
+{
+    Array<const GenericProcessor*> sources;
+    int selected, selectedSub;
+    AccessClass::getProcessorGraph()->getTimestampSources(sources, selected, selectedSub);
+
+    Array<uint32> sourceIds;
+    Array<float> sampleRates;
+    int reference = -1;
+
+    for (int i = 0; i < sources.size(); ++i)
+    {
+        for (int sub = 0; sub < sources[i]->getNumSubProcessors(); ++sub)
+        {
+            if (i == selected && sub == selectedSub)
+                reference = sourceIds.size();
+
+            sourceIds.add(getProcessorFullId(sources[i]->getNodeId(), sub));
+            sampleRates.add(sources[i]->getSampleRate(sub));
+        }
+    }
+
+    // with the software timer selected, align to the first source
+    if (reference < 0 && sourceIds.size() > 0)
+        reference = 0;
+
+    m_clockAligner->setSources(sourceIds, sampleRates, reference, AccessClass::getProcessorGraph()->getSyncLine());
+    m_alignedSources.ensureStorageAllocated(sourceIds.size());
+
+    if (m_clockAligner->isEnabled())
+        std::cout << "Aligning the clocks of " << sourceIds.size() - 1 << " sources with TTL line "
+                  << m_clockAligner->getSyncLine() + 1 << std::endl;
+}
+
+void RecordNode::addSyncEdge(const EventChannel* eventInfo, const MidiMessage& event)
+{
+    // the TTL channel is at the same place in every event; only the sync line is deserialized
+    if (Event::getEventType(event) != EventChannel::TTL
+        || *reinterpret_cast<const uint16*>(event.getRawData() + 16) != m_clockAligner->getSyncLine())
+        return;
+
+    const int source = m_clockAligner->findSource(getProcessorFullId(eventInfo->getSourceNodeID(), eventInfo->getSubProcessorIdx()));
+
+    if (source < 0)
+        return;
+
+    TTLEventPtr ttl = TTLEvent::deserializeFromMessage(event, eventInfo);
+
+    if (ttl != nullptr && ttl->getState())
+        m_clockAligner->addEdge(source, ttl->getTimestamp());
+}
+
+void RecordNode::queueClockAlignment(bool all)
+{
+    if (all)
+    {
+        m_alignedSources.clearQuick();
+
+        for (int i = 0; i < m_clockAligner->getNumSources(); ++i)
+        {
+            if (i != m_clockAligner->getReferenceIndex() && m_clockAligner->isAligned(i))
+                m_alignedSources.add(i);
+        }
+    }
+    else
+        m_clockAligner->getUpdatedSources(m_alignedSources);
+
+    if (!(isRecording || isQueueing) || stopQueued)
+        return;
+
+    for (int i = 0; i < m_alignedSources.size(); ++i)
+    {
+        const int source = m_alignedSources[i];
+        const uint32 sourceId = m_clockAligner->getSourceId(source);
+        const int64 sourceTimestamp = getSourceTimestamp(sourceId);
+
+        // formatted straight to where the text goes in the message
+        char* text = m_syncTextData.getData() + 16;
+        m_clockAligner->formatFitText(source, sourceTimestamp, text, SYNC_TEXT_DATA_SIZE - 16);
+        size_t dataSize = SystemEvent::fillSyncTextData(m_syncTextData.getData(), SYNC_TEXT_DATA_SIZE, uint16(sourceId >> 16),
+                                                        uint16(sourceId & 0xFFFF), sourceTimestamp, text);
+        m_eventQueue->addEvent(MidiMessage(m_syncTextData.getData(), (int) dataSize, 0), sourceTimestamp, -1);
     }
 }
 
@@ -503,7 +831,7 @@ int RecordNode::addSpikeElectrode(const SpikeChannel* elec)
 
 void RecordNode::writeSpike(const SpikeEvent* spike, const SpikeChannel* spikeElectrode)
 {
-    if (isRecording)
+    if ((isRecording || isQueueing) && !stopQueued)
     {
         int electrodeIndex = getSpikeChannelIndex(spikeElectrode->getSourceIndex(),
                                                   spikeElectrode->getSourceNodeID(),
@@ -518,9 +846,9 @@ void RecordNode::clearRecordEngines()
     engineArray.clear();
 }
 
-const String& RecordNode::getLastSettingsXml() const
+String RecordNode::getLastSettingsXml() const
 {
-    return m_lastSettingsText;
+    return m_settingsWriter->getSettingsText();
 }
 
 File RecordNode::getDataDirectory() const
@@ -36,10 +36,14 @@
 #define DATA_BUFFER_NBLOCKS 300
 #define EVENT_BUFFER_NEVENTS 512
 #define SPIKE_BUFFER_NSPIKES 512
+#define SYNC_TEXT_DATA_SIZE 512
 
 class RecordEngine;
 class RecordThread;
 class DataQueue;
+class PreTriggerBuffer;
+class ClockAligner;
+class SettingsWriter;
 
 /**
 
@@ -53,7 +57,8 @@ class DataQueue;
 */
 
 class RecordNode : public GenericProcessor,
-    public FilenameComponentListener
+    public FilenameComponentListener,
+    private Timer
 {
 public:
 
@@ -124,6 +129,10 @@ public:
     */
     void filenameComponentChanged(FilenameComponent*);
 
+    /** Sets the directory new recordings are created in.
+    */
+    void setDataDirectory(const File& directory);
+
     /** Creates a new data directory in the location specified by the fileNameComponent.
     */
     void createNewDirectory();
@@ -166,11 +175,29 @@ public:
 
     std::atomic<bool> isRecording;
 
+    /** Starts or stops recording at a given sample of a source subprocessor.
+
+        Safe to call from any thread, including the audio thread. Data is queued
+        from (or up to) that sample in the next block; the files are opened or
+        closed shortly after, on the message thread.
+    */
+    void setRecordingStatusAt(bool enable, int64 timestamp, uint16 sourceNodeId, uint16 subProcessorIdx);
+
+    /** Returns whether recording will be on once pending starts and stops take effect */
+    bool isRecordingRequested() const;
+
+    /** Sets how many seconds before the start of each recording are kept in it.
+        0 turns the pre-trigger buffer off. Takes effect right away unless a
+        recording is in progress, in which case it applies to the next one.
+    */
+    void setPreTriggerSeconds(float seconds);
+    float getPreTriggerSeconds() const;
+
     /** Generate a Matlab-compatible datestring */
     String generateDateString() const;
 
-    /** Get the last settings.xml in string form. Since the string will be large, returns a const ref.*/
-    const String& getLastSettingsXml() const;
+    /** Get the last settings.xml in string form. Strings share their text, so the copy is cheap.*/
+    String getLastSettingsXml() const;
 
     //Called by ProcessorGraph
     void updateRecordChannelIndexes();
@@ -213,6 +240,55 @@ private:
     bool hasRecorded;
     std::atomic<bool> setFirstBlock;
 
+    struct RecordTrigger
+    {
+        int64 timestamp;
+        uint16 sourceNodeId;
+        uint16 subProcessorIdx;
+    };
+
+    /** Written by setRecordingStatusAt, read by process() once the pending flag is seen */
+    RecordTrigger startTrigger;
+    RecordTrigger stopTrigger;
+    std::atomic<bool> startPending;
+    std::atomic<bool> stopPending;
+    std::atomic<bool> recordingRequested;
+
+    /** A trigger started queueing data; the record thread has not been started yet */
+    std::atomic<bool> isQueueing;
+    /** The stop sample has been queued; nothing more is queued until recording stops */
+    std::atomic<bool> stopQueued;
+    /** Only used on the audio thread, for the block a trigger falls in */
+    bool trimStart;
+    bool trimStop;
+
+    /** Set on the audio thread, acted on by timerCallback */
+    std::atomic<bool> startNeeded;
+    std::atomic<bool> stopNeeded;
+
+    /** Held only while the channel map and queues are rebuilt. The audio thread only tries it,
+        and skips starting and the pre-trigger buffer for a block it can't get it
+    */
+    CriticalSection queueLock;
+
+    /** Rebuilds channelMap, resizes the queues for it and clears the first block flags.
+        Call with queueLock held, and only while nothing is being queued.
+    */
+    void prepareQueues();
+
+    static bool isTriggerSource(const RecordTrigger& trigger, uint16 sourceNodeId, uint16 subProcessorIdx);
+
+    /** Sets up clock alignment from the timestamp source and sync line chosen in the ProcessorGraph */
+    void prepareClockAlignment();
+
+    /** Passes rising edges of the sync line to the clock aligner */
+    void addSyncEdge(const EventChannel* eventInfo, const MidiMessage& event);
+
+    /** Queues the fits that changed, or all current ones, as sync messages of the recording */
+    void queueClockAlignment(bool all);
+
+    void timerCallback() override;
+
     /** Cycle through the event buffer, looking for data to save */
     void handleEvent(const EventChannel* eventInfo, const MidiMessage& event, int samplePosition) override;
 
@@ -225,9 +301,16 @@ private:
     ScopedPointer<DataQueue> m_dataQueue;
     ScopedPointer<EventMsgQueue> m_eventQueue;
     ScopedPointer<SpikeMsgQueue> m_spikeQueue;
+    ScopedPointer<PreTriggerBuffer> m_preTrigger;
+    float preTriggerSeconds;
+    ScopedPointer<ClockAligner> m_clockAligner;
+    Array<int> m_alignedSources;
+    /** Where queueClockAlignment formats the sync messages, so the audio thread doesn't allocate for them */
+    HeapBlock<char> m_syncTextData;
     Array<int> m_recordedChannelMap;
 
-    String m_lastSettingsText;
+    /** Formats and writes the settings snapshot taken at record start */
+    ScopedPointer<SettingsWriter> m_settingsWriter;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(RecordNode);
 
@@ -26,6 +26,7 @@
 #include "../../AccessClass.h"
 #include "../ProcessorGraph/ProcessorGraph.h"
 #include "RecordNode.h"
+#include "PreTriggerBuffer.h"
 
 #define EVERY_ENGINE for(int eng = 0; eng < m_engineArray.size(); eng++) m_engineArray[eng]
 
@@ -60,11 +61,12 @@ void RecordThread::setChannelMap(const Array<int>& channels)
 	m_numChannels = channels.size();
 }
 
-void RecordThread::setQueuePointers(DataQueue* data, EventMsgQueue* events, SpikeMsgQueue* spikes)
+void RecordThread::setQueuePointers(DataQueue* data, EventMsgQueue* events, SpikeMsgQueue* spikes, PreTriggerBuffer* preTrigger)
 {
 	m_dataQueue = data;
 	m_eventQueue = events;
 	m_spikeQueue = spikes;
+	m_preTrigger = preTrigger;
 }
 
 void RecordThread::setFirstBlockFlag(bool state)
@@ -90,8 +92,19 @@ void RecordThread::run()
 		closeEarly = false;
 		Array<int64> timestamps;
 		m_dataQueue->getTimestampsForBlock(0, timestamps);
+
+		// the files start with the samples kept from before the recording
+		if (m_preTrigger->isEnabled())
+		{
+			for (int chan = 0; chan < m_numChannels; ++chan)
+				timestamps.set(chan, timestamps[chan] - m_preTrigger->getNumFlushSamples(chan));
+		}
+
 		EVERY_ENGINE->updateTimestamps(timestamps);
         EVERY_ENGINE->openFiles(m_rootFolder, m_baseName, m_recordingNumber);
+
+		if (m_preTrigger->isEnabled())
+			writePreTrigger(dataBuffer, timestamps);
 	}
 	//3-Normal loop
 	while (!threadShouldExit())
@@ -161,6 +174,57 @@ void RecordThread::writeData(const AudioSampleBuffer& dataBuffer, int maxSamples
 	}
 }
 
+void RecordThread::writePreTrigger(const AudioSampleBuffer& dataBuffer, Array<int64>& timestamps)
+{
+	AudioSampleBuffer block(m_numChannels, BLOCK_MAX_WRITE_SAMPLES);
+	Array<int> written;
+	written.insertMultiple(0, 0, m_numChannels);
+	Array<CircularBufferIndexes> idx;
+	Array<int64> queueTimestamps;
+	bool remaining = true;
+
+	// finished even if the recording is stopped meanwhile, or the files would have a gap
+	while (remaining)
+	{
+		EVERY_ENGINE->updateTimestamps(timestamps);
+		EVERY_ENGINE->startChannelBlock(false);
+		for (int chan = 0; chan < m_numChannels; ++chan)
+		{
+			int total = m_preTrigger->getNumFlushSamples(chan);
+			int n = jmin(BLOCK_MAX_WRITE_SAMPLES, total - written[chan]);
+			if (n <= 0)
+				continue;
+
+			m_preTrigger->read(chan, written[chan], block.getWritePointer(chan), n);
+			EVERY_ENGINE->writeData(chan, m_channelArray[chan], block.getReadPointer(chan), n);
+
+			written.set(chan, written[chan] + n);
+			timestamps.set(chan, timestamps[chan] + n);
+		}
+		EVERY_ENGINE->endChannelBlock(false);
+
+		// the queued samples follow on from the buffered ones, so they can go behind them
+		int room = std::numeric_limits<int>::max();
+		for (int chan = 0; chan < m_numChannels; ++chan)
+			room = jmin(room, m_preTrigger->getWindowSamples(chan) - (m_preTrigger->getNumFlushSamples(chan) - written[chan]));
+
+		if (room > 0 && m_dataQueue->startRead(idx, queueTimestamps, room))
+		{
+			for (int chan = 0; chan < m_numChannels; ++chan)
+			{
+				m_preTrigger->append(chan, dataBuffer.getReadPointer(chan, idx[chan].index1), idx[chan].size1);
+				if (idx[chan].size2 > 0)
+					m_preTrigger->append(chan, dataBuffer.getReadPointer(chan, idx[chan].index2), idx[chan].size2);
+			}
+			m_dataQueue->stopRead();
+		}
+
+		remaining = false;
+		for (int chan = 0; chan < m_numChannels; ++chan)
+			remaining = remaining || written[chan] < m_preTrigger->getNumFlushSamples(chan);
+	}
+}
+
 void RecordThread::forceCloseFiles()
 {
 	if (isThreadRunning() || m_cleanExit)
@@ -34,6 +34,7 @@
 #define BLOCK_MAX_WRITE_SPIKES 32
 
 class RecordEngine;
+class PreTriggerBuffer;
 
 
 class RecordThread : public Thread
@@ -43,7 +44,7 @@ public:
 	~RecordThread();
     void setFileComponents(File rootFolder, String baseName, int recordingNumber);
 	void setChannelMap(const Array<int>& channels);
-	void setQueuePointers(DataQueue* data, EventMsgQueue* events, SpikeMsgQueue* spikes);
+	void setQueuePointers(DataQueue* data, EventMsgQueue* events, SpikeMsgQueue* spikes, PreTriggerBuffer* preTrigger);
 
 	void run() override;
 
@@ -52,6 +53,10 @@ public:
 
 private:
 	void writeData(const AudioSampleBuffer& buffer, int maxSamples, int maxEvents, int maxSpikes, bool lastBlock = false);
+	/** Writes the samples kept from before the recording started, in front of the queued ones.
+	    What is queued meanwhile is moved behind them in the pre-trigger buffer as room frees up,
+	    so the data queue doesn't fill up during a long flush. */
+	void writePreTrigger(const AudioSampleBuffer& dataBuffer, Array<int64>& timestamps);
 
 	const OwnedArray<RecordEngine>& m_engineArray;
 	Array<int> m_channelArray;
@@ -59,6 +64,7 @@ private:
 	DataQueue* m_dataQueue;
 	EventMsgQueue* m_eventQueue;
 	SpikeMsgQueue *m_spikeQueue;
+	PreTriggerBuffer* m_preTrigger;
 
 	std::atomic<bool> m_receivedFirstBlock;
 	std::atomic<bool> m_cleanExit;
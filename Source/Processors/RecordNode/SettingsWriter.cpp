@@ -0,0 +1,68 @@
+/*
+	------------------------------------------------------------------
+
+	This file is part of the Open Ephys GUI
+	Copyright (C) 2017 Open Ephys
+
+	------------------------------------------------------------------
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	*/
+
+#include "SettingsWriter.h"
+
+SettingsWriter::SettingsWriter()
+	: Thread("Settings writer")
+{
+}
+
+SettingsWriter::~SettingsWriter()
+{
+	waitForThreadToExit(-1);
+}
+
+void SettingsWriter::writeSettings(XmlElement* snapshot, const File& file)
+{
+	waitForThreadToExit(-1);
+
+	m_snapshot = snapshot;
+	m_file = file;
+
+	startThread();
+}
+
+String SettingsWriter::getSettingsText()
+{
+	waitForThreadToExit(-1);
+
+	return m_settingsText;
+}
+
+void SettingsWriter::run()
+{
+	const double start = Time::getMillisecondCounterHiRes();
+
+	// format once, and write the same text that record engines get through getSettingsText()
+	m_settingsText = m_snapshot->createDocument(String::empty);
+
+	if (m_settingsText.isEmpty())
+		m_settingsText = "Couldn't create configuration xml";
+	else if (!m_file.replaceWithText(m_settingsText))
+		std::cout << "Couldn't write settings file " << m_file.getFullPathName() << std::endl;
+
+	m_snapshot = nullptr;
+
+	std::cout << "Wrote " << m_file.getFileName() << " in " << Time::getMillisecondCounterHiRes() - start << " ms" << std::endl;
+}
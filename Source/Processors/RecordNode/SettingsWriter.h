@@ -0,0 +1,62 @@
+/*
+	------------------------------------------------------------------
+
+	This file is part of the Open Ephys GUI
+	Copyright (C) 2017 Open Ephys
+
+	------------------------------------------------------------------
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+	*/
+
+#ifndef SETTINGSWRITER_H_INCLUDED
+#define SETTINGSWRITER_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+
+/**
+	Formats a settings snapshot and writes it to disk on its own thread, so
+	starting a recording does not wait for the XML document to be built.
+
+	The snapshot is created on the message thread (see EditorViewport::createSettingsXml)
+	and handed over; it is not touched by anything else afterwards.
+
+	@see RecordNode, EditorViewport
+*/
+class SettingsWriter : public Thread
+{
+public:
+	SettingsWriter();
+	~SettingsWriter();
+
+	/** Takes ownership of the snapshot and starts writing it. Waits for a previous write to finish first. */
+	void writeSettings(XmlElement* snapshot, const File& file);
+
+	/** Returns the text of the last settings document, waiting for a pending write if needed.
+	    A copy, since the next write replaces it. */
+	String getSettingsText();
+
+	void run() override;
+
+private:
+	ScopedPointer<XmlElement> m_snapshot;
+	File m_file;
+	String m_settingsText;
+
+	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SettingsWriter);
+};
+
+
+#endif  // SETTINGSWRITER_H_INCLUDED
@@ -0,0 +1,306 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SerialOutputThread.h"
+
+#if defined( TARGET_OSX ) || defined( TARGET_LINUX )
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+
+SerialOutputThread::SerialOutputThread (const String& name, Target* t)
+    : Thread            (name)
+    , target            (t)
+    , fifo              (queueSize)
+    , wakeUp            (false)
+    , numMeasured       (0)
+    , latencySum        (0)
+    , latencyMax        (0)
+    , loopback          (false)
+    , loopbackMaster    (-1)
+{
+    commands.allocate (queueSize, true);
+    histogram.allocate (histogramBins, true);
+}
+
+
+SerialOutputThread::~SerialOutputThread()
+{
+    stopOutput();
+    closeLoopback();
+}
+
+
+double SerialOutputThread::getDetectionTime (double blockStartMs, int sampleNum, int numSamples, float sampleRate)
+{
+    if (sampleRate <= 0)
+        return blockStartMs;
+
+    // samples after sampleNum had to be acquired before the block could be delivered
+    return blockStartMs - 1000.0 * (numSamples - sampleNum) / sampleRate;
+}
+
+
+bool SerialOutputThread::post (int channel, int value, int64 timestamp, double detectionTimeMs)
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    if (size1 + size2 < 1)
+    {
+        ++droppedCommands;
+        return false;
+    }
+
+    Command& c = commands[size1 > 0 ? start1 : start2];
+    c.channel = channel;
+    c.value = value;
+    c.timestamp = timestamp;
+    c.detectionTimeMs = detectionTimeMs;
+
+    fifo.finishedWrite (1);
+    wakeUp.signal();
+
+    return true;
+}
+
+
+void SerialOutputThread::startOutput()
+{
+    if (isThreadRunning())
+        return;
+
+    fifo.reset();
+    startThread (9);
+}
+
+
+void SerialOutputThread::stopOutput()
+{
+    if (! isThreadRunning())
+        return;
+
+    signalThreadShouldExit();
+    wakeUp.signal();
+    stopThread (1000);
+
+    if (numMeasured > 0)
+        std::cout << getThreadName() << " output latency: " << getLatencySummary() << std::endl;
+
+    if (droppedCommands.get() > 0)
+        std::cout << getThreadName() << " dropped " << droppedCommands.get() << " commands." << std::endl;
+}
+
+
+void SerialOutputThread::run()
+{
+    while (! threadShouldExit())
+    {
+        wakeUp.wait (100);
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            fire (commands[start1 + i]);
+
+        for (int i = 0; i < size2; ++i)
+            fire (commands[start2 + i]);
+
+        fifo.finishedRead (size1 + size2);
+    }
+}
+
+
+void SerialOutputThread::fire (const Command& command)
+{
+    if (! loopback)
+    {
+        if (target != nullptr)
+            target->fireSerialOutput (command);
+
+        addLatency (Time::getMillisecondCounterHiRes() - command.detectionTimeMs);
+        return;
+    }
+
+#if defined( TARGET_OSX ) || defined( TARGET_LINUX )
+    unsigned char msg[2] = { (unsigned char) command.channel, (unsigned char) command.value };
+
+    if (loopbackSerial.writeBytes (msg, 2) != 2)
+        return;
+
+    // wait for the bytes on the other end of the pty
+    int received = 0;
+    unsigned char buf[16];
+
+    while (received < 2)
+    {
+        struct pollfd pfd;
+        pfd.fd = loopbackMaster;
+        pfd.events = POLLIN;
+
+        if (poll (&pfd, 1, loopbackTimeoutMs) <= 0)
+            return;
+
+        const ssize_t n = read (loopbackMaster, buf, sizeof (buf));
+
+        if (n <= 0)
+            return;
+
+        received += (int) n;
+    }
+
+    addLatency (Time::getMillisecondCounterHiRes() - command.detectionTimeMs);
+#endif
+}
+
+
+bool SerialOutputThread::setLoopbackMode (bool enabled)
+{
+    jassert (! isThreadRunning());
+
+    closeLoopback();
+
+    if (! enabled)
+        return true;
+
+#if defined( TARGET_OSX ) || defined( TARGET_LINUX )
+    loopbackMaster = posix_openpt (O_RDWR | O_NOCTTY);
+
+    if (loopbackMaster < 0
+        || grantpt (loopbackMaster) != 0
+        || unlockpt (loopbackMaster) != 0
+        || ptsname (loopbackMaster) == nullptr)
+    {
+        std::cout << "Could not create a pseudo-terminal for loopback output." << std::endl;
+        closeLoopback();
+        return false;
+    }
+
+    fcntl (loopbackMaster, F_SETFL, fcntl (loopbackMaster, F_GETFL) | O_NONBLOCK);
+
+    const String slaveName (ptsname (loopbackMaster));
+
+    if (! loopbackSerial.setup (slaveName.toStdString(), 115200))
+    {
+        closeLoopback();
+        return false;
+    }
+
+    std::cout << getThreadName() << " looping back through " << slaveName << std::endl;
+
+    loopback = true;
+    resetLatencyStats();
+    return true;
+#else
+    std::cout << "Loopback output is not supported on this platform." << std::endl;
+    return false;
+#endif
+}
+
+
+bool SerialOutputThread::isLoopbackMode() const
+{
+    return loopback;
+}
+
+
+void SerialOutputThread::closeLoopback()
+{
+    if (loopback)
+        loopbackSerial.close();
+
+    loopback = false;
+
+#if defined( TARGET_OSX ) || defined( TARGET_LINUX )
+    if (loopbackMaster >= 0)
+        ::close (loopbackMaster);
+#endif
+
+    loopbackMaster = -1;
+}
+
+
+void SerialOutputThread::addLatency (double latencyMs)
+{
+    const ScopedLock sl (statsLock);
+
+    const int bin = jlimit (0, histogramBins - 1, (int) (latencyMs / histogramBinMs));
+    ++histogram[bin];
+    ++numMeasured;
+    latencySum += latencyMs;
+    latencyMax = jmax (latencyMax, latencyMs);
+}
+
+
+void SerialOutputThread::resetLatencyStats()
+{
+    const ScopedLock sl (statsLock);
+
+    histogram.clear (histogramBins);
+    numMeasured = 0;
+    latencySum = 0;
+    latencyMax = 0;
+}
+
+
+double SerialOutputThread::getPercentile (double fraction) const
+{
+    const uint32 wanted = (uint32) ceil (fraction * numMeasured);
+    uint32 count = 0;
+
+    for (int i = 0; i < histogramBins; ++i)
+    {
+        count += histogram[i];
+
+        if (count >= wanted)
+            return jmin ((i + 1) * histogramBinMs, latencyMax);
+    }
+
+    return latencyMax;
+}
+
+
+String SerialOutputThread::getLatencySummary() const
+{
+    const ScopedLock sl (statsLock);
+
+    if (numMeasured == 0)
+        return "no commands";
+
+    return String (numMeasured) + " commands, mean "
+        + String (latencySum / numMeasured, 2) + " ms, median "
+        + String (getPercentile (0.5), 2) + " ms, 95% "
+        + String (getPercentile (0.95), 2) + " ms, 99% "
+        + String (getPercentile (0.99), 2) + " ms, max "
+        + String (latencyMax, 2) + " ms";
+}
+
+
+int SerialOutputThread::getNumDroppedCommands() const
+{
+    return droppedCommands.get();
+}
@@ -0,0 +1,140 @@
+/*
+------------------------------------------------------------------
+
+This file is part of the Open Ephys GUI
+Copyright (C) 2017 Open Ephys
+
+------------------------------------------------------------------
+
+This program is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SERIALOUTPUTTHREAD_H_INCLUDED
+#define SERIALOUTPUTTHREAD_H_INCLUDED
+
+#include "../../../JuceLibraryCode/JuceHeader.h"
+#include "ofSerial.h"
+
+/**
+    High-priority thread that performs serial output on behalf of a processor.
+
+    Output processors (ArduinoOutput, PulsePalOutput, ...) call post() from
+    handleEvent() instead of writing to their device on the audio thread. The
+    command goes through a lock-free FIFO and the output thread, which spends
+    its time blocked on a WaitableEvent, hands it to the Target immediately.
+    The audio callback never blocks on serial I/O, and a slow device cannot
+    stall the signal chain.
+
+    Every command carries the estimated time at which the triggering sample
+    was acquired, so the thread can keep a histogram of detection-to-output
+    latencies. In loopback mode the commands are written through an ofSerial
+    opened on a pseudo-terminal instead of the real device, and the latency is
+    taken when the bytes arrive on the other end of the pty. That measures
+    the whole path without any hardware attached.
+
+    @see ofSerial
+*/
+class PLUGIN_API SerialOutputThread : public Thread
+{
+public:
+
+    /** A "fire now" request. The meaning of channel and value is up to the Target. */
+    struct Command
+    {
+        int channel;
+        int value;
+        int64 timestamp;
+        double detectionTimeMs;
+    };
+
+    /** Implemented by the processor that owns the device. */
+    class Target
+    {
+    public:
+        virtual ~Target() {}
+
+        /** Called on the output thread for each posted command. */
+        virtual void fireSerialOutput (const Command& command) = 0;
+    };
+
+    SerialOutputThread (const String& name, Target* target);
+    ~SerialOutputThread();
+
+    /** Queues a command and wakes the output thread. Lock-free and safe to call
+        from the audio thread; returns false if the queue is full. */
+    bool post (int channel, int value, int64 timestamp, double detectionTimeMs);
+
+    /** Convenience for processors: estimates the acquisition time of sample
+        sampleNum in a block of numSamples that reached the processor at
+        blockStartMs (Time::getMillisecondCounterHiRes()). */
+    static double getDetectionTime (double blockStartMs, int sampleNum, int numSamples, float sampleRate);
+
+    /** Starts the output thread at high priority. */
+    void startOutput();
+
+    /** Stops the output thread and prints the latency summary, if any. */
+    void stopOutput();
+
+    /** Routes commands to a pty instead of the Target. Returns false if
+        pseudo-terminals are not available. Only call while stopped. */
+    bool setLoopbackMode (bool enabled);
+    bool isLoopbackMode() const;
+
+    /** Clears the latency histogram. */
+    void resetLatencyStats();
+
+    /** Returns count, mean, percentiles and maximum of the measured latencies. */
+    String getLatencySummary() const;
+
+    /** Number of commands dropped because the queue was full. */
+    int getNumDroppedCommands() const;
+
+    void run() override;
+
+private:
+    void fire (const Command& command);
+    void addLatency (double latencyMs);
+    double getPercentile (double fraction) const;
+
+    void closeLoopback();
+
+    //Compile-time constants
+    const int queueSize{ 1024 };
+    const int histogramBins{ 2000 };
+    const double histogramBinMs{ 0.05 };
+    const int loopbackTimeoutMs{ 100 };
+
+    Target* target;
+
+    AbstractFifo fifo;
+    HeapBlock<Command> commands;
+    WaitableEvent wakeUp;
+    Atomic<int> droppedCommands;
+
+    HeapBlock<uint32> histogram;
+    uint32 numMeasured;
+    double latencySum;
+    double latencyMax;
+    CriticalSection statsLock;
+
+    bool loopback;
+    ofSerial loopbackSerial;
+    int loopbackMaster;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SerialOutputThread);
+};
+
+
+#endif  // SERIALOUTPUTTHREAD_H_INCLUDED
@@ -523,6 +523,8 @@ void ControlPanel::updateRecordEngineList()
 	{
 		Plugin::RecordEngineInfo info;
 		info = AccessClass::getPluginManager()->getRecordEngineInfo(i);
+		if (info.creator == nullptr) //library failed to load
+			continue;
 		recordSelector->addItem(info.name, id++);
 		recordEngines.add(info.creator());
 	}
@@ -1259,6 +1259,30 @@ const String EditorViewport::saveState(File fileToUse, String* xmlText)
     //     return error;
     // }
 
+    ScopedPointer<XmlElement> xml = createSettingsXml();
+
+    // format the document once and write that text, rather than formatting it twice
+    String text = xml->createDocument(String::empty);
+
+    if (text.isEmpty() || ! currentFile.replaceWithText(text))
+        error = "Couldn't write to file ";
+    else
+        error = "Saved configuration as ";
+
+    error += currentFile.getFileName();
+
+	if (xmlText != nullptr)
+	{
+		(*xmlText) = text;
+		if ((*xmlText).isEmpty())
+			(*xmlText) = "Couldn't create configuration xml";
+	}
+
+    return error;
+}
+
+XmlElement* EditorViewport::createSettingsXml()
+{
     Array<GenericProcessor*> splitPoints;
     /** Used to reset saveOrder at end, to allow saving the same processor multiple times*/
     Array<GenericProcessor*> allProcessors;
@@ -1399,6 +1423,7 @@ const String EditorViewport::saveState(File fileToUse, String* xmlText)
 	AccessClass::getProcessorGraph()->getTimestampSources(tsID, tsSubID);
 	timestampSettings->setAttribute("selected_index", tsID);
 	timestampSettings->setAttribute("selected_sub_index", tsSubID);
+	timestampSettings->setAttribute("sync_line", AccessClass::getProcessorGraph()->getSyncLine());
 	xml->addChildElement(timestampSettings);
 
     //Resets Save Order for processors, allowing them to be saved again without omitting themselves from the order.
@@ -1412,23 +1437,7 @@ const String EditorViewport::saveState(File fileToUse, String* xmlText)
     AccessClass::getProcessorList()->saveStateToXml(xml);
     AccessClass::getUIComponent()->saveStateToXml(xml);  // save the UI settings
 
-    if (! xml->writeToFile(currentFile, String::empty))
-        error = "Couldn't write to file ";
-    else
-        error = "Saved configuration as ";
-
-    error += currentFile.getFileName();
-
-	if (xmlText != nullptr)
-	{
-		(*xmlText) = xml->createDocument(String::empty);
-		if ((*xmlText).isEmpty())
-			(*xmlText) = "Couldn't create configuration xml";
-	}
-
-    delete xml;
-
-    return error;
+    return xml;
 }
 
 const String EditorViewport::loadState(File fileToLoad)
@@ -1641,6 +1650,7 @@ const String EditorViewport::loadState(File fileToLoad)
 			int tsID = element->getIntAttribute("selected_index", -1);
 			int tsSubID = element->getIntAttribute("selected_sub_index");
 			AccessClass::getProcessorGraph()->setTimestampSource(tsID, tsSubID);
+			AccessClass::getProcessorGraph()->setSyncLine(element->getIntAttribute("sync_line", -1));
 		}
 
     }
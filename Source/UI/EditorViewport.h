@@ -152,6 +152,11 @@ public:
 	/** Save the current configuration as an XML file. Reference wrapper*/
 	const String saveState(File filename, String& xmlText);
 
+    /** Builds the settings document for the current configuration. The returned tree does not refer
+        back to any processor or editor, so it can be formatted and written on another thread.
+        Must be called on the message thread; the caller owns the result. */
+    XmlElement* createSettingsXml();
+
     /** Load a saved configuration from an XML file. */
     const String loadState(File filename);
 
@@ -30,7 +30,7 @@ TimestampSourceSelectionWindow::TimestampSourceSelectionWindow()
 	: DocumentWindow("Global timestamp source selection", Colours::red,
 	DocumentWindow::closeButton)
 {
-	centreWithSize(300, 200);
+	centreWithSize(300, 270);
 	setUsingNativeTitleBar(true);
 	setResizable(false, false);
 	m_selectorComponent = new TimestampSourceSelectionComponent();
@@ -63,11 +63,25 @@ void TimestampSourceSelectionWindow::closeButtonPressed()
 //Component
 TimestampSourceSelectionComponent::TimestampSourceSelectionComponent()
 {
-	setSize(300, 200);
+	setSize(300, 270);
 	m_selector = new ComboBox("Timestamp Sources");
 	m_selector->setBounds(50, 150, 200, 30);
 	m_selector->addListener(this);
 	addAndMakeVisible(m_selector);
+
+	m_syncLineLabel = new Label("Sync line label", "Sync TTL line:");
+	m_syncLineLabel->setBounds(50, 230, 90, 30);
+	m_syncLineLabel->setColour(Label::textColourId, Colours::black);
+	addAndMakeVisible(m_syncLineLabel);
+
+	m_syncLineSelector = new ComboBox("Sync line");
+	m_syncLineSelector->setBounds(150, 230, 100, 30);
+	m_syncLineSelector->addItem("None", 1);
+	for (int line = 0; line < 16; line++)
+		m_syncLineSelector->addItem(String(line + 1), line + 2);
+	m_syncLineSelector->addListener(this);
+	addAndMakeVisible(m_syncLineSelector);
+
 	updateProcessorList();
 }
 
@@ -109,10 +123,17 @@ void TimestampSourceSelectionComponent::updateProcessorList()
 		}
 	}
 	m_selector->setSelectedId(selected, dontSendNotification);
+	m_syncLineSelector->setSelectedId(AccessClass::getProcessorGraph()->getSyncLine() + 2, dontSendNotification);
 }
 
 void TimestampSourceSelectionComponent::comboBoxChanged(ComboBox* c)
 {
+	if (c == m_syncLineSelector)
+	{
+		AccessClass::getProcessorGraph()->setSyncLine(c->getSelectedId() - 2);
+		return;
+	}
+
 	int selected = c->getSelectedId() - 2;
 	int sourceIdx, subIdx;
 	if (selected < 0)
@@ -131,6 +152,7 @@ void TimestampSourceSelectionComponent::comboBoxChanged(ComboBox* c)
 void TimestampSourceSelectionComponent::setAcquisitionState(bool s)
 {
 	m_selector->setEnabled(!s);
+	m_syncLineSelector->setEnabled(!s);
 }
 
 void TimestampSourceSelectionComponent::paint(Graphics& g)
@@ -142,4 +164,7 @@ void TimestampSourceSelectionComponent::paint(Graphics& g)
 		"Processors that generate events not based on any existing data streams but do not generate their "
 		"own timestamps will use both the timestamps and sample rate of the selected processor as reference.",
 		10, 30, 280);
+	g.drawMultiLineText("If all sources share a sync signal on one TTL line, recordings note how each "
+		"source's clock maps onto the selected one.",
+		10, 200, 280);
 }
\ No newline at end of file
@@ -48,6 +48,8 @@ private:
 		int subProcessorIndex;
 	};
 	ScopedPointer<ComboBox> m_selector;
+	ScopedPointer<Label> m_syncLineLabel;
+	ScopedPointer<ComboBox> m_syncLineSelector;
 	Array<SourceInfo> m_sourcesArray;
 
 	JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TimestampSourceSelectionComponent);